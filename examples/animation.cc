@@ -0,0 +1,52 @@
+#include <iostream>
+#include <string>
+
+#include "render/render_engine.h"
+
+// Animation benchmark: loads a pack and adds many instances of it, each with its own copy of the pack nodes
+// playing the animation. Prints how long posing all instances takes per frame next to the frame time,
+// and the vertices and joint matrices of skinned instances, which are skinned once per frame by a compute pass.
+// Usage: render_engine_animation [gltf_path] [animation_name] [instances_count]
+
+int main(int argc, char** argv)
+{
+	std::string path = argc > 1 ? argv[1] : "../blender/old_chair/old_chair_with_cube.glb";
+	std::string animation_name = argc > 2 ? argv[2] : "";
+	uint32_t instances_count = argc > 3 ? std::stoul(argv[3]) : 1000;
+
+	render::RenderEngine engine(nullptr, "animation");
+
+	if (!engine.VKInitSuccess())
+		return 1;
+
+	engine.StartRender();
+
+	auto camera = engine.AddObject<render::ObjectType::Node>({ "camera" });
+	engine.QueueCommand(render::command::SetActiveCameraNode{ camera });
+
+	engine.QueueCommand(render::command::LoadFile{ "animated", path });
+
+	for (uint32_t instance_index = 0; instance_index < instances_count; instance_index++)
+	{
+		engine.AddObject<render::ObjectType::AnimatedModel>({ "animated", animation_name, "animated_" + std::to_string(instance_index) });
+	}
+
+	uint32_t tick = 0;
+
+	while (true)
+	{
+		Sleep(16);
+		tick++;
+
+		auto stats = engine.GetStats();
+
+		if (tick % 60 == 0)
+		{
+			std::cout << "animated instances: " << stats.animated_instances_count << " update time: " << stats.animation_update_time_ms
+				<< " ms skinned vertices: " << stats.skinned_vertices_count << " joints: " << stats.joint_matrices_count
+				<< " frame: " << stats.frame_time_ms << " ms" << std::endl;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "render/render_engine.h"
+
+// Lights benchmark: spawns moving point lights around the chair scene in steps and prints
+// the average time of every frame rendered during a step and the lights clusters had no room for.
+// Usage: render_engine_clustered_lights [lights_count...]
+
+int main(int argc, char** argv)
+{
+	std::vector<uint32_t> lights_counts;
+
+	for (int arg_index = 1; arg_index < argc; arg_index++)
+	{
+		lights_counts.push_back(std::stoul(argv[arg_index]));
+	}
+
+	if (lights_counts.empty())
+	{
+		lights_counts = { 0, 256, 512, 1024, 2048, 4096 };
+	}
+
+	// lights are only added, so the counts are swept in ascending order
+	std::sort(lights_counts.begin(), lights_counts.end());
+
+	const uint32_t kWarmupTicks = 60;
+	const uint32_t kMeasuredTicks = 240;
+
+	render::RenderEngine engine(nullptr, "clustered_lights");
+
+	if (!engine.VKInitSuccess())
+		return 1;
+
+	engine.StartRender();
+
+	auto model = std::make_shared<tinygltf::Model>();
+	tinygltf::TinyGLTF loader;
+	render::SetupGLTFLoader(loader);
+	std::string err;
+	std::string warn;
+
+	if (!loader.LoadBinaryFromFile(model.get(), &err, &warn, "../blender/old_chair/old_chair_with_cube.glb"))
+	{
+		std::cout << "failed to load scene: " << err << std::endl;
+		return 1;
+	}
+
+	engine.QueueCommand(render::command::Load{ "chair", model });
+	engine.AddObject<render::ObjectType::StaticModel>({ "chair", "Floor", "floor" });
+	engine.AddObject<render::ObjectType::StaticModel>({ "chair", "Chair", "chair" });
+
+	auto camera = engine.AddObject<render::ObjectType::Node>({ "camera" });
+	engine.QueueCommand(render::command::SetActiveCameraNode{ camera });
+
+	std::mt19937 random_engine(0);
+	std::uniform_real_distribution<float> unit_distribution(0.0f, 1.0f);
+
+	struct AnimatedLight
+	{
+		uint32_t id;
+		glm::vec3 center;
+		float orbit_radius;
+		float phase;
+		float speed;
+	};
+
+	std::vector<AnimatedLight> lights;
+	lights.reserve(lights_counts.back());
+
+	auto add_lights = [&](uint32_t lights_count)
+	{
+		while (lights.size() < lights_count)
+		{
+			glm::vec3 center = { unit_distribution(random_engine) * 20 - 10, unit_distribution(random_engine) * 20 - 10, 0.2f + unit_distribution(random_engine) * 2 };
+			glm::vec3 color = { unit_distribution(random_engine), unit_distribution(random_engine), unit_distribution(random_engine) };
+
+			auto light = engine.AddObject<render::ObjectType::Light>({ center, color, 2.0f, 0.5f + unit_distribution(random_engine) * 1.5f });
+			lights.push_back({ light.value, center, 0.2f + unit_distribution(random_engine), unit_distribution(random_engine) * 6.28f, 0.5f + unit_distribution(random_engine) });
+		}
+	};
+
+	float time = 0;
+	uint32_t tick = 0;
+
+	size_t step_index = 0;
+	render::RenderStats step_start_stats;
+
+	add_lights(lights_counts[step_index]);
+
+	while (step_index < lights_counts.size())
+	{
+		Sleep(16);
+		time += 0.016f;
+		tick++;
+
+		render::command::ObjectsUpdate update;
+		update.updates.reserve(lights.size() + 1);
+
+		glm::mat4 camera_transform = glm::mat4(1.0f);
+		camera_transform[3] = glm::vec4(0.0f, -8.0f, 3.0f, 1.0f);
+		update.updates.push_back({ camera.value, camera_transform });
+
+		for (auto&& light : lights)
+		{
+			float angle = light.phase + light.speed * time;
+
+			glm::mat4 transform = glm::mat4(1.0f);
+			transform[3] = glm::vec4(light.center + light.orbit_radius * glm::vec3(std::cos(angle), std::sin(angle), 0.0f), 1.0f);
+
+			update.updates.push_back({ light.id, transform });
+		}
+
+		engine.QueueCommand(update);
+
+		// the engine renders several frames per tick, their total time is sampled at both ends of the step
+		if (tick == kWarmupTicks)
+		{
+			step_start_stats = engine.GetStats();
+		}
+
+		if (tick == kWarmupTicks + kMeasuredTicks)
+		{
+			auto stats = engine.GetStats();
+			uint64_t frames_count = stats.frames_count - step_start_stats.frames_count;
+			float frame_time_ms = frames_count > 0 ? float((stats.frames_time_ms - step_start_stats.frames_time_ms) / frames_count) : 0.0f;
+
+			std::cout << "lights: " << stats.lights_count << " frames: " << frames_count << " frame: " << frame_time_ms << " ms fps: " << (frame_time_ms > 0 ? 1000.0f / frame_time_ms : 0.0f)
+				<< " overflowed clusters: " << stats.overflowed_light_clusters << " dropped lights: " << stats.dropped_cluster_lights << std::endl;
+
+			tick = 0;
+			step_index++;
+
+			if (step_index < lights_counts.size())
+			{
+				add_lights(lights_counts[step_index]);
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "render/render_engine.h"
+
+// Descriptor update benchmark: loads the chair pack many times, so every copy gets its own primitive
+// descriptor sets, and prints how many sets are rewritten per frame, how long holder updates take
+// and how many bytes holders upload. The scene is static, so uploads should drop to zero.
+// Usage: render_engine_descriptor_updates [packs_count]
+
+int main(int argc, char** argv)
+{
+	uint32_t packs_count = argc > 1 ? std::stoul(argv[1]) : 256;
+
+	render::RenderEngine engine(nullptr, "descriptor_updates");
+
+	if (!engine.VKInitSuccess())
+		return 1;
+
+	engine.StartRender();
+
+	auto model = std::make_shared<tinygltf::Model>();
+	tinygltf::TinyGLTF loader;
+	render::SetupGLTFLoader(loader);
+	std::string err;
+	std::string warn;
+
+	if (!loader.LoadBinaryFromFile(model.get(), &err, &warn, "../blender/old_chair/old_chair_with_cube.glb"))
+	{
+		std::cout << "failed to load scene: " << err << std::endl;
+		return 1;
+	}
+
+	auto camera = engine.AddObject<render::ObjectType::Node>({ "camera" });
+	engine.QueueCommand(render::command::SetActiveCameraNode{ camera });
+
+	for (uint32_t pack_index = 0; pack_index < packs_count; pack_index++)
+	{
+		std::string pack_name = "chair_" + std::to_string(pack_index);
+
+		engine.QueueCommand(render::command::Load{ pack_name, model });
+		engine.AddObject<render::ObjectType::StaticModel>({ pack_name, "Chair", pack_name });
+	}
+
+	uint32_t tick = 0;
+
+	while (true)
+	{
+		Sleep(16);
+		tick++;
+
+		auto stats = engine.GetStats();
+
+		if (tick % 60 == 0)
+		{
+			float sets_per_ms = stats.descriptor_update_time_ms > 0 ? stats.descriptor_set_updates / stats.descriptor_update_time_ms : 0.0f;
+
+			std::cout << "packs: " << packs_count << " set updates: " << stats.descriptor_set_updates << " update time: " << stats.descriptor_update_time_ms
+				<< " ms (" << sets_per_ms << " sets/ms) uploaded: " << stats.uploaded_bytes << " bytes frame: " << stats.frame_time_ms << " ms" << std::endl;
+		}
+	}
+
+	return 0;
+}
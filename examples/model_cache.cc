@@ -0,0 +1,120 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "render/render_engine.h"
+
+// Model cache benchmark: loads every glb file under blender/ cold, parsing glTF, decoding images and generating tangents,
+// then cooks it into the cache and loads it again from the memory mapped entry. Both times include GPU uploads,
+// which only cover the geometry streams out of all glTF buffer bytes. With "optimize" meshes are reordered while cooking
+// and their vertex cache ACMR and ATVR are printed before and after, "lods=N" cooks up to N coarser index lists per primitive
+// and "quantize" packs vertices of static meshes into quantized streams, which shows in the uploaded bytes.
+// Files compressed with EXT_meshopt_compression are decoded before cooking, the file size next to the cold load time
+// compares them with their uncompressed versions. "animation_tolerance=E" drops linear animation keys reproduced within E
+// and "quantize_rotations" stores rotation keys as 16 bit, the time to build clips and their bytes are printed per file.
+// Usage: render_engine_model_cache [assets_dir] [cache_dir] [optimize] [lods=N] [quantize] [animation_tolerance=E] [quantize_rotations]
+
+namespace
+{
+	float LoadPack(render::RenderEngine& engine, const render::command::LoadFile& command)
+	{
+		uint32_t packs_loaded = engine.GetStats().packs_loaded;
+
+		engine.QueueCommand(command);
+
+		while (engine.GetStats().packs_loaded == packs_loaded)
+		{
+			Sleep(1);
+		}
+
+		return engine.GetStats().pack_load_time_ms;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string assets_dir = argc > 1 ? argv[1] : "../blender";
+	std::string cache_dir = argc > 2 ? argv[2] : "model_cache";
+
+	render::CookOptions cook_options;
+
+	for (int arg_index = 3; arg_index < argc; arg_index++)
+	{
+		std::string arg = argv[arg_index];
+
+		if (arg == "optimize")
+		{
+			cook_options.optimize_meshes = true;
+		}
+		else if (arg == "quantize")
+		{
+			cook_options.quantize_vertices = true;
+		}
+		else if (arg == "quantize_rotations")
+		{
+			cook_options.quantize_rotations = true;
+		}
+		else if (arg.starts_with("lods="))
+		{
+			cook_options.lods_count = std::stoul(arg.substr(5));
+		}
+		else if (arg.starts_with("animation_tolerance="))
+		{
+			cook_options.animation_tolerance = std::stof(arg.substr(20));
+		}
+	}
+
+	render::RenderEngine engine(nullptr, "model_cache");
+
+	if (!engine.VKInitSuccess())
+		return 1;
+
+	engine.StartRender();
+
+	float total_cold_ms = 0.0f;
+	float total_cached_ms = 0.0f;
+
+	for (auto&& entry : std::filesystem::recursive_directory_iterator(assets_dir))
+	{
+		if (entry.path().extension() != ".glb")
+			continue;
+
+		std::string path = entry.path().string();
+		std::string name = entry.path().stem().string();
+
+		float cold_ms = LoadPack(engine, { name + "_cold", path, "", cook_options });
+
+		auto cook_start_time = std::chrono::high_resolution_clock::now();
+
+		std::vector<render::MeshCacheReport> mesh_reports;
+
+		if (!render::CookModelPack(path, cache_dir, cook_options, &mesh_reports))
+		{
+			std::cout << "failed to cook " << path << std::endl;
+			continue;
+		}
+
+		std::chrono::duration<float, std::milli> cook_duration = std::chrono::high_resolution_clock::now() - cook_start_time;
+
+		float cached_ms = LoadPack(engine, { name + "_cached", path, cache_dir, cook_options });
+
+		total_cold_ms += cold_ms;
+		total_cached_ms += cached_ms;
+
+		std::cout << path << " file: " << entry.file_size() << " bytes cold: " << cold_ms << " ms cook: " << cook_duration.count() << " ms cached: " << cached_ms << " ms"
+			<< " buffers: " << engine.GetStats().pack_source_buffers_bytes << " bytes uploaded: " << engine.GetStats().pack_uploaded_buffers_bytes << " bytes"
+			<< " clips: " << engine.GetStats().pack_animation_import_time_ms << " ms " << engine.GetStats().pack_animation_clips_bytes << " bytes" << std::endl;
+
+		for (auto&& report : mesh_reports)
+		{
+			std::cout << "  " << report.mesh_name << " ACMR: " << report.acmr_before << " -> " << report.acmr_after
+				<< " ATVR: " << report.atvr_before << " -> " << report.atvr_after << std::endl;
+		}
+	}
+
+	std::cout << "total cold: " << total_cold_ms << " ms cached: " << total_cached_ms << " ms" << std::endl;
+
+	return 0;
+}
@@ -49,6 +49,46 @@ namespace render
 		return result;
 	}
 
+	// Defers image decoding to the engine, which decodes in parallel and uploads KTX2 textures as is
+	void SetupGLTFLoader(tinygltf::TinyGLTF& loader);
+
+	// import stages of glTF cooking, cache entries cooked with other options are recooked
+	struct CookOptions
+	{
+		// vertex cache, overdraw and vertex fetch reordering of triangle lists
+		bool optimize_meshes = false;
+
+		// coarser index lists simplified per primitive, each aiming at lod_triangles_ratio of the previous triangles.
+		// The chain stops early once simplification can't reduce a level further within the error limit.
+		uint32_t lods_count = 0;
+		float lod_triangles_ratio = 0.5f;
+
+		// Packs position, normal, tangent and texture coordinates of static meshes into 20 byte quantized vertices.
+		// Meshes with skins, missing attributes or texture coordinates half can't hold keep float streams.
+		bool quantize_vertices = false;
+
+		// Keys of linear animation channels that interpolating their neighbours reproduces within this distance are dropped,
+		// rotations compare quaternion components. Zero keeps all keys.
+		float animation_tolerance = 0.0f;
+
+		// stores animation rotations as 16 bit snorm quaternions, only affects loading
+		bool quantize_rotations = false;
+	};
+
+	// post transform cache efficiency of a mesh before and after import optimization
+	struct MeshCacheReport
+	{
+		std::string mesh_name;
+		float acmr_before;
+		float atvr_before;
+		float acmr_after;
+		float atvr_after;
+	};
+
+	// Offline cooking: writes the cache entry command::LoadFile maps for the glTF file, returns false on failure.
+	// options must match the ones of the LoadFile command, mesh_reports receive a report per mesh when not null.
+	bool CookModelPack(const std::string& gltf_path, const std::string& cache_dir, const CookOptions& options = {}, std::vector<MeshCacheReport>* mesh_reports = nullptr);
+
 	enum class ObjectType
 	{
 #define RENDER_ENGINE_OBJECTS
@@ -106,7 +146,93 @@ namespace render
 		std::string name;
 	};
 
+	template<>
+	struct ObjectDescription<ObjectType::Light>
+	{
+		glm::vec3 position;
+		glm::vec3 color = glm::vec3(1.0f);
+		float intensity = 1.0f;
+		float radius = 5.0f;
+
+		bool cast_shadows = false;
+
+		std::string name;
+	};
+
+	// Copy of all nodes and models of a pack playing animation_name looped, the returned id is the node they hang from.
+	// Every instance poses its own nodes, an unknown animation_name leaves them at rest.
+	template<>
+	struct ObjectDescription<ObjectType::AnimatedModel>
+	{
+		std::string pack_name;
+		std::string animation_name;
 
+		std::string name;
+	};
+
+	struct RenderStats
+	{
+		float frame_time_ms = 0.0f;
+		float fps = 0.0f;
+		uint32_t lights_count = 0;
+
+		// frames rendered so far and their summed time, the difference of two reads averages every frame in between
+		uint64_t frames_count = 0;
+		double frames_time_ms = 0.0;
+
+		// clusters with more lights than they hold and the lights left unshaded in them, read back a few frames late
+		uint32_t overflowed_light_clusters = 0;
+		uint32_t dropped_cluster_lights = 0;
+
+		// descriptor sets rewritten by holders during the last frame and time spent updating holders
+		uint32_t descriptor_set_updates = 0;
+		float descriptor_update_time_ms = 0.0f;
+
+		// uniform and storage bytes copied by holders during the last frame, zero for a static scene
+		uint64_t uploaded_bytes = 0;
+
+		uint32_t descriptor_sets_used = 0;
+		uint32_t descriptor_sets_free = 0;
+		// taken by thread caches of the descriptor sets manager, neither used nor free
+		uint32_t descriptor_sets_cached = 0;
+		uint32_t descriptor_pools_count = 0;
+
+		// sets shared by contents and references to them, the difference is the number of sets saved
+		uint32_t descriptor_sets_shared = 0;
+		uint32_t descriptor_set_shared_refs = 0;
+
+		uint32_t image_views_count = 0;
+
+		// mip levels of streamed textures resident on GPU and the levels sampling feedback asks for
+		uint32_t streamed_textures_count = 0;
+		uint64_t texture_resident_bytes = 0;
+		uint64_t texture_requested_bytes = 0;
+
+		// resident images being filled or uploaded, they replace the current ones once the upload completes
+		uint32_t texture_pending_loads = 0;
+
+		// triangles of the camera view at full detail and at the picked LODs, shadow cube faces pick their own
+		uint64_t full_detail_triangles_count = 0;
+		uint64_t lod_triangles_count = 0;
+
+		// Load and LoadFile commands executed so far and the time the last one took, including uploads
+		uint32_t packs_loaded = 0;
+		float pack_load_time_ms = 0.0f;
+		// glTF buffer bytes of the last loaded pack and the geometry bytes uploaded from them
+		uint64_t pack_source_buffers_bytes = 0;
+		uint64_t pack_uploaded_buffers_bytes = 0;
+		// animation clips of the last loaded pack, time to build them from the cooked channels and their keyframe bytes
+		float pack_animation_import_time_ms = 0.0f;
+		uint64_t pack_animation_clips_bytes = 0;
+
+		// animated model instances and the time spent evaluating their clips during the last frame
+		uint32_t animated_instances_count = 0;
+		float animation_update_time_ms = 0.0f;
+
+		// vertices written by the skinning pass and joint matrices uploaded for it each frame
+		uint32_t skinned_vertices_count = 0;
+		uint32_t joint_matrices_count = 0;
+	};
 
 
 	namespace command
@@ -117,6 +243,16 @@ namespace render
 			std::shared_ptr<tinygltf::Model> model;
 		};
 
+		// Loads a glTF file through the cooked pack cache in cache_dir, on a miss the file is cooked and cached.
+		// An empty cache_dir loads and cooks the file without caching.
+		struct LoadFile
+		{
+			std::string pack_name;
+			std::string path;
+			std::string cache_dir;
+			CookOptions options;
+		};
+
 		struct Image
 		{
 			std::string name;
@@ -144,6 +280,12 @@ namespace render
 			std::vector<std::pair<uint32_t, glm::mat4>> updates;
 		};
 
+		// GPU bytes streamed textures may keep resident, least recently sampled textures drop levels first
+		struct TextureStreamingBudget
+		{
+			uint64_t bytes;
+		};
+
 		template<typename T>
 		struct CallMethod;
 
@@ -176,7 +318,7 @@ namespace render
 #define RENDER_ENGINE_OBJECT(x) AddObject<ObjectType::x>,
 		using Command = std::variant<
 #include "render_engine_objects.inl"
-			Load, Image, Geometry, ObjectsUpdate, SetActiveCameraNode
+			Load, LoadFile, Image, Geometry, ObjectsUpdate, SetActiveCameraNode, TextureStreamingBudget
 		>;
 	}
 	
@@ -212,6 +354,8 @@ namespace render
 
 		void QueueCommand(const command::Command& render_command);
 
+		RenderStats GetStats();
+
 		~RenderEngine();
 
 		bool VKInitSuccess();
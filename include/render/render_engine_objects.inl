@@ -13,6 +13,8 @@ RENDER_ENGINE_OBJECT(Bitmap)
 RENDER_ENGINE_OBJECT(StaticModel)
 RENDER_ENGINE_OBJECT(UIPanel)
 RENDER_ENGINE_OBJECT(DbgPoints)
+RENDER_ENGINE_OBJECT(Light)
+RENDER_ENGINE_OBJECT(AnimatedModel)
 
 
 
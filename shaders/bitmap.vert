@@ -1,8 +1,8 @@
 #version 450
 
-layout(set = 0, binding = 0) uniform ModelMatrix_0 {
-    mat4 matrix;
-} transformUBO;
+layout(std430, set = 0, binding = 0) readonly buffer ModelMatrix_Data {
+    mat4 model_mats[];
+} objects;
 
 layout(set = 2, binding = 0) uniform BitmapAtlas_0 {
     vec2 position;
@@ -20,7 +20,7 @@ layout(location = 2) out vec4 fragColor;
 
 void main() {
     //gl_Position = vec4(positions[gl_VertexIndex], 0, 1);
-    gl_Position = transformUBO.matrix * vec4(inPosition.xy, 0, 1);
+    gl_Position = objects.model_mats[gl_InstanceIndex] * vec4(inPosition.xy, 0, 1);
 
     gl_Position.xy = gl_Position.xy * 2 - 1;
     gl_Position.z = 0.1;
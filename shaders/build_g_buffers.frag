@@ -1,13 +1,35 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 #define M_PI 3.1415926535897932384626433832795
 
-layout(set = 2, binding = 0) uniform Material_0 {
-	int flags;
-} material;
+#include "g_buffer.glsl"
 
-layout(set = 2, binding = 1) uniform sampler2D Material_albedo;
-layout(set = 2, binding = 2) uniform sampler2D Material_metallic_roughness;
-layout(set = 2, binding = 3) uniform sampler2D Material_normal_map;
+struct MaterialData
+{
+	vec4 color;
+	uint albedo_index;
+	uint metallic_roughness_index;
+	uint normal_map_index;
+	uint flags;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer Materials_Data {
+	MaterialData materials[];
+} materials;
+
+layout(set = 2, binding = 1) uniform sampler2D Materials_textures[];
+
+// finest lod sampled per texture, relative to the resident levels, read back by texture streaming
+layout(std430, set = 2, binding = 2) buffer Materials_Feedback {
+	int min_lods[];
+} feedback;
+
+layout( push_constant ) uniform constants
+{
+	layout(offset = 128) float metallic;
+	float roughness;
+	uint material_index;
+} PushConstants;
 
 
 //layout(set = 3, binding = 0) uniform LightPositionAndViewProjMat_0 {
@@ -23,14 +45,20 @@ layout(set = 4, binding = 0) uniform sampler2D Environement_envSampler;
 
 layout(location = 0) in vec3 fragPosition;
 layout(location = 1) in vec3 fragNorm;
-layout(location = 2) in vec3 fragTangent;
+layout(location = 2) in vec4 fragTangent;
 layout(location = 3) in vec2 fragTexCoord;
 layout(location = 4) in vec3 fragToEyeVec;
 
+#ifdef G_BUFFER_COMPACT
+layout(location = 0) out vec4 G_albedo;
+layout(location = 1) out vec2 G_normal;
+layout(location = 2) out vec2 G_metallic_roughness;
+#else
 layout(location = 0) out vec4 G_albedo;
 layout(location = 1) out vec4 G_position;
 layout(location = 2) out vec4 G_normal;
 layout(location = 3) out vec4 G_metallic_roughness;
+#endif
 	
 
 float rand(vec2 co){
@@ -63,6 +91,8 @@ float LinearizeShadow(float near, float far, float shadow)
 void main() {
 
 
+	MaterialData material = materials.materials[PushConstants.material_index];
+
 	bool emit = (material.flags & (1 << 0)) != 0;
 	bool contains_normal_map = (material.flags & (1 << 1)) != 0;
 
@@ -96,10 +126,24 @@ void main() {
 
 	vec4 mirror_color =vec4(texture(Environement_envSampler,mirrorTexCoord).rgb, 1.0);
 
-	vec4 albedo = texture(Material_albedo, fragTexCoord).rgba;
-	vec4 metallic_roughness = texture(Material_metallic_roughness, fragTexCoord).rgba;
-	vec4 normal_map_raw = texture(Material_normal_map, fragTexCoord).rgba;
-	vec3 normal_map_value = normalize(2 * (normal_map_raw.xyz - 0.5)); 
+	vec4 albedo = texture(Materials_textures[nonuniformEXT(material.albedo_index)], fragTexCoord).rgba;
+	vec4 metallic_roughness = texture(Materials_textures[nonuniformEXT(material.metallic_roughness_index)], fragTexCoord).rgba;
+	vec4 normal_map_raw = texture(Materials_textures[nonuniformEXT(material.normal_map_index)], fragTexCoord).rgba;
+
+	int albedo_lod = int(floor(textureQueryLod(Materials_textures[nonuniformEXT(material.albedo_index)], fragTexCoord).y));
+	int metallic_roughness_lod = int(floor(textureQueryLod(Materials_textures[nonuniformEXT(material.metallic_roughness_index)], fragTexCoord).y));
+	int normal_map_lod = int(floor(textureQueryLod(Materials_textures[nonuniformEXT(material.normal_map_index)], fragTexCoord).y));
+
+	// one pixel of each 4x4 block reports, atomics only when the lod gets finer
+	if ((int(gl_FragCoord.x) & 3) == 0 && (int(gl_FragCoord.y) & 3) == 0)
+	{
+		if (albedo_lod < feedback.min_lods[material.albedo_index]) atomicMin(feedback.min_lods[material.albedo_index], albedo_lod);
+		if (metallic_roughness_lod < feedback.min_lods[material.metallic_roughness_index]) atomicMin(feedback.min_lods[material.metallic_roughness_index], metallic_roughness_lod);
+		if (normal_map_lod < feedback.min_lods[material.normal_map_index]) atomicMin(feedback.min_lods[material.normal_map_index], normal_map_lod);
+	}
+	// z is rebuilt from xy so two channel (BC5) normal maps work as well
+	vec2 normal_map_xy = 2 * (normal_map_raw.xy - 0.5);
+	vec3 normal_map_value = normalize(vec3(normal_map_xy, sqrt(max(0.0, 1.0 - dot(normal_map_xy, normal_map_xy))))); 
 
 
 	if(contains_normal_map)
@@ -107,7 +151,8 @@ void main() {
 		vec3 N = normal;
 		vec3 T = normalize(fragTangent.xyz);
 		T = normalize(T - dot(T, N) * N);
-		vec3 B = cross(N, T);
+		// w holds the handedness, negative for mirrored texture coordinates
+		vec3 B = cross(N, T) * (fragTangent.w < 0.0 ? -1.0 : 1.0);
 
 		mat3 TBN = mat3(T, B, N);
 		normal = normalize(TBN * normal_map_value);
@@ -140,7 +185,12 @@ void main() {
 	//vec4 diffuse = vec4(color,color,color, 1.0) * (0.1 + 0.9 * diffuseMultiplier);
 	
 	G_albedo = vec4(1,1,0,1);//albedo;
+#ifdef G_BUFFER_COMPACT
+	G_normal = OctahedralEncode(normal);
+	G_metallic_roughness = metallic_roughness.bg;
+#else
 	G_position = vec4(fragPosition, 1);
 	G_normal = vec4(normal, 1);
 	G_metallic_roughness = metallic_roughness;
+#endif
 }
\ No newline at end of file
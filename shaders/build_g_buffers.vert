@@ -5,9 +5,9 @@ layout(set = 0, binding = 0) uniform CameraPositionAndViewProjMat {
     mat4 projViewMatrix;
 } camera;
 
-layout(set = 1, binding = 0) uniform ModelMatrix {
-    mat4 modelMatrix;
-} object;
+layout(std430, set = 1, binding = 0) readonly buffer ModelMatrix_Data {
+    mat4 model_mats[];
+} objects;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
@@ -16,7 +16,7 @@ layout(location = 3) in vec2 inTexCoord;
 
 layout(location = 0) out vec3 fragPosition;
 layout(location = 1) out vec3 fragNorm;
-layout(location = 2) out vec3 fragTangent;
+layout(location = 2) out vec4 fragTangent;
 layout(location = 3) out vec2 fragTexCoord;
 layout(location = 4) out vec3 fragToEyeVec;
 
@@ -26,12 +26,14 @@ void main() {
 
 	vec4 offset = vec4(0,0,0,0);
 
-    gl_Position = camera.projViewMatrix * object.modelMatrix * vec4(inPosition, 1.0) + offset;
+	mat4 modelMatrix = objects.model_mats[gl_InstanceIndex];
 
-	fragPosition = (object.modelMatrix * vec4(inPosition, 1.0)).xyz +  + offset.xyz;
+    gl_Position = camera.projViewMatrix * modelMatrix * vec4(inPosition, 1.0) + offset;
+
+	fragPosition = (modelMatrix * vec4(inPosition, 1.0)).xyz +  + offset.xyz;
 	fragToEyeVec = camera.position.xyz - fragPosition;
 
-	fragNorm = (mat3(object.modelMatrix) * vec3(inNormal));
-	fragTangent = (mat3(object.modelMatrix) * vec3(inTangent.xyz));
+	fragNorm = (mat3(modelMatrix) * vec3(inNormal));
+	fragTangent = vec4(mat3(modelMatrix) * inTangent.xyz, inTangent.w);
 	fragTexCoord = inTexCoord;
 }
\ No newline at end of file
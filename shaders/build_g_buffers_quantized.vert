@@ -0,0 +1,40 @@
+#version 450
+
+#include "g_buffer.glsl"
+
+layout(set = 0, binding = 0) uniform CameraPositionAndViewProjMat {
+    vec4 position;
+    mat4 projViewMatrix;
+} camera;
+
+layout(std430, set = 1, binding = 0) readonly buffer ModelMatrix_Data {
+    mat4 model_mats[];
+} objects;
+
+// model matrices of quantized meshes include the dequantization, w of the position is the tangent handedness
+layout(location = 0) in vec4 /*quantized*/ inPosition;
+layout(location = 1) in vec2 /*quantized*/ inNormal;
+layout(location = 2) in vec2 /*quantized*/ inTangent;
+layout(location = 3) in vec2 /*quantized*/ inTexCoord;
+
+layout(location = 0) out vec3 fragPosition;
+layout(location = 1) out vec3 fragNorm;
+layout(location = 2) out vec4 fragTangent;
+layout(location = 3) out vec2 fragTexCoord;
+layout(location = 4) out vec3 fragToEyeVec;
+
+void main() {
+
+	mat4 modelMatrix = objects.model_mats[gl_InstanceIndex];
+	vec4 position = modelMatrix * vec4(inPosition.xyz, 1.0);
+
+	gl_Position = camera.projViewMatrix * position;
+
+	fragPosition = position.xyz;
+	fragToEyeVec = camera.position.xyz - fragPosition;
+
+	// the dequantization scale is uniform, it only changes the length of transformed directions
+	fragNorm = normalize(mat3(modelMatrix) * OctahedralDecode(inNormal));
+	fragTangent = vec4(normalize(mat3(modelMatrix) * OctahedralDecode(inTangent)), inPosition.w);
+	fragTexCoord = inTexCoord;
+}
@@ -1,19 +1,96 @@
 #version 450
 
 #include "ggx.glsl"
-
-layout(set = 0, binding = 0) uniform sampler2D GBuffers_albedo;
-layout(set = 0, binding = 1) uniform sampler2D GBuffers_position;
-layout(set = 0, binding = 2) uniform sampler2D GBuffers_normal;
-layout(set = 0, binding = 3) uniform sampler2D GBuffers_metallic_roughness;
+#include "g_buffer.glsl"
+#include "light_clusters.glsl"
+
+// written by the previous subpass of the same render pass, read at the current pixel
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput GBuffers_albedo;
+#ifdef G_BUFFER_COMPACT
+layout(input_attachment_index = 1, set = 0, binding = 1) uniform subpassInput GBuffers_depth;
+#else
+layout(input_attachment_index = 1, set = 0, binding = 1) uniform subpassInput GBuffers_position;
+#endif
+layout(input_attachment_index = 2, set = 0, binding = 2) uniform subpassInput GBuffers_normal;
+layout(input_attachment_index = 3, set = 0, binding = 3) uniform subpassInput GBuffers_metallic_roughness;
 
 layout(set = 1, binding = 0) uniform CameraPositionAndViewProjMat_0 {
     vec4 position;
     mat4 projViewMatrix;
+    mat4 invProjViewMatrix;
 } camera;
 
+vec3 ReadPosition(vec2 ndc)
+{
+#ifdef G_BUFFER_COMPACT
+	vec4 world_position = camera.invProjViewMatrix * vec4(ndc, subpassLoad(GBuffers_depth).r, 1);
+	return world_position.xyz / world_position.w;
+#else
+	return subpassLoad(GBuffers_position).xyz;
+#endif
+}
+
+vec3 ReadNormal()
+{
+#ifdef G_BUFFER_COMPACT
+	return OctahedralDecode(subpassLoad(GBuffers_normal).rg);
+#else
+	return normalize(subpassLoad(GBuffers_normal).xyz);
+#endif
+}
+
+// x - metallic, y - roughness
+vec2 ReadMetallicRoughness()
+{
+#ifdef G_BUFFER_COMPACT
+	return subpassLoad(GBuffers_metallic_roughness).rg;
+#else
+	return subpassLoad(GBuffers_metallic_roughness).bg;
+#endif
+}
+
 layout(set = 2, binding = 0) uniform sampler2D Environement_envSampler;
 
+struct LightData
+{
+	vec4 position_radius;
+	vec4 color_intensity;
+};
+
+layout(std430, set = 3, binding = 0) readonly buffer Lights_Data {
+	uint count;
+	uint padding[3];
+	LightData lights[];
+} lights;
+
+layout(set = 3, binding = 1) uniform Lights_View {
+	mat4 view;
+	vec4 projection_params;
+	uvec4 grid_size;
+} light_view;
+
+layout(std430, set = 4, binding = 0) readonly buffer LightClusters_Data {
+	uint counts[LIGHT_CLUSTERS_COUNT];
+	uint indices[];
+} clusters;
+
+uint GetClusterIndex(vec3 position)
+{
+	vec4 clip_position = camera.projViewMatrix * vec4(position, 1);
+
+	uvec3 grid_size = light_view.grid_size.xyz;
+	float near_plane = light_view.projection_params.z;
+	float far_plane = light_view.projection_params.w;
+
+	vec2 ndc = clip_position.xy / clip_position.w;
+	uvec2 tile = uvec2(clamp((ndc * 0.5 + 0.5) * vec2(grid_size.xy), vec2(0), vec2(grid_size.xy) - 1));
+
+	float slice = log(max(clip_position.w, near_plane) / near_plane) / log(far_plane / near_plane) * grid_size.z;
+	uint depth_slice = uint(clamp(slice, 0, grid_size.z - 1));
+
+	return tile.x + grid_size.x * (tile.y + grid_size.y * depth_slice);
+}
+
 
 layout(location = 0) in vec3 fragPosition;
 
@@ -21,125 +98,82 @@ layout(location = 0) out vec4 outColor;
 
 void main() {
 
-	vec4 texColor = texture(GBuffers_albedo, (fragPosition.xy + 1));
+	vec3 unit_normal = ReadNormal();
+	
+	vec3 position = ReadPosition(fragPosition.xy);
+	vec3 albedo = subpassLoad(GBuffers_albedo).xyz;
 
-	if(fragPosition.x > 0)
-		texColor = texture(GBuffers_position, (fragPosition.xy ));
+	vec2 metallic_roughness = ReadMetallicRoughness();
+	
+	vec3 unit_view_direction = normalize(camera.position.xyz - position);
 
-	if(fragPosition.y > 0)
-		texColor = texture(GBuffers_normal, (fragPosition.xy));
 
-	float delta;
-	int delta_ind;
+	float roughness = 0.01 + metallic_roughness.y * 0.99;
+	//roughness = 0.01;
+	vec3 R0 = vec3(0.1, 0.1, 0.1);
 	
-	outColor =  texColor;
-	
-	if(fragPosition.x > 0 && fragPosition.y > 0)
-	{
-		
-		vec3 light_pos_1 = vec3(1,2,1);
-		vec3 light_pos_2 = vec3(-2,1,2);
-		vec3 light_pos_3 = vec3(0,-2,1.5);
-		
-		vec3 unit_normal = normalize(texture(GBuffers_normal, (fragPosition.xy)).xyz); 
-		
-		vec3 position = texture(GBuffers_position, (fragPosition.xy)).xyz;
-		//vec3 albedo = texture(GBuffers_albedo, (fragPosition.xy)).xyz;
-		vec3 albedo = textureLod(GBuffers_albedo, (fragPosition.xy), 7).xyz;
-
-		vec3 metallic_roughness = texture(GBuffers_metallic_roughness, (fragPosition.xy)).xyz;
-		
-		vec3 unit_view_direction = normalize(camera.position.xyz - position);
-
-
-		float roughness = 0.01 + metallic_roughness.g * 0.99;
-		//roughness = 0.01;
-		vec3 R0 = vec3(0.1, 0.1, 0.1);
-		
-
-
-		vec3 mirror_dir = 2 * dot(unit_normal, unit_view_direction) * unit_normal - unit_view_direction;
-		
-
-		float mirror_tex_y = -asin(mirror_dir.z) / M_PI + 0.5;
-		vec2 mirrorNormalizeFlatDir = normalize(mirror_dir.xy);
-		float mirror_tex_x = (mirrorNormalizeFlatDir.x > 0 ? acos(mirrorNormalizeFlatDir.y) : (2*M_PI - acos(mirrorNormalizeFlatDir.y))) / (2 * M_PI);
+
+
+	vec3 mirror_dir = 2 * dot(unit_normal, unit_view_direction) * unit_normal - unit_view_direction;
 	
-		vec2 mirrorTexCoord = vec2(mirror_tex_x, mirror_tex_y);
 
-		//mirrorTexCoord = mirrorTexCoord + 0.003*(rand2(mirrorTexCoord) - 0.5);
+	float mirror_tex_y = -asin(mirror_dir.z) / M_PI + 0.5;
+	vec2 mirrorNormalizeFlatDir = normalize(mirror_dir.xy);
+	float mirror_tex_x = (mirrorNormalizeFlatDir.x > 0 ? acos(mirrorNormalizeFlatDir.y) : (2*M_PI - acos(mirrorNormalizeFlatDir.y))) / (2 * M_PI);
 
-		vec4 mirror_color = vec4(textureLod(Environement_envSampler,mirrorTexCoord, 6).rgb, 1.0);
+	vec2 mirrorTexCoord = vec2(mirror_tex_x, mirror_tex_y);
 
-		texColor = vec4(0);
+	//mirrorTexCoord = mirrorTexCoord + 0.003*(rand2(mirrorTexCoord) - 0.5);
 
-		float metallic = metallic_roughness.b;
-		//metallic = 1;
+	vec4 mirror_color = vec4(textureLod(Environement_envSampler,mirrorTexCoord, 6).rgb, 1.0);
 
-		vec3 unit_env_light_direction = normalize(mirror_dir);
-		float mirror_brigthness = pow(length(mirror_color.xyz), 5) / 10;
-		vec3 env_color = metallic * mirror_color.xyz * albedo + (1 - metallic) * vec3(mirror_brigthness);
+	vec4 texColor = vec4(0);
 
+	float metallic = metallic_roughness.x;
+	//metallic = 1;
 
-		{
+	vec3 unit_env_light_direction = normalize(mirror_dir);
+	float mirror_brigthness = pow(length(mirror_color.xyz), 5) / 10;
+	vec3 env_color = metallic * mirror_color.xyz * albedo + (1 - metallic) * vec3(mirror_brigthness);
 
-		vec3 kr = F(unit_view_direction, unit_env_light_direction, R0);
 
-		float cook_torrance_no_fresnel = clamp(CookTorrance_GGX_NoFresnel(unit_view_direction, unit_env_light_direction, unit_normal, roughness), 0, 1);
+	{
+
+	vec3 kr = F(unit_view_direction, unit_env_light_direction, R0);
 
-		vec3 fr = env_color * cook_torrance_no_fresnel;
-		texColor += vec4(kr * fr , 1);
+	float cook_torrance_no_fresnel = clamp(CookTorrance_GGX_NoFresnel(unit_view_direction, unit_env_light_direction, unit_normal, roughness), 0, 1);
 
-		}
+	vec3 fr = env_color * cook_torrance_no_fresnel;
+	texColor += vec4(kr * fr , 1);
+
+	}
+
+
+	uint cluster_index = GetClusterIndex(position);
+	uint cluster_lights_count = clusters.counts[cluster_index];
+	uint max_lights_per_cluster = light_view.grid_size.w;
+
+	for (uint i = 0; i < cluster_lights_count; i++)
+	{
+		LightData light = lights.lights[clusters.indices[cluster_index * max_lights_per_cluster + i]];
 
+		vec3 light_pos = light.position_radius.xyz;
+		float light_radius = light.position_radius.w;
 
-		{
-		vec3 unit_light_direction = normalize(light_pos_1 - position);
+		vec3 unit_light_direction = normalize(light_pos - position);
 
-		float light_distance = length(light_pos_1 - position);
-		float attenuation = 1 / (0.001 + light_distance * light_distance);
+		float light_distance = length(light_pos - position);
+		float distance_falloff = clamp(1 - pow(light_distance / light_radius, 4), 0, 1);
+		float attenuation = light.color_intensity.w * distance_falloff * distance_falloff / (0.001 + light_distance * light_distance);
 
 		vec3 kr = F(unit_view_direction, unit_env_light_direction, R0);
 		vec3 kd = 1- kr;
-		vec3 krfr = CookTorrance_GGX(unit_view_direction, unit_light_direction, unit_normal, roughness, R0);
+		vec3 krfr = attenuation * CookTorrance_GGX(unit_view_direction, unit_light_direction, unit_normal, roughness, R0);
 
 		vec3 fd = (1 - metallic) * attenuation * albedo * clamp(dot(unit_normal, unit_light_direction),0,1);
 
-		texColor += vec4(kd*fd + krfr, 1);
-		}
-//
-//				{
-//		vec3 unit_light_direction = normalize(light_pos_2 - position);
-//
-//		float light_distance = length(light_pos_2 - position);
-//		float attenuation = 1 / (0.001 + light_distance * light_distance);
-//
-//		vec3 kr = F(unit_light_direction, unit_normal, R0);
-//		vec3 kd = 1- kr;
-//		vec3 krfr = attenuation * albedo * CookTorrance_GGX(unit_view_direction, unit_light_direction, unit_normal, roughness, R0);
-//
-//		vec3 fd = (1 - metalness) * attenuation * albedo * clamp(dot(unit_normal, unit_light_direction),0,1);
-//
-//		texColor += vec4(kd*fd + krfr, 1);
-//		}
-//
-//				{
-//		vec3 unit_light_direction = normalize(light_pos_3 - position);
-//
-//		float light_distance = length(light_pos_3 - position);
-//		float attenuation = 1 / (0.001 + light_distance * light_distance);
-//
-//		vec3 kr = F(unit_light_direction, unit_normal, R0);
-//		vec3 kd = 1- kr;
-//		vec3 krfr = attenuation * albedo * CookTorrance_GGX(unit_view_direction, unit_light_direction, unit_normal, roughness, R0);
-//
-//		vec3 fd = (1 - metalness) * attenuation * albedo * clamp(dot(unit_normal, unit_light_direction),0,1);
-//
-//		texColor += vec4(kd*fd + krfr, 1);
-//		}
-
-			outColor =  vec4(roughness,roughness,roughness, 1);
-			outColor = texColor;
+		texColor += vec4(light.color_intensity.rgb * (kd*fd + krfr), 0);
 	}
 
-}
\ No newline at end of file
+	outColor = texColor;
+}
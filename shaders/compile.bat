@@ -6,10 +6,8 @@ glslc.exe test.frag -o frag.spv
 glslc.exe test_2.vert -o vert_2.spv
 glslc.exe test_2.frag -o frag_2.spv
 glslc.exe color.vert -o color.vert.spv
-glslc.exe color_skin.vert -o color_skin.vert.spv
 glslc.exe color.frag -o color.frag.spv
 glslc.exe shadow.vert -o shadow.vert.spv
-glslc.exe shadow_skin.vert -o shadow_skin.vert.spv
 glslc.exe shadow.frag -o shadow.frag.spv
 glslc.exe ui.vert -o ui.vert.spv
 glslc.exe ui.frag -o ui.frag.spv
@@ -17,7 +15,15 @@ glslc.exe bitmap.vert -o bitmap.vert.spv
 glslc.exe bitmap.frag -o bitmap.frag.spv
 glslc.exe collect_g_buffers.vert -o collect_g_buffers.vert.spv
 glslc.exe collect_g_buffers.frag -o collect_g_buffers.frag.spv
+glslc.exe -DG_BUFFER_COMPACT collect_g_buffers.frag -o collect_g_buffers.frag.compact.spv
 glslc.exe build_g_buffers.vert -o build_g_buffers.vert.spv
+glslc.exe build_g_buffers_quantized.vert -o build_g_buffers_quantized.vert.spv
 glslc.exe build_g_buffers.frag -o build_g_buffers.frag.spv
+glslc.exe -DG_BUFFER_COMPACT build_g_buffers.frag -o build_g_buffers.frag.compact.spv
+glslc.exe light_culling.comp -o light_culling.comp.spv
+glslc.exe skinning.comp -o skinning.comp.spv
+glslc.exe cube_depth_face.vert -o cube_depth_face.vert.spv
+glslc.exe cube_depth_face_quantized.vert -o cube_depth_face_quantized.vert.spv
+glslc.exe cube_depth_face.frag -o cube_depth_face.frag.spv
 
 popd
\ No newline at end of file
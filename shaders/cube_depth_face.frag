@@ -0,0 +1,7 @@
+#version 450
+
+layout(location = 0) in vec3 fragLightToPosition;
+
+void main() {
+	gl_FragDepth = length(fragLightToPosition);
+}
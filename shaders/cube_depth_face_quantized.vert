@@ -0,0 +1,23 @@
+#version 450
+
+// only the position stream is read, the pushed matrix includes the mesh dequantization
+layout(location = 0) in vec4 /*quantized*/ inPosition;
+
+layout( push_constant ) uniform constants
+{
+	mat4 project_matrix;
+	mat4 view_model_matrix;
+} PushConstants;
+
+// light to position in far plane units, its length is the stored depth
+layout(location = 0) out vec3 fragLightToPosition;
+
+void main() {
+	vec4 light_space_position = PushConstants.view_model_matrix * vec4(inPosition.xyz, 1.0);
+
+	// the far plane of the pushed perspective projection, same for zero-to-one and minus-one-to-one depth
+	float far_plane = PushConstants.project_matrix[3][2] / (PushConstants.project_matrix[2][2] + 1.0);
+
+	fragLightToPosition = light_space_position.xyz / far_plane;
+	gl_Position = PushConstants.project_matrix * light_space_position;
+}
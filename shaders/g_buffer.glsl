@@ -0,0 +1,25 @@
+
+// octahedral mapping of a unit vector to [-1, 1]^2, used for the RG16 normal of the compact layout
+
+vec2 SignNotZero(vec2 v)
+{
+	return vec2(v.x >= 0 ? 1.0 : -1.0, v.y >= 0 ? 1.0 : -1.0);
+}
+
+vec2 OctahedralEncode(vec3 unit_vector)
+{
+	vec2 projected = unit_vector.xy / (abs(unit_vector.x) + abs(unit_vector.y) + abs(unit_vector.z));
+	return unit_vector.z >= 0 ? projected : (1.0 - abs(projected.yx)) * SignNotZero(projected);
+}
+
+vec3 OctahedralDecode(vec2 encoded)
+{
+	vec3 unit_vector = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+	if (unit_vector.z < 0)
+	{
+		unit_vector.xy = (1.0 - abs(unit_vector.yx)) * SignNotZero(unit_vector.xy);
+	}
+
+	return normalize(unit_vector);
+}
@@ -0,0 +1,7 @@
+// should match kLightClusterGrid* and kMaxLightsPerCluster in data_types.h
+
+#define LIGHT_CLUSTER_GRID_X 16
+#define LIGHT_CLUSTER_GRID_Y 9
+#define LIGHT_CLUSTER_GRID_Z 24
+#define LIGHT_CLUSTERS_COUNT (LIGHT_CLUSTER_GRID_X * LIGHT_CLUSTER_GRID_Y * LIGHT_CLUSTER_GRID_Z)
+#define MAX_LIGHTS_PER_CLUSTER 64
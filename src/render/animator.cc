@@ -1,151 +1,208 @@
 #include "animator.h"
 
-template<typename ChannelValueType>
-static int FindFrameIntervalBeginIndex(const render::AnimSampler<ChannelValueType>& sampler, render::Animator::Milliseconds loop_time, int channel_index, std::vector<int>& channels_indexes)
-{
-	if (channel_index >= channels_indexes.size())
-		channels_indexes.push_back(0);
-
-	int frame_interval_begin = channels_indexes[channel_index];
-
-	for (; frame_interval_begin + 1 < sampler.frames.size() && sampler.frames[frame_interval_begin + 1].time < loop_time; frame_interval_begin++) {}
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
-	return frame_interval_begin;
-}
+#include "glm/glm/gtc/matrix_transform.hpp"
 
-template<typename ChannelValueType>
-static auto Interpolate(const render::AnimSampler<ChannelValueType>& sampler, int frame_interval_begin, render::Animator::Milliseconds loop_time, render::Animator::Milliseconds animation_duration, int channel_index, std::vector<int>& channels_indexes)
+namespace
 {
-	if (sampler.interpolation_type == render::InterpolationType::kCubicSpline)
-	{
-		//https://www.khronos.org/registry/glTF/specs/2.0/glTF-2.0.html#appendix-c-interpolation
-
-		int k = 3 * (frame_interval_begin / 3) + 1;
-		int k_pl_1 = k + 3;
-		if (k_pl_1 >= sampler.frames.size()) k_pl_1 = 1;
+	const uint32_t kNoPose = std::numeric_limits<uint32_t>::max();
 
+	glm::vec3 ToValue(const glm::vec3& value)
+	{
+		return value;
+	}
 
-		float tc = static_cast<float>(loop_time.count());
-		float tk = static_cast<float>(sampler.frames[k].time.count());
-
-		float tk_pl_1 = static_cast<float>(sampler.frames[k_pl_1].time.count());
-		if (tk_pl_1 < tk) tk_pl_1 += animation_duration.count();
-
+	glm::quat ToValue(const glm::quat& value)
+	{
+		return value;
+	}
 
-		float td = tk_pl_1 - tk;
+	glm::quat ToValue(const render::QuantizedRotation& value)
+	{
+		return glm::quat(value.xyzw[3] / 32767.0f, value.xyzw[0] / 32767.0f, value.xyzw[1] / 32767.0f, value.xyzw[2] / 32767.0f);
+	}
 
-		float t = (tc - tk) / td;
+	glm::vec3 Mix(const glm::vec3& a, const glm::vec3& b, float t)
+	{
+		return glm::mix(a, b, t);
+	}
 
-		float t2 = t * t;
-		float t3 = t2 * t;
+	// takes the shorter arc
+	glm::quat Mix(const glm::quat& a, const glm::quat& b, float t)
+	{
+		return glm::slerp(a, b, t);
+	}
 
+	glm::vec3 Normalize(const glm::vec3& value)
+	{
+		return value;
+	}
 
-		auto&& bk = sampler.frames[k + 1].value;
-		auto&& ak_pl_1 = sampler.frames[k_pl_1 - 1].value;
+	glm::quat Normalize(const glm::quat& value)
+	{
+		return glm::normalize(value);
+	}
 
-		auto&& vk = sampler.frames[k].value;
-		auto&& vk_pl_1 = sampler.frames[k_pl_1].value;
+	// Last key at or before time, which is inside the channel times. The cursor and the key after it are tried
+	// before the binary search, as time moves forward by less than a key between most updates.
+	uint32_t FindKey(const std::vector<float>& times, float time, uint32_t& cursor)
+	{
+		auto&& is_key = [&](uint32_t key) { return key + 1 < times.size() && times[key] <= time && time < times[key + 1]; };
 
+		if (is_key(cursor))
+			return cursor;
 
-		auto vt = (2 * t3 - 3 * t2 + 1) * vk + td * (t3 - 2 * t2 + t) * bk + (-2 * t3 + 3 * t2) * vk_pl_1 + td * (t3 - t2) * ak_pl_1;
+		if (is_key(cursor + 1))
+			return ++cursor;
 
-		return vt;
+		cursor = static_cast<uint32_t>(std::upper_bound(times.begin(), times.end(), time) - times.begin()) - 1;
+		return cursor;
 	}
-	else
+
+	//https://www.khronos.org/registry/glTF/specs/2.0/glTF-2.0.html#appendix-c-interpolation
+	template<typename ValueType>
+	auto Sample(const render::AnimationChannel<ValueType>& channel, float time, uint32_t& cursor)
 	{
-		assert(false);
-	}
+		bool is_cubic = channel.interpolation_type == render::InterpolationType::kCubicSpline;
+		auto&& get_value = [&](size_t key) { return ToValue(channel.values[is_cubic ? 3 * key + 1 : key]); };
 
-	return sampler.frames[frame_interval_begin].value;
-}
+		if (time <= channel.times.front())
+			return get_value(0);
 
-template<typename ChannelValueType>
-static auto GetChannelValue(const render::AnimSampler<ChannelValueType>& sampler, render::Animator::TimePoint start_time, render::Animator::TimePoint current_time, int channel_index, std::vector<int>& channels_indexes)
-{
-	render::Animator::Milliseconds time_since_start = std::chrono::duration_cast<render::Animator::Milliseconds>(current_time - start_time);
+		if (time >= channel.times.back())
+			return get_value(channel.times.size() - 1);
 
-	render::Animator::Milliseconds anim_duration = (sampler.frames.back().time - sampler.frames.front().time);
+		uint32_t key = FindKey(channel.times, time, cursor);
 
-	render::Animator::Milliseconds current_loop_time = time_since_start - (time_since_start / anim_duration) * anim_duration;
+		float td = channel.times[key + 1] - channel.times[key];
+		float t = (time - channel.times[key]) / td;
 
-	int frame_interval_begin = FindFrameIntervalBeginIndex<ChannelValueType>(sampler, current_loop_time, channel_index, channels_indexes);
+		switch (channel.interpolation_type)
+		{
+		case render::InterpolationType::kStep:
+			return get_value(key);
+		case render::InterpolationType::kLinear:
+			return Mix(get_value(key), get_value(key + 1), t);
+		default:
+		{
+			float t2 = t * t;
+			float t3 = t2 * t;
 
-	return Interpolate<ChannelValueType>(sampler, frame_interval_begin, current_loop_time, anim_duration, channel_index, channels_indexes);
+			auto&& out_tangent = ToValue(channel.values[3 * key + 2]);
+			auto&& in_tangent = ToValue(channel.values[3 * (key + 1)]);
 
+			return Normalize((2 * t3 - 3 * t2 + 1) * get_value(key) + td * (t3 - 2 * t2 + t) * out_tangent + (-2 * t3 + 3 * t2) * get_value(key + 1) + td * (t3 - t2) * in_tangent);
+		}
+		}
+	}
 }
 
-
-template<>
-static auto GetChannelValue<glm::quat>(const render::AnimSampler<glm::quat>& sampler, render::Animator::TimePoint start_time, render::Animator::TimePoint current_time, int channel_index, std::vector<int>& channels_indexes)
+render::Animator::Animator(const AnimationClip& animation, std::vector<byes::RTM<Node>> animated_nodes): animation_(animation), animated_nodes_(std::move(animated_nodes))
 {
-	render::Animator::Milliseconds time_since_start = std::chrono::duration_cast<render::Animator::Milliseconds>(current_time - start_time);
-
-	render::Animator::Milliseconds anim_duration = (sampler.frames.back().time - sampler.frames.front().time);
-
-	render::Animator::Milliseconds current_loop_time = time_since_start - (time_since_start / anim_duration) * anim_duration;
-
-	int frame_interval_begin = FindFrameIntervalBeginIndex<glm::quat>(sampler, current_loop_time, channel_index, channels_indexes);
+	std::vector<uint32_t> node_pose_indices(animated_nodes_.size(), kNoPose);
+
+	auto&& add_states = [&](auto&& channels, std::vector<ChannelState>& states)
+		{
+			for (auto&& channel : channels)
+			{
+				if (channel.node_index >= animated_nodes_.size() || channel.times.empty())
+				{
+					states.push_back({ kNoPose });
+					continue;
+				}
+
+				uint32_t& pose_index = node_pose_indices[channel.node_index];
+
+				if (pose_index == kNoPose)
+				{
+					pose_index = static_cast<uint32_t>(posed_node_indices_.size());
+					posed_node_indices_.push_back(channel.node_index);
+				}
+
+				states.push_back({ pose_index });
+			}
+		};
+
+	add_states(animation_.translations, translation_states_);
+	add_states(animation_.scales, scale_states_);
+	add_states(animation_.rotations, rotation_states_);
+	add_states(animation_.quantized_rotations, quantized_rotation_states_);
+
+	// node transforms are built from translation, rotation and scale, so they have no shear
+	for (uint32_t node_index : posed_node_indices_)
+	{
+		const glm::mat4& transform = animated_nodes_[node_index]->GetLocalTransform();
 
-	glm::quat cubic_val = Interpolate<glm::quat>(sampler, frame_interval_begin, current_loop_time, anim_duration, channel_index, channels_indexes);
+		glm::vec3 scale(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])));
 
-	//use w component to determine factor for glm::slerp
+		if (glm::determinant(glm::mat3(transform)) < 0.0f)
+		{
+			scale.x = -scale.x;
+		}
 
-	int k = 3 * (frame_interval_begin / 3) + 1;
-	int k_pl_1 = k + 3;
-	if (k_pl_1 >= sampler.frames.size()) k_pl_1 = 1;
+		glm::vec3 axes_scale = glm::vec3(scale.x != 0.0f ? scale.x : 1.0f, scale.y != 0.0f ? scale.y : 1.0f, scale.z != 0.0f ? scale.z : 1.0f);
+		glm::mat3 rotation(glm::vec3(transform[0]) / axes_scale.x, glm::vec3(transform[1]) / axes_scale.y, glm::vec3(transform[2]) / axes_scale.z);
 
-	float factor = (cubic_val.w - sampler.frames[k].value.w) / (sampler.frames[k_pl_1].value.w - sampler.frames[k].value.w);
+		rest_poses_.push_back({ glm::vec3(transform[3]), glm::quat_cast(rotation), scale });
+	}
 
-	return glm::slerp(sampler.frames[k].value, sampler.frames[k_pl_1].value, factor);
+	poses_.resize(rest_poses_.size());
 }
 
-
-render::Animator::Animator(const Animation& animation, std::vector<Node>& animated_nodes): animation_(animation), animated_nodes_(animated_nodes)
+void render::Animator::Start()
 {
+	Start(Clock::now());
 }
 
-void render::Animator::Start()
+void render::Animator::Start(TimePoint explicit_start_time)
 {
-	start_time_ = std::chrono::steady_clock::now();
+	start_time_ = explicit_start_time;
 }
 
 void render::Animator::Update()
 {
-	TimePoint current_time = std::chrono::steady_clock::now();
-	Update(current_time);
+	Update(Clock::now());
 }
 
 void render::Animator::Update(TimePoint explicit_current_time)
 {
-	int channel_index = 0;
-
-	for (auto&& rotation : animation_.rotations)
-	{
-		auto val = GetChannelValue<glm::quat>(rotation, start_time_, explicit_current_time, channel_index, channels_indexes_);
-
-		auto&& node = animated_nodes_[rotation.node_index];
-
-		//node.rotation = glm::normalize(glm::quat(val.w, val.x, val.y, val.z));
-
-		//node.local_transform = glm::translate(glm::identity<glm::mat4>(), node.translation);
-		//node.local_transform *= glm::toMat4(node.rotation);
-		//node.local_transform = glm::scale(node.local_transform, node.scale);
+	float time = std::chrono::duration<float>(explicit_current_time - start_time_).count();
 
-		channel_index++;
-	}
+	Evaluate(animation_.duration > 0.0f ? std::fmod(std::max(time, 0.0f), animation_.duration) : 0.0f);
+}
 
-	for (auto&& translation : animation_.translations)
+void render::Animator::Evaluate(float time)
+{
+	std::copy(rest_poses_.begin(), rest_poses_.end(), poses_.begin());
+
+	auto&& sample_channels = [&](auto&& channels, std::vector<ChannelState>& states, auto&& apply)
+		{
+			for (size_t channel_index = 0; channel_index < channels.size(); channel_index++)
+			{
+				auto&& state = states[channel_index];
+
+				if (state.pose_index != kNoPose)
+				{
+					apply(poses_[state.pose_index], Sample(channels[channel_index], time, state.cursor));
+				}
+			}
+		};
+
+	sample_channels(animation_.translations, translation_states_, [](Pose& pose, const glm::vec3& value) { pose.translation = value; });
+	sample_channels(animation_.scales, scale_states_, [](Pose& pose, const glm::vec3& value) { pose.scale = value; });
+	sample_channels(animation_.rotations, rotation_states_, [](Pose& pose, const glm::quat& value) { pose.rotation = value; });
+	sample_channels(animation_.quantized_rotations, quantized_rotation_states_, [](Pose& pose, const glm::quat& value) { pose.rotation = value; });
+
+	for (size_t pose_index = 0; pose_index < poses_.size(); pose_index++)
 	{
-		auto val = GetChannelValue<glm::vec3>(translation, start_time_, explicit_current_time, channel_index, channels_indexes_);
-
-		auto&& node = animated_nodes_[translation.node_index];
-
-		//node.translation = val;
+		auto&& pose = poses_[pose_index];
 
-		//node.local_transform = glm::translate(glm::identity<glm::mat4>(), node.translation);
-		//node.local_transform *= glm::toMat4(node.rotation);
-		//node.local_transform = glm::scale(node.local_transform, node.scale);
+		glm::mat4 local_transform = glm::translate(glm::identity<glm::mat4>(), pose.translation) * glm::mat4_cast(glm::normalize(pose.rotation));
+		local_transform = glm::scale(local_transform, pose.scale);
 
-		channel_index++;
+		animated_nodes_[posed_node_indices_[pose_index]]->SetLocalTransform(local_transform);
 	}
 }
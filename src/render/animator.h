@@ -8,6 +8,8 @@
 
 namespace render
 {
+	// Plays a clip looped over the nodes it animates, which are indexed like the nodes of the pack the clip came from.
+	// Channels hold their first and last keys outside of their times, nodes without channels keep their transforms.
 	class Animator
 	{
 	public:
@@ -15,23 +17,48 @@ namespace render
 		using Clock = std::chrono::steady_clock;
 		using Duration = std::chrono::steady_clock::duration;
 		using TimePoint = std::chrono::time_point<std::chrono::steady_clock>;
-		using Milliseconds = std::chrono::milliseconds;
 
-		Animator(const Animation& animation, std::vector<Node>& animated_nodes);
+		Animator(const AnimationClip& animation, std::vector<byes::RTM<Node>> animated_nodes);
 
 		void Start();
+		void Start(TimePoint explicit_start_time);
 
 		void Update();
 		void Update(TimePoint explicit_current_time);
 
+		// time in seconds from the clip start, writes local transforms of the animated nodes
+		void Evaluate(float time);
+
 	private:
 
+		struct Pose
+		{
+			glm::vec3 translation;
+			glm::quat rotation;
+			glm::vec3 scale;
+		};
+
+		// key found by the last evaluation, the next one usually finds the same or the following key
+		struct ChannelState
+		{
+			uint32_t pose_index;
+			uint32_t cursor = 0;
+		};
+
 		TimePoint start_time_;
 
-		const Animation& animation_;
-		std::vector<Node>& animated_nodes_;
+		const AnimationClip& animation_;
+		std::vector<byes::RTM<Node>> animated_nodes_;
+
+		// rest transforms of nodes with channels, channels overwrite the parts they animate
+		std::vector<uint32_t> posed_node_indices_;
+		std::vector<Pose> rest_poses_;
+		std::vector<Pose> poses_;
 
-		std::vector<int> channels_indexes_;
+		std::vector<ChannelState> translation_states_;
+		std::vector<ChannelState> scale_states_;
+		std::vector<ChannelState> rotation_states_;
+		std::vector<ChannelState> quantized_rotation_states_;
 	};
 }
 
@@ -0,0 +1,828 @@
+#include "astc_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace render
+{
+	namespace
+	{
+		const unsigned char kErrorColor[4] = { 255, 0, 255, 255 };
+
+		const uint32_t kMaxWeights = 64;
+		const uint32_t kMaxColorValues = 18;
+		const uint32_t kMaxBlockTexels = 12 * 12;
+
+		// bits of the trailing values and whether a trit or a quint is packed with each of them
+		struct IseRange
+		{
+			uint32_t bits;
+			bool trit;
+			bool quint;
+		};
+
+		// levels 2, 3, 4, 5, 6, 8, 10, 12, 16, 20, 24, 32, 40, 48, 64, 80, 96, 128, 160, 192, 256, weights use the first 12
+		const IseRange kIseRanges[21] =
+		{
+			{ 1, false, false }, { 0, true, false }, { 2, false, false }, { 0, false, true }, { 1, true, false },
+			{ 3, false, false }, { 1, false, true }, { 2, true, false }, { 4, false, false }, { 2, false, true },
+			{ 3, true, false }, { 5, false, false }, { 3, false, true }, { 4, true, false }, { 6, false, false },
+			{ 4, false, true }, { 5, true, false }, { 7, false, false }, { 5, false, true }, { 6, true, false },
+			{ 8, false, false },
+		};
+
+		uint32_t GetIseBitCount(const IseRange& range, uint32_t count)
+		{
+			uint32_t result = range.bits * count;
+			if (range.trit)
+				result += (8 * count + 4) / 5;
+			if (range.quint)
+				result += (7 * count + 2) / 3;
+			return result;
+		}
+
+		// reads zeros past the end, the last trit and quint groups of a sequence are truncated
+		class BitReader
+		{
+		public:
+			BitReader(const unsigned char* data, uint32_t begin, uint32_t end) : data_(data), position_(begin), end_(end) {}
+
+			uint32_t Read(uint32_t count)
+			{
+				uint32_t result = 0;
+				for (uint32_t i = 0; i < count; i++, position_++)
+				{
+					if (position_ < end_)
+						result |= uint32_t((data_[position_ >> 3] >> (position_ & 7)) & 1) << i;
+				}
+				return result;
+			}
+
+		private:
+			const unsigned char* data_;
+			uint32_t position_;
+			uint32_t end_;
+		};
+
+		uint32_t ReadBits(const unsigned char* block, uint32_t offset, uint32_t count)
+		{
+			return BitReader(block, offset, 128).Read(count);
+		}
+
+		uint32_t Bit(uint32_t value, uint32_t index)
+		{
+			return (value >> index) & 1;
+		}
+
+		void DecodeTrits(uint32_t t, uint32_t* trits)
+		{
+			uint32_t c;
+			if (((t >> 2) & 7) == 7)
+			{
+				c = (((t >> 5) & 7) << 2) | (t & 3);
+				trits[4] = 2;
+				trits[3] = 2;
+			}
+			else
+			{
+				c = t & 0x1F;
+				if (((t >> 5) & 3) == 3)
+				{
+					trits[4] = 2;
+					trits[3] = Bit(t, 7);
+				}
+				else
+				{
+					trits[4] = Bit(t, 7);
+					trits[3] = (t >> 5) & 3;
+				}
+			}
+
+			if ((c & 3) == 3)
+			{
+				trits[2] = 2;
+				trits[1] = Bit(c, 4);
+				trits[0] = (Bit(c, 3) << 1) | (Bit(c, 2) & ~Bit(c, 3) & 1);
+			}
+			else if (((c >> 2) & 3) == 3)
+			{
+				trits[2] = 2;
+				trits[1] = 2;
+				trits[0] = c & 3;
+			}
+			else
+			{
+				trits[2] = Bit(c, 4);
+				trits[1] = (c >> 2) & 3;
+				trits[0] = (Bit(c, 1) << 1) | (Bit(c, 0) & ~Bit(c, 1) & 1);
+			}
+		}
+
+		void DecodeQuints(uint32_t q, uint32_t* quints)
+		{
+			if (((q >> 1) & 3) == 3 && ((q >> 5) & 3) == 0)
+			{
+				quints[2] = (Bit(q, 0) << 2) | ((Bit(q, 4) & ~Bit(q, 0) & 1) << 1) | (Bit(q, 3) & ~Bit(q, 0) & 1);
+				quints[1] = 4;
+				quints[0] = 4;
+				return;
+			}
+
+			uint32_t c;
+			if (((q >> 1) & 3) == 3)
+			{
+				quints[2] = 4;
+				c = (((q >> 3) & 3) << 3) | ((~(q >> 5) & 3) << 1) | (q & 1);
+			}
+			else
+			{
+				quints[2] = (q >> 5) & 3;
+				c = q & 0x1F;
+			}
+
+			if ((c & 7) == 5)
+			{
+				quints[1] = 4;
+				quints[0] = (c >> 3) & 3;
+			}
+			else
+			{
+				quints[1] = (c >> 3) & 3;
+				quints[0] = c & 7;
+			}
+		}
+
+		// raw bits and the trit or quint of a value, unquantization needs them apart
+		struct IseValue
+		{
+			uint32_t bits;
+			uint32_t tq;
+		};
+
+		void DecodeIse(const unsigned char* data, uint32_t offset, const IseRange& range, uint32_t count, IseValue* values)
+		{
+			BitReader reader(data, offset, offset + GetIseBitCount(range, count));
+			uint32_t n = range.bits;
+
+			if (range.trit)
+			{
+				for (uint32_t first = 0; first < count; first += 5)
+				{
+					uint32_t bits[5];
+					uint32_t t = 0;
+					bits[0] = reader.Read(n);
+					t |= reader.Read(2);
+					bits[1] = reader.Read(n);
+					t |= reader.Read(2) << 2;
+					bits[2] = reader.Read(n);
+					t |= reader.Read(1) << 4;
+					bits[3] = reader.Read(n);
+					t |= reader.Read(2) << 5;
+					bits[4] = reader.Read(n);
+					t |= reader.Read(1) << 7;
+
+					uint32_t trits[5];
+					DecodeTrits(t, trits);
+
+					for (uint32_t i = 0; i < 5 && first + i < count; i++)
+						values[first + i] = { bits[i], trits[i] };
+				}
+			}
+			else if (range.quint)
+			{
+				for (uint32_t first = 0; first < count; first += 3)
+				{
+					uint32_t bits[3];
+					uint32_t q = 0;
+					bits[0] = reader.Read(n);
+					q |= reader.Read(3);
+					bits[1] = reader.Read(n);
+					q |= reader.Read(2) << 3;
+					bits[2] = reader.Read(n);
+					q |= reader.Read(2) << 5;
+
+					uint32_t quints[3];
+					DecodeQuints(q, quints);
+
+					for (uint32_t i = 0; i < 3 && first + i < count; i++)
+						values[first + i] = { bits[i], quints[i] };
+				}
+			}
+			else
+			{
+				for (uint32_t i = 0; i < count; i++)
+					values[i] = { reader.Read(n), 0 };
+			}
+		}
+
+		uint32_t Replicate(uint32_t value, uint32_t from_bits, uint32_t to_bits)
+		{
+			if (from_bits == 0)
+				return 0;
+
+			uint32_t result = 0;
+			int shift = int(to_bits) - int(from_bits);
+			for (; shift > -int(from_bits); shift -= int(from_bits))
+				result |= shift >= 0 ? value << shift : value >> -shift;
+
+			return result & ((1u << to_bits) - 1);
+		}
+
+		// to 0..255
+		uint32_t UnquantizeColor(const IseRange& range, IseValue value)
+		{
+			uint32_t n = range.bits;
+			if (!range.trit && !range.quint)
+				return Replicate(value.bits, n, 8);
+
+			if (n == 0)
+				return value.tq * 255 / (range.trit ? 2 : 4);
+
+			uint32_t a = (value.bits & 1) ? 0x1FF : 0;
+			uint32_t b = value.bits >> 1;
+			uint32_t B = 0;
+			uint32_t C = 0;
+
+			if (range.trit)
+			{
+				switch (n)
+				{
+				case 1: C = 204; break;
+				case 2: B = (b << 8) | (b << 4) | (b << 2) | (b << 1); C = 93; break;
+				case 3: B = (b << 7) | (b << 1) | (b >> 1); C = 44; break;
+				case 4: B = (b << 6) | b; C = 22; break;
+				case 5: B = (b << 5) | (b >> 2); C = 11; break;
+				default: B = (b << 4) | (b >> 4); C = 5; break;
+				}
+			}
+			else
+			{
+				switch (n)
+				{
+				case 1: C = 113; break;
+				case 2: B = (b << 8) | (b << 3) | (b << 2); C = 54; break;
+				case 3: B = (b << 7) | (b << 1) | (b >> 1); C = 26; break;
+				case 4: B = (b << 6) | (b >> 1); C = 13; break;
+				default: B = (b << 5) | (b >> 3); C = 6; break;
+				}
+			}
+
+			uint32_t t = (value.tq * C + B) ^ a;
+			return ((a & 0x80) | (t >> 2)) & 0xFF;
+		}
+
+		// to 0..64
+		uint32_t UnquantizeWeight(const IseRange& range, IseValue value)
+		{
+			uint32_t n = range.bits;
+			uint32_t result;
+
+			if (!range.trit && !range.quint)
+			{
+				result = Replicate(value.bits, n, 6);
+			}
+			else if (n == 0)
+			{
+				return value.tq * (range.trit ? 32 : 16);
+			}
+			else
+			{
+				uint32_t a = (value.bits & 1) ? 0x7F : 0;
+				uint32_t b = value.bits >> 1;
+				uint32_t B = 0;
+				uint32_t C = 0;
+
+				if (range.trit)
+				{
+					switch (n)
+					{
+					case 1: C = 50; break;
+					case 2: B = (b << 6) | (b << 2) | b; C = 23; break;
+					default: B = (b << 5) | b; C = 11; break;
+					}
+				}
+				else
+				{
+					switch (n)
+					{
+					case 1: C = 28; break;
+					default: B = (b << 6) | (b << 1); C = 13; break;
+					}
+				}
+
+				uint32_t t = (value.tq * C + B) ^ a;
+				result = (a & 0x20) | (t >> 2);
+			}
+
+			return result > 32 ? result + 1 : result;
+		}
+
+		struct BlockMode
+		{
+			uint32_t grid_width;
+			uint32_t grid_height;
+			bool dual_plane;
+			uint32_t weight_range;
+		};
+
+		bool DecodeBlockMode(uint32_t mode, BlockMode& result)
+		{
+			uint32_t base_range = Bit(mode, 4);
+			uint32_t high_precision = Bit(mode, 9);
+			uint32_t dual_plane = Bit(mode, 10);
+			uint32_t a = (mode >> 5) & 3;
+			uint32_t width;
+			uint32_t height;
+
+			if ((mode & 3) != 0)
+			{
+				base_range |= (mode & 3) << 1;
+				uint32_t b = (mode >> 7) & 3;
+
+				switch ((mode >> 2) & 3)
+				{
+				case 0: width = b + 4; height = a + 2; break;
+				case 1: width = b + 8; height = a + 2; break;
+				case 2: width = a + 2; height = b + 8; break;
+				default:
+					b &= 1;
+					if (Bit(mode, 8))
+					{
+						width = b + 2;
+						height = a + 2;
+					}
+					else
+					{
+						width = a + 2;
+						height = b + 6;
+					}
+					break;
+				}
+			}
+			else
+			{
+				base_range |= ((mode >> 2) & 3) << 1;
+				if (((mode >> 2) & 3) == 0)
+					return false;
+
+				uint32_t b = (mode >> 9) & 3;
+
+				switch ((mode >> 7) & 3)
+				{
+				case 0: width = 12; height = a + 2; break;
+				case 1: width = a + 2; height = 12; break;
+				case 2:
+					width = a + 6;
+					height = b + 6;
+					dual_plane = 0;
+					high_precision = 0;
+					break;
+				default:
+					switch ((mode >> 5) & 3)
+					{
+					case 0: width = 6; height = 10; break;
+					case 1: width = 10; height = 6; break;
+					default: return false;
+					}
+					break;
+				}
+			}
+
+			if (base_range < 2)
+				return false;
+
+			result.grid_width = width;
+			result.grid_height = height;
+			result.dual_plane = dual_plane != 0;
+			result.weight_range = base_range - 2 + 6 * high_precision;
+			return true;
+		}
+
+		uint32_t Hash52(uint32_t p)
+		{
+			p ^= p >> 15;
+			p -= p << 17;
+			p += p << 7;
+			p += p << 4;
+			p ^= p >> 5;
+			p += p << 16;
+			p ^= p >> 7;
+			p ^= p >> 3;
+			p ^= p << 6;
+			p ^= p >> 17;
+			return p;
+		}
+
+		uint32_t SelectPartition(uint32_t seed, uint32_t x, uint32_t y, uint32_t partition_count, bool small_block)
+		{
+			if (small_block)
+			{
+				x <<= 1;
+				y <<= 1;
+			}
+
+			seed += (partition_count - 1) * 1024;
+			uint32_t rnum = Hash52(seed);
+
+			uint32_t seeds[8];
+			for (uint32_t i = 0; i < 8; i++)
+			{
+				seeds[i] = (rnum >> (4 * i)) & 0xF;
+				seeds[i] *= seeds[i];
+			}
+
+			uint32_t sh1;
+			uint32_t sh2;
+			if (seed & 1)
+			{
+				sh1 = (seed & 2) ? 4 : 5;
+				sh2 = partition_count == 3 ? 6 : 5;
+			}
+			else
+			{
+				sh1 = partition_count == 3 ? 6 : 5;
+				sh2 = (seed & 2) ? 4 : 5;
+			}
+
+			for (uint32_t i = 0; i < 8; i++)
+				seeds[i] >>= (i & 1) ? sh2 : sh1;
+
+			// the z terms of 3D blocks are left out
+			uint32_t a = (seeds[0] * x + seeds[1] * y + (rnum >> 14)) & 0x3F;
+			uint32_t b = (seeds[2] * x + seeds[3] * y + (rnum >> 10)) & 0x3F;
+			uint32_t c = (seeds[4] * x + seeds[5] * y + (rnum >> 6)) & 0x3F;
+			uint32_t d = (seeds[6] * x + seeds[7] * y + (rnum >> 2)) & 0x3F;
+
+			if (partition_count < 4)
+				d = 0;
+			if (partition_count < 3)
+				c = 0;
+
+			if (a >= b && a >= c && a >= d)
+				return 0;
+			if (b >= c && b >= d)
+				return 1;
+			if (c >= d)
+				return 2;
+			return 3;
+		}
+
+		int Clamp255(int value)
+		{
+			return std::clamp(value, 0, 255);
+		}
+
+		void BitTransferSigned(int& a, int& b)
+		{
+			b >>= 1;
+			b |= a & 0x80;
+			a >>= 1;
+			a &= 0x3F;
+			if (a & 0x20)
+				a -= 0x40;
+		}
+
+		void BlueContract(int* color)
+		{
+			color[0] = (color[0] + color[2]) >> 1;
+			color[1] = (color[1] + color[2]) >> 1;
+		}
+
+		// LDR endpoint modes, returns false for HDR ones
+		bool DecodeEndpoints(uint32_t mode, const uint32_t* values, int* e0, int* e1)
+		{
+			int v[8];
+			for (uint32_t i = 0; i < (mode / 4 + 1) * 2; i++)
+				v[i] = int(values[i]);
+
+			switch (mode)
+			{
+			case 0:
+				e0[0] = e0[1] = e0[2] = v[0];
+				e1[0] = e1[1] = e1[2] = v[1];
+				e0[3] = e1[3] = 255;
+				return true;
+			case 1:
+			{
+				int l0 = (v[0] >> 2) | (v[1] & 0xC0);
+				int l1 = std::min(l0 + (v[1] & 0x3F), 255);
+				e0[0] = e0[1] = e0[2] = l0;
+				e1[0] = e1[1] = e1[2] = l1;
+				e0[3] = e1[3] = 255;
+				return true;
+			}
+			case 4:
+				e0[0] = e0[1] = e0[2] = v[0];
+				e1[0] = e1[1] = e1[2] = v[1];
+				e0[3] = v[2];
+				e1[3] = v[3];
+				return true;
+			case 5:
+				BitTransferSigned(v[1], v[0]);
+				BitTransferSigned(v[3], v[2]);
+				e0[0] = e0[1] = e0[2] = v[0];
+				e1[0] = e1[1] = e1[2] = Clamp255(v[0] + v[1]);
+				e0[3] = v[2];
+				e1[3] = Clamp255(v[2] + v[3]);
+				return true;
+			case 6:
+				e0[0] = (v[0] * v[3]) >> 8;
+				e0[1] = (v[1] * v[3]) >> 8;
+				e0[2] = (v[2] * v[3]) >> 8;
+				e1[0] = v[0];
+				e1[1] = v[1];
+				e1[2] = v[2];
+				e0[3] = e1[3] = 255;
+				return true;
+			case 8:
+			case 12:
+			{
+				int a0 = mode == 12 ? v[6] : 255;
+				int a1 = mode == 12 ? v[7] : 255;
+				if (v[1] + v[3] + v[5] >= v[0] + v[2] + v[4])
+				{
+					e0[0] = v[0]; e0[1] = v[2]; e0[2] = v[4]; e0[3] = a0;
+					e1[0] = v[1]; e1[1] = v[3]; e1[2] = v[5]; e1[3] = a1;
+				}
+				else
+				{
+					e0[0] = v[1]; e0[1] = v[3]; e0[2] = v[5]; e0[3] = a1;
+					e1[0] = v[0]; e1[1] = v[2]; e1[2] = v[4]; e1[3] = a0;
+					BlueContract(e0);
+					BlueContract(e1);
+				}
+				return true;
+			}
+			case 9:
+			case 13:
+			{
+				BitTransferSigned(v[1], v[0]);
+				BitTransferSigned(v[3], v[2]);
+				BitTransferSigned(v[5], v[4]);
+
+				int a0 = 255;
+				int a1 = 255;
+				if (mode == 13)
+				{
+					BitTransferSigned(v[7], v[6]);
+					a0 = v[6];
+					a1 = v[6] + v[7];
+				}
+
+				if (v[1] + v[3] + v[5] >= 0)
+				{
+					e0[0] = v[0]; e0[1] = v[2]; e0[2] = v[4]; e0[3] = a0;
+					e1[0] = v[0] + v[1]; e1[1] = v[2] + v[3]; e1[2] = v[4] + v[5]; e1[3] = a1;
+				}
+				else
+				{
+					e0[0] = v[0] + v[1]; e0[1] = v[2] + v[3]; e0[2] = v[4] + v[5]; e0[3] = a1;
+					e1[0] = v[0]; e1[1] = v[2]; e1[2] = v[4]; e1[3] = a0;
+					BlueContract(e0);
+					BlueContract(e1);
+				}
+
+				for (uint32_t channel = 0; channel < 4; channel++)
+				{
+					e0[channel] = Clamp255(e0[channel]);
+					e1[channel] = Clamp255(e1[channel]);
+				}
+				return true;
+			}
+			case 10:
+				e0[0] = (v[0] * v[3]) >> 8;
+				e0[1] = (v[1] * v[3]) >> 8;
+				e0[2] = (v[2] * v[3]) >> 8;
+				e0[3] = v[4];
+				e1[0] = v[0];
+				e1[1] = v[1];
+				e1[2] = v[2];
+				e1[3] = v[5];
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		// bilinear infill of the weight grid to the block texels, one plane at a time
+		void InfillWeights(const uint32_t* grid, uint32_t plane_count, uint32_t plane, uint32_t grid_width, uint32_t grid_height,
+			uint32_t block_width, uint32_t block_height, uint32_t* weights)
+		{
+			uint32_t ds = (1024 + block_width / 2) / (block_width - 1);
+			uint32_t dt = (1024 + block_height / 2) / (block_height - 1);
+
+			auto grid_weight = [&](uint32_t x, uint32_t y)
+			{
+				x = std::min(x, grid_width - 1);
+				y = std::min(y, grid_height - 1);
+				return grid[(y * grid_width + x) * plane_count + plane];
+			};
+
+			for (uint32_t t = 0; t < block_height; t++)
+			{
+				for (uint32_t s = 0; s < block_width; s++)
+				{
+					uint32_t gs = (ds * s * (grid_width - 1) + 32) >> 6;
+					uint32_t gt = (dt * t * (grid_height - 1) + 32) >> 6;
+					uint32_t js = gs >> 4;
+					uint32_t fs = gs & 0xF;
+					uint32_t jt = gt >> 4;
+					uint32_t ft = gt & 0xF;
+
+					uint32_t w11 = (fs * ft + 8) >> 4;
+					uint32_t w10 = ft - w11;
+					uint32_t w01 = fs - w11;
+					uint32_t w00 = 16 - fs - ft + w11;
+
+					uint32_t p00 = grid_weight(js, jt);
+					uint32_t p01 = grid_weight(js + 1, jt);
+					uint32_t p10 = grid_weight(js, jt + 1);
+					uint32_t p11 = grid_weight(js + 1, jt + 1);
+
+					weights[t * block_width + s] = (p00 * w00 + p01 * w01 + p10 * w10 + p11 * w11 + 8) >> 4;
+				}
+			}
+		}
+
+		void FillColor(unsigned char* texels, uint32_t texel_count, const unsigned char* color)
+		{
+			for (uint32_t i = 0; i < texel_count; i++)
+				std::memcpy(texels + i * 4, color, 4);
+		}
+	}
+
+	void DecodeAstcBlock(const unsigned char* block, uint32_t block_width, uint32_t block_height, bool srgb, unsigned char* texels)
+	{
+		uint32_t texel_count = block_width * block_height;
+		uint32_t mode = ReadBits(block, 0, 11);
+
+		// void extent blocks carry one UNORM16 color, the extent coordinates only help filtering and are ignored
+		if ((mode & 0x1FF) == 0x1FC)
+		{
+			if (mode & 0x200)
+			{
+				FillColor(texels, texel_count, kErrorColor);
+				return;
+			}
+
+			unsigned char color[4];
+			for (uint32_t channel = 0; channel < 4; channel++)
+				color[channel] = static_cast<unsigned char>(ReadBits(block, 64 + 16 * channel, 16) >> 8);
+
+			FillColor(texels, texel_count, color);
+			return;
+		}
+
+		BlockMode block_mode;
+		if (!DecodeBlockMode(mode, block_mode) || block_mode.grid_width > block_width || block_mode.grid_height > block_height)
+		{
+			FillColor(texels, texel_count, kErrorColor);
+			return;
+		}
+
+		uint32_t partition_count = ReadBits(block, 11, 2) + 1;
+		uint32_t plane_count = block_mode.dual_plane ? 2 : 1;
+		uint32_t weight_count = block_mode.grid_width * block_mode.grid_height * plane_count;
+		const IseRange& weight_range = kIseRanges[block_mode.weight_range];
+		uint32_t weight_bits = GetIseBitCount(weight_range, weight_count);
+
+		if (weight_count > kMaxWeights || weight_bits < 24 || weight_bits > 96 || (partition_count == 4 && block_mode.dual_plane))
+		{
+			FillColor(texels, texel_count, kErrorColor);
+			return;
+		}
+
+		uint32_t endpoint_modes[4];
+		uint32_t partition_index = 0;
+		uint32_t color_begin;
+		uint32_t below_weights = 128 - weight_bits;
+
+		if (partition_count == 1)
+		{
+			endpoint_modes[0] = ReadBits(block, 13, 4);
+			color_begin = 17;
+		}
+		else
+		{
+			partition_index = ReadBits(block, 13, 10);
+			uint32_t modes_bits = ReadBits(block, 23, 6);
+			color_begin = 29;
+
+			uint32_t base_class = modes_bits & 3;
+			if (base_class == 0)
+			{
+				for (uint32_t i = 0; i < partition_count; i++)
+					endpoint_modes[i] = modes_bits >> 2;
+			}
+			else
+			{
+				// the rest of the per partition modes sits right under the weights
+				uint32_t extra_bits = 3 * partition_count - 4;
+				below_weights -= extra_bits;
+				uint32_t encoded = (modes_bits >> 2) | (ReadBits(block, below_weights, extra_bits) << 4);
+
+				for (uint32_t i = 0; i < partition_count; i++)
+				{
+					uint32_t mode_class = base_class - 1 + Bit(encoded, i);
+					endpoint_modes[i] = (mode_class << 2) | ((encoded >> (partition_count + 2 * i)) & 3);
+				}
+			}
+		}
+
+		uint32_t dual_plane_channel = 0;
+		if (block_mode.dual_plane)
+		{
+			below_weights -= 2;
+			dual_plane_channel = ReadBits(block, below_weights, 2);
+		}
+
+		uint32_t color_value_count = 0;
+		for (uint32_t i = 0; i < partition_count; i++)
+			color_value_count += (endpoint_modes[i] / 4 + 1) * 2;
+
+		if (color_value_count > kMaxColorValues || below_weights <= color_begin)
+		{
+			FillColor(texels, texel_count, kErrorColor);
+			return;
+		}
+
+		// the largest range the endpoint values fit in
+		uint32_t color_bits = below_weights - color_begin;
+		int color_range = 20;
+		while (color_range >= 0 && GetIseBitCount(kIseRanges[color_range], color_value_count) > color_bits)
+			color_range--;
+
+		if (color_range < 0)
+		{
+			FillColor(texels, texel_count, kErrorColor);
+			return;
+		}
+
+		IseValue color_values[kMaxColorValues];
+		DecodeIse(block, color_begin, kIseRanges[color_range], color_value_count, color_values);
+
+		uint32_t unquantized_colors[kMaxColorValues];
+		for (uint32_t i = 0; i < color_value_count; i++)
+			unquantized_colors[i] = UnquantizeColor(kIseRanges[color_range], color_values[i]);
+
+		int endpoints[4][2][4];
+		uint32_t value_offset = 0;
+		for (uint32_t i = 0; i < partition_count; i++)
+		{
+			if (!DecodeEndpoints(endpoint_modes[i], unquantized_colors + value_offset, endpoints[i][0], endpoints[i][1]))
+			{
+				FillColor(texels, texel_count, kErrorColor);
+				return;
+			}
+			value_offset += (endpoint_modes[i] / 4 + 1) * 2;
+		}
+
+		// weights are stored bit reversed from the top of the block
+		unsigned char reversed[16];
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			unsigned char byte = block[15 - i];
+			unsigned char result = 0;
+			for (uint32_t bit = 0; bit < 8; bit++)
+				result |= ((byte >> bit) & 1) << (7 - bit);
+			reversed[i] = result;
+		}
+
+		IseValue weight_values[kMaxWeights];
+		DecodeIse(reversed, 0, weight_range, weight_count, weight_values);
+
+		uint32_t grid[kMaxWeights];
+		for (uint32_t i = 0; i < weight_count; i++)
+			grid[i] = UnquantizeWeight(weight_range, weight_values[i]);
+
+		uint32_t weights[2][kMaxBlockTexels];
+		for (uint32_t plane = 0; plane < plane_count; plane++)
+			InfillWeights(grid, plane_count, plane, block_mode.grid_width, block_mode.grid_height, block_width, block_height, weights[plane]);
+
+		bool small_block = texel_count < 31;
+
+		for (uint32_t y = 0; y < block_height; y++)
+		{
+			for (uint32_t x = 0; x < block_width; x++)
+			{
+				uint32_t texel = y * block_width + x;
+				uint32_t partition = partition_count > 1 ? SelectPartition(partition_index, x, y, partition_count, small_block) : 0;
+
+				for (uint32_t channel = 0; channel < 4; channel++)
+				{
+					uint32_t plane = (block_mode.dual_plane && channel == dual_plane_channel) ? 1 : 0;
+					uint32_t weight = weights[plane][texel];
+
+					// sRGB endpoints are expanded to 16 bits without replication so the top byte is the 8 bit value
+					uint32_t c0 = uint32_t(endpoints[partition][0][channel]);
+					uint32_t c1 = uint32_t(endpoints[partition][1][channel]);
+					c0 = srgb ? (c0 << 8) | 0x80 : c0 * 257;
+					c1 = srgb ? (c1 << 8) | 0x80 : c1 * 257;
+
+					uint32_t value = (c0 * (64 - weight) + c1 * weight + 32) >> 6;
+					texels[texel * 4 + channel] = static_cast<unsigned char>(value >> 8);
+				}
+			}
+		}
+	}
+}
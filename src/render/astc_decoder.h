@@ -0,0 +1,12 @@
+#ifndef RENDER_ENGINE_RENDER_ASTC_DECODER_H_
+#define RENDER_ENGINE_RENDER_ASTC_DECODER_H_
+
+#include <cstdint>
+
+namespace render
+{
+	// Decodes one 16 byte ASTC block of block_width x block_height texels to RGBA8, texels are written row by row.
+	// The LDR profile is decoded, HDR and malformed blocks give the error color like the hardware does.
+	void DecodeAstcBlock(const unsigned char* block, uint32_t block_width, uint32_t block_height, bool srgb, unsigned char* texels);
+}
+#endif  // RENDER_ENGINE_RENDER_ASTC_DECODER_H_
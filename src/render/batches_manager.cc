@@ -116,8 +116,8 @@ namespace render
 	glm::mat4 Node::GetGlobalTransformMatrix() const
 	{
 		if (parent)
-			return parent->GetGlobalTransformMatrix() * local_transform;
+			return parent->GetGlobalTransformMatrix() * local_transform_;
 
-		return local_transform;
+		return local_transform_;
 	}
 }
\ No newline at end of file
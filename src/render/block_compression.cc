@@ -0,0 +1,517 @@
+#include "block_compression.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "global.h"
+#include "render/astc_decoder.h"
+
+namespace render
+{
+	namespace
+	{
+		using Texels = unsigned char[16][4];
+
+		const uint32_t kAstcBlockExtents[14][2] =
+		{
+			{ 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+			{ 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 },
+		};
+
+		bool IsAstc(VkFormat format)
+		{
+			return format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK;
+		}
+
+		// UNORM and SRGB variants alternate starting from 4x4 UNORM
+		Extent GetAstcBlockExtent(VkFormat format)
+		{
+			const uint32_t* extent = kAstcBlockExtents[(format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+			return { extent[0], extent[1] };
+		}
+
+		bool IsAstcSrgb(VkFormat format)
+		{
+			return (format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) % 2 == 1;
+		}
+
+		void Expand565(uint16_t color, unsigned char* rgba)
+		{
+			uint32_t r = (color >> 11) & 0x1F;
+			uint32_t g = (color >> 5) & 0x3F;
+			uint32_t b = color & 0x1F;
+
+			rgba[0] = static_cast<unsigned char>((r << 3) | (r >> 2));
+			rgba[1] = static_cast<unsigned char>((g << 2) | (g >> 4));
+			rgba[2] = static_cast<unsigned char>((b << 3) | (b >> 2));
+			rgba[3] = 255;
+		}
+
+		// BC1 uses three colors and transparent black when c0 <= c1, BC3 color blocks always use four colors
+		void DecodeColorBlock(const unsigned char* block, bool bc1, Texels& texels)
+		{
+			uint16_t c0 = uint16_t(block[0] | (block[1] << 8));
+			uint16_t c1 = uint16_t(block[2] | (block[3] << 8));
+
+			unsigned char colors[4][4];
+			Expand565(c0, colors[0]);
+			Expand565(c1, colors[1]);
+
+			for (int channel = 0; channel < 3; channel++)
+			{
+				if (c0 > c1 || !bc1)
+				{
+					colors[2][channel] = static_cast<unsigned char>((2 * colors[0][channel] + colors[1][channel]) / 3);
+					colors[3][channel] = static_cast<unsigned char>((colors[0][channel] + 2 * colors[1][channel]) / 3);
+				}
+				else
+				{
+					colors[2][channel] = static_cast<unsigned char>((colors[0][channel] + colors[1][channel]) / 2);
+					colors[3][channel] = 0;
+				}
+			}
+
+			colors[2][3] = 255;
+			colors[3][3] = (c0 > c1 || !bc1) ? 255 : 0;
+
+			uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+
+			for (int i = 0; i < 16; i++)
+			{
+				std::memcpy(texels[i], colors[(indices >> (2 * i)) & 3], 4);
+			}
+		}
+
+		// BC4 block, also the alpha block of BC3 and each channel of BC5
+		void DecodeChannelBlock(const unsigned char* block, int channel, Texels& texels)
+		{
+			uint32_t a0 = block[0];
+			uint32_t a1 = block[1];
+
+			unsigned char values[8];
+			values[0] = static_cast<unsigned char>(a0);
+			values[1] = static_cast<unsigned char>(a1);
+
+			if (a0 > a1)
+			{
+				for (uint32_t i = 1; i < 7; i++)
+					values[i + 1] = static_cast<unsigned char>(((7 - i) * a0 + i * a1) / 7);
+			}
+			else
+			{
+				for (uint32_t i = 1; i < 5; i++)
+					values[i + 1] = static_cast<unsigned char>(((5 - i) * a0 + i * a1) / 5);
+
+				values[6] = 0;
+				values[7] = 255;
+			}
+
+			uint64_t indices = 0;
+			for (int i = 0; i < 6; i++)
+			{
+				indices |= uint64_t(block[2 + i]) << (8 * i);
+			}
+
+			for (int i = 0; i < 16; i++)
+			{
+				texels[i][channel] = values[(indices >> (3 * i)) & 7];
+			}
+		}
+
+		// BC7 mode layout: subsets, partition, rotation, index selection, color, alpha bits,
+		// per endpoint and shared p-bits, primary and secondary index bits
+		struct Bc7Mode
+		{
+			uint32_t subsets;
+			uint32_t partition_bits;
+			uint32_t rotation_bits;
+			uint32_t index_selection_bits;
+			uint32_t color_bits;
+			uint32_t alpha_bits;
+			uint32_t endpoint_pbits;
+			uint32_t shared_pbits;
+			uint32_t index_bits;
+			uint32_t index2_bits;
+		};
+
+		const Bc7Mode kBc7Modes[8] =
+		{
+			{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+			{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+			{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+			{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+			{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+			{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+			{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+			{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+		};
+
+		// bit i is the subset of texel i
+		const uint16_t kBc7Partitions2[64] =
+		{
+			0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+			0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+			0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+			0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+		};
+
+		const unsigned char kBc7Partitions3[64][16] =
+		{
+			{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+			{ 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+			{ 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 }, { 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 }, { 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+			{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+			{ 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 }, { 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+			{ 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+			{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 }, { 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+			{ 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+			{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+			{ 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 }, { 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+			{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 }, { 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+			{ 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 }, { 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+			{ 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 }, { 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+			{ 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 }, { 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+			{ 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 }, { 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+			{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 }, { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+			{ 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 }, { 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+			{ 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 }, { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 }, { 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+			{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 }, { 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+			{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 }, { 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+			{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 }, { 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+			{ 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 }, { 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+			{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 }, { 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+			{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+			{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+			{ 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+			{ 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 }, { 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+			{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 },
+		};
+
+		// texels whose index drops its top bit, the first texel is always an anchor
+		const unsigned char kBc7Anchors2[64] =
+		{
+			15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+			15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+			15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+			6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+		};
+
+		const unsigned char kBc7Anchors3[2][64] =
+		{
+			{
+				3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+				3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+				8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+				3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,
+			},
+			{
+				15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+				15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+				15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+				15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8,
+			},
+		};
+
+		const uint32_t kBc7Weights2[4] = { 0, 21, 43, 64 };
+		const uint32_t kBc7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+		const uint32_t kBc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		uint32_t GetBc7Weight(uint32_t index_bits, uint32_t index)
+		{
+			switch (index_bits)
+			{
+			case 2:
+				return kBc7Weights2[index];
+			case 3:
+				return kBc7Weights3[index];
+			default:
+				return kBc7Weights4[index];
+			}
+		}
+
+		// 128 bit block read from the lowest bit up
+		class BlockBitReader
+		{
+		public:
+			explicit BlockBitReader(const unsigned char* block) : block_(block), position_(0) {}
+
+			uint32_t Read(uint32_t count)
+			{
+				uint32_t result = 0;
+				for (uint32_t i = 0; i < count; i++, position_++)
+				{
+					result |= uint32_t((block_[position_ >> 3] >> (position_ & 7)) & 1) << i;
+				}
+				return result;
+			}
+
+		private:
+			const unsigned char* block_;
+			uint32_t position_;
+		};
+
+		unsigned char Bc7Interpolate(uint32_t e0, uint32_t e1, uint32_t weight)
+		{
+			return static_cast<unsigned char>(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+		}
+
+		void DecodeBc7Block(const unsigned char* block, Texels& texels)
+		{
+			uint32_t mode_index = 0;
+			while (mode_index < 8 && !(block[0] & (1 << mode_index)))
+				mode_index++;
+
+			// reserved mode decodes to transparent black
+			if (mode_index == 8)
+			{
+				std::memset(texels, 0, sizeof(Texels));
+				return;
+			}
+
+			const Bc7Mode& mode = kBc7Modes[mode_index];
+			BlockBitReader reader(block);
+			reader.Read(mode_index + 1);
+
+			uint32_t partition = reader.Read(mode.partition_bits);
+			uint32_t rotation = reader.Read(mode.rotation_bits);
+			uint32_t index_selection = reader.Read(mode.index_selection_bits);
+
+			uint32_t endpoint_count = mode.subsets * 2;
+			uint32_t endpoints[6][4];
+
+			for (uint32_t channel = 0; channel < 3; channel++)
+			{
+				for (uint32_t endpoint = 0; endpoint < endpoint_count; endpoint++)
+					endpoints[endpoint][channel] = reader.Read(mode.color_bits);
+			}
+
+			for (uint32_t endpoint = 0; endpoint < endpoint_count; endpoint++)
+				endpoints[endpoint][3] = reader.Read(mode.alpha_bits);
+
+			uint32_t pbits[6] = {};
+			if (mode.endpoint_pbits)
+			{
+				for (uint32_t endpoint = 0; endpoint < endpoint_count; endpoint++)
+					pbits[endpoint] = reader.Read(1);
+			}
+			if (mode.shared_pbits)
+			{
+				for (uint32_t subset = 0; subset < mode.subsets; subset++)
+					pbits[subset * 2] = pbits[subset * 2 + 1] = reader.Read(1);
+			}
+
+			uint32_t pbit_count = mode.endpoint_pbits | mode.shared_pbits;
+			for (uint32_t endpoint = 0; endpoint < endpoint_count; endpoint++)
+			{
+				for (uint32_t channel = 0; channel < 4; channel++)
+				{
+					uint32_t bits = channel < 3 ? mode.color_bits : mode.alpha_bits;
+					if (bits == 0)
+					{
+						endpoints[endpoint][channel] = 255;
+						continue;
+					}
+
+					uint32_t value = (endpoints[endpoint][channel] << pbit_count) | (pbit_count ? pbits[endpoint] : 0);
+					bits += pbit_count;
+					value <<= 8 - bits;
+					endpoints[endpoint][channel] = value | (value >> bits);
+				}
+			}
+
+			uint32_t subsets[16];
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				if (mode.subsets == 2)
+					subsets[i] = (kBc7Partitions2[partition] >> i) & 1;
+				else if (mode.subsets == 3)
+					subsets[i] = kBc7Partitions3[partition][i];
+				else
+					subsets[i] = 0;
+			}
+
+			auto is_anchor = [&](uint32_t i)
+			{
+				if (i == 0)
+					return true;
+				if (mode.subsets == 2)
+					return i == kBc7Anchors2[partition];
+				if (mode.subsets == 3)
+					return i == kBc7Anchors3[0][partition] || i == kBc7Anchors3[1][partition];
+				return false;
+			};
+
+			uint32_t indices[16];
+			for (uint32_t i = 0; i < 16; i++)
+				indices[i] = reader.Read(mode.index_bits - (is_anchor(i) ? 1 : 0));
+
+			uint32_t indices2[16] = {};
+			if (mode.index2_bits)
+			{
+				for (uint32_t i = 0; i < 16; i++)
+					indices2[i] = reader.Read(mode.index2_bits - (i == 0 ? 1 : 0));
+			}
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				const uint32_t* e0 = endpoints[subsets[i] * 2];
+				const uint32_t* e1 = endpoints[subsets[i] * 2 + 1];
+
+				uint32_t color_weight = GetBc7Weight(mode.index_bits, indices[i]);
+				uint32_t alpha_weight = color_weight;
+
+				if (mode.index2_bits)
+				{
+					alpha_weight = GetBc7Weight(mode.index2_bits, indices2[i]);
+					if (index_selection)
+						std::swap(color_weight, alpha_weight);
+				}
+
+				for (uint32_t channel = 0; channel < 3; channel++)
+					texels[i][channel] = Bc7Interpolate(e0[channel], e1[channel], color_weight);
+				texels[i][3] = Bc7Interpolate(e0[3], e1[3], alpha_weight);
+
+				if (rotation)
+					std::swap(texels[i][3], texels[i][rotation - 1]);
+			}
+		}
+	}
+
+	bool IsBlockCompressed(VkFormat format)
+	{
+		return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK;
+	}
+
+	bool IsSampledFormatSupported(const Global& global, VkFormat format)
+	{
+		VkFormatProperties format_properties;
+		vkGetPhysicalDeviceFormatProperties(global.physical_device, format, &format_properties);
+
+		return (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+	}
+
+	bool CanDecodeBlockCompressed(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return true;
+		default:
+			return IsAstc(format);
+		}
+	}
+
+	VkFormat GetDecodedFormat(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return VK_FORMAT_R8G8B8A8_SRGB;
+		default:
+			return IsAstc(format) && IsAstcSrgb(format) ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+		}
+	}
+
+	void DecodeBlockCompressed(VkFormat format, Extent extent, std::span<const unsigned char> blocks, std::span<unsigned char> pixels)
+	{
+		if (!CanDecodeBlockCompressed(format))
+			throw std::runtime_error("failed to decode texture, unsupported block format");
+
+		bool bc1 = format <= VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		bool astc = IsAstc(format);
+		size_t block_size = (bc1 || format == VK_FORMAT_BC4_UNORM_BLOCK) ? 8 : 16;
+		Extent block_extent = astc ? GetAstcBlockExtent(format) : Extent{ 4, 4 };
+
+		uint32_t blocks_x = (extent.width + block_extent.width - 1) / block_extent.width;
+		uint32_t blocks_y = (extent.height + block_extent.height - 1) / block_extent.height;
+
+		if (blocks.size() < size_t(blocks_x) * blocks_y * block_size)
+			throw std::runtime_error("failed to decode texture, not enough block data");
+
+		if (pixels.size() < size_t(extent.width) * extent.height * 4)
+			throw std::runtime_error("failed to decode texture, output is too small");
+
+		Texels texels;
+		unsigned char astc_texels[12 * 12][4];
+		const unsigned char (*block_texels)[4] = astc ? astc_texels : texels;
+
+		for (uint32_t block_y = 0; block_y < blocks_y; block_y++)
+		{
+			for (uint32_t block_x = 0; block_x < blocks_x; block_x++)
+			{
+				const unsigned char* block = blocks.data() + (size_t(block_y) * blocks_x + block_x) * block_size;
+
+				if (astc)
+				{
+					DecodeAstcBlock(block, block_extent.width, block_extent.height, IsAstcSrgb(format), astc_texels[0]);
+				}
+				else
+				{
+					for (auto&& texel : texels)
+					{
+						texel[0] = texel[1] = texel[2] = 0;
+						texel[3] = 255;
+					}
+
+					switch (format)
+					{
+					case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+					case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+						DecodeColorBlock(block, true, texels);
+						for (auto&& texel : texels)
+							texel[3] = 255;
+						break;
+					case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+					case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+						DecodeColorBlock(block, true, texels);
+						break;
+					case VK_FORMAT_BC3_UNORM_BLOCK:
+					case VK_FORMAT_BC3_SRGB_BLOCK:
+						DecodeColorBlock(block + 8, false, texels);
+						DecodeChannelBlock(block, 3, texels);
+						break;
+					case VK_FORMAT_BC4_UNORM_BLOCK:
+						DecodeChannelBlock(block, 0, texels);
+						break;
+					case VK_FORMAT_BC5_UNORM_BLOCK:
+						DecodeChannelBlock(block, 0, texels);
+						DecodeChannelBlock(block + 8, 1, texels);
+						break;
+					case VK_FORMAT_BC7_UNORM_BLOCK:
+					case VK_FORMAT_BC7_SRGB_BLOCK:
+						DecodeBc7Block(block, texels);
+						break;
+					default:
+						break;
+					}
+				}
+
+				for (uint32_t y = 0; y < block_extent.height && block_y * block_extent.height + y < extent.height; y++)
+				{
+					for (uint32_t x = 0; x < block_extent.width && block_x * block_extent.width + x < extent.width; x++)
+					{
+						size_t pixel_index = size_t(block_y * block_extent.height + y) * extent.width + block_x * block_extent.width + x;
+						std::memcpy(pixels.data() + pixel_index * 4, block_texels[y * block_extent.width + x], 4);
+					}
+				}
+			}
+		}
+	}
+}
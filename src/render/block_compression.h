@@ -0,0 +1,28 @@
+#ifndef RENDER_ENGINE_RENDER_BLOCK_COMPRESSION_H_
+#define RENDER_ENGINE_RENDER_BLOCK_COMPRESSION_H_
+
+#include <span>
+
+#include "vulkan/vulkan.h"
+
+#include "common.h"
+#include "render/data_types.h"
+
+namespace render
+{
+	// BC, ETC2 and ASTC formats
+	bool IsBlockCompressed(VkFormat format);
+
+	bool IsSampledFormatSupported(const Global& global, VkFormat format);
+
+	// BC1, BC3, BC4, BC5, BC7 and LDR ASTC can be decoded on CPU for devices without support for them
+	bool CanDecodeBlockCompressed(VkFormat format);
+
+	// RGBA8 format matching the color space of the compressed one
+	VkFormat GetDecodedFormat(VkFormat format);
+
+	// Decodes one mip level to tightly packed RGBA8 in pixels, which holds at least extent.width * extent.height * 4 bytes.
+	// Missing channels are filled the way the sampler does it.
+	void DecodeBlockCompressed(VkFormat format, Extent extent, std::span<const unsigned char> blocks, std::span<unsigned char> pixels);
+}
+#endif  // RENDER_ENGINE_RENDER_BLOCK_COMPRESSION_H_
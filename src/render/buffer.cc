@@ -88,4 +88,20 @@ namespace render
         memcpy(mapped_data, data, static_cast<size_t>(size));
         vkUnmapMemory(global_.logical_device, memory_->GetMemoryHandle());
     }
+
+    void HostVisibleBuffer::LoadData(const void* data, size_t size, size_t offset)
+    {
+        void* mapped_data;
+        vkMapMemory(global_.logical_device, memory_->GetMemoryHandle(), memory_->GetMemoryOffset() + offset, size, 0, &mapped_data);
+        memcpy(mapped_data, data, static_cast<size_t>(size));
+        vkUnmapMemory(global_.logical_device, memory_->GetMemoryHandle());
+    }
+
+    void HostVisibleBuffer::ReadData(void* data, size_t size, size_t offset) const
+    {
+        void* mapped_data;
+        vkMapMemory(global_.logical_device, memory_->GetMemoryHandle(), memory_->GetMemoryOffset() + offset, size, 0, &mapped_data);
+        memcpy(data, mapped_data, static_cast<size_t>(size));
+        vkUnmapMemory(global_.logical_device, memory_->GetMemoryHandle());
+    }
 }
\ No newline at end of file
@@ -72,6 +72,9 @@ namespace render
 		{}
 
 		void LoadData(const void* data, size_t size);
+		void LoadData(const void* data, size_t size, size_t offset);
+
+		void ReadData(void* data, size_t size, size_t offset = 0) const;
 	};
 
 	class StagingBuffer : public HostVisibleBuffer
@@ -110,5 +113,17 @@ namespace render
 		UniformBuffer& operator=(const UniformBuffer&) = delete;
 		UniformBuffer& operator=(UniformBuffer&&) = default;
 	};
+
+	class StorageBuffer : public HostVisibleBuffer
+	{
+	public:
+
+		StorageBuffer(const Global& global, VkDeviceSize size) : HostVisibleBuffer(global, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {}
+		StorageBuffer(const StorageBuffer&) = delete;
+		StorageBuffer(StorageBuffer&&) = default;
+
+		StorageBuffer& operator=(const StorageBuffer&) = delete;
+		StorageBuffer& operator=(StorageBuffer&&) = default;
+	};
 }
 #endif  // RENDER_ENGINE_RENDER_BUFFER_H_
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "compute_pipeline.h"
+
+#include <vector>
+
+#include "common.h"
+
+#include "global.h"
+
+namespace render
+{
+	ComputePipeline::ComputePipeline(const Global& global, const ShaderModule& compute_shader_module, uint32_t push_constants_size) :
+		RenderObjBase(global), descriptor_sets_(compute_shader_module.GetDescriptorSets()), layout_(VK_NULL_HANDLE)
+	{
+		assert(compute_shader_module.GetShaderType() == ShaderType::Compute);
+
+		std::vector<VkDescriptorSetLayout> descriptor_sets_layouts;
+
+		for (auto&& [set_index, set_layout] : descriptor_sets_)
+		{
+			descriptor_sets_layouts.push_back(set_layout.GetHandle());
+		}
+
+		VkPushConstantRange push_constant{};
+		push_constant.offset = 0;
+		push_constant.size = push_constants_size;
+		push_constant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkPipelineLayoutCreateInfo pipeline_layout_info{};
+		pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipeline_layout_info.setLayoutCount = u32(descriptor_sets_layouts.size());
+		pipeline_layout_info.pSetLayouts = descriptor_sets_layouts.data();
+		pipeline_layout_info.pushConstantRangeCount = push_constants_size > 0 ? 1 : 0;
+		pipeline_layout_info.pPushConstantRanges = &push_constant;
+
+		if (vkCreatePipelineLayout(global_.logical_device, &pipeline_layout_info, nullptr, &layout_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+
+		VkComputePipelineCreateInfo pipeline_info{};
+		pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipeline_info.stage.module = compute_shader_module.GetHandle();
+		pipeline_info.stage.pName = "main";
+		pipeline_info.layout = layout_;
+
+		if (vkCreateComputePipelines(global_.logical_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &handle_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create compute pipeline!");
+		}
+	}
+
+	const std::map<uint32_t, const DescriptorSetLayout&>& ComputePipeline::GetDescriptorSetLayouts() const
+	{
+		return descriptor_sets_;
+	}
+
+	const VkPipelineLayout& ComputePipeline::GetLayout() const
+	{
+		return layout_;
+	}
+
+	ComputePipeline::~ComputePipeline()
+	{
+		if (handle_ != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(global_.logical_device, handle_, nullptr);
+
+			if (layout_ != VK_NULL_HANDLE)
+			{
+				vkDestroyPipelineLayout(global_.logical_device, layout_, nullptr);
+			}
+		}
+	}
+}
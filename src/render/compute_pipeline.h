@@ -0,0 +1,39 @@
+#ifndef RENDER_ENGINE_RENDER_COMPUTE_PIPELINE_H_
+#define RENDER_ENGINE_RENDER_COMPUTE_PIPELINE_H_
+
+#include <map>
+
+#include "vulkan/vulkan.h"
+
+#include "render/descriptor_set_layout.h"
+#include "render/object_base.h"
+#include "render/shader_module.h"
+
+namespace render
+{
+	class ComputePipeline : public RenderObjBase<VkPipeline>
+	{
+	public:
+
+		// push_constants_size bytes of push constants are available to the shader, none by default
+		ComputePipeline(const Global& global, const ShaderModule& compute_shader_module, uint32_t push_constants_size = 0);
+
+		ComputePipeline(const ComputePipeline&) = delete;
+		ComputePipeline(ComputePipeline&&) = default;
+
+		ComputePipeline& operator=(const ComputePipeline&) = delete;
+		ComputePipeline& operator=(ComputePipeline&&) = default;
+
+		const std::map<uint32_t, const DescriptorSetLayout&>& GetDescriptorSetLayouts() const;
+
+		const VkPipelineLayout& GetLayout() const;
+
+		virtual ~ComputePipeline() override;
+	private:
+
+		std::map<uint32_t, const DescriptorSetLayout&> descriptor_sets_;
+
+		VkPipelineLayout layout_;
+	};
+}
+#endif  // RENDER_ENGINE_RENDER_COMPUTE_PIPELINE_H_
@@ -0,0 +1,1792 @@
+#include "cooked_model_pack.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <type_traits>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <glm/glm/gtc/matrix_transform.hpp>
+
+#include "stl_util.h"
+
+#include "render/meshopt_decoder.h"
+#include "render/render_engine.h"
+#include "render/tangents.h"
+#include "render/vertex_buffer.h"
+
+namespace render
+{
+	namespace
+	{
+		const char kMagic[8] = { 'V', 'V', 'F', 'P', 'A', 'C', 'K', '\0' };
+
+		// blobs start at file offsets aligned for any texel block and vertex format
+		const size_t kBlobAlignment = 16;
+
+		// LOD simplification error limit, a fraction of the primitive extent
+		const float kLodMaxSimplifyError = 0.1f;
+		// a level keeping more than this fraction of the previous triangles ends the chain
+		const float kLodMinReduction = 0.9f;
+
+		// half keeps texture coordinates below this magnitude within 1/1024
+		const float kMaxQuantizedTexCoord = 2.0f;
+
+		struct FileHeader
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t cook_flags;
+			uint64_t source_hash;
+		};
+
+		uint32_t GetCookFlags(const CookOptions& options)
+		{
+			return (options.optimize_meshes ? 1 : 0) | (std::min(options.lods_count, kMaxLodsCount) << 1) | (options.quantize_vertices ? 1 << 4 : 0) | (u32(options.lod_triangles_ratio * 100.0f) << 8)
+				| (std::min(u32(options.animation_tolerance * 100000.0f), 0xFFFFu) << 16);
+		}
+
+		size_t AlignBlob(size_t offset)
+		{
+			return (offset + kBlobAlignment - 1) & ~(kBlobAlignment - 1);
+		}
+
+		// read only view of a whole file, kept alive by everything pointing into it
+		class MappedFile
+		{
+		public:
+
+			MappedFile(const std::string& path)
+			{
+#ifdef WIN32
+				file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+				if (file_ == INVALID_HANDLE_VALUE)
+					throw std::runtime_error("failed to open file for mapping");
+
+				LARGE_INTEGER size;
+
+				if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0 || !(mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr)))
+				{
+					CloseHandle(file_);
+					throw std::runtime_error("failed to map file");
+				}
+
+				data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+
+				if (!data_)
+				{
+					CloseHandle(mapping_);
+					CloseHandle(file_);
+					throw std::runtime_error("failed to map file");
+				}
+
+				size_ = size_t(size.QuadPart);
+#else
+				int file = open(path.c_str(), O_RDONLY);
+
+				if (file < 0)
+					throw std::runtime_error("failed to open file for mapping");
+
+				struct stat file_stat;
+				void* mapping = MAP_FAILED;
+
+				if (fstat(file, &file_stat) == 0 && file_stat.st_size > 0)
+				{
+					mapping = mmap(nullptr, size_t(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+				}
+
+				// the mapping keeps the file referenced
+				close(file);
+
+				if (mapping == MAP_FAILED)
+					throw std::runtime_error("failed to map file");
+
+				data_ = static_cast<const unsigned char*>(mapping);
+				size_ = size_t(file_stat.st_size);
+#endif
+			}
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			~MappedFile()
+			{
+#ifdef WIN32
+				UnmapViewOfFile(data_);
+				CloseHandle(mapping_);
+				CloseHandle(file_);
+#else
+				munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+			}
+
+			std::span<const unsigned char> GetData() const
+			{
+				return { data_, size_ };
+			}
+
+		private:
+#ifdef WIN32
+			HANDLE file_;
+			HANDLE mapping_;
+#endif
+			const unsigned char* data_;
+			size_t size_;
+		};
+
+		void HashBytes(uint64_t& hash, const void* data, size_t size)
+		{
+			for (size_t i = 0; i < size; i++)
+			{
+				hash = (hash ^ static_cast<const unsigned char*>(data)[i]) * 1099511628211ull;
+			}
+		}
+
+		// path, size and last write time, a missing file still changes the key through its path
+		void HashFileStamp(uint64_t& hash, const std::filesystem::path& path)
+		{
+			std::string path_string = path.lexically_normal().generic_string();
+			HashBytes(hash, path_string.data(), path_string.size());
+
+			std::error_code error;
+			uint64_t size = std::filesystem::file_size(path, error);
+			int64_t write_time = error ? 0 : int64_t(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+
+			if (error)
+			{
+				size = write_time = 0;
+			}
+
+			HashBytes(hash, &size, sizeof(size));
+			HashBytes(hash, &write_time, sizeof(write_time));
+		}
+
+		std::string DecodeUri(const std::string& uri)
+		{
+			std::string decoded;
+			decoded.reserve(uri.size());
+
+			for (size_t i = 0; i < uri.size(); i++)
+			{
+				if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) && std::isxdigit(static_cast<unsigned char>(uri[i + 2])))
+				{
+					decoded.push_back(char(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+					i += 2;
+				}
+				else
+				{
+					decoded.push_back(uri[i]);
+				}
+			}
+
+			return decoded;
+		}
+
+		// Buffer and image files the glTF or GLB references, resolved against its directory.
+		// Only the JSON is read, data URIs and the GLB binary chunk are covered by the file itself.
+		std::vector<std::filesystem::path> GetExternalFiles(const std::filesystem::path& gltf_path)
+		{
+			std::string json_text;
+
+			{
+				std::ifstream file(gltf_path, std::ios::binary);
+
+				if (!file)
+					return {};
+
+				// GLB: 12 byte header, then the JSON chunk length and type
+				uint32_t glb_header[5] = {};
+				file.read(reinterpret_cast<char*>(glb_header), sizeof(glb_header));
+
+				if (file && glb_header[0] == 0x46546C67 && glb_header[4] == 0x4E4F534A)
+				{
+					json_text.resize(glb_header[3]);
+					file.read(json_text.data(), json_text.size());
+					json_text.resize(size_t(file.gcount()));
+				}
+				else
+				{
+					file.clear();
+					file.seekg(0, std::ios::end);
+					json_text.resize(size_t(file.tellg()));
+					file.seekg(0, std::ios::beg);
+					file.read(json_text.data(), json_text.size());
+				}
+			}
+
+			nlohmann::json json = nlohmann::json::parse(json_text, nullptr, false);
+
+			if (json.is_discarded() || !json.is_object())
+				return {};
+
+			std::vector<std::filesystem::path> files;
+
+			for (auto&& array_name : { "buffers", "images" })
+			{
+				auto&& array = json.find(array_name);
+
+				if (array == json.end() || !array->is_array())
+					continue;
+
+				for (auto&& item : *array)
+				{
+					if (!item.is_object())
+						continue;
+
+					auto&& uri = item.find("uri");
+
+					if (uri == item.end() || !uri->is_string())
+						continue;
+
+					std::string uri_string = uri->get<std::string>();
+
+					if (uri_string.rfind("data:", 0) == 0)
+						continue;
+
+					files.push_back(gltf_path.parent_path() / std::filesystem::u8path(DecodeUri(uri_string)));
+				}
+			}
+
+			return files;
+		}
+
+		class BinaryWriter
+		{
+		public:
+
+			template<typename T>
+			void Write(const T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				Append(&value, sizeof(T));
+			}
+
+			template<typename T>
+			void WriteVector(const std::vector<T>& values)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				Write(uint64_t(values.size()));
+				Append(values.data(), values.size() * sizeof(T));
+			}
+
+			void WriteString(const std::string& value)
+			{
+				Write(uint64_t(value.size()));
+				Append(value.data(), value.size());
+			}
+
+			void WriteBlob(std::span<const unsigned char> blob)
+			{
+				Write(uint64_t(blob.size()));
+				data_.resize(AlignBlob(data_.size()));
+				Append(blob.data(), blob.size());
+			}
+
+			const std::vector<unsigned char>& GetData() const
+			{
+				return data_;
+			}
+
+		private:
+
+			void Append(const void* data, size_t size)
+			{
+				auto&& bytes = static_cast<const unsigned char*>(data);
+				data_.insert(data_.end(), bytes, bytes + size);
+			}
+
+			std::vector<unsigned char> data_;
+		};
+
+		class BinaryReader
+		{
+		public:
+
+			BinaryReader(std::span<const unsigned char> data) : data_(data), position_(0) {}
+
+			template<typename T>
+			T Read()
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				T value;
+				std::memcpy(&value, Take(sizeof(T)).data(), sizeof(T));
+				return value;
+			}
+
+			template<typename T>
+			std::vector<T> ReadVector()
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				uint64_t count = Read<uint64_t>();
+
+				if (count > (data_.size() - position_) / sizeof(T))
+					throw std::runtime_error("failed to read cooked model pack, file is truncated");
+
+				std::vector<T> values(count);
+				std::memcpy(values.data(), Take(count * sizeof(T)).data(), count * sizeof(T));
+				return values;
+			}
+
+			std::string ReadString()
+			{
+				uint64_t size = Read<uint64_t>();
+				auto&& chars = Take(size);
+				return std::string(chars.begin(), chars.end());
+			}
+
+			std::span<const unsigned char> ReadBlob()
+			{
+				uint64_t size = Read<uint64_t>();
+				position_ = std::min(AlignBlob(position_), data_.size());
+				return Take(size);
+			}
+
+		private:
+
+			std::span<const unsigned char> Take(uint64_t size)
+			{
+				if (size > data_.size() - position_)
+					throw std::runtime_error("failed to read cooked model pack, file is truncated");
+
+				auto&& result = data_.subspan(position_, size_t(size));
+				position_ += size_t(size);
+				return result;
+			}
+
+			std::span<const unsigned char> data_;
+			size_t position_;
+		};
+
+		int GetAttributeAccessorIndex(const std::map<std::string, int>& attributes, VertexBufferType vertex_buffer_type)
+		{
+			std::string name = GetVertexBufferTypesToNames().at(vertex_buffer_type);
+
+			if (auto&& it = attributes.find(name); it != attributes.end())
+				return it->second;
+
+			if (auto&& it = attributes.find(name + "_0"); it != attributes.end())
+				return it->second;
+
+			return -1;
+		}
+
+		CookedModelPack::Accessor CookAccessor(const tinygltf::Model& gltf_model, int acc_ind)
+		{
+			assert(acc_ind >= 0);
+
+			auto&& accessor = gltf_model.accessors[acc_ind];
+			auto&& buffer_view = gltf_model.bufferViews[accessor.bufferView];
+
+			auto element_size = tinygltf::GetNumComponentsInType(accessor.type) * tinygltf::GetComponentSizeInBytes(accessor.componentType);
+			size_t actual_stride = buffer_view.byteStride > 0 ? buffer_view.byteStride : element_size;
+
+			return { buffer_view.buffer, u32(actual_stride), buffer_view.byteOffset + accessor.byteOffset, u32(accessor.count) };
+		}
+
+		// basis universal sources can't be transcoded here, so the plain source stays as a fallback
+		CookedModelPack::TextureRef CookTextureRef(const tinygltf::Model& gltf_model, int texture_index)
+		{
+			auto&& texture = gltf_model.textures[texture_index];
+
+			if (auto&& it = texture.extensions.find("KHR_texture_basisu"); it != texture.extensions.end() && it->second.Has("source"))
+				return { it->second.Get("source").GetNumberAsInt(), texture.source };
+
+			return { texture.source, -1 };
+		}
+
+		// float ones and the integer ones KHR_mesh_quantization allows, read as floats by ReadAttribute
+		bool IsAttributeAccessor(const tinygltf::Model& gltf_model, int acc_ind, int type)
+		{
+			if (acc_ind < 0 || gltf_model.accessors[acc_ind].type != type)
+				return false;
+
+			switch (gltf_model.accessors[acc_ind].componentType)
+			{
+			case TINYGLTF_COMPONENT_TYPE_BYTE:
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			case TINYGLTF_COMPONENT_TYPE_SHORT:
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			case TINYGLTF_COMPONENT_TYPE_FLOAT:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		// tightly packed copy of a strided float accessor
+		template<typename T>
+		std::vector<T> ReadAccessor(const tinygltf::Model& gltf_model, int acc_ind)
+		{
+			CookedModelPack::Accessor accessor = CookAccessor(gltf_model, acc_ind);
+			auto&& data = gltf_model.buffers[accessor.buffer].data;
+
+			if (accessor.count > 0 && accessor.offset + uint64_t(accessor.stride) * (accessor.count - 1) + sizeof(T) > data.size())
+				throw std::runtime_error("failed to read gltf accessor, it is out of range");
+
+			std::vector<T> values(accessor.count);
+
+			for (uint32_t i = 0; i < accessor.count; i++)
+			{
+				std::memcpy(&values[i], data.data() + accessor.offset + uint64_t(accessor.stride) * i, sizeof(T));
+			}
+
+			return values;
+		}
+
+		// normalized integers are mapped to [-1, 1] or [0, 1] as glTF specifies, others are converted as is
+		float ReadComponent(const unsigned char* data, int component_type, bool normalized)
+		{
+			switch (component_type)
+			{
+			case TINYGLTF_COMPONENT_TYPE_BYTE:
+			{
+				int8_t value;
+				std::memcpy(&value, data, sizeof(value));
+				return normalized ? std::max(value / 127.0f, -1.0f) : float(value);
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			{
+				uint8_t value;
+				std::memcpy(&value, data, sizeof(value));
+				return normalized ? value / 255.0f : float(value);
+			}
+			case TINYGLTF_COMPONENT_TYPE_SHORT:
+			{
+				int16_t value;
+				std::memcpy(&value, data, sizeof(value));
+				return normalized ? std::max(value / 32767.0f, -1.0f) : float(value);
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			{
+				uint16_t value;
+				std::memcpy(&value, data, sizeof(value));
+				return normalized ? value / 65535.0f : float(value);
+			}
+			case TINYGLTF_COMPONENT_TYPE_FLOAT:
+			{
+				float value;
+				std::memcpy(&value, data, sizeof(value));
+				return value;
+			}
+			default:
+				throw std::runtime_error("failed to read gltf accessor, component type is not supported");
+			}
+		}
+
+		// tightly packed float components of an accessor of any component type
+		std::vector<float> ReadFloatComponents(const tinygltf::Model& gltf_model, int acc_ind)
+		{
+			auto&& gltf_accessor = gltf_model.accessors[acc_ind];
+			size_t components_count = tinygltf::GetNumComponentsInType(gltf_accessor.type);
+			size_t component_size = tinygltf::GetComponentSizeInBytes(gltf_accessor.componentType);
+
+			CookedModelPack::Accessor accessor = CookAccessor(gltf_model, acc_ind);
+			auto&& data = gltf_model.buffers[accessor.buffer].data;
+
+			if (accessor.count > 0 && accessor.offset + uint64_t(accessor.stride) * (accessor.count - 1) + components_count * component_size > data.size())
+				throw std::runtime_error("failed to read gltf accessor, it is out of range");
+
+			std::vector<float> values(size_t(accessor.count) * components_count);
+
+			for (uint32_t i = 0; i < accessor.count; i++)
+			{
+				const unsigned char* element = data.data() + accessor.offset + uint64_t(accessor.stride) * i;
+
+				for (size_t component = 0; component < components_count; component++)
+				{
+					values[i * components_count + component] = ReadComponent(element + component * component_size, gltf_accessor.componentType, gltf_accessor.normalized);
+				}
+			}
+
+			return values;
+		}
+
+		// ReadAccessor for float vectors, quantized accessors are dequantized
+		template<typename T>
+		std::vector<T> ReadAttribute(const tinygltf::Model& gltf_model, int acc_ind)
+		{
+			if (gltf_model.accessors[acc_ind].componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+				return ReadAccessor<T>(gltf_model, acc_ind);
+
+			if (tinygltf::GetNumComponentsInType(gltf_model.accessors[acc_ind].type) != size_t(T::length()))
+				throw std::runtime_error("failed to read gltf accessor, type doesn't match");
+
+			std::vector<float> components = ReadFloatComponents(gltf_model, acc_ind);
+			std::vector<T> values(components.size() / size_t(T::length()));
+			std::memcpy(values.data(), components.data(), values.size() * sizeof(T));
+
+			return values;
+		}
+
+		// min and max of float accessors that have them, of the decoded positions otherwise, as quantized ones store them unscaled
+		std::optional<std::pair<glm::vec3, glm::vec3>> GetPositionBounds(const tinygltf::Model& gltf_model, int position_acc_index)
+		{
+			auto&& position_accessor = gltf_model.accessors[position_acc_index];
+
+			if (position_accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT && position_accessor.minValues.size() == 3 && position_accessor.maxValues.size() == 3)
+				return std::pair(glm::vec3(position_accessor.minValues[0], position_accessor.minValues[1], position_accessor.minValues[2]),
+					glm::vec3(position_accessor.maxValues[0], position_accessor.maxValues[1], position_accessor.maxValues[2]));
+
+			if (!IsAttributeAccessor(gltf_model, position_acc_index, TINYGLTF_TYPE_VEC3) || position_accessor.count == 0)
+				return std::nullopt;
+
+			std::vector<glm::vec3> positions = ReadAttribute<glm::vec3>(gltf_model, position_acc_index);
+			std::pair<glm::vec3, glm::vec3> bounds(positions[0], positions[0]);
+
+			for (auto&& position : positions)
+			{
+				bounds.first = glm::min(bounds.first, position);
+				bounds.second = glm::max(bounds.second, position);
+			}
+
+			return bounds;
+		}
+
+		// meshes with KHR_mesh_quantization attributes go into the quantized streams, as pipelines only reflect those and float ones
+		bool HasQuantizedAttributes(const tinygltf::Model& gltf_model, const tinygltf::Mesh& gltf_mesh)
+		{
+			for (auto&& gltf_primitive : gltf_mesh.primitives)
+			{
+				for (VertexBufferType vertex_buffer_type : { VertexBufferType::kPOSITION, VertexBufferType::kNORMAL, VertexBufferType::kTANGENT, VertexBufferType::kTEXCOORD })
+				{
+					int acc_ind = GetAttributeAccessorIndex(gltf_primitive.attributes, vertex_buffer_type);
+
+					if (acc_ind >= 0 && gltf_model.accessors[acc_ind].componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+						return true;
+				}
+			}
+
+			return false;
+		}
+
+		std::vector<uint32_t> ReadIndices(const tinygltf::Model& gltf_model, int acc_ind)
+		{
+			switch (gltf_model.accessors[acc_ind].componentType)
+			{
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			{
+				auto&& indices = ReadAccessor<uint8_t>(gltf_model, acc_ind);
+				return std::vector<uint32_t>(indices.begin(), indices.end());
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			{
+				auto&& indices = ReadAccessor<uint16_t>(gltf_model, acc_ind);
+				return std::vector<uint32_t>(indices.begin(), indices.end());
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+				return ReadAccessor<uint32_t>(gltf_model, acc_ind);
+			default:
+				throw std::runtime_error("failed to read gltf indices, component type is not supported");
+			}
+		}
+
+		// values of the cooked vertices, the values themselves for an empty order
+		template<typename T>
+		std::vector<T> GatherVertices(std::vector<T> values, std::span<const uint32_t> vertex_order)
+		{
+			if (vertex_order.empty())
+				return values;
+
+			std::vector<T> result(vertex_order.size());
+
+			for (uint32_t i = 0; i < vertex_order.size(); i++)
+			{
+				result[i] = values[vertex_order[i]];
+			}
+
+			return result;
+		}
+
+		// primitives without TANGENT that have everything MikkTSpace needs
+		bool NeedsGeneratedTangents(const tinygltf::Model& gltf_model, const tinygltf::Primitive& gltf_primitive)
+		{
+			return gltf_primitive.indices >= 0 && gltf_primitive.mode == TINYGLTF_MODE_TRIANGLES
+				&& GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kTANGENT) < 0
+				&& IsAttributeAccessor(gltf_model, GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kPOSITION), TINYGLTF_TYPE_VEC3)
+				&& IsAttributeAccessor(gltf_model, GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kNORMAL), TINYGLTF_TYPE_VEC3)
+				&& IsAttributeAccessor(gltf_model, GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kTEXCOORD), TINYGLTF_TYPE_VEC2);
+		}
+
+		// Each level is simplified from the full detail indices, so errors don't add up along the chain.
+		// Indices address the vertices of vertex_order when it isn't empty.
+		std::vector<SimplifiedMesh> BuildLods(const tinygltf::Model& gltf_model, const std::array<int, kVertexBufferTypesCount>& attribute_accessor_indices, std::span<const uint32_t> indices, std::span<const uint32_t> vertex_order, const CookOptions& options)
+		{
+			int normal_acc_index = attribute_accessor_indices[u32(VertexBufferType::kNORMAL)];
+			int uv_acc_index = attribute_accessor_indices[u32(VertexBufferType::kTEXCOORD)];
+
+			std::vector<glm::vec3> positions = ReadAttribute<glm::vec3>(gltf_model, attribute_accessor_indices[u32(VertexBufferType::kPOSITION)]);
+			std::vector<glm::vec3> normals = IsAttributeAccessor(gltf_model, normal_acc_index, TINYGLTF_TYPE_VEC3) ? ReadAttribute<glm::vec3>(gltf_model, normal_acc_index) : std::vector<glm::vec3>();
+			std::vector<glm::vec2> uvs = IsAttributeAccessor(gltf_model, uv_acc_index, TINYGLTF_TYPE_VEC2) ? ReadAttribute<glm::vec2>(gltf_model, uv_acc_index) : std::vector<glm::vec2>();
+
+			if (normals.size() != positions.size())
+			{
+				normals.clear();
+			}
+
+			if (uvs.size() != positions.size())
+			{
+				uvs.clear();
+			}
+
+			positions = GatherVertices(std::move(positions), vertex_order);
+
+			if (!normals.empty())
+			{
+				normals = GatherVertices(std::move(normals), vertex_order);
+			}
+
+			if (!uvs.empty())
+			{
+				uvs = GatherVertices(std::move(uvs), vertex_order);
+			}
+
+			std::vector<SimplifiedMesh> lods;
+			size_t indices_count = indices.size();
+
+			for (uint32_t level = 0; level < std::min(options.lods_count, kMaxLodsCount); level++)
+			{
+				size_t target_indices_count = size_t(indices_count / 3 * options.lod_triangles_ratio) * 3;
+
+				SimplifiedMesh lod = SimplifyMesh(indices, positions, normals, uvs, target_indices_count, kLodMaxSimplifyError);
+
+				if (lod.indices.empty() || lod.indices.size() > indices_count * kLodMinReduction)
+					break;
+
+				indices_count = lod.indices.size();
+				lods.push_back(std::move(lod));
+			}
+
+			return lods;
+		}
+
+		// Maps snorm16 positions into the bounds of the mesh, empty if one of its primitives can't be quantized.
+		// The scale is uniform, so normals transformed by the model matrix only change their length.
+		std::optional<glm::mat4> GetMeshDequantization(const tinygltf::Model& gltf_model, const tinygltf::Mesh& gltf_mesh)
+		{
+			glm::vec3 bounds_min = glm::vec3(std::numeric_limits<float>::max());
+			glm::vec3 bounds_max = glm::vec3(-std::numeric_limits<float>::max());
+
+			for (auto&& gltf_primitive : gltf_mesh.primitives)
+			{
+				int position_acc_index = GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kPOSITION);
+				int normal_acc_index = GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kNORMAL);
+				int tangent_acc_index = GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kTANGENT);
+				int uv_acc_index = GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kTEXCOORD);
+
+				// skinning would need the dequantization before the joint transforms
+				if (!IsAttributeAccessor(gltf_model, position_acc_index, TINYGLTF_TYPE_VEC3) || !IsAttributeAccessor(gltf_model, normal_acc_index, TINYGLTF_TYPE_VEC3)
+					|| !IsAttributeAccessor(gltf_model, uv_acc_index, TINYGLTF_TYPE_VEC2) || GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kJOINTS) >= 0)
+					return std::nullopt;
+
+				// missing tangents are generated from the indices
+				if (tangent_acc_index >= 0 ? !IsAttributeAccessor(gltf_model, tangent_acc_index, TINYGLTF_TYPE_VEC4) : gltf_primitive.indices < 0)
+					return std::nullopt;
+
+				auto&& position_accessor = gltf_model.accessors[position_acc_index];
+
+				if (gltf_model.accessors[normal_acc_index].count != position_accessor.count || gltf_model.accessors[uv_acc_index].count != position_accessor.count
+					|| (tangent_acc_index >= 0 && gltf_model.accessors[tangent_acc_index].count != position_accessor.count))
+					return std::nullopt;
+
+				for (auto&& uv : ReadAttribute<glm::vec2>(gltf_model, uv_acc_index))
+				{
+					if (!(std::max(std::abs(uv.x), std::abs(uv.y)) < kMaxQuantizedTexCoord))
+						return std::nullopt;
+				}
+
+				auto&& position_bounds = GetPositionBounds(gltf_model, position_acc_index);
+
+				if (!position_bounds)
+					return std::nullopt;
+
+				bounds_min = glm::min(bounds_min, position_bounds->first);
+				bounds_max = glm::max(bounds_max, position_bounds->second);
+			}
+
+			if (gltf_mesh.primitives.empty())
+				return std::nullopt;
+
+			glm::vec3 half_extent = (bounds_max - bounds_min) * 0.5f;
+			float scale = std::max({ half_extent.x, half_extent.y, half_extent.z });
+
+			return glm::scale(glm::translate(glm::identity<glm::mat4>(), (bounds_min + bounds_max) * 0.5f), glm::vec3(scale > 0.0f ? scale : 1.0f));
+		}
+
+		// Drops keys of a linear channel that interpolating the kept keys around them reproduces within tolerance.
+		// Every dropped key is checked, so errors don't add up along a run of dropped keys.
+		void ReduceLinearKeys(std::vector<float>& times, std::vector<glm::vec4>& values, float tolerance, bool is_rotation)
+		{
+			auto&& interpolate = [&](size_t begin, size_t end, float time)
+				{
+					float td = times[end] - times[begin];
+					float t = td > 0.0f ? (time - times[begin]) / td : 0.0f;
+
+					if (!is_rotation)
+						return glm::mix(values[begin], values[end], t);
+
+					glm::quat rotation = glm::slerp(glm::quat(values[begin].w, values[begin].x, values[begin].y, values[begin].z), glm::quat(values[end].w, values[end].x, values[end].y, values[end].z), t);
+					return glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+				};
+
+			// q and -q are the same rotation
+			auto&& get_error = [&](const glm::vec4& value, const glm::vec4& expected)
+				{
+					return is_rotation ? std::min(glm::length(value - expected), glm::length(value + expected)) : glm::length(value - expected);
+				};
+
+			auto&& reproduces = [&](size_t begin, size_t end)
+				{
+					for (size_t i = begin + 1; i < end; i++)
+					{
+						if (get_error(interpolate(begin, end, times[i]), values[i]) > tolerance)
+							return false;
+					}
+
+					return true;
+				};
+
+			if (times.size() < 3)
+				return;
+
+			std::vector<size_t> kept = { 0 };
+
+			for (size_t i = 2; i < times.size(); i++)
+			{
+				if (!reproduces(kept.back(), i))
+				{
+					kept.push_back(i - 1);
+				}
+			}
+
+			kept.push_back(times.size() - 1);
+
+			for (size_t i = 0; i < kept.size(); i++)
+			{
+				times[i] = times[kept[i]];
+				values[i] = values[kept[i]];
+			}
+
+			times.resize(kept.size());
+			values.resize(kept.size());
+		}
+
+		glm::vec3 NormalizeOr(const glm::vec3& vector, const glm::vec3& fallback)
+		{
+			float length2 = glm::dot(vector, vector);
+			return length2 > 0.0f && std::isfinite(length2) ? vector / std::sqrt(length2) : fallback;
+		}
+
+		// Index and vertex streams of all primitives, tightly packed into the only buffer of a pack,
+		// so image bytes, keyframes and inverse bind matrices in the same glTF buffers stay on CPU
+		class GeometryArena
+		{
+		public:
+
+			CookedModelPack::Accessor Allocate(uint32_t element_size, uint32_t count)
+			{
+				size_t offset = AlignBlob(data_.size());
+				data_.resize(offset + size_t(element_size) * count);
+
+				return { 0, element_size, offset, count };
+			}
+
+			// strides of interleaved views are normalized to the element size,
+			// streams gathered through a vertex order belong to one primitive and aren't shared
+			CookedModelPack::Accessor AddVertexStream(const tinygltf::Model& gltf_model, int acc_ind, std::span<const uint32_t> vertex_order)
+			{
+				if (auto&& it = streams_.find(acc_ind); vertex_order.empty() && it != streams_.end())
+					return it->second;
+
+				auto&& gltf_accessor = gltf_model.accessors[acc_ind];
+				uint32_t element_size = u32(tinygltf::GetNumComponentsInType(gltf_accessor.type) * tinygltf::GetComponentSizeInBytes(gltf_accessor.componentType));
+
+				CookedModelPack::Accessor source = CookAccessor(gltf_model, acc_ind);
+				auto&& source_data = gltf_model.buffers[source.buffer].data;
+
+				if (source.count > 0 && source.offset + uint64_t(source.stride) * (source.count - 1) + element_size > source_data.size())
+					throw std::runtime_error("failed to read gltf accessor, it is out of range");
+
+				CookedModelPack::Accessor stream = Allocate(element_size, vertex_order.empty() ? source.count : u32(vertex_order.size()));
+
+				for (uint32_t i = 0; i < stream.count; i++)
+				{
+					uint32_t source_index = vertex_order.empty() ? i : vertex_order[i];
+
+					if (source_index >= source.count)
+						throw std::runtime_error("failed to read gltf accessor, vertex is out of range");
+
+					std::memcpy(data_.data() + stream.offset + size_t(element_size) * i, source_data.data() + source.offset + uint64_t(source.stride) * source_index, element_size);
+				}
+
+				if (vertex_order.empty())
+				{
+					streams_.emplace(acc_ind, stream);
+				}
+
+				return stream;
+			}
+
+			// integer components are converted to float, for attributes of meshes that can't use the quantized streams
+			CookedModelPack::Accessor AddFloatVertexStream(const tinygltf::Model& gltf_model, int acc_ind, std::span<const uint32_t> vertex_order)
+			{
+				if (auto&& it = streams_.find(acc_ind); vertex_order.empty() && it != streams_.end())
+					return it->second;
+
+				uint32_t components_count = u32(tinygltf::GetNumComponentsInType(gltf_model.accessors[acc_ind].type));
+				std::vector<float> components = ReadFloatComponents(gltf_model, acc_ind);
+				uint32_t source_count = u32(components.size() / components_count);
+
+				CookedModelPack::Accessor stream = Allocate(components_count * sizeof(float), vertex_order.empty() ? source_count : u32(vertex_order.size()));
+
+				for (uint32_t i = 0; i < stream.count; i++)
+				{
+					uint32_t source_index = vertex_order.empty() ? i : vertex_order[i];
+
+					if (source_index >= source_count)
+						throw std::runtime_error("failed to read gltf accessor, vertex is out of range");
+
+					std::memcpy(data_.data() + stream.offset + size_t(stream.stride) * i, components.data() + size_t(components_count) * source_index, stream.stride);
+				}
+
+				if (vertex_order.empty())
+				{
+					streams_.emplace(acc_ind, stream);
+				}
+
+				return stream;
+			}
+
+			// 8 bit indices and 32 bit ones that fit are stored as 16 bit, the stride selects the index type.
+			// Indices read from an unchanged accessor are shared by acc_ind, -1 for reordered ones.
+			CookedModelPack::Accessor AddIndices(std::span<const uint32_t> indices, int acc_ind)
+			{
+				if (auto&& it = streams_.find(acc_ind); acc_ind >= 0 && it != streams_.end())
+					return it->second;
+
+				bool wide = !indices.empty() && *std::max_element(indices.begin(), indices.end()) > std::numeric_limits<uint16_t>::max();
+
+				CookedModelPack::Accessor stream = Allocate(wide ? sizeof(uint32_t) : sizeof(uint16_t), u32(indices.size()));
+
+				for (uint32_t i = 0; i < indices.size(); i++)
+				{
+					if (wide)
+					{
+						std::memcpy(data_.data() + stream.offset + sizeof(uint32_t) * i, &indices[i], sizeof(uint32_t));
+					}
+					else
+					{
+						uint16_t index = static_cast<uint16_t>(indices[i]);
+						std::memcpy(data_.data() + stream.offset + sizeof(uint16_t) * i, &index, sizeof(uint16_t));
+					}
+				}
+
+				if (acc_ind >= 0)
+				{
+					streams_.emplace(acc_ind, stream);
+				}
+
+				return stream;
+			}
+
+			std::vector<unsigned char>& GetData()
+			{
+				return data_;
+			}
+
+		private:
+
+			std::vector<unsigned char> data_;
+			std::map<int, CookedModelPack::Accessor> streams_;
+		};
+
+		// cooked streams are tightly packed, the stride is the element size
+		void ValidateAccessor(const CookedModelPack& pack, const CookedModelPack::Accessor& accessor)
+		{
+			if (accessor.buffer < 0)
+				return;
+
+			if (accessor.buffer >= pack.buffers.size() || accessor.count == 0 || accessor.stride == 0)
+				throw std::runtime_error("failed to read cooked model pack, accessor is out of range");
+
+			// stride * (count - 1) can't overflow 64 bits, the offset and the last element are checked against what is left
+			uint64_t buffer_size = pack.buffers[accessor.buffer].size();
+			uint64_t last_element_offset = uint64_t(accessor.stride) * (accessor.count - 1);
+
+			if (accessor.offset > buffer_size || last_element_offset > buffer_size - accessor.offset || accessor.stride > buffer_size - accessor.offset - last_element_offset)
+				throw std::runtime_error("failed to read cooked model pack, accessor is out of range");
+		}
+
+		void ValidateIndices(const CookedModelPack& pack, const CookedModelPack::Accessor& accessor)
+		{
+			ValidateAccessor(pack, accessor);
+
+			if (accessor.buffer >= 0 && accessor.stride != sizeof(uint16_t) && accessor.stride != sizeof(uint32_t))
+				throw std::runtime_error("failed to read cooked model pack, unsupported index size");
+		}
+
+		CookedModelPack CookFile(const std::string& gltf_path, const CookOptions& options)
+		{
+			tinygltf::Model gltf_model;
+
+			tinygltf::TinyGLTF loader;
+			SetupGLTFLoader(loader);
+			std::string err;
+			std::string warn;
+
+			bool loaded = std::filesystem::path(gltf_path).extension() == ".glb" ?
+				loader.LoadBinaryFromFile(&gltf_model, &err, &warn, gltf_path) :
+				loader.LoadASCIIFromFile(&gltf_model, &err, &warn, gltf_path);
+
+			if (!loaded)
+				throw std::runtime_error("failed to load gltf file: " + err);
+
+			DecodeMeshoptCompression(gltf_model);
+
+			return CookGLTF(gltf_model, options);
+		}
+	}
+
+	CookedModelPack CookGLTF(const tinygltf::Model& gltf_model, const CookOptions& options)
+	{
+		if (HasMeshoptCompression(gltf_model))
+		{
+			tinygltf::Model decoded_model = gltf_model;
+			DecodeMeshoptCompression(decoded_model);
+			return CookGLTF(decoded_model, options);
+		}
+
+		CookedModelPack pack;
+		pack.options = options;
+
+		auto&& generated_buffers = std::make_shared<std::vector<std::vector<unsigned char>>>();
+
+		GeometryArena arena;
+
+		// primitives of quantized meshes, packed in parallel once all meshes are cooked
+		struct QuantizeJob
+		{
+			std::array<int, kVertexBufferTypesCount> attribute_accessor_indices;
+			std::vector<uint32_t> vertex_order;
+			// in the cooked vertex order, empty if the primitive has TANGENT or generating failed
+			std::vector<glm::vec4> tangents;
+			glm::mat4 quantization;
+			CookedModelPack::Accessor position_stream;
+			CookedModelPack::Accessor attributes_stream;
+		};
+
+		std::vector<QuantizeJob> quantize_jobs;
+
+		for (auto&& buffer : gltf_model.buffers)
+		{
+			pack.source_buffers_bytes += buffer.data.size();
+		}
+
+		pack.images.resize(gltf_model.images.size());
+
+		util::ParallelFor(gltf_model.images.size(), [&](size_t index)
+			{
+				auto&& image = gltf_model.images[index];
+
+				auto name = image.name;
+				std::transform(name.begin(), name.end(), name.begin(),
+					[](unsigned char c) { return std::tolower(c); });
+
+				VkFormat format = (name.find("normal") != std::string::npos || name.find("roughness") != std::string::npos) ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
+
+				try
+				{
+					pack.images[index] = std::make_shared<const MipChain>(image.width > 0 ?
+						Image::BuildMipChain(format, { u32(image.width), u32(image.height) }, image.image.data()) :
+						Image::LoadMipChain(image.image, format));
+				}
+				catch (const std::runtime_error&)
+				{
+				}
+			});
+
+		for (auto&& gltf_material : gltf_model.materials)
+		{
+			CookedModelPack::Material material;
+
+			if (gltf_material.pbrMetallicRoughness.baseColorTexture.index >= 0)
+			{
+				material.albedo = CookTextureRef(gltf_model, gltf_material.pbrMetallicRoughness.baseColorTexture.index);
+			}
+
+			if (gltf_material.emissiveTexture.index >= 0)
+			{
+				material.albedo = CookTextureRef(gltf_model, gltf_material.emissiveTexture.index);
+				material.flags |= (1 << 0);
+			}
+
+			if (gltf_material.pbrMetallicRoughness.metallicRoughnessTexture.index >= 0)
+			{
+				material.metallic_roughness = CookTextureRef(gltf_model, gltf_material.pbrMetallicRoughness.metallicRoughnessTexture.index);
+			}
+
+			if (gltf_material.normalTexture.index >= 0)
+			{
+				material.normal_map = CookTextureRef(gltf_model, gltf_material.normalTexture.index);
+			}
+
+			pack.materials.push_back(material);
+		}
+
+		pack.nodes.resize(gltf_model.nodes.size());
+
+		for (int i = 0; i < gltf_model.nodes.size(); i++)
+		{
+			auto&& node = gltf_model.nodes[i];
+
+			glm::mat4 local_transform = glm::identity<glm::mat4>();
+
+			if (node.translation.size() == 3)
+			{
+				local_transform = glm::translate(local_transform, glm::vec3(node.translation[0], node.translation[1], node.translation[2]));
+			}
+
+			if (node.rotation.size() == 4)
+			{
+				glm::quat rot_quat = glm::quat(static_cast<float>(node.rotation[3]), static_cast<float>(node.rotation[0]), static_cast<float>(node.rotation[1]), static_cast<float>(node.rotation[2]));
+				local_transform = local_transform * glm::mat4_cast(rot_quat);
+			}
+
+			if (node.scale.size() == 3)
+			{
+				local_transform = glm::scale(local_transform, glm::vec3(node.scale[0], node.scale[1], node.scale[2]));
+			}
+
+			pack.nodes[i].local_transform = local_transform;
+
+			for (auto&& children_index : node.children)
+			{
+				pack.nodes[children_index].parent = i;
+			}
+
+			if (node.mesh != -1)
+			{
+				pack.models.push_back({ node.name, u32(i), u32(node.mesh), node.skin });
+			}
+		}
+
+		std::vector<const tinygltf::Primitive*> gltf_primitives;
+
+		for (auto&& gltf_mesh : gltf_model.meshes)
+		{
+			for (auto&& gltf_primitive : gltf_mesh.primitives)
+			{
+				gltf_primitives.push_back(&gltf_primitive);
+			}
+		}
+
+		// generated in parallel before the primitives are cooked, split vertices change the vertex count the rest of cooking uses
+		std::vector<std::optional<GeneratedTangents>> generated_tangents(gltf_primitives.size());
+
+		util::ParallelFor(gltf_primitives.size(), [&](size_t index)
+			{
+				auto&& gltf_primitive = *gltf_primitives[index];
+
+				if (!NeedsGeneratedTangents(gltf_model, gltf_primitive))
+					return;
+
+				try
+				{
+					generated_tangents[index] = GenerateTangents(
+						ReadIndices(gltf_model, gltf_primitive.indices),
+						ReadAttribute<glm::vec3>(gltf_model, GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kPOSITION)),
+						ReadAttribute<glm::vec3>(gltf_model, GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kNORMAL)),
+						ReadAttribute<glm::vec2>(gltf_model, GetAttributeAccessorIndex(gltf_primitive.attributes, VertexBufferType::kTEXCOORD)));
+				}
+				catch (const std::runtime_error&)
+				{
+				}
+			});
+
+		size_t primitive_index = 0;
+
+		for (auto&& gltf_mesh : gltf_model.meshes)
+		{
+			CookedModelPack::Mesh mesh{ gltf_mesh.name };
+
+			// the dequantization goes into the model matrix, so either all primitives of a mesh are quantized or none
+			std::optional<glm::mat4> dequantization = options.quantize_vertices || HasQuantizedAttributes(gltf_model, gltf_mesh) ? GetMeshDequantization(gltf_model, gltf_mesh) : std::nullopt;
+
+			if (dequantization)
+			{
+				mesh.dequantization = *dequantization;
+			}
+
+			for (auto&& gltf_primitive : gltf_mesh.primitives)
+			{
+				CookedModelPack::Primitive primitive;
+
+				std::array<int, kVertexBufferTypesCount> attribute_accessor_indices{};
+
+				for (VertexBufferType vertex_buffer_type = VertexBufferType::Begin; vertex_buffer_type != VertexBufferType::End; vertex_buffer_type = util::enums::Next(vertex_buffer_type))
+				{
+					attribute_accessor_indices[u32(vertex_buffer_type)] = GetAttributeAccessorIndex(gltf_primitive.attributes, vertex_buffer_type);
+				}
+
+				int position_acc_index = attribute_accessor_indices[u32(VertexBufferType::kPOSITION)];
+				uint32_t vertices_count = position_acc_index >= 0 ? u32(gltf_model.accessors[position_acc_index].count) : 0;
+				bool is_triangle_list = gltf_primitive.mode == TINYGLTF_MODE_TRIANGLES && position_acc_index >= 0;
+
+				std::vector<uint32_t> indices = ReadIndices(gltf_model, gltf_primitive.indices);
+				// cooked vertex to source vertex, empty while they are the same
+				std::vector<uint32_t> vertex_order;
+				std::vector<SimplifiedMesh> lods;
+
+				const std::optional<GeneratedTangents>& generated = generated_tangents[primitive_index++];
+				bool has_split_vertices = generated && !generated->split_vertices.empty();
+				// in the cooked vertex order
+				std::vector<glm::vec4> tangents;
+
+				if (generated)
+				{
+					indices = generated->indices;
+					tangents = generated->tangents;
+
+					// copies made by tangent generation follow the source vertices
+					if (has_split_vertices)
+					{
+						vertex_order.resize(vertices_count);
+						std::iota(vertex_order.begin(), vertex_order.end(), 0);
+						vertex_order.insert(vertex_order.end(), generated->split_vertices.begin(), generated->split_vertices.end());
+						vertices_count = u32(vertex_order.size());
+					}
+				}
+
+				if (options.lods_count > 0 && is_triangle_list && IsAttributeAccessor(gltf_model, position_acc_index, TINYGLTF_TYPE_VEC3))
+				{
+					lods = BuildLods(gltf_model, attribute_accessor_indices, indices, vertex_order, options);
+				}
+
+				VertexCacheStats cache_stats = is_triangle_list ? AnalyzeVertexCache(indices, vertices_count) : VertexCacheStats{};
+				mesh.cache_stats_before += cache_stats;
+
+				if (options.optimize_meshes && is_triangle_list)
+				{
+					OptimizeVertexCache(indices, vertices_count);
+
+					if (IsAttributeAccessor(gltf_model, position_acc_index, TINYGLTF_TYPE_VEC3))
+					{
+						OptimizeOverdraw(indices, GatherVertices(ReadAttribute<glm::vec3>(gltf_model, position_acc_index), vertex_order), kOverdrawThreshold);
+					}
+
+					std::vector<uint32_t> fetch_order = OptimizeVertexFetch(indices, vertices_count);
+					cache_stats = AnalyzeVertexCache(indices, u32(fetch_order.size()));
+
+					// levels only use vertices of the full detail one, so they follow its renumbering
+					std::vector<uint32_t> vertex_remap(vertices_count);
+
+					for (uint32_t i = 0; i < fetch_order.size(); i++)
+					{
+						vertex_remap[fetch_order[i]] = i;
+					}
+
+					for (auto&& lod : lods)
+					{
+						for (uint32_t& index : lod.indices)
+						{
+							index = vertex_remap[index];
+						}
+
+						OptimizeVertexCache(lod.indices, u32(fetch_order.size()));
+					}
+
+					if (!tangents.empty())
+					{
+						tangents = GatherVertices(std::move(tangents), fetch_order);
+					}
+
+					vertex_order = GatherVertices(std::move(vertex_order), fetch_order);
+
+					if (vertex_order.empty())
+					{
+						vertex_order = std::move(fetch_order);
+					}
+
+					primitive.indices = arena.AddIndices(indices, -1);
+				}
+				else
+				{
+					primitive.indices = arena.AddIndices(indices, has_split_vertices ? -1 : gltf_primitive.indices);
+				}
+
+				mesh.cache_stats_after += cache_stats;
+
+				for (auto&& lod : lods)
+				{
+					primitive.lods[primitive.lods_count++] = { arena.AddIndices(lod.indices, -1), lod.error };
+				}
+
+				for (uint32_t vertex_buffer_index = 0; vertex_buffer_index < kVertexBufferTypesCount; vertex_buffer_index++)
+				{
+					int acc_ind = attribute_accessor_indices[vertex_buffer_index];
+
+					if (acc_ind < 0 || (dequantization && GetQuantizedVertexAttribute(VertexBufferType(vertex_buffer_index))))
+						continue;
+
+					// joint indices are integers in the shaders, quantized attributes of other meshes are widened
+					if (gltf_model.accessors[acc_ind].componentType != TINYGLTF_COMPONENT_TYPE_FLOAT && VertexBufferType(vertex_buffer_index) != VertexBufferType::kJOINTS)
+					{
+						primitive.vertex_buffers[vertex_buffer_index] = arena.AddFloatVertexStream(gltf_model, acc_ind, vertex_order);
+					}
+					else
+					{
+						primitive.vertex_buffers[vertex_buffer_index] = arena.AddVertexStream(gltf_model, acc_ind, vertex_order);
+					}
+				}
+
+				if (position_acc_index >= 0)
+				{
+					if (auto&& position_bounds = GetPositionBounds(gltf_model, position_acc_index))
+					{
+						primitive.bounds_min = position_bounds->first;
+						primitive.bounds_max = position_bounds->second;
+					}
+				}
+
+				if (dequantization)
+				{
+					uint32_t quantized_count = vertex_order.empty() ? vertices_count : u32(vertex_order.size());
+
+					CookedModelPack::Accessor position_stream = arena.Allocate(sizeof(QuantizedPosition), quantized_count);
+					CookedModelPack::Accessor attributes_stream = arena.Allocate(sizeof(QuantizedAttributes), quantized_count);
+
+					primitive.vertex_buffers[u32(VertexBufferType::kPOSITION)] = position_stream;
+					primitive.vertex_buffers[u32(VertexBufferType::kNORMAL)] = attributes_stream;
+					primitive.vertex_buffers[u32(VertexBufferType::kTANGENT)] = attributes_stream;
+					primitive.vertex_buffers[u32(VertexBufferType::kTEXCOORD)] = attributes_stream;
+
+					quantize_jobs.push_back({ attribute_accessor_indices, std::move(vertex_order), std::move(tangents), glm::inverse(*dequantization), position_stream, attributes_stream });
+				}
+				else if (NeedsGeneratedTangents(gltf_model, gltf_primitive))
+				{
+					CookedModelPack::Accessor tangent_stream = arena.Allocate(sizeof(glm::vec4), vertex_order.empty() ? vertices_count : u32(vertex_order.size()));
+					glm::vec4* stream_tangents = reinterpret_cast<glm::vec4*>(arena.GetData().data() + tangent_stream.offset);
+
+					if (tangents.size() == tangent_stream.count)
+					{
+						std::copy(tangents.begin(), tangents.end(), stream_tangents);
+					}
+					else
+					{
+						std::fill(stream_tangents, stream_tangents + tangent_stream.count, glm::vec4(1, 0, 0, 1));
+					}
+
+					primitive.vertex_buffers[u32(VertexBufferType::kTANGENT)] = tangent_stream;
+				}
+
+				primitive.material = gltf_primitive.material;
+
+				mesh.primitives.push_back(primitive);
+			}
+
+			pack.meshes.push_back(std::move(mesh));
+		}
+
+		util::ParallelFor(quantize_jobs.size(), [&](size_t job_index)
+			{
+				auto&& job = quantize_jobs[job_index];
+				auto&& positions = ReadAttribute<glm::vec3>(gltf_model, job.attribute_accessor_indices[u32(VertexBufferType::kPOSITION)]);
+				auto&& normals = ReadAttribute<glm::vec3>(gltf_model, job.attribute_accessor_indices[u32(VertexBufferType::kNORMAL)]);
+				auto&& uvs = ReadAttribute<glm::vec2>(gltf_model, job.attribute_accessor_indices[u32(VertexBufferType::kTEXCOORD)]);
+
+				// generated tangents are in the cooked order already, read ones are in the source order
+				std::vector<glm::vec4> source_tangents;
+
+				if (int tangent_acc_index = job.attribute_accessor_indices[u32(VertexBufferType::kTANGENT)]; tangent_acc_index >= 0)
+				{
+					source_tangents = ReadAttribute<glm::vec4>(gltf_model, tangent_acc_index);
+				}
+
+				auto&& quantized_positions = reinterpret_cast<QuantizedPosition*>(arena.GetData().data() + job.position_stream.offset);
+				auto&& quantized_attributes = reinterpret_cast<QuantizedAttributes*>(arena.GetData().data() + job.attributes_stream.offset);
+
+				for (uint32_t i = 0; i < job.position_stream.count; i++)
+				{
+					uint32_t source_index = job.vertex_order.empty() ? i : job.vertex_order[i];
+
+					glm::vec3 position = glm::vec3(job.quantization * glm::vec4(positions[source_index], 1.0f));
+					glm::vec2 normal = OctahedralEncode(NormalizeOr(normals[source_index], glm::vec3(0, 0, 1)));
+					glm::vec4 vertex_tangent = !job.tangents.empty() ? job.tangents[i] : (source_index < source_tangents.size() ? source_tangents[source_index] : glm::vec4(1, 0, 0, 1));
+					glm::vec2 tangent = OctahedralEncode(NormalizeOr(glm::vec3(vertex_tangent), glm::vec3(1, 0, 0)));
+					const glm::vec2& uv = uvs[source_index];
+
+					quantized_positions[i].position = { QuantizeSnorm16(position.x), QuantizeSnorm16(position.y), QuantizeSnorm16(position.z), int16_t(vertex_tangent.w < 0.0f ? -32767 : 32767) };
+					quantized_attributes[i].normal = { QuantizeSnorm16(normal.x), QuantizeSnorm16(normal.y) };
+					quantized_attributes[i].tangent = { QuantizeSnorm16(tangent.x), QuantizeSnorm16(tangent.y) };
+					quantized_attributes[i].texcoord = { QuantizeHalf(uv.x), QuantizeHalf(uv.y) };
+				}
+			});
+
+		if (!arena.GetData().empty())
+		{
+			pack.buffers.push_back(generated_buffers->emplace_back(std::move(arena.GetData())));
+		}
+
+		for (auto&& gltf_skin : gltf_model.skins)
+		{
+			CookedModelPack::Skin skin;
+
+			std::map<int, int16_t> node_ind_to_skin_ind;
+
+			for (int i = 0; i < gltf_skin.joints.size(); i++)
+			{
+				node_ind_to_skin_ind[gltf_skin.joints[i]] = int16_t(i);
+			}
+
+			std::span<const glm::mat4> inverse_bind_matrices;
+
+			if (gltf_skin.inverseBindMatrices >= 0)
+			{
+				assert(gltf_model.accessors[gltf_skin.inverseBindMatrices].componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
+				inverse_bind_matrices = GetBufferSpanByAccessor<glm::mat4>(gltf_model, gltf_skin.inverseBindMatrices);
+			}
+
+			for (int i = 0; i < gltf_skin.joints.size(); i++)
+			{
+				int parent_node = pack.nodes[gltf_skin.joints[i]].parent;
+				auto&& parent_it = node_ind_to_skin_ind.find(parent_node);
+
+				skin.joints.push_back(u32(gltf_skin.joints[i]));
+				skin.inverse_bind_matrices.push_back(i < inverse_bind_matrices.size() ? inverse_bind_matrices[i] : glm::identity<glm::mat4>());
+				skin.parent_indices.push_back(parent_it != node_ind_to_skin_ind.end() ? parent_it->second : -1);
+			}
+
+			pack.skins.push_back(std::move(skin));
+		}
+
+		for (auto&& anim : gltf_model.animations)
+		{
+			CookedModelPack::Animation animation{ anim.name };
+
+			for (auto&& gltf_channel : anim.channels)
+			{
+				auto&& gltf_sampler = anim.samplers[gltf_channel.sampler];
+
+				if (gltf_channel.target_node < 0)
+					continue;
+
+				CookedModelPack::AnimationChannel channel;
+				channel.node_index = u32(gltf_channel.target_node);
+				channel.interpolation = gltf_sampler.interpolation == "CUBICSPLINE" ? InterpolationType::kCubicSpline : gltf_sampler.interpolation == "STEP" ? InterpolationType::kStep : InterpolationType::kLinear;
+				channel.times = ReadAccessor<float>(gltf_model, gltf_sampler.input);
+
+				// outputs may be normalized integers, e.g. rotations exported with KHR_mesh_quantization
+				if (gltf_channel.target_path == "translation" || gltf_channel.target_path == "scale")
+				{
+					channel.path = gltf_channel.target_path == "translation" ? CookedModelPack::ChannelPath::kTranslation : CookedModelPack::ChannelPath::kScale;
+
+					for (auto&& value : ReadAttribute<glm::vec3>(gltf_model, gltf_sampler.output))
+					{
+						channel.values.push_back(glm::vec4(value, 0.0f));
+					}
+				}
+				else if (gltf_channel.target_path == "rotation")
+				{
+					channel.path = CookedModelPack::ChannelPath::kRotation;
+					channel.values = ReadAttribute<glm::vec4>(gltf_model, gltf_sampler.output);
+				}
+				else continue;
+
+				if (channel.times.empty() || channel.values.size() != channel.times.size() * (channel.interpolation == InterpolationType::kCubicSpline ? 3 : 1))
+					continue;
+
+				if (options.animation_tolerance > 0.0f && channel.interpolation == InterpolationType::kLinear)
+				{
+					ReduceLinearKeys(channel.times, channel.values, options.animation_tolerance, channel.path == CookedModelPack::ChannelPath::kRotation);
+				}
+
+				animation.channels.push_back(std::move(channel));
+			}
+
+			pack.animations.push_back(std::move(animation));
+		}
+
+		pack.storage = std::move(generated_buffers);
+
+		return pack;
+	}
+
+	void WriteCookedModelPack(const CookedModelPack& pack, uint64_t source_hash, const std::string& path)
+	{
+		BinaryWriter writer;
+
+		FileHeader header{};
+		std::memcpy(header.magic, kMagic, sizeof(kMagic));
+		header.version = kCookedModelPackVersion;
+		header.cook_flags = GetCookFlags(pack.options);
+		header.source_hash = source_hash;
+
+		writer.Write(header);
+		writer.Write(pack.source_buffers_bytes);
+
+		writer.Write(uint64_t(pack.buffers.size()));
+
+		for (auto&& buffer : pack.buffers)
+		{
+			writer.WriteBlob(buffer);
+		}
+
+		writer.Write(uint64_t(pack.images.size()));
+
+		for (auto&& mip_chain : pack.images)
+		{
+			writer.Write(uint32_t(mip_chain ? 1 : 0));
+
+			if (!mip_chain)
+				continue;
+
+			writer.Write(mip_chain->format);
+			writer.Write(mip_chain->extent);
+			writer.WriteVector(std::vector<uint64_t>(mip_chain->level_offsets.begin(), mip_chain->level_offsets.end()));
+			writer.WriteBlob(mip_chain->data);
+		}
+
+		writer.WriteVector(pack.materials);
+
+		writer.Write(uint64_t(pack.meshes.size()));
+
+		for (auto&& mesh : pack.meshes)
+		{
+			writer.WriteString(mesh.name);
+			writer.WriteVector(mesh.primitives);
+			writer.Write(mesh.cache_stats_before);
+			writer.Write(mesh.cache_stats_after);
+			writer.Write(mesh.dequantization);
+		}
+
+		writer.WriteVector(pack.nodes);
+
+		writer.Write(uint64_t(pack.models.size()));
+
+		for (auto&& model : pack.models)
+		{
+			writer.WriteString(model.name);
+			writer.Write(model.node);
+			writer.Write(model.mesh);
+			writer.Write(model.skin);
+		}
+
+		writer.Write(uint64_t(pack.skins.size()));
+
+		for (auto&& skin : pack.skins)
+		{
+			writer.WriteVector(skin.joints);
+			writer.WriteVector(skin.inverse_bind_matrices);
+			writer.WriteVector(skin.parent_indices);
+		}
+
+		writer.Write(uint64_t(pack.animations.size()));
+
+		for (auto&& animation : pack.animations)
+		{
+			writer.WriteString(animation.name);
+			writer.Write(uint64_t(animation.channels.size()));
+
+			for (auto&& channel : animation.channels)
+			{
+				writer.Write(channel.path);
+				writer.Write(channel.node_index);
+				writer.Write(channel.interpolation);
+				writer.WriteVector(channel.times);
+				writer.WriteVector(channel.values);
+			}
+		}
+
+		// written aside and renamed, so a failed write never leaves a truncated entry behind
+		std::string temp_path = path + ".tmp";
+
+		{
+			std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+
+			if (!file)
+				throw std::runtime_error("failed to create cooked model pack file");
+
+			file.write(reinterpret_cast<const char*>(writer.GetData().data()), writer.GetData().size());
+
+			if (!file)
+				throw std::runtime_error("failed to write cooked model pack file");
+		}
+
+		std::filesystem::rename(temp_path, path);
+	}
+
+	std::optional<CookedModelPack> MapCookedModelPack(const std::string& path, uint64_t source_hash, const CookOptions& options)
+	{
+		if (!std::filesystem::exists(path))
+			return std::nullopt;
+
+		try
+		{
+			auto&& file = std::make_shared<const MappedFile>(path);
+			BinaryReader reader(file->GetData());
+
+			FileHeader header = reader.Read<FileHeader>();
+
+			if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kCookedModelPackVersion || header.source_hash != source_hash || header.cook_flags != GetCookFlags(options))
+				return std::nullopt;
+
+			CookedModelPack pack;
+			pack.options = options;
+			pack.source_buffers_bytes = reader.Read<uint64_t>();
+
+			pack.buffers.resize(reader.Read<uint64_t>());
+
+			for (auto&& buffer : pack.buffers)
+			{
+				buffer = reader.ReadBlob();
+			}
+
+			pack.images.resize(reader.Read<uint64_t>());
+
+			for (auto&& image : pack.images)
+			{
+				if (reader.Read<uint32_t>() == 0)
+					continue;
+
+				MipChain mip_chain;
+				mip_chain.format = reader.Read<VkFormat>();
+				mip_chain.extent = reader.Read<Extent>();
+
+				for (auto&& level_offset : reader.ReadVector<uint64_t>())
+				{
+					mip_chain.level_offsets.push_back(size_t(level_offset));
+				}
+
+				mip_chain.data = reader.ReadBlob();
+				mip_chain.storage = file;
+
+				if (mip_chain.level_offsets.empty() || mip_chain.level_offsets.back() >= mip_chain.data.size())
+					throw std::runtime_error("failed to read cooked model pack, mip level is out of range");
+
+				image = std::make_shared<const MipChain>(std::move(mip_chain));
+			}
+
+			pack.materials = reader.ReadVector<CookedModelPack::Material>();
+
+			for (auto&& material : pack.materials)
+			{
+				for (auto&& texture : { material.albedo, material.metallic_roughness, material.normal_map })
+				{
+					if (texture.image < -1 || texture.image >= int32_t(pack.images.size()) || texture.fallback_image < -1 || texture.fallback_image >= int32_t(pack.images.size()))
+						throw std::runtime_error("failed to read cooked model pack, texture image is out of range");
+				}
+			}
+
+			pack.meshes.resize(reader.Read<uint64_t>());
+
+			for (auto&& mesh : pack.meshes)
+			{
+				mesh.name = reader.ReadString();
+				mesh.primitives = reader.ReadVector<CookedModelPack::Primitive>();
+				mesh.cache_stats_before = reader.Read<VertexCacheStats>();
+				mesh.cache_stats_after = reader.Read<VertexCacheStats>();
+				mesh.dequantization = reader.Read<glm::mat4>();
+
+				for (auto&& primitive : mesh.primitives)
+				{
+					if (primitive.material < -1 || primitive.material >= int32_t(pack.materials.size()))
+						throw std::runtime_error("failed to read cooked model pack, primitive material is out of range");
+
+					ValidateIndices(pack, primitive.indices);
+
+					if (primitive.lods_count > kMaxLodsCount)
+						throw std::runtime_error("failed to read cooked model pack, too many lods");
+
+					for (uint32_t lod = 0; lod < primitive.lods_count; lod++)
+					{
+						ValidateIndices(pack, primitive.lods[lod].indices);
+					}
+
+					for (auto&& vertex_buffer : primitive.vertex_buffers)
+					{
+						ValidateAccessor(pack, vertex_buffer);
+					}
+				}
+			}
+
+			pack.nodes = reader.ReadVector<CookedModelPack::Node>();
+
+			for (uint32_t node_index = 0; node_index < pack.nodes.size(); node_index++)
+			{
+				// every parent chain has to reach a root within nodes count steps
+				int32_t parent = pack.nodes[node_index].parent;
+
+				for (size_t depth = 0; parent != -1; depth++)
+				{
+					if (parent < -1 || parent >= int32_t(pack.nodes.size()) || depth >= pack.nodes.size())
+						throw std::runtime_error("failed to read cooked model pack, node parent is out of range");
+
+					parent = pack.nodes[parent].parent;
+				}
+			}
+
+			pack.models.resize(reader.Read<uint64_t>());
+
+			for (auto&& model : pack.models)
+			{
+				model.name = reader.ReadString();
+				model.node = reader.Read<uint32_t>();
+				model.mesh = reader.Read<uint32_t>();
+				model.skin = reader.Read<int32_t>();
+
+				if (model.node >= pack.nodes.size() || model.mesh >= pack.meshes.size())
+					throw std::runtime_error("failed to read cooked model pack, model is out of range");
+			}
+
+			pack.skins.resize(reader.Read<uint64_t>());
+
+			for (auto&& skin : pack.skins)
+			{
+				skin.joints = reader.ReadVector<uint32_t>();
+				skin.inverse_bind_matrices = reader.ReadVector<glm::mat4>();
+				skin.parent_indices = reader.ReadVector<int16_t>();
+
+				if (skin.inverse_bind_matrices.size() != skin.joints.size() || std::any_of(skin.joints.begin(), skin.joints.end(), [&](uint32_t joint) { return joint >= pack.nodes.size(); }))
+					throw std::runtime_error("failed to read cooked model pack, skin is malformed");
+
+				if (skin.parent_indices.size() != skin.joints.size() || std::any_of(skin.parent_indices.begin(), skin.parent_indices.end(), [&](int16_t parent) { return parent < -1 || parent >= int32_t(skin.joints.size()); }))
+					throw std::runtime_error("failed to read cooked model pack, skin parent is out of range");
+			}
+
+			for (auto&& model : pack.models)
+			{
+				if (model.skin < -1 || model.skin >= int32_t(pack.skins.size()))
+					throw std::runtime_error("failed to read cooked model pack, model skin is out of range");
+			}
+
+			pack.animations.resize(reader.Read<uint64_t>());
+
+			for (auto&& animation : pack.animations)
+			{
+				animation.name = reader.ReadString();
+				animation.channels.resize(reader.Read<uint64_t>());
+
+				for (auto&& channel : animation.channels)
+				{
+					channel.path = reader.Read<CookedModelPack::ChannelPath>();
+					channel.node_index = reader.Read<uint32_t>();
+					channel.interpolation = reader.Read<InterpolationType>();
+					channel.times = reader.ReadVector<float>();
+					channel.values = reader.ReadVector<glm::vec4>();
+
+					if (channel.node_index >= pack.nodes.size())
+						throw std::runtime_error("failed to read cooked model pack, animation node is out of range");
+
+					if (channel.times.empty() || channel.values.size() != channel.times.size() * (channel.interpolation == InterpolationType::kCubicSpline ? 3 : 1))
+						throw std::runtime_error("failed to read cooked model pack, animation channel is malformed");
+				}
+			}
+
+			pack.storage = std::move(file);
+
+			return pack;
+		}
+		catch (const std::runtime_error&)
+		{
+			return std::nullopt;
+		}
+	}
+
+	uint64_t HashSource(const std::string& gltf_path)
+	{
+		uint64_t hash = 14695981039346656037ull;
+
+		std::filesystem::path path = std::filesystem::absolute(gltf_path);
+		HashFileStamp(hash, path);
+
+		for (auto&& external_file : GetExternalFiles(path))
+		{
+			HashFileStamp(hash, external_file);
+		}
+
+		return hash;
+	}
+
+	std::string GetCookedModelPackPath(const std::string& cache_dir, uint64_t source_hash)
+	{
+		char file_name[32];
+		std::snprintf(file_name, sizeof(file_name), "%016llx.vvfpack", static_cast<unsigned long long>(source_hash));
+
+		return (std::filesystem::path(cache_dir) / file_name).string();
+	}
+
+	CookedModelPack LoadCookedModelPack(const std::string& gltf_path, const std::string& cache_dir, const CookOptions& options)
+	{
+		if (cache_dir.empty())
+			return CookFile(gltf_path, options);
+
+		uint64_t source_hash = HashSource(gltf_path);
+		std::string cache_path = GetCookedModelPackPath(cache_dir, source_hash);
+
+		if (auto&& pack = MapCookedModelPack(cache_path, source_hash, options))
+			return std::move(*pack);
+
+		CookedModelPack pack = CookFile(gltf_path, options);
+
+		// a failed cache write only costs the next load another cooking
+		try
+		{
+			std::filesystem::create_directories(cache_dir);
+			WriteCookedModelPack(pack, source_hash, cache_path);
+		}
+		catch (const std::exception&)
+		{
+		}
+
+		return pack;
+	}
+
+	bool CookModelPack(const std::string& gltf_path, const std::string& cache_dir, const CookOptions& options, std::vector<MeshCacheReport>* mesh_reports)
+	{
+		try
+		{
+			uint64_t source_hash = HashSource(gltf_path);
+			std::string cache_path = GetCookedModelPackPath(cache_dir, source_hash);
+
+			std::optional<CookedModelPack> pack = MapCookedModelPack(cache_path, source_hash, options);
+
+			if (!pack)
+			{
+				pack = CookFile(gltf_path, options);
+
+				std::filesystem::create_directories(cache_dir);
+				WriteCookedModelPack(*pack, source_hash, cache_path);
+			}
+
+			if (mesh_reports)
+			{
+				for (auto&& mesh : pack->meshes)
+				{
+					mesh_reports->push_back({ mesh.name,
+						mesh.cache_stats_before.GetACMR(), mesh.cache_stats_before.GetATVR(),
+						mesh.cache_stats_after.GetACMR(), mesh.cache_stats_after.GetATVR() });
+				}
+			}
+
+			return true;
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+	}
+}
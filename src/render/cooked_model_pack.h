@@ -0,0 +1,171 @@
+#ifndef RENDER_ENGINE_RENDER_COOKED_MODEL_PACK_H_
+#define RENDER_ENGINE_RENDER_COOKED_MODEL_PACK_H_
+
+#include <array>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+#include "glm/glm/glm.hpp"
+
+#pragma warning(push, 0)
+#include "tinygltf/tiny_gltf.h"
+#pragma warning(pop)
+
+#include "common.h"
+#include "render/data_types.h"
+#include "render/image.h"
+#include "render/mesh.h"
+#include "render/mesh_optimizer.h"
+#include "render/render_engine.h"
+
+namespace render
+{
+	// bump when the file layout or the cooking changes, older cache entries are recooked
+	const uint32_t kCookedModelPackVersion = 13;
+
+	// ModelPack contents in their final GPU ready form, cooked from glTF once and cached in memory mapped files.
+	// Buffers and texture levels point into storage, the mapped file or the buffers generated by cooking.
+	// Only index and vertex streams are kept, packed into a single buffer with 16 byte aligned streams.
+	struct CookedModelPack
+	{
+		struct Accessor
+		{
+			int32_t buffer = -1;
+			uint32_t stride = 0;
+			uint64_t offset = 0;
+			uint32_t count = 0;
+		};
+
+		// fallback_image is used when image can't be loaded on the device, e.g. basis universal sources
+		struct TextureRef
+		{
+			int32_t image = -1;
+			int32_t fallback_image = -1;
+		};
+
+		struct Material
+		{
+			TextureRef albedo;
+			TextureRef metallic_roughness;
+			TextureRef normal_map;
+			uint32_t flags = 0;
+		};
+
+		// coarser index list over the vertex buffers of its primitive, error is in object space units
+		struct Lod
+		{
+			Accessor indices;
+			float error = 0.0f;
+		};
+
+		struct Primitive
+		{
+			Accessor indices;
+			std::array<Lod, kMaxLodsCount> lods;
+			uint32_t lods_count = 0;
+			std::array<Accessor, kVertexBufferTypesCount> vertex_buffers;
+			glm::vec3 bounds_min = glm::vec3(-std::numeric_limits<float>::max());
+			glm::vec3 bounds_max = glm::vec3(std::numeric_limits<float>::max());
+			int32_t material = -1;
+		};
+
+		struct Mesh
+		{
+			std::string name;
+			std::vector<Primitive> primitives;
+			// of the source index order and the cooked one, equal unless meshes were optimized
+			VertexCacheStats cache_stats_before;
+			VertexCacheStats cache_stats_after;
+			// identity unless primitives have quantized streams
+			glm::mat4 dequantization = glm::identity<glm::mat4>();
+		};
+
+		struct Node
+		{
+			glm::mat4 local_transform;
+			int32_t parent = -1;
+		};
+
+		struct Model
+		{
+			std::string name;
+			uint32_t node;
+			uint32_t mesh;
+			// -1 for static meshes
+			int32_t skin = -1;
+		};
+
+		struct Skin
+		{
+			std::vector<uint32_t> joints;
+			std::vector<glm::mat4> inverse_bind_matrices;
+			// index in joints, -1 for roots
+			std::vector<int16_t> parent_indices;
+		};
+
+		enum class ChannelPath : uint32_t
+		{
+			kTranslation,
+			kRotation,
+			kScale,
+		};
+
+		// times in seconds, one value per time, three for cubic spline keys: in tangent, value and out tangent, rotations are xyzw
+		struct AnimationChannel
+		{
+			ChannelPath path;
+			uint32_t node_index;
+			InterpolationType interpolation;
+			std::vector<float> times;
+			std::vector<glm::vec4> values;
+		};
+
+		struct Animation
+		{
+			std::string name;
+			std::vector<AnimationChannel> channels;
+		};
+
+		std::vector<std::span<const unsigned char>> buffers;
+		// size of all glTF buffers the pack was cooked from, images and animation data included
+		uint64_t source_buffers_bytes = 0;
+		// null for images that failed to decode
+		std::vector<std::shared_ptr<const MipChain>> images;
+		std::vector<Material> materials;
+		std::vector<Mesh> meshes;
+		std::vector<Node> nodes;
+		std::vector<Model> models;
+		std::vector<Skin> skins;
+		std::vector<Animation> animations;
+
+		CookOptions options;
+
+		std::shared_ptr<const void> storage;
+	};
+
+	// Decodes images in parallel, generates missing tangents and copies geometry out of gltf_model.
+	// Index streams are 16 bit when the indices fit and 32 bit otherwise, vertex streams are float or quantized.
+	// Meshopt compressed buffer views are decoded into a copy of gltf_model, pass decoded models to skip the copy.
+	CookedModelPack CookGLTF(const tinygltf::Model& gltf_model, const CookOptions& options = {});
+
+	void WriteCookedModelPack(const CookedModelPack& pack, uint64_t source_hash, const std::string& path);
+
+	// empty if the file is missing, truncated, or was cooked from another source, by another version or with other options
+	std::optional<CookedModelPack> MapCookedModelPack(const std::string& path, uint64_t source_hash, const CookOptions& options);
+
+	// FNV-1a of the path, size and last write time of the glTF file and of every external buffer and image it references.
+	// Sources are not read beyond the glTF JSON, so a warm load costs a few stat calls.
+	uint64_t HashSource(const std::string& gltf_path);
+
+	std::string GetCookedModelPackPath(const std::string& cache_dir, uint64_t source_hash);
+
+	// Maps the cache entry of the glTF file, the file is cooked and the entry written on a miss.
+	// An empty cache_dir cooks without caching.
+	CookedModelPack LoadCookedModelPack(const std::string& gltf_path, const std::string& cache_dir, const CookOptions& options);
+}
+#endif  // RENDER_ENGINE_RENDER_COOKED_MODEL_PACK_H_
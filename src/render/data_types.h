@@ -43,13 +43,32 @@ namespace render
 		kHighRangeColor,
 		kColor,
 		kDepth,
+		kOctahedralNormal,
+		kMetallicRoughness,
 
 		Count
 	};
 
+	enum class GBufferLayout
+	{
+		// RGBA32F albedo, position, normal and metallic/roughness
+		kFull,
+		// sRGB albedo, octahedral RG16 normal, RG8 metallic/roughness, position restored from depth
+		kCompact
+	};
+
 	const int kExtentTypeCnt = static_cast<int>(ExtentType::Count);
 	const int kFormatTypeCnt = static_cast<int>(FormatType::Count);
 
+	// should match light_clusters.glsl
+	const uint32_t kMaxLightsCount = 4096;
+	const uint32_t kMaxLightsPerCluster = 64;
+
+	const uint32_t kLightClusterGridX = 16;
+	const uint32_t kLightClusterGridY = 9;
+	const uint32_t kLightClusterGridZ = 24;
+	const uint32_t kLightClustersCount = kLightClusterGridX * kLightClusterGridY * kLightClusterGridZ;
+
 	struct Extent
 	{
 		uint32_t width;
@@ -73,6 +92,7 @@ namespace render
 		Vertex,
 		Geometry,
 		Fragment,
+		Compute,
 
 		Invalid = -1
 	};
@@ -84,6 +104,7 @@ namespace render
 		Vertex = 1 << static_cast<int>(ShaderType::Vertex),
 		Geometry = 1 << static_cast<int>(ShaderType::Geometry),
 		Fragment = 1 << static_cast<int>(ShaderType::Fragment),
+		Compute = 1 << static_cast<int>(ShaderType::Compute),
 	};
 
 	constexpr ShaderTypeFlags operator|(ShaderTypeFlags lhs, ShaderTypeFlags rhs) {
@@ -6,20 +6,23 @@
 #include "common.h"
 #include "global.h"
 
-render::DescriptorPool::DescriptorPool(const Global& global, uint32_t uniform_set_cnt, uint32_t sampler_set_cnt):
+render::DescriptorPool::DescriptorPool(const Global& global, uint32_t uniform_set_cnt, uint32_t sampler_set_cnt, uint32_t storage_set_cnt, uint32_t input_attachment_set_cnt, VkDescriptorPoolCreateFlags flags):
 	RenderObjBase(global)
 {
-	std::array<VkDescriptorPoolSize, 2> pool_sizes{};
-	pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	pool_sizes[0].descriptorCount = uniform_set_cnt;
-	pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	pool_sizes[1].descriptorCount = sampler_set_cnt;
+	std::vector<VkDescriptorPoolSize> pool_sizes;
+
+	// zero descriptor counts are not allowed
+	if (uniform_set_cnt > 0) pool_sizes.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, uniform_set_cnt });
+	if (sampler_set_cnt > 0) pool_sizes.push_back({ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampler_set_cnt });
+	if (storage_set_cnt > 0) pool_sizes.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storage_set_cnt });
+	if (input_attachment_set_cnt > 0) pool_sizes.push_back({ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, input_attachment_set_cnt });
 
 	VkDescriptorPoolCreateInfo pool_info{};
 	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.flags = flags;
 	pool_info.poolSizeCount = u32(pool_sizes.size());
 	pool_info.pPoolSizes = pool_sizes.data();
-	pool_info.maxSets = uniform_set_cnt + sampler_set_cnt;
+	pool_info.maxSets = uniform_set_cnt + sampler_set_cnt + storage_set_cnt + input_attachment_set_cnt;
 
 	if (vkCreateDescriptorPool(global_.logical_device, &pool_info, nullptr, &handle_) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create descriptor pool!");
@@ -43,6 +46,32 @@ void render::DescriptorPool::AllocateSet(VkDescriptorSetLayout descriptor_set_la
 	}
 }
 
+bool render::DescriptorPool::TryAllocateSet(VkDescriptorSetLayout descriptor_set_layout, uint32_t count, std::vector<VkDescriptorSet>& allocated_sets)
+{
+	std::vector<VkDescriptorSetLayout> layouts(count, descriptor_set_layout);
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = handle_;
+	allocInfo.descriptorSetCount = count;
+	allocInfo.pSetLayouts = layouts.data();
+
+	allocated_sets.resize(count);
+
+	VkResult result = vkAllocateDescriptorSets(global_.logical_device, &allocInfo, allocated_sets.data());
+
+	if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+	{
+		allocated_sets.clear();
+		return false;
+	}
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate descriptor sets!");
+	}
+
+	return true;
+}
+
 void render::DescriptorPool::FreeSet(std::vector<VkDescriptorSet>& allocated_sets)
 {
 	vkFreeDescriptorSets(global_.logical_device, handle_, u32(allocated_sets.size()), allocated_sets.data());
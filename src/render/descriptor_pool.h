@@ -14,7 +14,7 @@ namespace render
 	class DescriptorPool : public RenderObjBase<VkDescriptorPool>
 	{
 	public:
-		DescriptorPool(const Global& global, uint32_t uniform_set_cnt, uint32_t sampler_set_cnt);
+		DescriptorPool(const Global& global, uint32_t uniform_set_cnt, uint32_t sampler_set_cnt, uint32_t storage_set_cnt = 0, uint32_t input_attachment_set_cnt = 0, VkDescriptorPoolCreateFlags flags = 0);
 
 		DescriptorPool(const DescriptorPool&) = delete;
 		DescriptorPool(DescriptorPool&&) = default;
@@ -23,6 +23,9 @@ namespace render
 		DescriptorPool& operator=(DescriptorPool&&) = default;
 
 		void AllocateSet(VkDescriptorSetLayout descriptor_set_layout, uint32_t count,std::vector<VkDescriptorSet>& allocated_sets);
+
+		// returns false if the pool is exhausted, other errors throw
+		bool TryAllocateSet(VkDescriptorSetLayout descriptor_set_layout, uint32_t count, std::vector<VkDescriptorSet>& allocated_sets);
 		void FreeSet(std::vector<VkDescriptorSet>& allocated_sets);
 
 		virtual ~DescriptorPool() override;
@@ -29,10 +29,17 @@ namespace render
 	{
 		kUniform,
 		kSampler,
+		kStorage,
+		kInputAttachment,
+		kSamplerArray,
 
 		Count
 	};
 
+	// kSamplerArray bindings hold this many partially bound descriptors, written after bind
+	const uint32_t kBindlessTexturesCount = 4096;
+	const uint32_t kMaterialsCount = 1024;
+
 	const uint32_t kDescriptorSetTypesCount = static_cast<uint32_t>(DescriptorSetType::Count);
 
 
@@ -71,6 +78,16 @@ namespace render
 		{};
 	};
 
+	template<ShaderTypeFlags shader_flags>
+	struct BindingBase<DescriptorBindingType::kSamplerArray, shader_flags>
+	{
+		static const DescriptorBindingType type = DescriptorBindingType::kSamplerArray;
+		static const ShaderTypeFlags shaders_flags = shader_flags;
+
+		struct Data
+		{};
+	};
+
 
 	template<DescriptorSetType Type>
 	struct DescriptorSetBindings;
@@ -88,6 +105,7 @@ namespace render
 			{
 				glm::vec4 position;
 				glm::mat4 proj_view_mat;
+				glm::mat4 inv_proj_view_mat;
 			};
 		};
 	};
@@ -134,71 +152,101 @@ namespace render
 		template<int i>
 		struct Binding {using NotBinded = void;};
 
+		// model matrices of all scene models indexed by gl_InstanceIndex, per frame, sized by the scene
 		template<>
-		struct Binding<0> : BindingBase<DescriptorBindingType::kUniform, ShaderTypeFlags::Vertex>
+		struct Binding<0> : BindingBase<DescriptorBindingType::kStorage, ShaderTypeFlags::Vertex>
 		{
 			struct Data
 			{
-				glm::mat4 model_mat;
+				glm::mat4 model_mats[1];
 			};
 		};
 	};
 
+	// Written by SkinningCache, which grows the buffers with the skinned models, so Data only describes the elements.
 	template<>
 	struct DescriptorSetBindings<DescriptorSetType::kSkeleton>
 	{
 		template<int i>
 		struct Binding {using NotBinded = void;};
 
+		// joint matrices of all skinned models, per frame
 		template<>
-		struct Binding<0> : BindingBase<DescriptorBindingType::kUniform, ShaderTypeFlags::Vertex>
+		struct Binding<0> : BindingBase<DescriptorBindingType::kStorage, ShaderTypeFlags::Compute>
+		{
+			struct Data
+			{
+				glm::mat4 joint_matrices[1];
+			};
+		};
+
+		// skinned positions, normals and tangents, read as vertex streams by the graphics passes
+		template<>
+		struct Binding<1> : BindingBase<DescriptorBindingType::kStorage, ShaderTypeFlags::Compute>
 		{
 			struct Data
 			{
-				glm::mat4 matrices[32];
+				float values[1];
 			};
 		};
 	};
 
+	// geometry buffer of a pack with the source streams of skinned primitives
 	template<>
-	struct DescriptorSetBindings<DescriptorSetType::kMaterial>
+	struct DescriptorSetBindings<DescriptorSetType::kSkinningSource>
 	{
 		template<int i>
 		struct Binding {using NotBinded = void;};
 
 		template<>
-		struct Binding<0> : BindingBase<DescriptorBindingType::kUniform, ShaderTypeFlags::Fragment>
+		struct Binding<0> : BindingBase<DescriptorBindingType::kStorage, ShaderTypeFlags::Compute>
 		{
 			struct Data
 			{
-				uint32_t flags;
+				uint32_t values[1];
 			};
 		};
+	};
+
+	struct MaterialData
+	{
+		glm::vec4 color;
+
+		// indices into the kMaterials texture array
+		uint32_t albedo_index;
+		uint32_t metallic_roughness_index;
+		uint32_t normal_map_index;
+
+		uint32_t flags;
+	};
+
+	template<>
+	struct DescriptorSetBindings<DescriptorSetType::kMaterials>
+	{
+		template<int i>
+		struct Binding {using NotBinded = void;};
 
 		template<>
-		struct Binding<1> : BindingBase<DescriptorBindingType::kSampler, ShaderTypeFlags::Fragment>
+		struct Binding<0> : BindingBase<DescriptorBindingType::kStorage, ShaderTypeFlags::Fragment>
 		{
 			struct Data
 			{
-				std::optional<SamplerData> albedo;
+				MaterialData materials[kMaterialsCount];
 			};
 		};
 
 		template<>
-		struct Binding<2> : BindingBase<DescriptorBindingType::kSampler, ShaderTypeFlags::Fragment>
+		struct Binding<1> : BindingBase<DescriptorBindingType::kSamplerArray, ShaderTypeFlags::Fragment>
 		{
-			struct Data
-			{
-				std::optional<SamplerData> metallic_roughness;
-			};
 		};
 
+		// finest mip level sampled per texture during the frame, relative to the bound view, read back by texture streaming
 		template<>
-		struct Binding<3> : BindingBase<DescriptorBindingType::kSampler, ShaderTypeFlags::Fragment>
+		struct Binding<2> : BindingBase<DescriptorBindingType::kStorage, ShaderTypeFlags::Fragment>
 		{
 			struct Data
 			{
-				std::optional<SamplerData> normal_map;
+				int32_t min_lods[kBindlessTexturesCount];
 			};
 		};
 	};
@@ -262,7 +310,7 @@ namespace render
 		struct Binding {using NotBinded = void;};
 
 		template<>
-		struct Binding<0> : BindingBase<DescriptorBindingType::kSampler, ShaderTypeFlags::Fragment>
+		struct Binding<0> : BindingBase<DescriptorBindingType::kInputAttachment, ShaderTypeFlags::Fragment>
 		{
 			struct Data
 			{
@@ -271,16 +319,17 @@ namespace render
 		};
 
 		template<>
-		struct Binding<1> : BindingBase<DescriptorBindingType::kSampler, ShaderTypeFlags::Fragment>
+		struct Binding<1> : BindingBase<DescriptorBindingType::kInputAttachment, ShaderTypeFlags::Fragment>
 		{
 			struct Data
 			{
+				// depth for GBufferLayout::kCompact
 				std::optional<SamplerData> position;
 			};
 		};
 
 		template<>
-		struct Binding<2> : BindingBase<DescriptorBindingType::kSampler, ShaderTypeFlags::Fragment>
+		struct Binding<2> : BindingBase<DescriptorBindingType::kInputAttachment, ShaderTypeFlags::Fragment>
 		{
 			struct Data
 			{
@@ -289,7 +338,7 @@ namespace render
 		};
 
 		template<>
-		struct Binding<3> : BindingBase<DescriptorBindingType::kSampler, ShaderTypeFlags::Fragment>
+		struct Binding<3> : BindingBase<DescriptorBindingType::kInputAttachment, ShaderTypeFlags::Fragment>
 		{
 			struct Data
 			{
@@ -351,10 +400,96 @@ namespace render
 		};
 	};
 
+	struct LightData
+	{
+		glm::vec4 position_radius;
+		glm::vec4 color_intensity;
+	};
+
+	template<>
+	struct DescriptorSetBindings<DescriptorSetType::kLights>
+	{
+		template<int i>
+		struct Binding { using NotBinded = void; };
+
+		template<>
+		struct Binding<0> : BindingBase<DescriptorBindingType::kStorage, ShaderTypeFlags::Compute | ShaderTypeFlags::Fragment>
+		{
+			struct Data
+			{
+				uint32_t count;
+				uint32_t padding[3];
+				LightData lights[kMaxLightsCount];
+			};
+		};
+
+		template<>
+		struct Binding<1> : BindingBase<DescriptorBindingType::kUniform, ShaderTypeFlags::Compute | ShaderTypeFlags::Fragment>
+		{
+			struct Data
+			{
+				glm::mat4 view;
+				glm::vec4 projection_params;
+				glm::uvec4 grid_size;
+			};
+		};
+	};
+
+	template<>
+	struct DescriptorSetBindings<DescriptorSetType::kLightClusters>
+	{
+		template<int i>
+		struct Binding { using NotBinded = void; };
+
+		template<>
+		struct Binding<0> : BindingBase<DescriptorBindingType::kStorage, ShaderTypeFlags::Compute | ShaderTypeFlags::Fragment>
+		{
+			struct Data
+			{
+				uint32_t counts[kLightClustersCount];
+				uint32_t indices[kLightClustersCount * kMaxLightsPerCluster];
+			};
+		};
+	};
+
+	// Counted by light_culling.comp, per frame, read back and cleared by the scene once the frame fence is signaled.
+	template<>
+	struct DescriptorSetBindings<DescriptorSetType::kLightCullingStats>
+	{
+		template<int i>
+		struct Binding { using NotBinded = void; };
+
+		template<>
+		struct Binding<0> : BindingBase<DescriptorBindingType::kStorage, ShaderTypeFlags::Compute>
+		{
+			struct Data
+			{
+				// clusters touched by more than kMaxLightsPerCluster lights and the lights they dropped
+				uint32_t overflowed_clusters;
+				uint32_t dropped_lights;
+			};
+		};
+	};
+
+	template<class T, int n>
+	struct SamplersOnly
+	{
+		static const bool value = T::template Binding<n - 1>::type == DescriptorBindingType::kSampler && SamplersOnly<T, n - 1>::value;
+	};
+
+	template<class T>
+	struct SamplersOnly<T, 0>
+	{
+		static const bool value = true;
+	};
+
 	template<DescriptorSetType Type>
 	struct DescriptorSet : DescriptorSetBindings<Type>
 	{
 		static const uint32_t binding_count = BindingCounter<DescriptorSetBindings<Type>>::count;
+
+		// sets that only reference images are shared between holders with identical contents
+		static const bool shared_by_contents = SamplersOnly<DescriptorSetBindings<Type>, binding_count>::value;
 	};
 
 	struct DescriptorSetInfo
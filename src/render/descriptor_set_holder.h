@@ -1,9 +1,12 @@
 #ifndef RENDER_ENGINE_RENDER_DESCRIPTOR_SET_HOLDER_H_
 #define RENDER_ENGINE_RENDER_DESCRIPTOR_SET_HOLDER_H_
 
+#include <cstring>
 #include <map>
+#include <memory>
 #include <variant>
 #include <span>
+#include <type_traits>
 
 #include "vulkan/vulkan.h"
 
@@ -14,13 +17,16 @@
 #include "render/object_base.h"
 #include "render/descriptor_set.h"
 #include "render/descriptor_sets_manager.h"
+#include "render/descriptor_update_template.h"
 #include "render/global.h"
 
 namespace render
 {
 	namespace descriptor_sets_holder
 	{
-
+		// sources that track their changes return versions starting from 1 and growing on every change,
+		// unversioned sources are refilled every frame
+		const uint64_t kUnversioned = 0;
 
 		template<typename DataType, DescriptorBindingType BindingType>
 		class BindingData;
@@ -31,7 +37,12 @@ namespace render
 			std::array<UniformBuffer, kFramesCount> uniform_buffers_;
 			std::array<bool, kFramesCount> attached_per_frame_;
 
-			VkDescriptorBufferInfo vk_buffer_info_;
+			// version of the data copied to each frame buffer
+			std::array<uint64_t, kFramesCount> uploaded_versions_;
+
+			DataType data_;
+			uint64_t data_version_;
+
 		protected:
 			std::reference_wrapper<const Global> global_ref_;
 		public:
@@ -48,50 +59,140 @@ namespace render
 			{
 				false, false, false, false
 			},
+				uploaded_versions_{},
+				data_{},
+				data_version_(kUnversioned),
 				global_ref_(global)
 			{}
 
 			virtual bool FillData(DataType& data) = 0;
 
-			bool UpdateAndTryFillWrite(int frame_index, VkWriteDescriptorSet& write_desc_set)
+			virtual uint64_t GetDataVersion(std::type_identity<DataType>) const { return kUnversioned; }
+
+			bool UpdateAndTryFillInfo(int frame_index, DescriptorInfo& info)
 			{
-				uint32_t size = sizeof(DataType);
+				uint64_t source_version = GetDataVersion(std::type_identity<DataType>());
 
-				DataType new_data;
-				if (FillData(new_data))
+				if (source_version == kUnversioned)
 				{
-					void* mapped_data;
-					vkMapMemory(uniform_buffers_[frame_index].GetGlobal().logical_device, uniform_buffers_[frame_index].GetBufferMemory().vk_memory, uniform_buffers_[frame_index].GetBufferMemory().offset, size, 0, &mapped_data);
-					memcpy(mapped_data, &new_data, size);
-					vkUnmapMemory(uniform_buffers_[frame_index].GetGlobal().logical_device, uniform_buffers_[frame_index].GetBufferMemory().vk_memory);
+					// unversioned data is still compared, so unchanged data is not copied again
+					DataType new_data{};
+					if (!FillData(new_data))
+					{
+						DebugBreak();
+					}
+
+					if (data_version_ == kUnversioned || std::memcmp(&new_data, &data_, sizeof(DataType)) != 0)
+					{
+						data_ = new_data;
+						data_version_++;
+					}
 				}
-				else
+				else if (source_version != data_version_)
 				{
-					DebugBreak();
+					if (!FillData(data_))
+					{
+						DebugBreak();
+					}
+
+					data_version_ = source_version;
+				}
+
+				if (uploaded_versions_[frame_index] != data_version_)
+				{
+					uniform_buffers_[frame_index].LoadData(&data_, sizeof(DataType));
+					uploaded_versions_[frame_index] = data_version_;
+					global_ref_.get().uploaded_bytes += sizeof(DataType);
 				}
 
 
 				if (!attached_per_frame_[frame_index])
 				{
 					attached_per_frame_[frame_index] = true;
-					FillWriteDescriptorSet(frame_index, write_desc_set);
+
+					info.buffer.buffer = uniform_buffers_[frame_index].GetHandle();
+					info.buffer.offset = 0;
+					info.buffer.range = sizeof(DataType);
 					return true;
 				}
 				return false;
 			}
+		};
 
-			void FillWriteDescriptorSet(int frame_index, VkWriteDescriptorSet& write_desc_set)
+		template<typename DataType>
+		class BindingData<DataType, DescriptorBindingType::kStorage>
+		{
+			std::array<StorageBuffer, kFramesCount> storage_buffers_;
+			std::array<bool, kFramesCount> attached_per_frame_;
+
+			std::array<uint64_t, kFramesCount> uploaded_versions_;
+			uint64_t data_version_;
+
+			// storage data can be too large for the stack
+			std::unique_ptr<DataType> new_data_;
+
+		protected:
+			std::reference_wrapper<const Global> global_ref_;
+		public:
+
+			BindingData(const Global& global) :
+				storage_buffers_
+			{
+				StorageBuffer(global, sizeof(DataType)),
+				StorageBuffer(global, sizeof(DataType)),
+				StorageBuffer(global, sizeof(DataType)),
+				StorageBuffer(global, sizeof(DataType)),
+			},
+			attached_per_frame_
 			{
+				false, false, false, false
+			},
+				uploaded_versions_{},
+				data_version_(kUnversioned),
+				new_data_(std::make_unique<DataType>()),
+				global_ref_(global)
+			{}
+
+			virtual bool FillData(DataType& data) = 0;
+
+			// only the filled prefix of the data is uploaded
+			virtual size_t GetFilledSize(const DataType& data) const { return sizeof(DataType); }
 
-				vk_buffer_info_.buffer = uniform_buffers_[frame_index].GetHandle();
-				vk_buffer_info_.offset = 0;
-				vk_buffer_info_.range = sizeof(DataType);
+			virtual uint64_t GetDataVersion(std::type_identity<DataType>) const { return kUnversioned; }
 
-				write_desc_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				write_desc_set.dstArrayElement = 0;
-				write_desc_set.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-				write_desc_set.descriptorCount = 1;
-				write_desc_set.pBufferInfo = &vk_buffer_info_;
+			bool UpdateAndTryFillInfo(int frame_index, DescriptorInfo& info)
+			{
+				uint64_t source_version = GetDataVersion(std::type_identity<DataType>());
+
+				// storage data is too large to compare, unversioned data is uploaded every frame
+				if (source_version == kUnversioned || source_version != data_version_)
+				{
+					if (!FillData(*new_data_))
+					{
+						DebugBreak();
+					}
+
+					data_version_ = source_version == kUnversioned ? data_version_ + 1 : source_version;
+				}
+
+				if (uploaded_versions_[frame_index] != data_version_)
+				{
+					size_t size = GetFilledSize(*new_data_);
+					storage_buffers_[frame_index].LoadData(new_data_.get(), size);
+					uploaded_versions_[frame_index] = data_version_;
+					global_ref_.get().uploaded_bytes += size;
+				}
+
+				if (!attached_per_frame_[frame_index])
+				{
+					attached_per_frame_[frame_index] = true;
+
+					info.buffer.buffer = storage_buffers_[frame_index].GetHandle();
+					info.buffer.offset = 0;
+					info.buffer.range = sizeof(DataType);
+					return true;
+				}
+				return false;
 			}
 		};
 
@@ -100,9 +201,7 @@ namespace render
 		{
 			std::array<VkImage, kFramesCount> images_per_frame_;
 
-			std::array<std::optional<ImageView>, kFramesCount> image_views_;
-
-			VkDescriptorImageInfo vk_image_info_;
+			std::array<std::shared_ptr<const ImageView>, kFramesCount> image_views_;
 
 		protected:
 			std::reference_wrapper<const Global> global_ref_;
@@ -116,23 +215,17 @@ namespace render
 			}
 			{}
 
-			void FillWriteDescriptorSet(int frame_index, VkWriteDescriptorSet& write_desc_set, SamplerData& sampler_data)
+			void FillInfo(int frame_index, DescriptorInfo& info, SamplerData& sampler_data)
 			{
-				vk_image_info_.imageLayout = image_views_[frame_index]->GetFormat() == image_views_[frame_index]->GetGlobal().depth_map_format ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-				vk_image_info_.imageView = image_views_[frame_index]->GetHandle();
-				vk_image_info_.sampler = sampler_data.sampler.get().GetHandle();
+				info.image.imageLayout = image_views_[frame_index]->GetFormat() == image_views_[frame_index]->GetGlobal().depth_map_format ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-				write_desc_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				write_desc_set.dstArrayElement = 0;
-				write_desc_set.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-				write_desc_set.descriptorCount = 1;
-				write_desc_set.pImageInfo = &vk_image_info_;
+				info.image.imageView = image_views_[frame_index]->GetHandle();
+				info.image.sampler = sampler_data.sampler.get().GetHandle();
 			}
 
 			virtual bool FillData(DataType& data) = 0;
 
-			bool UpdateAndTryFillWrite(int frame_index, VkWriteDescriptorSet& write_desc_set)
+			bool UpdateAndTryFillInfo(int frame_index, DescriptorInfo& info)
 			{
 				DataType new_data;
 				if (FillData(new_data))
@@ -142,9 +235,9 @@ namespace render
 
 					if (images_per_frame_[frame_index] != sampler_data->image.get().GetHandle())
 					{
-						image_views_[frame_index].emplace(global_ref_.get(), sampler_data->image.get());
+						image_views_[frame_index] = global_ref_.get().image_view_cache.Get(global_ref_.get(), sampler_data->image.get());
 						images_per_frame_[frame_index] = sampler_data->image.get().GetHandle();
-						FillWriteDescriptorSet(frame_index, write_desc_set, *sampler_data);
+						FillInfo(frame_index, info, *sampler_data);
 						return true;
 					}
 
@@ -176,18 +269,14 @@ namespace render
 				BindingIter<Type, BindingIndex - 1>(global) {}
 
 
-			int UpdateAndTryFillWrites(int frame_index, VkDescriptorSet descriptor_set, std::span<VkWriteDescriptorSet>& descriptor_set_writes)
+			// returns true if any binding descriptor changed
+			bool UpdateAndTryFillInfos(int frame_index, std::span<DescriptorInfo> infos)
 			{
-				int filled_writes = BindingIter<Type, BindingIndex - 1>::UpdateAndTryFillWrites(frame_index, descriptor_set, descriptor_set_writes);
+				bool changed = BindingIter<Type, BindingIndex - 1>::UpdateAndTryFillInfos(frame_index, infos);
 
-				if (BindingData<typename DescriptorSet<Type>::template Binding<BindingIndex>::Data, DescriptorSet<Type>::template Binding<BindingIndex>::type>::UpdateAndTryFillWrite(frame_index, descriptor_set_writes[filled_writes]))
-				{
-					descriptor_set_writes[filled_writes].dstSet = descriptor_set;
-					descriptor_set_writes[filled_writes].dstBinding = BindingIndex;
-					return 1 + filled_writes;
-				}
+				changed |= BindingData<typename DescriptorSet<Type>::template Binding<BindingIndex>::Data, DescriptorSet<Type>::template Binding<BindingIndex>::type>::UpdateAndTryFillInfo(frame_index, infos[BindingIndex]);
 
-				return filled_writes;
+				return changed;
 			}
 
 		};
@@ -199,9 +288,7 @@ namespace render
 
 			BindingIter(const Global& global) {}
 
-			int UpdateAndTryFillWrites(int frame_index, VkDescriptorSet descriptor_set, std::span<VkWriteDescriptorSet>& descriptor_set_writes) { return 0; }
-
-			//void FillDescriptorSetWrites(int frame_index, VkDescriptorSet descriptor_set, std::span<VkWriteDescriptorSet>& write_descriptor_sets) {}
+			bool UpdateAndTryFillInfos(int frame_index, std::span<DescriptorInfo> infos) { return false; }
 		};
 
 		template<DescriptorSetType Type>
@@ -213,11 +300,17 @@ namespace render
 				vk_descriptor_sets_
 			{
 				VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE
-			}
+			},
+				update_template_(VK_NULL_HANDLE),
+				descriptor_infos_{},
+				manager_(nullptr)
 			{}
 
 			Set(const Set& set) = delete;
-			Set(Set&& set) : BindingIter<Type, DescriptorSet<Type>::binding_count - 1>(std::move(set))
+			Set(Set&& set) : BindingIter<Type, DescriptorSet<Type>::binding_count - 1>(std::move(set)),
+				update_template_(set.update_template_),
+				descriptor_infos_(set.descriptor_infos_),
+				manager_(set.manager_)
 			{
 				vk_descriptor_sets_ = set.vk_descriptor_sets_;
 				set.vk_descriptor_sets_.fill(VK_NULL_HANDLE);
@@ -231,21 +324,53 @@ namespace render
 				FreeDescriptorSets(BindingIter<Type, DescriptorSet<Type>::binding_count - 1>::global_ref_);
 				vk_descriptor_sets_ = set.vk_descriptor_sets_;
 				set.vk_descriptor_sets_.fill(VK_NULL_HANDLE);
+				update_template_ = set.update_template_;
+				descriptor_infos_ = set.descriptor_infos_;
+				manager_ = set.manager_;
 
 				return *this;
 			}
 
-
-			int UpdateAndTryFillWrites(int frame_index, std::span<VkWriteDescriptorSet>& descriptor_set_writes)
+			// the whole set is rewritten with the type update template, and only if one of its descriptors changed
+			bool UpdateDescriptorSet(int frame_index, const Global& global)
 			{
-				return BindingIter<Type, DescriptorSet<Type>::binding_count - 1>::UpdateAndTryFillWrites(frame_index, vk_descriptor_sets_[frame_index], descriptor_set_writes);
+				if (!BindingIter<Type, DescriptorSet<Type>::binding_count - 1>::UpdateAndTryFillInfos(frame_index, descriptor_infos_[frame_index]))
+					return false;
+
+				if constexpr (DescriptorSet<Type>::shared_by_contents)
+				{
+					bool created;
+					VkDescriptorSet shared_set = manager_->AcquireSharedDescriptor(Type, descriptor_infos_[frame_index], created);
+
+					if (vk_descriptor_sets_[frame_index] != VK_NULL_HANDLE)
+					{
+						manager_->ReleaseSharedDescriptor(vk_descriptor_sets_[frame_index]);
+					}
+
+					vk_descriptor_sets_[frame_index] = shared_set;
+
+					if (!created)
+						return false;
+				}
+
+				vkUpdateDescriptorSetWithTemplate(global.logical_device, vk_descriptor_sets_[frame_index], update_template_, descriptor_infos_[frame_index].data());
+				return true;
 			}
 
 			VkDescriptorSet AttachVkDescriptorSet(int frame_index, DescriptorSetsManager& manager)
 			{
 				assert(vk_descriptor_sets_[frame_index] == VK_NULL_HANDLE);
 
-				vk_descriptor_sets_[frame_index] = manager.GetFreeDescriptor(Type);
+				manager_ = &manager;
+				update_template_ = manager.GetLayouts()[u32(Type)].GetUpdateTemplate();
+
+				assert(update_template_ != VK_NULL_HANDLE);
+
+				// shared sets are acquired on the first update, once the contents are known
+				if constexpr (!DescriptorSet<Type>::shared_by_contents)
+				{
+					vk_descriptor_sets_[frame_index] = manager.GetFreeDescriptor(Type);
+				}
 
 				return vk_descriptor_sets_[frame_index];
 			}
@@ -256,7 +381,14 @@ namespace render
 				{
 					if (set != VK_NULL_HANDLE)
 					{
-						global.delete_list.push_back({ global.frame_ind, set });
+						if constexpr (DescriptorSet<Type>::shared_by_contents)
+						{
+							manager_->ReleaseSharedDescriptor(set);
+						}
+						else
+						{
+							global.delete_list.push_back({ global.frame_ind, set });
+						}
 						set = VK_NULL_HANDLE;
 					}
 				}
@@ -265,6 +397,11 @@ namespace render
 		protected:
 
 			std::array<VkDescriptorSet, kFramesCount> vk_descriptor_sets_;
+
+			VkDescriptorUpdateTemplate update_template_;
+			std::array<std::array<DescriptorInfo, DescriptorSet<Type>::binding_count>, kFramesCount> descriptor_infos_;
+
+			DescriptorSetsManager* manager_;
 		};
 
 
@@ -294,17 +431,29 @@ namespace render
 
 		protected:
 
-			int UpdateAndTryFillWrites(int frame_index, std::span<VkWriteDescriptorSet> write_descriptor_sets)
+			int UpdateDescriptorSets(int frame_index)
 			{
-				int writes_filled_by_this_set = Set<T1>::UpdateAndTryFillWrites(frame_index, write_descriptor_sets);
+				int updated_sets_cnt = Set<T1>::UpdateDescriptorSet(frame_index, SetIter<Ts...>::global_) ? 1 : 0;
+
+				if constexpr (DescriptorSet<T1>::shared_by_contents)
+				{
+					if (Set<T1>::vk_descriptor_sets_[frame_index] != VK_NULL_HANDLE)
+					{
+						SetIter<Ts...>::descriptor_sets_per_frame_[frame_index][T1] = Set<T1>::vk_descriptor_sets_[frame_index];
+					}
+				}
 
-				return writes_filled_by_this_set + SetIter<Ts...>::UpdateAndTryFillWrites(frame_index, std::span(write_descriptor_sets.begin() + writes_filled_by_this_set, write_descriptor_sets.end()));
+				return updated_sets_cnt + SetIter<Ts...>::UpdateDescriptorSets(frame_index);
 			}
 
 			void AttachVkDescriptorSet(int frame_index)
 			{
 				VkDescriptorSet vk_descriptor_set = Set<T1>::AttachVkDescriptorSet(frame_index, SetIter<Ts...>::desc_set_manager_);
-				SetIter<Ts...>::descriptor_sets_per_frame_[frame_index].emplace(T1, vk_descriptor_set);
+
+				if (vk_descriptor_set != VK_NULL_HANDLE)
+				{
+					SetIter<Ts...>::descriptor_sets_per_frame_[frame_index].emplace(T1, vk_descriptor_set);
+				}
 
 				SetIter<Ts...>::AttachVkDescriptorSet(frame_index);
 			}
@@ -320,7 +469,7 @@ namespace render
 
 		protected:
 
-			int UpdateAndTryFillWrites(int frame_index, std::span<VkWriteDescriptorSet> write_descriptor_sets) { return 0; }
+			int UpdateDescriptorSets(int frame_index) { return 0; }
 
 			void AttachVkDescriptorSet(int frame_index) {}
 
@@ -341,14 +490,10 @@ namespace render
 				}
 			}
 
-			void UpdateAndTryFillWrites(int frame_index)
+			// returns the number of descriptor sets rewritten
+			int UpdateAndTryFillWrites(int frame_index)
 			{
-				std::array<VkWriteDescriptorSet, 64> writes = {};
-				int filled_writes_cnt = SetIter<Ts..., DescriptorSetType::ListEnd>::UpdateAndTryFillWrites(frame_index, writes);
-				if (filled_writes_cnt > 0)
-				{
-					vkUpdateDescriptorSets(RenderObjBase<void*>::global_.logical_device, filled_writes_cnt, writes.data(), 0, nullptr);
-				}
+				return SetIter<Ts..., DescriptorSetType::ListEnd>::UpdateDescriptorSets(frame_index);
 			}
 
 			const std::map<DescriptorSetType, VkDescriptorSet>& GetDescriptorSets(uint32_t frame_index) const
@@ -6,7 +6,7 @@
 std::map<render::DescriptorSetType, render::DescriptorSetInfo> render::DescriptorSetUtil::info_map_;
 std::map<std::string, render::DescriptorSetType> render::DescriptorSetUtil::name_map_;
 
-render::DescriptorSetLayout::DescriptorSetLayout(const Global& global, DescriptorSetType type): RenderObjBase(global), type_(type)
+render::DescriptorSetLayout::DescriptorSetLayout(const Global& global, DescriptorSetType type): RenderObjBase(global), type_(type), update_after_bind_(false)
 {
 
 	std::map<DescriptorSetType, DescriptorSetInfo> infos = DescriptorSetUtil::GetTypeToInfoMap();
@@ -14,6 +14,7 @@ render::DescriptorSetLayout::DescriptorSetLayout(const Global& global, Descripto
 	DescriptorSetInfo info = infos[type];
 
 	std::vector<VkDescriptorSetLayoutBinding> bindings(info.bindings.size());
+	std::vector<VkDescriptorBindingFlags> binding_flags(info.bindings.size(), 0);
 
 	for (int i = 0; i < info.bindings.size(); i++)
 	{
@@ -21,14 +22,25 @@ render::DescriptorSetLayout::DescriptorSetLayout(const Global& global, Descripto
 
 			bindings[i].descriptorType =
 			info.bindings[i].type == DescriptorBindingType::kUniform			? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER :
-			info.bindings[i].type == DescriptorBindingType::kSampler			? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_MAX_ENUM;
+			info.bindings[i].type == DescriptorBindingType::kSampler			? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER :
+			info.bindings[i].type == DescriptorBindingType::kSamplerArray		? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER :
+			info.bindings[i].type == DescriptorBindingType::kStorage			? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER :
+			info.bindings[i].type == DescriptorBindingType::kInputAttachment	? VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT : VK_DESCRIPTOR_TYPE_MAX_ENUM;
 
 			bindings[i].descriptorCount = 1;
 
+			if (info.bindings[i].type == DescriptorBindingType::kSamplerArray)
+			{
+				bindings[i].descriptorCount = kBindlessTexturesCount;
+				binding_flags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+				update_after_bind_ = true;
+			}
+
 			bindings[i].stageFlags =
 			((info.bindings[i].shaders_flags & ShaderTypeFlags::Vertex) != ShaderTypeFlags::Empty ? VK_SHADER_STAGE_VERTEX_BIT : 0) |
 			((info.bindings[i].shaders_flags & ShaderTypeFlags::Geometry) != ShaderTypeFlags::Empty ? VK_SHADER_STAGE_GEOMETRY_BIT : 0) |
-			((info.bindings[i].shaders_flags & ShaderTypeFlags::Fragment) != ShaderTypeFlags::Empty ? VK_SHADER_STAGE_FRAGMENT_BIT : 0);
+			((info.bindings[i].shaders_flags & ShaderTypeFlags::Fragment) != ShaderTypeFlags::Empty ? VK_SHADER_STAGE_FRAGMENT_BIT : 0) |
+			((info.bindings[i].shaders_flags & ShaderTypeFlags::Compute) != ShaderTypeFlags::Empty ? VK_SHADER_STAGE_COMPUTE_BIT : 0);
 
 		bindings[i].pImmutableSamplers = nullptr;
 	}
@@ -38,9 +50,25 @@ render::DescriptorSetLayout::DescriptorSetLayout(const Global& global, Descripto
 	desc_set_layout_create_info.bindingCount = u32(bindings.size());
 	desc_set_layout_create_info.pBindings = bindings.data();
 
+	VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_create_info{};
+	binding_flags_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	binding_flags_create_info.bindingCount = u32(binding_flags.size());
+	binding_flags_create_info.pBindingFlags = binding_flags.data();
+
+	if (update_after_bind_)
+	{
+		desc_set_layout_create_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		desc_set_layout_create_info.pNext = &binding_flags_create_info;
+	}
+
 	if (vkCreateDescriptorSetLayout(global_.logical_device, &desc_set_layout_create_info, nullptr, &handle_) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create descriptor set layout!");
 	}
+
+	if (!update_after_bind_)
+	{
+		update_template_.emplace(global, handle_, type);
+	}
 }
 
 render::DescriptorSetType render::DescriptorSetLayout::GetType() const
@@ -48,8 +76,20 @@ render::DescriptorSetType render::DescriptorSetLayout::GetType() const
 	return type_;
 }
 
+bool render::DescriptorSetLayout::IsUpdateAfterBind() const
+{
+	return update_after_bind_;
+}
+
+VkDescriptorUpdateTemplate render::DescriptorSetLayout::GetUpdateTemplate() const
+{
+	return update_template_ ? update_template_->GetHandle() : VK_NULL_HANDLE;
+}
+
 render::DescriptorSetLayout::~DescriptorSetLayout()
 {
+	update_template_.reset();
+
 	if (handle_ != VK_NULL_HANDLE)
 	{
 		vkDestroyDescriptorSetLayout(global_.logical_device, handle_, nullptr);
@@ -4,9 +4,11 @@
 
 #include "vulkan/vulkan.h"
 
+#include <optional>
 #include <vector>
 
 #include "render/descriptor_set.h"
+#include "render/descriptor_update_template.h"
 #include "render/object_base.h"
 #include "render/render_pass.h"
 
@@ -35,11 +37,19 @@ namespace render
 
 		DescriptorSetType GetType() const;
 
+		// contains bindless arrays, sets must come from a pool created with update after bind flag
+		bool IsUpdateAfterBind() const;
+
+		// writes every binding of a set from DescriptorInfo array, null for update after bind layouts
+		VkDescriptorUpdateTemplate GetUpdateTemplate() const;
+
 		virtual ~DescriptorSetLayout() override;
 
 	private:
 
 		DescriptorSetType type_;
+		bool update_after_bind_;
+		std::optional<DescriptorUpdateTemplate> update_template_;
 	};
 }
 #endif  // RENDER_ENGINE_RENDER_DESCRIPTOR_SET_LAYOUT_H_
\ No newline at end of file
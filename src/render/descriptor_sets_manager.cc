@@ -2,9 +2,18 @@
 
 #include "render\global.h"
 
+namespace
+{
+	std::atomic<uint64_t> next_manager_id = 0;
+}
+
 render::DescriptorSetsManager::DescriptorSetsManager(const Global& global) : 
 	RenderObjBase(global),
-	descriptor_pool_(global, 2000, 2000),
+	id_(next_manager_id++),
+	shared_set_refs_cnt_(0),
+	used_sets_cnt_(0),
+	cached_sets_cnt_(0),
+	allocated_sets_cnt_(0),
 	descriptor_set_layouts_
 {
 #define ENUM_OP(val) DescriptorSetLayout(global, DescriptorSetType::k##val),
@@ -12,89 +21,146 @@ render::DescriptorSetsManager::DescriptorSetsManager(const Global& global) :
 #undef ENUM_OP
 }
 {
-//#define ENUM_OP(x) descriptor_sets_[DescriptorSetType::k##x].resize(64); global_.descriptor_pool->AllocateSet(render_setup.GetDescriptorSetLayout(DescriptorSetType::k##x).GetHandle(), 64, descriptor_sets_[DescriptorSetType::k##x]);
-//#include "descriptor_types.inl"
-//#undef ENUM_OP
+	descriptor_pools_.push_back(CreatePool(false));
 }
 
-static int alloc_frame_ind = -1;
-static int free_frame_ind = -1;
-static int allocated = 0;
-static int freed = 0;
-
 VkDescriptorSet render::DescriptorSetsManager::GetFreeDescriptor(DescriptorSetType type)
 {
-	//if (global_.frame_ind != alloc_frame_ind)
-	//{
-	//	std::cout << "Get on " << alloc_frame_ind << " : " << allocated << "\n";
-	//	alloc_frame_ind = global_.frame_ind;
-	//	allocated = 0;
-	//}
+	ThreadCache& thread_cache = GetThreadCache();
 
-	//if (type == (DescriptorSetType)2)
-	//{
-	//	allocated++;
-	//}
+	std::lock_guard<std::mutex> cache_lock(thread_cache.mutex);
 
+	auto&& typed_cache = thread_cache.free_sets[u32(type)];
 
-	VkDescriptorSet result;
+	if (typed_cache.size() == 0)
+	{
+		RefillThreadCache(type, typed_cache);
+	}
+
+	VkDescriptorSet result = typed_cache.back();
+	typed_cache.pop_back();
+
+	cached_sets_cnt_--;
+	used_sets_cnt_++;
+
+	return result;
+}
 
-	auto&& free_typed_desc_sets = free_descriptor_sets_[type];
+render::DescriptorSetsManager::ThreadCache& render::DescriptorSetsManager::GetThreadCache()
+{
+	// keyed by manager id, the manager registry keeps the cache reachable from other threads
+	thread_local std::unordered_map<uint64_t, std::shared_ptr<ThreadCache>> thread_caches;
 
-	//if (free_typed_desc_sets.size() >= 40)
-	//{
-	//	int a = 1;
-	//}
+	auto&& thread_cache = thread_caches[id_];
 
-	if (free_typed_desc_sets.size() == 0)
+	if (!thread_cache)
 	{
-		free_typed_desc_sets.resize(10);
-		descriptor_pool_.AllocateSet(descriptor_set_layouts_[u32(type)].GetHandle(), 10, free_typed_desc_sets);
+		thread_cache = std::make_shared<ThreadCache>();
 
-		descriptor_sets_[type].insert(descriptor_sets_[type].end(), free_typed_desc_sets.begin(), free_typed_desc_sets.end());
+		std::lock_guard<std::mutex> lock(mutex_);
+		thread_caches_.push_back(thread_cache);
 	}
 
-	result = free_typed_desc_sets.back();
-	descriptor_set_to_type_[result] = type;
-	free_typed_desc_sets.pop_back();
+	return *thread_cache;
+}
 
-	//if (type == (DescriptorSetType)2)
-	//{
-	//	std::cout << "Get " << result << "\n";
-	//}
+void render::DescriptorSetsManager::ClearThreadCaches()
+{
+	std::vector<std::shared_ptr<ThreadCache>> thread_caches;
 
-	free_sets_.erase(result);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		thread_caches = thread_caches_;
+	}
 
-	return result;
+	// cache mutexes are taken before mutex_ by GetFreeDescriptor, so they are never locked under it
+	for (auto&& thread_cache : thread_caches)
+	{
+		std::lock_guard<std::mutex> cache_lock(thread_cache->mutex);
+
+		for (auto&& typed_cache : thread_cache->free_sets)
+		{
+			cached_sets_cnt_ -= u32(typed_cache.size());
+			typed_cache.clear();
+		}
+	}
 }
 
 void render::DescriptorSetsManager::FreeDescriptorSet(VkDescriptorSet set)
 {
+	std::lock_guard<std::mutex> lock(mutex_);
 
-	DescriptorSetType set_type = descriptor_set_to_type_.at(set);
-	assert(!free_sets_.contains(set));
-	free_sets_.insert(set);
-	
-	//if (global_.frame_ind != free_frame_ind)
-	//{
-	//	std::cout << "Free on " << free_frame_ind << " : " << freed << "\n";
-	//	free_frame_ind = global_.frame_ind;
-	//	freed = 0;
-	//}
+	DescriptorSetType set_type = set_to_type_.at(set);
 
-	//if (set_type == (DescriptorSetType)2)
-	//{
-	//	freed++;
-	//	std::cout << "Free " << set << "\n";
-	//}
+#ifndef NDEBUG
+	assert(!released_sets_.contains(set));
+	released_sets_.insert(set);
+#endif
 
-	auto&& free_desc_sets = free_descriptor_sets_.at(set_type);
-	free_desc_sets.push_back(set);
+	free_sets_[u32(set_type)].push_back(set);
+	used_sets_cnt_--;
 }
 
 void render::DescriptorSetsManager::FreeAll()
 {
-	free_descriptor_sets_ = descriptor_sets_;
+	ClearThreadCaches();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	free_sets_ = allocated_sets_;
+	used_sets_cnt_ = 0;
+}
+
+VkDescriptorSet render::DescriptorSetsManager::AcquireSharedDescriptor(DescriptorSetType type, std::span<const DescriptorInfo> image_infos, bool& created)
+{
+	std::string contents;
+	contents.reserve(image_infos.size() * sizeof(VkDescriptorImageInfo));
+
+	for (auto&& info : image_infos)
+	{
+		contents.append(reinterpret_cast<const char*>(&info.image.sampler), sizeof(VkSampler));
+		contents.append(reinterpret_cast<const char*>(&info.image.imageView), sizeof(VkImageView));
+		contents.append(reinterpret_cast<const char*>(&info.image.imageLayout), sizeof(VkImageLayout));
+	}
+
+	std::lock_guard<std::mutex> lock(shared_sets_mutex_);
+
+	shared_set_refs_cnt_++;
+
+	if (auto&& it = shared_sets_.find({ type, contents }); it != shared_sets_.end())
+	{
+		it->second.refs_cnt++;
+		created = false;
+		return it->second.set;
+	}
+
+	VkDescriptorSet set = GetFreeDescriptor(type);
+
+	auto&& it = shared_sets_.emplace(SharedSetKey{ type, std::move(contents) }, SharedSet{ set, 1 }).first;
+	shared_set_to_key_.emplace(set, it->first);
+
+	created = true;
+	return set;
+}
+
+void render::DescriptorSetsManager::ReleaseSharedDescriptor(VkDescriptorSet set)
+{
+	std::lock_guard<std::mutex> lock(shared_sets_mutex_);
+
+	auto&& key_it = shared_set_to_key_.find(set);
+	assert(key_it != shared_set_to_key_.end());
+
+	auto&& it = shared_sets_.find(key_it->second);
+
+	shared_set_refs_cnt_--;
+
+	if (--it->second.refs_cnt == 0)
+	{
+		shared_sets_.erase(it);
+		shared_set_to_key_.erase(key_it);
+
+		global_.delete_list.push_back({ global_.frame_ind, set });
+	}
 }
 
 const std::array<render::DescriptorSetLayout, static_cast<uint32_t>(render::DescriptorSetType::Count)>& render::DescriptorSetsManager::GetLayouts() const
@@ -102,10 +168,90 @@ const std::array<render::DescriptorSetLayout, static_cast<uint32_t>(render::Desc
 	return descriptor_set_layouts_;
 }
 
-render::DescriptorSetsManager::~DescriptorSetsManager()
+render::DescriptorSetsManager::Stats render::DescriptorSetsManager::GetStats() const
+{
+	Stats stats{};
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		stats.used_sets = used_sets_cnt_;
+		stats.cached_sets = cached_sets_cnt_;
+		stats.free_sets = allocated_sets_cnt_ - stats.used_sets - stats.cached_sets;
+		stats.pools_count = u32(descriptor_pools_.size() + bindless_descriptor_pools_.size());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(shared_sets_mutex_);
+
+		stats.shared_sets = u32(shared_sets_.size());
+		stats.shared_set_refs = shared_set_refs_cnt_;
+	}
+
+	return stats;
+}
+
+void render::DescriptorSetsManager::RefillThreadCache(DescriptorSetType type, std::vector<VkDescriptorSet>& thread_cache)
 {
-	for (auto&& [type, sets] : descriptor_sets_)
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	// bindless sets are large and few, they are handed out one by one
+	uint32_t batch = descriptor_set_layouts_[u32(type)].IsUpdateAfterBind() ? 1 : kThreadCacheBatch;
+
+	auto&& free_typed_sets = free_sets_[u32(type)];
+
+	if (free_typed_sets.size() < batch)
+	{
+		AllocateFromPools(type, batch - u32(free_typed_sets.size()));
+	}
+
+	thread_cache.insert(thread_cache.end(), free_typed_sets.end() - batch, free_typed_sets.end());
+	free_typed_sets.resize(free_typed_sets.size() - batch);
+	cached_sets_cnt_ += batch;
+
+#ifndef NDEBUG
+	for (auto&& set : thread_cache)
 	{
-		//global_.descriptor_pool->FreeSet(sets);
+		released_sets_.erase(set);
 	}
+#endif
+}
+
+void render::DescriptorSetsManager::AllocateFromPools(DescriptorSetType type, uint32_t count)
+{
+	bool update_after_bind = descriptor_set_layouts_[u32(type)].IsUpdateAfterBind();
+	auto&& pools = update_after_bind ? bindless_descriptor_pools_ : descriptor_pools_;
+
+	std::vector<VkDescriptorSet> allocated_sets;
+
+	if (pools.size() == 0 || !pools.back().TryAllocateSet(descriptor_set_layouts_[u32(type)].GetHandle(), count, allocated_sets))
+	{
+		pools.push_back(CreatePool(update_after_bind));
+		pools.back().AllocateSet(descriptor_set_layouts_[u32(type)].GetHandle(), count, allocated_sets);
+	}
+
+	for (auto&& set : allocated_sets)
+	{
+		set_to_type_.emplace(set, type);
+	}
+
+	allocated_sets_[u32(type)].insert(allocated_sets_[u32(type)].end(), allocated_sets.begin(), allocated_sets.end());
+	free_sets_[u32(type)].insert(free_sets_[u32(type)].end(), allocated_sets.begin(), allocated_sets.end());
+	allocated_sets_cnt_ += u32(allocated_sets.size());
+}
+
+render::DescriptorPool render::DescriptorSetsManager::CreatePool(bool update_after_bind) const
+{
+	if (update_after_bind)
+	{
+		return DescriptorPool(global_, 0, 2 * kBindlessTexturesCount, 2 * 2, 0, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+	}
+
+	return DescriptorPool(global_, 2000, 2000, 200, 200);
+}
+
+render::DescriptorSetsManager::~DescriptorSetsManager()
+{
+	// threads may still hold their caches, they must not hand out sets of a destroyed pool
+	ClearThreadCaches();
 }
@@ -1,8 +1,14 @@
 #ifndef RENDER_ENGINE_RENDER_DESCRIPTOR_SETS_MANAGER_H_
 #define RENDER_ENGINE_RENDER_DESCRIPTOR_SETS_MANAGER_H_
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 
 
@@ -13,6 +19,7 @@
 #include "render/descriptor_pool.h"
 #include "render/descriptor_set.h"
 #include "render/descriptor_set_layout.h"
+#include "render/descriptor_update_template.h"
 #include "render/image_view.h"
 #include "render/sampler.h"
 
@@ -20,10 +27,28 @@ namespace render
 {
 	class RenderSetup;
 
+	// Sets are allocated from a chain of pools that grows when the last pool is exhausted.
+	// GetFreeDescriptor may be called from any thread, each thread takes sets from its own cache
+	// refilled in batches. The manager keeps every cache it handed sets to and drains them on FreeAll.
+	// FreeDescriptorSet is called once the frame that used the set is complete.
+	// Sets that only reference images can be shared by contents, they are reference counted
+	// and go to the delete list when the last holder releases them.
 	class DescriptorSetsManager: RenderObjBase<void*>
 	{
 	public:
 
+		struct Stats
+		{
+			uint32_t used_sets;
+			uint32_t free_sets;
+			// taken by thread caches and not handed out yet
+			uint32_t cached_sets;
+			uint32_t pools_count;
+
+			uint32_t shared_sets;
+			uint32_t shared_set_refs;
+		};
+
 		DescriptorSetsManager(const Global& global);
 
 		DescriptorSetsManager(const DescriptorSetsManager&) = delete;
@@ -36,25 +61,71 @@ namespace render
 		void FreeDescriptorSet(VkDescriptorSet);
 		void FreeAll();
 
+		// created is set when the returned set is new and has to be written by the caller
+		VkDescriptorSet AcquireSharedDescriptor(DescriptorSetType type, std::span<const DescriptorInfo> image_infos, bool& created);
+		void ReleaseSharedDescriptor(VkDescriptorSet set);
+
 		const std::array<DescriptorSetLayout, static_cast<uint32_t>(DescriptorSetType::Count)>& GetLayouts() const;
 
+		Stats GetStats() const;
+
 		virtual ~DescriptorSetsManager();
 
 	private:
 
-		//const RenderSetup& render_setup_;
+		// sets handed to a thread cache at once
+		static const uint32_t kThreadCacheBatch = 16;
+
+		// sets a thread took from the free lists, locked by the owning thread and by ClearThreadCaches
+		struct ThreadCache
+		{
+			std::mutex mutex;
+			std::array<std::vector<VkDescriptorSet>, kDescriptorSetTypesCount> free_sets;
+		};
+
+		ThreadCache& GetThreadCache();
+		void RefillThreadCache(DescriptorSetType type, std::vector<VkDescriptorSet>& thread_cache);
+		// empties the caches of all threads, the caller returns their sets to the free lists
+		void ClearThreadCaches();
+		void AllocateFromPools(DescriptorSetType type, uint32_t count);
+		DescriptorPool CreatePool(bool update_after_bind) const;
+
+		// identifies the manager in thread local caches, never reused
+		uint64_t id_;
+
+		mutable std::mutex mutex_;
+
+		std::array<std::vector<VkDescriptorSet>, kDescriptorSetTypesCount> allocated_sets_;
+		std::array<std::vector<VkDescriptorSet>, kDescriptorSetTypesCount> free_sets_;
+		std::unordered_map<VkDescriptorSet, DescriptorSetType> set_to_type_;
+
+		// every thread cache of the manager, threads also hold them in a thread local map
+		std::vector<std::shared_ptr<ThreadCache>> thread_caches_;
+
+#ifndef NDEBUG
+		std::unordered_set<VkDescriptorSet> released_sets_;
+#endif
+
+		struct SharedSet
+		{
+			VkDescriptorSet set;
+			uint32_t refs_cnt;
+		};
 
-		std::map<DescriptorSetType, std::vector<VkDescriptorSet>> descriptor_sets_;
-		std::map<DescriptorSetType, std::vector<VkDescriptorSet>> free_descriptor_sets_;
-		std::map<VkDescriptorSet, DescriptorSetType> descriptor_set_to_type_;
+		using SharedSetKey = std::pair<DescriptorSetType, std::string>;
 
-		std::unordered_set<VkDescriptorSet> free_sets_;
+		mutable std::mutex shared_sets_mutex_;
+		std::map<SharedSetKey, SharedSet> shared_sets_;
+		std::unordered_map<VkDescriptorSet, SharedSetKey> shared_set_to_key_;
+		uint32_t shared_set_refs_cnt_;
 
-		std::map<DescriptorSetType, std::vector<UniformBuffer>> uniform_buffers_;
-		std::map<DescriptorSetType, std::vector<ImageView>> image_views_;
+		std::atomic<uint32_t> used_sets_cnt_;
+		std::atomic<uint32_t> cached_sets_cnt_;
+		uint32_t allocated_sets_cnt_;
 
 		std::array<DescriptorSetLayout, static_cast<uint32_t>(DescriptorSetType::Count)> descriptor_set_layouts_;
-		DescriptorPool descriptor_pool_;
+		std::vector<DescriptorPool> descriptor_pools_;
+		std::vector<DescriptorPool> bindless_descriptor_pools_;
 	};
 }
 
@@ -3,7 +3,8 @@ ENUM_OP(LightPositionAndViewProjMat)
 
 ENUM_OP(ModelMatrix)
 ENUM_OP(Skeleton)
-ENUM_OP(Material)
+ENUM_OP(SkinningSource)
+ENUM_OP(Materials)
 
 ENUM_OP(Environement)
 
@@ -16,3 +17,7 @@ ENUM_OP(Color)
 
 ENUM_OP(ShadowCubeViewProj)
 ENUM_OP(ShadowCubeMaps)
+
+ENUM_OP(Lights)
+ENUM_OP(LightClusters)
+ENUM_OP(LightCullingStats)
@@ -0,0 +1,45 @@
+#include "descriptor_update_template.h"
+
+#include <vector>
+
+#include "global.h"
+
+render::DescriptorUpdateTemplate::DescriptorUpdateTemplate(const Global& global, VkDescriptorSetLayout layout, DescriptorSetType type) : RenderObjBase(global)
+{
+	const DescriptorSetInfo& info = DescriptorSetUtil::GetTypeToInfoMap().at(type);
+
+	std::vector<VkDescriptorUpdateTemplateEntry> entries(info.bindings.size());
+
+	for (int i = 0; i < info.bindings.size(); i++)
+	{
+		entries[i].dstBinding = i;
+		entries[i].dstArrayElement = 0;
+		entries[i].descriptorCount = 1;
+		entries[i].descriptorType =
+			info.bindings[i].type == DescriptorBindingType::kUniform			? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER :
+			info.bindings[i].type == DescriptorBindingType::kSampler			? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER :
+			info.bindings[i].type == DescriptorBindingType::kStorage			? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER :
+			info.bindings[i].type == DescriptorBindingType::kInputAttachment	? VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT : VK_DESCRIPTOR_TYPE_MAX_ENUM;
+		entries[i].offset = i * sizeof(DescriptorInfo);
+		entries[i].stride = sizeof(DescriptorInfo);
+	}
+
+	VkDescriptorUpdateTemplateCreateInfo create_info{};
+	create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+	create_info.descriptorUpdateEntryCount = u32(entries.size());
+	create_info.pDescriptorUpdateEntries = entries.data();
+	create_info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+	create_info.descriptorSetLayout = layout;
+
+	if (vkCreateDescriptorUpdateTemplate(global_.logical_device, &create_info, nullptr, &handle_) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor update template!");
+	}
+}
+
+render::DescriptorUpdateTemplate::~DescriptorUpdateTemplate()
+{
+	if (handle_ != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorUpdateTemplate(global_.logical_device, handle_, nullptr);
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef RENDER_ENGINE_RENDER_DESCRIPTOR_UPDATE_TEMPLATE_H_
+#define RENDER_ENGINE_RENDER_DESCRIPTOR_UPDATE_TEMPLATE_H_
+
+#include "vulkan/vulkan.h"
+
+#include "common.h"
+#include "render/descriptor_set.h"
+#include "render/object_base.h"
+
+namespace render
+{
+	// one entry per binding of a set, update templates read them with sizeof(DescriptorInfo) stride
+	union DescriptorInfo
+	{
+		VkDescriptorBufferInfo buffer;
+		VkDescriptorImageInfo image;
+	};
+
+	class DescriptorUpdateTemplate : public RenderObjBase<VkDescriptorUpdateTemplate>
+	{
+	public:
+
+		DescriptorUpdateTemplate(const Global& global, VkDescriptorSetLayout layout, DescriptorSetType type);
+
+		DescriptorUpdateTemplate(const DescriptorUpdateTemplate&) = delete;
+		DescriptorUpdateTemplate(DescriptorUpdateTemplate&&) = default;
+
+		DescriptorUpdateTemplate& operator=(const DescriptorUpdateTemplate&) = delete;
+		DescriptorUpdateTemplate& operator=(DescriptorUpdateTemplate&&) = default;
+
+		virtual ~DescriptorUpdateTemplate() override;
+	};
+}
+#endif  // RENDER_ENGINE_RENDER_DESCRIPTOR_UPDATE_TEMPLATE_H_
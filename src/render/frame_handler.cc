@@ -16,22 +16,33 @@
 namespace render
 {
 	FrameHandler::FrameHandler(const Global& global, const Swapchain& swapchain, const RenderSetup& render_setup,
-		const Extents& extents, const Formats& formats, DescriptorSetsManager& descriptor_set_manager) :
+		const Extents& extents, const Formats& formats, DescriptorSetsManager& descriptor_set_manager, MaterialTable& material_table, CubeFaceCache& cube_face_cache) :
 		RenderObjBase(global), swapchain_(swapchain.GetHandle()), graphics_queue_(global.graphics_queue),
 		command_buffer_(global.graphics_cmd_pool->GetCommandBuffer()),
 		image_available_semaphore_(vk_util::CreateSemaphore(global.logical_device)),
 		render_finished_semaphore_(vk_util::CreateSemaphore(global.logical_device)),
 		cmd_buffer_fence_(vk_util::CreateFence(global.logical_device)), present_info_{}, submit_info_{}, wait_stages_(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT),
-		render_setup_(render_setup),
-		render_graph_handler_(global, render_setup.GetRenderGraph(), extents, formats, descriptor_set_manager),
-		descriptor_set_manager_(descriptor_set_manager)
+		render_setup_(render_setup), extents_(extents),
+		render_graph_handler_(global, render_setup.GetRenderGraph(), extents, formats, descriptor_set_manager, material_table, cube_face_cache),
+		descriptor_set_manager_(descriptor_set_manager), material_table_(material_table)
 	{
 		handle_ = (void*)(1);
 	}
 
+	void FrameHandler::UpdateSwapchain(const Swapchain& swapchain)
+	{
+		swapchain_ = swapchain.GetHandle();
+		render_graph_handler_.ResetSwapchainFramebuffers();
+	}
+
+	void FrameHandler::WaitForCompletion() const
+	{
+		vkWaitForFences(global_.logical_device, 1, &cmd_buffer_fence_, VK_TRUE, UINT64_MAX);
+	}
+
 	extern void FreeMemory(VkDevice logical_device, OffsettedMemory memory);
 
-	bool FrameHandler::Draw(const FrameInfo& frame_info, const Scene& scene)
+	bool FrameHandler::Draw(const FrameInfo& frame_info, Scene& scene)
 	{
 		submit_info_.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
@@ -65,7 +76,7 @@ namespace render
 
 		{
 
-			std::vector<std::pair<uint32_t, std::variant<VkBuffer, OffsettedMemory, VkImageView, VkDescriptorSet>>> new_delete_list;
+			std::vector<std::pair<uint32_t, std::variant<VkBuffer, OffsettedMemory, VkImageView, VkDescriptorSet, VkFramebuffer, VkSwapchainKHR>>> new_delete_list;
 
 			for (auto&& [frame_ind, handle_variant] : global_.delete_list)
 			{
@@ -93,6 +104,14 @@ namespace render
 					{
 						descriptor_set_manager_.FreeDescriptorSet(*(VkDescriptorSet*)handle);
 					}
+					else if (void* handle = std::get_if<VkFramebuffer>(&handle_variant))
+					{
+						vkDestroyFramebuffer(global_.logical_device, *(VkFramebuffer*)handle, nullptr);
+					}
+					else if (void* handle = std::get_if<VkSwapchainKHR>(&handle_variant))
+					{
+						vkDestroySwapchainKHR(global_.logical_device, *(VkSwapchainKHR*)handle, nullptr);
+					}
 				}
 				else
 				{
@@ -104,6 +123,11 @@ namespace render
 
 		}
 
+		material_table_.BeginFrame(frame_info.frame_index);
+		scene.BeginFrame(frame_info.frame_index);
+
+		render_graph_handler_.UpdateExtents(extents_);
+
 
 		render_graph_handler_.FillCommandBuffer(command_buffer_, frame_info, scene);
 
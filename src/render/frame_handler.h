@@ -20,7 +20,7 @@ namespace render
 	public:
 
 		FrameHandler(const Global& global, const Swapchain& swapchain, const RenderSetup& render_setup,
-			const Extents& extents, const Formats& formats, DescriptorSetsManager& descriptor_set_manager);
+			const Extents& extents, const Formats& formats, DescriptorSetsManager& descriptor_set_manager, MaterialTable& material_table, CubeFaceCache& cube_face_cache);
 		
 		FrameHandler(const FrameHandler&) = delete;
 		FrameHandler(FrameHandler&&) = default;
@@ -32,7 +32,13 @@ namespace render
 
 
 
-		bool Draw(const FrameInfo& frame_info, const Scene& scene);
+		// the swapchain, its views and framebuffers are only replaced once every frame has waited for completion
+		void UpdateSwapchain(const Swapchain& swapchain);
+
+		// waits until the last command buffer submitted by the frame is complete
+		void WaitForCompletion() const;
+
+		bool Draw(const FrameInfo& frame_info, Scene& scene);
 
 		VkSemaphore GetImageAvailableSemaphore() const;
 
@@ -56,8 +62,10 @@ namespace render
 		VkQueue graphics_queue_;
 
 		DescriptorSetsManager& descriptor_set_manager_;
+		MaterialTable& material_table_;
 
 		const RenderSetup& render_setup_;
+		const Extents& extents_;
 
 		//ModelSceneDescSetHolder model_scene_;
 		RenderGraphHandler render_graph_handler_;
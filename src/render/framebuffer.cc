@@ -48,7 +48,14 @@ render::Framebuffer::~Framebuffer()
 {
 	if (handle_ != VK_NULL_HANDLE)
 	{
-		vkDestroyFramebuffer(global_.logical_device, handle_, nullptr);
+		if (!deferred_delete_)
+		{
+			vkDestroyFramebuffer(global_.logical_device, handle_, nullptr);
+		}
+		else
+		{
+			global_.delete_list.push_back({ global_.frame_ind, handle_ });
+		}
 	}
 }
 
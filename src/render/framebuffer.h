@@ -58,6 +58,8 @@ namespace render
 	
 		Extent GetExtent() const;
 
+		bool deferred_delete_ = false;
+
 		const RenderPass& GetRenderPass() const;
 		const std::vector<VkFormat>& GetFormats() const;
 		//void Build(const RenderPass2& render_pass);
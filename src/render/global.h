@@ -1,11 +1,13 @@
 #ifndef RENDER_ENGINE_RENDER_GLOBAL_H_
 #define RENDER_ENGINE_RENDER_GLOBAL_H_
 
+#include <atomic>
 #include <vector>
 #include <variant>
 
 
 #include "render/command_pool.h"
+#include "render/image_view_cache.h"
 #include "render/sampler.h"
 
 
@@ -36,11 +38,16 @@ namespace render
 		std::optional<Image> error_image;
 		std::optional<Image> default_normal;
 
+		mutable ImageViewCache image_view_cache;
+
+		// bytes copied by descriptor holders to uniform and storage buffers, reset every frame
+		mutable std::atomic<uint64_t> uploaded_bytes = 0;
+
 		Format depth_map_format = VK_FORMAT_D32_SFLOAT;
 		Format color_format = VK_FORMAT_R8G8B8A8_SRGB;
 
 		uint32_t frame_ind;
-		mutable std::vector<std::pair<uint32_t, std::variant<VkBuffer, OffsettedMemory, VkImageView, VkDescriptorSet>>> delete_list;
+		mutable std::vector<std::pair<uint32_t, std::variant<VkBuffer, OffsettedMemory, VkImageView, VkDescriptorSet, VkFramebuffer, VkSwapchainKHR>>> delete_list;
 	};
 }
 #endif  // RENDER_ENGINE_RENDER_GLOBAL_H_
\ No newline at end of file
@@ -9,6 +9,8 @@
 #undef TINYGLTF_IMPLEMENTATION
 #pragma warning(pop)
 
+#include <chrono>
+
 #include <glm/glm/glm.hpp>
 #include <glm/glm/gtc/matrix_transform.hpp>
 #include <glm/glm/gtc/type_ptr.hpp>
@@ -17,378 +19,279 @@
 
 #include "global.h"
 
+#include "render/render_engine.h"
 #include "render/render_setup.h"
 
 
 namespace render
 {
-	ModelPack::ModelPack(const Global& global, DescriptorSetsManager& manager):global_(global), desc_set_manager_(manager)
+	namespace
 	{
+		// Images are kept as encoded file bytes with zero width and decoded in parallel by CookGLTF.
+		// Decoding KTX2 through stb would also fail the whole load.
+		bool LoadGLTFImageData(tinygltf::Image* image, const int image_idx, std::string* err, std::string* warn, int req_width, int req_height, const unsigned char* bytes, int size, void* user_data)
+		{
+			image->image.assign(bytes, bytes + size);
+			image->width = 0;
+			image->height = 0;
+			image->component = 4;
+			image->bits = 8;
+			return true;
+		}
 	}
 
-	void ModelPack::AddGLTF(const tinygltf::Model& gltf_model)
+	void SetupGLTFLoader(tinygltf::TinyGLTF& loader)
 	{
-		tinygltf::TinyGLTF loader;
-		std::string err;
-		std::string wrn;
+		loader.SetImageLoader(LoadGLTFImageData, nullptr);
+	}
 
-		//bool load_result = loader.LoadBinaryFromFile(&gltf_model_, &err, &wrn, path);
+	ModelPack::ModelPack(const Global& global, DescriptorSetsManager& manager, MaterialTable& material_table):global_(global), desc_set_manager_(manager), material_table_(material_table)
+	{
+	}
 
-	//	if (load_result)
-	//	{
+	ModelPack::~ModelPack()
+	{
+		for (auto&& image : images_)
+		{
+			if (image)
+				material_table_.RemoveTexture(*image);
+		}
+	}
+
+	void ModelPack::AddGLTF(const tinygltf::Model& gltf_model)
+	{
+		AddCooked(CookGLTF(gltf_model));
+	}
+
+	void ModelPack::AddCooked(const CookedModelPack& pack)
+	{
 		std::vector<uint32_t> queue_indices = { global_.graphics_queue_index, global_.transfer_queue_index };
 
-		buffers_.reserve(16);
+		size_t first_buffer = buffers_.size();
+		buffers_.reserve(first_buffer + pack.buffers.size());
 
-		for (auto&& buffer : gltf_model.buffers)
+		// the only copy of mapped data, into the staging buffer
+		// the skinning pass reads source streams of skinned primitives as a storage buffer
+		for (auto&& buffer : pack.buffers)
 		{
-			buffers_.push_back(GPULocalBuffer(global_, buffer.data.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, queue_indices));
-			buffers_.back().LoadData(buffer.data.data(), buffer.data.size());
+			buffers_.push_back(GPULocalBuffer(global_, buffer.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, queue_indices));
+			buffers_.back().LoadData(buffer.data(), buffer.size());
+			uploaded_buffers_bytes += buffer.size();
 		}
 
-		for (auto&& image : gltf_model.images)
-		{
-			auto&& buffer_view = gltf_model.bufferViews[image.bufferView];
-			auto&& buffer = gltf_model.buffers[buffer_view.buffer];
+		source_buffers_bytes += pack.source_buffers_bytes;
 
-			auto name = image.name;
-				std::transform(name.begin(), name.end(), name.begin(),
-					[](unsigned char c) { return std::tolower(c); });
-			if (name.find("normal") != std::string::npos || name.find("roughness") != std::string::npos)
-			{
-				images_.push_back(Image(global_, VK_FORMAT_R8G8B8A8_UNORM, { u32(image.width), u32(image.height) }, image.image.data()/*, {ImageProperty::kShaderInput, ImageProperty::kMipMap}*/));
-			}
-			else
-			{
-				images_.push_back(Image(global_, VK_FORMAT_R8G8B8A8_SRGB, { u32(image.width), u32(image.height) }, image.image.data()/*, {ImageProperty::kShaderInput, ImageProperty::kMipMap}*/));
-			}
+		// block compressed levels the device can't sample are decoded here, other chains are used as is
+		std::vector<std::shared_ptr<const MipChain>> mip_chains(pack.images.size());
 
-			for (int i = 0; i < image.height; i++)
+		util::ParallelFor(pack.images.size(), [&](size_t index)
 			{
-				for (int j = 0; j < image.width; j++)
-				{
-					auto& r = image.image[4 * (i * image.width + j)];
-					auto& g = image.image[4 * (i * image.width + j) + 1];
-					auto& b = image.image[4 * (i * image.width + j) + 2];
-					auto& a = image.image[4 * (i * image.width + j) + 3];
+				if (!pack.images[index])
+					return;
 
-					if (r != -1 || g != -1 || b != -1)
-					{
-						int a = 1;
-					}
+				try
+				{
+					mip_chains[index] = Image::ToSampledFormat(global_, pack.images[index]);
 				}
-			}
-
-			images_views_.push_back(ImageView(global_, images_.back()));
-		}
-
-		std::vector<short> index_to_parent;
+				catch (const std::runtime_error&)
+				{
+				}
+			});
 
-		nodes.resize(gltf_model.nodes.size());
-		index_to_parent.resize(gltf_model.nodes.size(), -1);
+		size_t first_image = images_.size();
+		images_.reserve(first_image + mip_chains.size());
 
-		for (int i = 0; i < gltf_model.nodes.size(); i++)
+		for (auto&& mip_chain : mip_chains)
 		{
-			auto&& node = gltf_model.nodes[i];
-
-			nodes[i].local_transform = glm::identity<glm::mat4>();
-
-
-			if (node.translation.size() == 3)
+			if (!mip_chain)
 			{
-				//nodes[i].translation = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
-				glm::vec3 translation = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
-				nodes[i].local_transform = glm::translate(nodes[i].local_transform, translation);
+				images_.push_back(std::nullopt);
+				continue;
 			}
 
-			//nodes[i].rotation = glm::quat(1, 0, 0, 0);
-			if (node.rotation.size() == 4)
+			// large textures start with their coarse levels, finer ones are streamed in when sampled
+			uint32_t resident_level = 0;
+			while (resident_level + 1 < mip_chain->GetLevelsCount() && std::max(mip_chain->GetLevelExtent(resident_level).width, mip_chain->GetLevelExtent(resident_level).height) > kStreamingResidentExtent)
 			{
-				//glm::rotate(glm::mat4(1.0f), (1 * (1.0f + 1 * 1.37f)) * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-				glm::quat rot_quat = glm::quat(static_cast<float>(node.rotation[3]), static_cast<float>(node.rotation[0]), static_cast<float>(node.rotation[1]), static_cast<float>(node.rotation[2]));
-
-				//nodes[i].rotation = rot_quat;
-
-				nodes[i].local_transform = nodes[i].local_transform * glm::mat4_cast(rot_quat);
-				//nodes.back().node_matrix = glm::rotate(nodes.back().node_matrix, 1. glm::vec3());
+				resident_level++;
 			}
 
-			//nodes[i].scale = glm::vec3(1);
-			if (node.scale.size() == 3)
+			images_.emplace_back(std::in_place, global_, mip_chain, resident_level);
+
+			if (resident_level > 0)
 			{
-				//nodes[i].scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
-				glm::vec3 scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
-				nodes[i].local_transform = glm::scale(nodes[i].local_transform, scale);
+				material_table_.AddStreamedTexture(*images_.back(), mip_chain, resident_level);
 			}
 		}
 
-		for (int i = 0; i < gltf_model.nodes.size(); i++)
+		size_t first_node = nodes.size();
+		nodes.resize(first_node + pack.nodes.size());
+
+		for (int i = 0; i < pack.nodes.size(); i++)
 		{
-			auto&& node = gltf_model.nodes[i];
-			for (auto&& children_index : node.children)
+			nodes[first_node + i].SetLocalTransform(pack.nodes[i].local_transform);
+
+			if (pack.nodes[i].parent >= 0)
 			{
-				nodes[children_index].parent = nodes[i];
-				index_to_parent[children_index] = i;
+				nodes[first_node + i].SetParent(nodes[first_node + pack.nodes[i].parent]);
 			}
+
+			node_parents.push_back(pack.nodes[i].parent >= 0 ? int32_t(first_node + pack.nodes[i].parent) : -1);
 		}
 
+		// cooked material index to MaterialTable index, primitives sharing a material share the entry
+		std::vector<std::optional<uint32_t>> material_indices(pack.materials.size());
 
-		meshes.resize(gltf_model.meshes.size());
+		size_t first_mesh = meshes.size();
+		meshes.resize(first_mesh + pack.meshes.size());
 
-		for (int mesh_index = 0; mesh_index < meshes.size(); mesh_index++)
+		for (int mesh_index = 0; mesh_index < pack.meshes.size(); mesh_index++)
 		{
-			const tinygltf::Mesh& gltf_mesh = gltf_model.meshes[mesh_index];
+			auto&& cooked_mesh = pack.meshes[mesh_index];
+			auto&& mesh = meshes[first_mesh + mesh_index];
+
+			mesh.name = cooked_mesh.name;
+			mesh.dequantization = cooked_mesh.dequantization;
 
-			for (auto&& gltf_primitive : gltf_mesh.primitives)
+			for (auto&& cooked_primitive : cooked_mesh.primitives)
 			{
 				primitive::Geometry primitive(global_, desc_set_manager_, PrimitiveProps::kOpaque);
 
-				primitive.indices.emplace(BuildBufferAccessor(gltf_model, gltf_primitive.indices));
-
-				std::array<int, u32(VertexBufferType::Count)> attribute_accessor_indices{};
-
-				for (VertexBufferType vertex_buffer_type = VertexBufferType::Begin; vertex_buffer_type != VertexBufferType::End; vertex_buffer_type = util::enums::Next(vertex_buffer_type))
+				if (cooked_primitive.indices.buffer >= 0)
 				{
-					if (int buffer_acc_index = GetBufferViewIndexFromAttributes(gltf_primitive.attributes, vertex_buffer_type); buffer_acc_index >= 0)
-					{
-						attribute_accessor_indices[u32(vertex_buffer_type)] = buffer_acc_index;
-						primitive.vertex_buffers[u32(vertex_buffer_type)].emplace(BuildBufferAccessor(gltf_model, buffer_acc_index));
-					}
-					else if (buffer_acc_index = GetBufferViewIndexFromAttributes(gltf_primitive.attributes, vertex_buffer_type, 0); buffer_acc_index >= 0)
-					{
-						attribute_accessor_indices[u32(vertex_buffer_type)] = buffer_acc_index;
-						primitive.vertex_buffers[u32(vertex_buffer_type)].emplace(BuildBufferAccessor(gltf_model, buffer_acc_index));
-					}
-					else attribute_accessor_indices[u32(vertex_buffer_type)] = -1;
+					primitive.indices.emplace(BuildBufferAccessor(cooked_primitive.indices, first_buffer));
 				}
 
-				if (attribute_accessor_indices[u32(VertexBufferType::kPOSITION)] >= 0 && attribute_accessor_indices[u32(VertexBufferType::kTEXCOORD)] >= 0
-					&& attribute_accessor_indices[u32(VertexBufferType::kNORMAL)] >= 0 && attribute_accessor_indices[u32(VertexBufferType::kTANGENT)] < 0)
+				for (uint32_t lod = 0; lod < cooked_primitive.lods_count; lod++)
 				{
-					std::span<const short> indices = GetBufferSpanByAccessor<short>(gltf_model, gltf_primitive.indices);
-					std::span<const glm::vec3> positions = GetBufferSpanByAccessor<glm::vec3>(gltf_model, attribute_accessor_indices[u32(VertexBufferType::kPOSITION)]);
-					std::span<const glm::vec2> uvs = GetBufferSpanByAccessor<glm::vec2>(gltf_model, attribute_accessor_indices[u32(VertexBufferType::kTEXCOORD)]);
-					std::span<const glm::vec3> normals = GetBufferSpanByAccessor<glm::vec3>(gltf_model, attribute_accessor_indices[u32(VertexBufferType::kNORMAL)]);
-
-					assert(normals.size() == positions.size());
-
-					std::vector<glm::vec3> tangents(normals.size());
+					primitive.lods.push_back({ BuildBufferAccessor(cooked_primitive.lods[lod].indices, first_buffer), cooked_primitive.lods[lod].error });
+				}
 
-					for (auto it = indices.begin(); it != indices.end();)
+				for (uint32_t vertex_buffer_index = 0; vertex_buffer_index < kVertexBufferTypesCount; vertex_buffer_index++)
+				{
+					if (cooked_primitive.vertex_buffers[vertex_buffer_index].buffer >= 0)
 					{
-						std::array<short, 3> tri_verts_indices;
-						std::array<glm::vec3, 3> tri_verts;
-						std::array<glm::vec2, 3> tri_uvs;
-
-						for (int i = 0; i < 3; i++)
-						{
-							tri_verts_indices[i] = *it++;
-							tri_verts[i] = positions[tri_verts_indices[i]];
-							tri_uvs[i] = uvs[tri_verts_indices[i]];
-						}
-
-						for (int i = 0; i < 3; i++)
-						{							
-							short ind_0 = i;
-							short ind_1 = (i + 1) % 3;
-							short ind_2 = (i + 2) % 3;
-
-							glm::vec2 duv1 = tri_uvs[ind_1] - tri_uvs[ind_0];
-							glm::vec2 duv2 = tri_uvs[ind_2] - tri_uvs[ind_0];
-
-							glm::vec3 dpos1 = tri_verts[ind_1] - tri_verts[ind_0];
-							glm::vec3 dpos2 = tri_verts[ind_2] - tri_verts[ind_0];
-
-							float u1v2_minus_u2v1 = duv1.x * duv2.y - duv2.x * duv1.y;
-
-							assert(fabs(u1v2_minus_u2v1) > glm::epsilon<float>());
-
-							float a = duv2.y / u1v2_minus_u2v1;
-							float b = - duv1.y / u1v2_minus_u2v1;
-
-							float test_u = a * duv1.x + b * duv2.x;
-							float test_v = a * duv1.y + b * duv2.y;
-
-							glm::vec3 tangent = glm::normalize(a * dpos1 + b * dpos2);
-							tangents[tri_verts_indices[ind_0]] = tangent;
-						}
-
+						primitive.vertex_buffers[vertex_buffer_index].emplace(BuildBufferAccessor(cooked_primitive.vertex_buffers[vertex_buffer_index], first_buffer));
 					}
-
-					buffers_.push_back(GPULocalBuffer(global_, tangents.size()*sizeof(glm::vec3), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, queue_indices));
-					buffers_.back().LoadData(tangents.data(), tangents.size() * sizeof(glm::vec3));
-
-					primitive.vertex_buffers[u32(VertexBufferType::kTANGENT)].emplace(BufferAccessor(ElemType<glm::vec3>{}, buffers_.back()));
 				}
 
-				if (gltf_primitive.material >= 0)
+				primitive.bounds_min = cooked_primitive.bounds_min;
+				primitive.bounds_max = cooked_primitive.bounds_max;
+
+				if (cooked_primitive.material >= 0)
 				{
-					tinygltf::Material gltf_material = gltf_model.materials[gltf_primitive.material];
+					auto&& cooked_material = pack.materials[cooked_primitive.material];
 
-					if (gltf_material.pbrMetallicRoughness.baseColorTexture.index >= 0)
+					if (cooked_material.albedo.image >= 0)
 					{
-						primitive.material.albedo = images_[gltf_model.textures[gltf_material.pbrMetallicRoughness.baseColorTexture.index].source];
+						primitive.material.albedo = GetTextureImage(cooked_material.albedo, first_image);
 					}
 
-					if (gltf_material.emissiveTexture.index >= 0)
+					if (cooked_material.metallic_roughness.image >= 0)
 					{
-						primitive.material.albedo = images_[gltf_model.textures[gltf_material.emissiveTexture.index].source];
-						primitive.material.flags |= (1 << 0);
+						primitive.material.metallic_roughness = GetTextureImage(cooked_material.metallic_roughness, first_image);
 					}
 
-					if (gltf_material.pbrMetallicRoughness.metallicRoughnessTexture.index >= 0)
+					if (cooked_material.normal_map.image >= 0)
 					{
-						primitive.material.metallic_roughness = images_[gltf_model.textures[gltf_material.pbrMetallicRoughness.metallicRoughnessTexture.index].source];
+						primitive.material.normal_map = GetTextureImage(cooked_material.normal_map, first_image);
 					}
 
-					if (gltf_material.normalTexture.index >= 0)
-					{
-						primitive.material.normal_map = images_[gltf_model.textures[gltf_material.normalTexture.index].source];
-					}
-				}
+					primitive.material.flags = cooked_material.flags;
 
-				//auto&& tmp = *(primitive.positions.buffer);
+					auto&& material_index = material_indices[cooked_primitive.material];
 
-				//if (primitive.positions.buffer) primitive.vertex_buffers.push_back(primitive.positions);
-				//if (primitive.normals.buffer) primitive.vertex_buffers.push_back(primitive.normals);
-				//if (primitive.tangents.buffer)
-				//{
-				//	primitive.vertex_buffers.push_back(primitive.tangents);
-				//	primitive.material.flags |= (1 << 1);
-				//}
-				//else primitive.vertex_buffers.push_back(primitive.normals);
-				//if (primitive.tex_coords.buffer) primitive.vertex_buffers.push_back(primitive.tex_coords);
-				//if (primitive.joints.buffer) { primitive.vertex_buffers.push_back(primitive.joints);  primitive.type = RenderModelType::kSkinned; }
-				//if (primitive.weights.buffer) primitive.vertex_buffers.push_back(primitive.weights);
+					if (!material_index)
+					{
+						material_index = material_table_.AddMaterial(primitive.material);
+					}
 
+					primitive.material_index = *material_index;
+				}
 
-				meshes[mesh_index].primitives.push_back(std::move(primitive));
-				meshes[mesh_index].name = gltf_mesh.name;
+				mesh.primitives.push_back(std::move(primitive));
 			}
-
 		}
 
-		skins.resize(gltf_model.skins.size());
+		size_t first_skin = skins.size();
+		skins.resize(first_skin + pack.skins.size());
 
-		for (int i = 0; i < gltf_model.nodes.size(); i++)
+		for (int skin_index = 0; skin_index < pack.skins.size(); skin_index++)
 		{
-			auto&& gltf_node = gltf_model.nodes[i];
-			auto&& node = nodes[i];
+			auto&& cooked_skin = pack.skins[skin_index];
+			auto&& skin = skins[first_skin + skin_index];
 
-			if (gltf_node.mesh != -1)
+			for (int i = 0; i < cooked_skin.joints.size(); i++)
 			{
-				const tinygltf::Mesh& gltf_mesh = gltf_model.meshes[gltf_node.mesh];
+				skin.joints.push_back(u32(first_node + cooked_skin.joints[i]));
+				skin.inverse_bind_matrices.push_back(cooked_skin.inverse_bind_matrices[i]);
+			}
+		}
 
-				models.emplace(gltf_node.name, Model{ node, meshes[gltf_node.mesh] });
+		for (auto&& cooked_model : pack.models)
+		{
+			int32_t skin_index = cooked_model.skin >= 0 ? int32_t(first_skin + cooked_model.skin) : -1;
 
-				if (gltf_node.skin != -1)
-				{
-					auto&& gltf_skin = gltf_model.skins[gltf_node.skin];
-					auto&& gltf_inverse_matrix_acc = gltf_model.accessors[gltf_skin.inverseBindMatrices];
-					auto&& gltf_inverse_matrix_buf_view = gltf_model.bufferViews[gltf_inverse_matrix_acc.bufferView];
+			Model model{ nodes[first_node + cooked_model.node], meshes[first_mesh + cooked_model.mesh] };
 
-					auto overriden_stride = gltf_inverse_matrix_buf_view.byteStride;
-					auto element_size = tinygltf::GetNumComponentsInType(gltf_inverse_matrix_acc.type) * tinygltf::GetComponentSizeInBytes(gltf_inverse_matrix_acc.componentType);
+			if (skin_index >= 0)
+			{
+				model.skin = skins[skin_index];
+			}
 
-					auto actual_stride = overriden_stride > 0 ? overriden_stride : element_size;
-					auto offset = gltf_inverse_matrix_buf_view.byteOffset + gltf_inverse_matrix_acc.byteOffset;
+			models.emplace(cooked_model.name, model);
+			node_meshes.push_back({ u32(first_node + cooked_model.node), u32(first_mesh + cooked_model.mesh), skin_index });
+		}
 
-					assert(tinygltf::GetNumComponentsInType(gltf_inverse_matrix_acc.type) == 4 * 4);
-					assert(gltf_inverse_matrix_acc.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
+		auto animation_start_time = std::chrono::high_resolution_clock::now();
 
-					std::vector<glm::mat4> inverce_matrices;
+		for (auto&& cooked_animation : pack.animations)
+		{
+			AnimationClip clip;
 
-					for (int i = 0; i < gltf_inverse_matrix_acc.count; i++)
-					{
-						const glm::mat4* mat_ptr = reinterpret_cast<const glm::mat4*>(&(gltf_model.buffers[gltf_inverse_matrix_buf_view.buffer].data[offset + actual_stride * i]));
-						inverce_matrices.push_back(*mat_ptr);
-					}
+			for (auto&& channel : cooked_animation.channels)
+			{
+				clip.duration = std::max(clip.duration, channel.times.back());
 
-					std::map<short, short> node_ind_to_skin_ind;
-					
-					for (int i = 0; i < gltf_skin.joints.size(); i++)
-					{
-						node_ind_to_skin_ind[gltf_skin.joints[i]] = i;
-					}
+				// cubic spline tangents may be outside of [-1, 1], so those channels stay float
+				if (channel.path == CookedModelPack::ChannelPath::kRotation && pack.options.quantize_rotations && channel.interpolation != InterpolationType::kCubicSpline)
+				{
+					auto&& quantized_channel = clip.quantized_rotations.emplace_back(AnimationChannel<QuantizedRotation>{ u32(first_node + channel.node_index), channel.interpolation, channel.times });
+					quantized_channel.values.reserve(channel.values.size());
 
-					for (int i = 0; i < gltf_skin.joints.size(); i++)
+					for (auto&& value : channel.values)
 					{
-						skins[gltf_node.skin].nodes.push_back(nodes[gltf_skin.joints[i]]);
-						skins[gltf_node.skin].inverse_bind_matrices.push_back(inverce_matrices[i]);
-						skins[gltf_node.skin].parent_indices.push_back(node_ind_to_skin_ind[index_to_parent[gltf_skin.joints[i]]]);
+						quantized_channel.values.push_back({ QuantizeSnorm16(value.x), QuantizeSnorm16(value.y), QuantizeSnorm16(value.z), QuantizeSnorm16(value.w) });
 					}
+				}
+				else if (channel.path == CookedModelPack::ChannelPath::kRotation)
+				{
+					auto&& rotation_channel = clip.rotations.emplace_back(AnimationChannel<glm::quat>{ u32(first_node + channel.node_index), channel.interpolation, channel.times });
+					rotation_channel.values.reserve(channel.values.size());
 
-					for (int i = 0; i < skins[gltf_node.skin].nodes.size(); i++)
+					for (auto&& value : channel.values)
 					{
-						if (skins[gltf_node.skin].parent_indices[i] != -1)
-						{
-							skins[gltf_node.skin].nodes[i].parent = skins[gltf_node.skin].nodes[skins[gltf_node.skin].parent_indices[i]];
-						}
+						rotation_channel.values.push_back(glm::quat(value.w, value.x, value.y, value.z));
 					}
 				}
-			}
-
-
-			for (auto&& anim : gltf_model.animations)
-			{
-				Animation animation;
-
-				for (int channel_ind = 0; channel_ind < anim.channels.size(); channel_ind++)
+				else
 				{
-					int sampler_ind = anim.channels[channel_ind].sampler;
-
-					std::span<const float> times = GetBufferSpanByAccessor<float>(gltf_model, anim.samplers[sampler_ind].input);
+					auto&& vector_channel = (channel.path == CookedModelPack::ChannelPath::kTranslation ? clip.translations : clip.scales).emplace_back(AnimationChannel<glm::vec3>{ u32(first_node + channel.node_index), channel.interpolation, channel.times });
+					vector_channel.values.reserve(channel.values.size());
 
-					if (anim.channels[channel_ind].target_path == "translation")
-					{
-						std::span<const glm::vec3> values = GetBufferSpanByAccessor<glm::vec3>(gltf_model, anim.samplers[sampler_ind].output);
-						AnimSampler<glm::vec3> sampler;
-						sampler.node_index = anim.channels[channel_ind].target_node;
-						sampler.interpolation_type = anim.samplers[sampler_ind].interpolation == "CUBICSPLINE" ? InterpolationType::kCubicSpline : InterpolationType::kLinear;
-
-						for (int i = 0; i < values.size(); i++)
-						{
-							int ms_time = static_cast<int>(sampler.interpolation_type == InterpolationType::kCubicSpline ? times[i / 3] : times[i]) * 1000;
-							sampler.frames.push_back({ std::chrono::milliseconds(ms_time), values[i] });
-						}
-
-						animation.translations.push_back(sampler);
-					}
-					else if (anim.channels[channel_ind].target_path == "scale")
+					for (auto&& value : channel.values)
 					{
-						std::span<const glm::vec3> values = GetBufferSpanByAccessor<glm::vec3>(gltf_model, anim.samplers[sampler_ind].output);
-						AnimSampler<glm::vec3> sampler;
-						sampler.node_index = anim.channels[channel_ind].target_node;
-						sampler.interpolation_type = anim.samplers[sampler_ind].interpolation == "CUBICSPLINE" ? InterpolationType::kCubicSpline : InterpolationType::kLinear;
-
-						for (int i = 0; i < values.size(); i++)
-						{
-							int ms_time = static_cast<int>(sampler.interpolation_type == InterpolationType::kCubicSpline ? times[i / 3] : times[i]) * 1000;
-							sampler.frames.push_back({ std::chrono::milliseconds(ms_time), values[i] });
-						}
-
-						animation.scales.push_back(sampler);
-					}
-					else if (anim.channels[channel_ind].target_path == "rotation")
-					{
-						std::span<const glm::vec4> values = GetBufferSpanByAccessor<glm::vec4>(gltf_model, anim.samplers[sampler_ind].output);
-						AnimSampler<glm::quat> sampler;
-						sampler.node_index = anim.channels[channel_ind].target_node;
-						sampler.interpolation_type = anim.samplers[sampler_ind].interpolation == "CUBICSPLINE" ? InterpolationType::kCubicSpline : InterpolationType::kLinear;
-
-						for (int i = 0; i < values.size(); i++)
-						{
-							int ms_time = static_cast<int>(sampler.interpolation_type == InterpolationType::kCubicSpline ? times[i / 3] : times[i]) * 1000;
-							sampler.frames.push_back({ std::chrono::milliseconds(ms_time), glm::quat(values[i].w,values[i].x,values[i].y,values[i].z) });
-						}
-
-						animation.rotations.push_back(sampler);
+						vector_channel.values.push_back(glm::vec3(value));
 					}
 				}
-
-				animations.emplace(anim.name, animation);
 			}
+
+			animation_clips_bytes += clip.GetMemorySize();
+			animations.emplace(cooked_animation.name, std::move(clip));
 		}
+
+		std::chrono::duration<float, std::milli> animation_duration = std::chrono::high_resolution_clock::now() - animation_start_time;
+		animation_import_time_ms += animation_duration.count();
 	}
 
 	void ModelPack::AddSimpleMesh(const std::vector<glm::vec3>& faces, PrimitiveFlags primitive_flags)
@@ -406,42 +309,21 @@ namespace render
 		meshes.push_back(std::move(mesh));
 	}
 
-	BufferAccessor ModelPack::BuildBufferAccessor(const tinygltf::Model& gltf_model, int acc_ind) const
+	BufferAccessor ModelPack::BuildBufferAccessor(const CookedModelPack::Accessor& accessor, size_t first_buffer) const
 	{
-		assert(acc_ind >= 0);
-
-		auto overriden_stride = gltf_model.bufferViews[gltf_model.accessors[acc_ind].bufferView].byteStride;
-		auto element_size = tinygltf::GetNumComponentsInType(gltf_model.accessors[acc_ind].type) * tinygltf::GetComponentSizeInBytes(gltf_model.accessors[acc_ind].componentType);
-
-		size_t actual_stride = overriden_stride > 0 ? overriden_stride : element_size;
+		assert(accessor.buffer >= 0);
 
-		size_t offset = gltf_model.bufferViews[gltf_model.accessors[acc_ind].bufferView].byteOffset + gltf_model.accessors[acc_ind].byteOffset;
-
-		BufferAccessor buffer_accessor(buffers_[gltf_model.bufferViews[gltf_model.accessors[acc_ind].bufferView].buffer], actual_stride, offset, gltf_model.accessors[acc_ind].count);
-
-		return buffer_accessor;
+		return BufferAccessor(buffers_[first_buffer + accessor.buffer], accessor.stride, size_t(accessor.offset), accessor.count);
 	}
 
-	int ModelPack::GetBufferViewIndexFromAttributes(const std::map<std::string, int>& attributes, VertexBufferType vertex_buffer_type, int index) const
+	const Image& ModelPack::GetTextureImage(const CookedModelPack::TextureRef& texture_ref, size_t first_image) const
 	{
-		std::string name = GetVertexBufferTypesToNames().at(vertex_buffer_type);
+		if (texture_ref.image >= 0 && images_[first_image + texture_ref.image])
+			return *images_[first_image + texture_ref.image];
 
-		if (index < 0)
-		{
-			if (auto&& it = attributes.find(name); it != attributes.end())
-			{
-				return it->second;
-			}
-		}
-		else
-		{
-			std::string indexed_name = name + "_" + std::to_string(index);
-			if (auto&& it = attributes.find(indexed_name); it != attributes.end())
-			{
-				return it->second;
-			}
-		}
+		if (texture_ref.fallback_image >= 0 && images_[first_image + texture_ref.fallback_image])
+			return *images_[first_image + texture_ref.fallback_image];
 
-		return -1;
+		return *global_.error_image;
 	}
-}
\ No newline at end of file
+}
@@ -14,8 +14,10 @@
 #include "data_types.h"
 #include "mesh.h"
 #include "render/buffer.h"
+#include "render/cooked_model_pack.h"
 #include "render/image.h"
 #include "render/image_view.h"
+#include "render/material_table.h"
 #include "render/vertex_buffer.h"
 
 namespace render
@@ -23,32 +25,56 @@ namespace render
 	class ModelPack
 	{
 	public:
-		ModelPack(const Global& global, DescriptorSetsManager& manager);
+		ModelPack(const Global& global, DescriptorSetsManager& manager, MaterialTable& material_table);
 		ModelPack(const ModelPack&) = delete;
 		ModelPack(ModelPack&&) = default;
 
+		~ModelPack();
+
 		void AddGLTF(const tinygltf::Model& gltf_model);
+		void AddCooked(const CookedModelPack& pack);
 		void AddSimpleMesh(const std::vector<glm::vec3>& faces, PrimitiveFlags primitive_flags);
 
 		std::vector<Node> nodes;
 		std::unordered_map<std::string, Model> models;
+
+		// hierarchy of nodes and the meshes placed on them, for instances that copy the nodes to pose them
+		struct NodeMesh
+		{
+			uint32_t node;
+			uint32_t mesh;
+			// -1 for static meshes
+			int32_t skin;
+		};
+
+		std::vector<int32_t> node_parents;
+		std::vector<NodeMesh> node_meshes;
 		std::vector<Mesh> meshes;
 		std::vector<Skin> skins;
 
-		std::map<std::string, Animation> animations;
+		// parsed once per pack, clips with the same name as earlier ones are skipped
+		std::map<std::string, AnimationClip> animations;
+
+		// glTF buffer bytes the added packs were cooked from and geometry bytes actually uploaded
+		uint64_t source_buffers_bytes = 0;
+		uint64_t uploaded_buffers_bytes = 0;
+
+		float animation_import_time_ms = 0.0f;
+		uint64_t animation_clips_bytes = 0;
 
 	private:
 		const Global& global_;
 		DescriptorSetsManager& desc_set_manager_;
+		MaterialTable& material_table_;
 
 		std::vector<GPULocalBuffer> buffers_;
-		std::vector<Image> images_;
-		std::vector<ImageView> images_views_;
+		// empty for images that failed to load, e.g. basis universal KTX2 payloads
+		std::vector<std::optional<Image>> images_;
 
 
 
-		int GetBufferViewIndexFromAttributes(const std::map<std::string, int>& attributes, VertexBufferType vertex_buffer_type, int index = -1) const;
-		BufferAccessor BuildBufferAccessor(const tinygltf::Model& gltf_model, int acc_ind) const;
+		const Image& GetTextureImage(const CookedModelPack::TextureRef& texture_ref, size_t first_image) const;
+		BufferAccessor BuildBufferAccessor(const CookedModelPack::Accessor& accessor, size_t first_buffer) const;
 	};
 
 
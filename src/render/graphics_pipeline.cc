@@ -13,16 +13,16 @@
 namespace render
 {
 
-	GraphicsPipeline::GraphicsPipeline(const Global& global, const RenderNode& render_node, const ShaderModule& vertex_shader_module, const ShaderModule& fragment_shader_module, const std::array<Extent, kExtentTypeCnt>& extents, PrimitiveFlags required_primitive_flags, Params params) :
+	GraphicsPipeline::GraphicsPipeline(const Global& global, const RenderNode& render_node, const ShaderModule& vertex_shader_module, const ShaderModule& fragment_shader_module, PrimitiveFlags required_primitive_flags, Params params) :
 		RenderObjBase(global), layout_(VK_NULL_HANDLE), required_primitive_flags_(required_primitive_flags), vertex_bindings_count_(0)
 	{
-		InitPipeline(render_node, vertex_shader_module, {}, fragment_shader_module, extents, params);
+		InitPipeline(render_node, vertex_shader_module, {}, fragment_shader_module, params);
 	}
 
-	GraphicsPipeline::GraphicsPipeline(const Global& global, const RenderNode& render_node, util::NullableRef<const ShaderModule> vertex_shader_module, util::NullableRef<const ShaderModule> geometry_shader_module, util::NullableRef<const ShaderModule> fragment_shader_module, const std::array<Extent, kExtentTypeCnt>& extents, PrimitiveFlags required_primitive_flags, Params params) :
+	GraphicsPipeline::GraphicsPipeline(const Global& global, const RenderNode& render_node, util::NullableRef<const ShaderModule> vertex_shader_module, util::NullableRef<const ShaderModule> geometry_shader_module, util::NullableRef<const ShaderModule> fragment_shader_module, PrimitiveFlags required_primitive_flags, Params params) :
 		RenderObjBase(global), layout_(VK_NULL_HANDLE), required_primitive_flags_(required_primitive_flags), vertex_bindings_count_(0)
 	{
-		InitPipeline(render_node, vertex_shader_module, geometry_shader_module, fragment_shader_module, extents, params);
+		InitPipeline(render_node, vertex_shader_module, geometry_shader_module, fragment_shader_module, params);
 	}
 
 	const std::map<uint32_t, const DescriptorSetLayout&>& GraphicsPipeline::GetDescriptorSetLayouts() const
@@ -64,7 +64,7 @@ namespace render
 	}
 
 	bool GraphicsPipeline::InitPipeline(const RenderNode& render_node, util::NullableRef<const ShaderModule> vertex_shader_module, util::NullableRef<const ShaderModule> geometry_shader_module,
-		util::NullableRef<const ShaderModule> fragment_shader_module, const std::array<Extent, kExtentTypeCnt>& extents, Params params)
+		util::NullableRef<const ShaderModule> fragment_shader_module, Params params)
 	{
 		std::vector<VkPipelineShaderStageCreateInfo> shader_stage_create_infos;
 		std::vector<VkVertexInputBindingDescription> vertex_input_bindings_descs;
@@ -123,24 +123,19 @@ namespace render
 		input_assembly.topology = params.Check(EParams::kLineTopology) ? VK_PRIMITIVE_TOPOLOGY_LINE_LIST : params.Check(EParams::kPointTopology) ? VK_PRIMITIVE_TOPOLOGY_POINT_LIST : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 		input_assembly.primitiveRestartEnable = VK_FALSE;
 
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(extents[u32(render_node.GetExtentType())].width);
-		viewport.height = static_cast<float>(extents[u32(render_node.GetExtentType())].height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D scissor{};
-		scissor.offset = { 0, 0 };
-		scissor.extent = extents[u32(render_node.GetExtentType())];
-
 		VkPipelineViewportStateCreateInfo viewport_state{};
 		viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 		viewport_state.viewportCount = 1;
-		viewport_state.pViewports = &viewport;
+		viewport_state.pViewports = nullptr; // dynamic
 		viewport_state.scissorCount = 1;
-		viewport_state.pScissors = &scissor;
+		viewport_state.pScissors = nullptr; // dynamic
+
+		std::array<VkDynamicState, 2> dynamic_states = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+		VkPipelineDynamicStateCreateInfo dynamic_state{};
+		dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamic_state.dynamicStateCount = u32(dynamic_states.size());
+		dynamic_state.pDynamicStates = dynamic_states.data();
 
 		VkPipelineRasterizationStateCreateInfo rasterizer{};
 		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -334,12 +329,12 @@ namespace render
 		pipeline_info.pDepthStencilState = nullptr; // Optional
 		pipeline_info.pColorBlendState = &color_blending;
 		pipeline_info.pDepthStencilState = &depth_stencil;
-		pipeline_info.pDynamicState = nullptr; // Optional
+		pipeline_info.pDynamicState = &dynamic_state;
 
 		pipeline_info.layout = layout_;
 
 		pipeline_info.renderPass = render_node.GetRenderPass().GetHandle();
-		pipeline_info.subpass = 0;
+		pipeline_info.subpass = render_node.GetSubpassIndex();
 
 		pipeline_info.basePipelineHandle = VK_NULL_HANDLE; // Optional
 		pipeline_info.basePipelineIndex = -1; // Optional
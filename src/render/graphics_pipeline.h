@@ -20,6 +20,7 @@ namespace render
 	struct FragmentPushConstants {
 		float metallic;
 		float roughness;
+		uint32_t material_index;
 	};
 
 	struct GraphicsPipelineCreateInfo
@@ -46,10 +47,10 @@ namespace render
 		using Params = util::enums::Flags<EParams>;
 
 		GraphicsPipeline(const Global& global, const RenderNode& render_node, const ShaderModule& vertex_shader_module, const ShaderModule& fragment_shader_module,
-			const std::array<Extent, kExtentTypeCnt>& extents, PrimitiveFlags required_primitive_flags, Params params = {});
+			PrimitiveFlags required_primitive_flags, Params params = {});
 
 		GraphicsPipeline(const Global& global, const RenderNode& render_node, util::NullableRef<const ShaderModule> vertex_shader_module, util::NullableRef<const ShaderModule> geomery_shader_module, util::NullableRef<const ShaderModule> fragment_shader_module,
-			const std::array<Extent, kExtentTypeCnt>& extents, PrimitiveFlags required_primitive_flags, Params params = {});
+			PrimitiveFlags required_primitive_flags, Params params = {});
 
 		GraphicsPipeline(const GraphicsPipeline&) = delete;
 		GraphicsPipeline(GraphicsPipeline&&) = default;
@@ -70,7 +71,7 @@ namespace render
 	private:
 
 		bool InitPipeline(const RenderNode& render_node, util::NullableRef<const ShaderModule> vertex_shader_module, util::NullableRef<const ShaderModule> geometry_shader_module,
-			util::NullableRef<const ShaderModule> fragmnt_shader_module, const std::array<Extent, kExtentTypeCnt>& extents, Params params);
+			util::NullableRef<const ShaderModule> fragmnt_shader_module, Params params);
 
 		std::vector<VkVertexInputBindingDescription> BuildVertexInputBindingDescriptions(const std::map<uint32_t, render::ShaderModule::VertexBindingDesc>& vertex_bindings_descs);
 		std::vector<VkVertexInputAttributeDescription> BuildVertexAttributeDescription(const std::map<uint32_t, render::ShaderModule::VertexBindingDesc>& vertex_bindings_descs);
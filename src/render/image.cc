@@ -1,8 +1,16 @@
 #include "image.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iterator>
 #include <memory>
 
 #include "global.h"
+#include "render/block_compression.h"
+#include "render/ktx2.h"
 
 #pragma warning(push, 0)
 #define STB_IMAGE_IMPLEMENTATION
@@ -11,6 +19,43 @@
 
 namespace render
 {
+	namespace
+	{
+		// sRGB levels are filtered on linear values, alpha is always linear
+		struct SrgbTables
+		{
+			std::array<float, 256> to_linear;
+
+			// indexed by linear value * (kToSrgbSize - 1)
+			static const size_t kToSrgbSize = 4096;
+			std::array<unsigned char, kToSrgbSize> to_srgb;
+		};
+
+		const SrgbTables& GetSrgbTables()
+		{
+			static const SrgbTables tables = []()
+				{
+					SrgbTables tables;
+
+					for (size_t i = 0; i < tables.to_linear.size(); i++)
+					{
+						float value = i / 255.0f;
+						tables.to_linear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+					}
+
+					for (size_t i = 0; i < tables.to_srgb.size(); i++)
+					{
+						float value = float(i) / (SrgbTables::kToSrgbSize - 1);
+						float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+						tables.to_srgb[i] = static_cast<unsigned char>(std::clamp(srgb, 0.0f, 1.0f) * 255.0f + 0.5f);
+					}
+
+					return tables;
+				}();
+
+			return tables;
+		}
+	}
 
 	Image::Image(const Global& global, VkFormat format, Extent extent, uint32_t layer_cnt) : LazyRenderObj(global), format_(format), extent_(extent), holds_external_handle_(false), usage_(0), layer_cnt_(layer_cnt), mipmap_levels_count_(1)
 	{
@@ -110,25 +155,229 @@ namespace render
 		}
 	}
 
+	Image::Image(const Global& global, std::shared_ptr<const MipChain> mip_chain, uint32_t first_level) : Image(global, mip_chain->format, mip_chain->GetLevelExtent(first_level))
+	{
+		assert(first_level < mip_chain->GetLevelsCount());
+
+		mipmap_levels_count_ = mip_chain->GetLevelsCount() - first_level;
+		first_level_ = first_level;
+		mip_chain_ = std::move(mip_chain);
+	}
+
 	Image Image::FromFile(const Global& global, const std::string_view& path)
 	{
+		std::ifstream file(std::string(path), std::ios::binary);
+
+		if (!file)
+			throw std::runtime_error("failed to open image file");
+
+		std::vector<unsigned char> file_data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		return FromEncoded(global, file_data, VK_FORMAT_R8G8B8A8_SRGB);
+	}
+
+	Image Image::FromEncoded(const Global& global, std::span<const unsigned char> data, VkFormat format)
+	{
+		if (IsKtx2(data))
+			return FromKtx2(global, data);
+
 		int width = 0;
 		int height = 0;
 		int channels;
 
 		//properties.Set(ImageProperty::kLoad);
 
-		stbi_uc* pixels = stbi_load(path.data(), &width, &height, &channels, STBI_rgb_alpha);
+		stbi_uc* pixels = stbi_load_from_memory(data.data(), int(data.size()), &width, &height, &channels, STBI_rgb_alpha);
 
-		assert(width > 0 && height > 0);
+		if (!pixels)
+			throw std::runtime_error("failed to decode image");
 
-		Image res = Image(global, VK_FORMAT_R8G8B8A8_SRGB, { u32(width), u32(height) }, pixels);
+		Image res = Image(global, format, { u32(width), u32(height) }, pixels);
 
 		stbi_image_free(pixels);
 
 		return res;
 	}
 
+	MipChain Image::LoadMipChain(std::span<const unsigned char> data, VkFormat format)
+	{
+		if (IsKtx2(data))
+			return LoadKtx2MipChain(data);
+
+		int width = 0;
+		int height = 0;
+		int channels;
+
+		stbi_uc* pixels = stbi_load_from_memory(data.data(), int(data.size()), &width, &height, &channels, STBI_rgb_alpha);
+
+		if (!pixels)
+			throw std::runtime_error("failed to decode image");
+
+		MipChain mip_chain = BuildMipChain(format, { u32(width), u32(height) }, pixels);
+
+		stbi_image_free(pixels);
+
+		return mip_chain;
+	}
+
+	MipChain Image::BuildMipChain(VkFormat format, Extent extent, const unsigned char* pixels)
+	{
+		std::vector<unsigned char> data;
+		std::vector<size_t> level_offsets;
+
+		bool srgb = format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_B8G8R8A8_SRGB;
+		const SrgbTables& srgb_tables = GetSrgbTables();
+
+		size_t base_size = size_t(extent.width) * extent.height * 4;
+		data.reserve(base_size + base_size / 2);
+		data.assign(pixels, pixels + base_size);
+		level_offsets.push_back(0);
+
+		Extent src_extent = extent;
+
+		while (src_extent.width > 1 || src_extent.height > 1)
+		{
+			Extent dst_extent{ std::max(src_extent.width / 2, 1u), std::max(src_extent.height / 2, 1u) };
+
+			size_t src_offset = level_offsets.back();
+			size_t dst_offset = data.size();
+
+			data.resize(dst_offset + size_t(dst_extent.width) * dst_extent.height * 4);
+			level_offsets.push_back(dst_offset);
+
+			const unsigned char* src = data.data() + src_offset;
+			unsigned char* dst = data.data() + dst_offset;
+
+			// 2x2 box filter, odd edges repeat the last texel
+			for (uint32_t y = 0; y < dst_extent.height; y++)
+			{
+				uint32_t y0 = std::min(2 * y, src_extent.height - 1);
+				uint32_t y1 = std::min(2 * y + 1, src_extent.height - 1);
+
+				for (uint32_t x = 0; x < dst_extent.width; x++)
+				{
+					uint32_t x0 = std::min(2 * x, src_extent.width - 1);
+					uint32_t x1 = std::min(2 * x + 1, src_extent.width - 1);
+
+					for (uint32_t channel = 0; channel < 4; channel++)
+					{
+						if (srgb && channel < 3)
+						{
+							float linear_sum =
+								srgb_tables.to_linear[src[(size_t(y0) * src_extent.width + x0) * 4 + channel]] +
+								srgb_tables.to_linear[src[(size_t(y0) * src_extent.width + x1) * 4 + channel]] +
+								srgb_tables.to_linear[src[(size_t(y1) * src_extent.width + x0) * 4 + channel]] +
+								srgb_tables.to_linear[src[(size_t(y1) * src_extent.width + x1) * 4 + channel]];
+
+							dst[(size_t(y) * dst_extent.width + x) * 4 + channel] = srgb_tables.to_srgb[size_t(linear_sum / 4 * (SrgbTables::kToSrgbSize - 1) + 0.5f)];
+							continue;
+						}
+
+						uint32_t sum =
+							src[(size_t(y0) * src_extent.width + x0) * 4 + channel] +
+							src[(size_t(y0) * src_extent.width + x1) * 4 + channel] +
+							src[(size_t(y1) * src_extent.width + x0) * 4 + channel] +
+							src[(size_t(y1) * src_extent.width + x1) * 4 + channel];
+
+						dst[(size_t(y) * dst_extent.width + x) * 4 + channel] = static_cast<unsigned char>((sum + 2) / 4);
+					}
+				}
+			}
+
+			src_extent = dst_extent;
+		}
+
+		return MipChain::FromData(format, extent, std::move(data), std::move(level_offsets));
+	}
+
+	std::shared_ptr<const MipChain> Image::ToSampledFormat(const Global& global, std::shared_ptr<const MipChain> mip_chain)
+	{
+		if (!IsBlockCompressed(mip_chain->format) || IsSampledFormatSupported(global, mip_chain->format))
+			return mip_chain;
+
+		if (!CanDecodeBlockCompressed(mip_chain->format))
+			throw std::runtime_error("failed to load texture, format is not supported by device");
+
+		// the storage is sized once and every level is decoded in place, it is the only copy until the staging upload
+		std::vector<size_t> level_offsets(mip_chain->GetLevelsCount());
+		size_t pixels_size = 0;
+
+		for (uint32_t level = 0; level < mip_chain->GetLevelsCount(); level++)
+		{
+			Extent level_extent = mip_chain->GetLevelExtent(level);
+
+			level_offsets[level] = pixels_size;
+			pixels_size += size_t(level_extent.width) * level_extent.height * 4;
+		}
+
+		std::vector<unsigned char> pixels(pixels_size);
+
+		for (uint32_t level = 0; level < mip_chain->GetLevelsCount(); level++)
+		{
+			size_t level_end = level + 1 < mip_chain->GetLevelsCount() ? mip_chain->level_offsets[level + 1] : mip_chain->data.size();
+			auto&& level_data = mip_chain->data.subspan(mip_chain->level_offsets[level], level_end - mip_chain->level_offsets[level]);
+
+			DecodeBlockCompressed(mip_chain->format, mip_chain->GetLevelExtent(level), level_data, std::span(pixels).subspan(level_offsets[level]));
+		}
+
+		return std::make_shared<const MipChain>(MipChain::FromData(GetDecodedFormat(mip_chain->format), mip_chain->extent, std::move(pixels), std::move(level_offsets)));
+	}
+
+	Image Image::FromKtx2(const Global& global, std::span<const unsigned char> data)
+	{
+		return Image(global, ToSampledFormat(global, std::make_shared<const MipChain>(LoadKtx2MipChain(data))));
+	}
+
+	MipChain Image::LoadKtx2MipChain(std::span<const unsigned char> data)
+	{
+		Ktx2Texture texture = ParseKtx2(data);
+
+		if (texture.generate_mips && (texture.format == VK_FORMAT_R8G8B8A8_SRGB || texture.format == VK_FORMAT_R8G8B8A8_UNORM))
+		{
+			// the level is in the file, BuildMipChain also reads the whole extent from it
+			if (texture.levels[0].size < size_t(texture.extent.width) * texture.extent.height * 4)
+				throw std::runtime_error("failed to load ktx2, base level is smaller than its extent");
+
+			return BuildMipChain(texture.format, texture.extent, data.data() + texture.levels[0].offset);
+		}
+
+		std::vector<unsigned char> pixels;
+		std::vector<size_t> level_offsets;
+
+		for (uint32_t level = 0; level < texture.levels.size(); level++)
+		{
+			auto&& level_data = data.subspan(texture.levels[level].offset, texture.levels[level].size);
+
+			// copy regions must start at a multiple of the texel block size
+			pixels.resize((pixels.size() + 15) & ~size_t(15));
+			level_offsets.push_back(pixels.size());
+			pixels.insert(pixels.end(), level_data.begin(), level_data.end());
+		}
+
+		return MipChain::FromData(texture.format, texture.extent, std::move(pixels), std::move(level_offsets));
+	}
+
+	MipChain MipChain::FromData(VkFormat format, Extent extent, std::vector<unsigned char>&& data, std::vector<size_t>&& level_offsets)
+	{
+		auto&& owned_data = std::make_shared<const std::vector<unsigned char>>(std::move(data));
+		return MipChain{ format, extent, *owned_data, std::move(level_offsets), owned_data };
+	}
+
+	uint32_t MipChain::GetLevelsCount() const
+	{
+		return u32(level_offsets.size());
+	}
+
+	Extent MipChain::GetLevelExtent(uint32_t level) const
+	{
+		return { std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u) };
+	}
+
+	size_t MipChain::GetBytes(uint32_t first_level) const
+	{
+		return data.size() - level_offsets[first_level];
+	}
+
 	VkFormat Image::GetFormat() const
 	{
 		return format_;
@@ -140,6 +389,31 @@ namespace render
 	}
 
 	void Image::TransitionImageLayout(const CommandPool& command_pool, TransitionType transfer_type) const
+	{
+		command_pool.ExecuteOneTimeCommand([this, transfer_type](VkCommandBuffer command_buffer) { RecordTransition(command_buffer, transfer_type); });
+	}
+
+	void Image::CopyBuffer(const CommandPool& command_pool, const Buffer& buffer) const
+	{
+		command_pool.ExecuteOneTimeCommand([this, &buffer](VkCommandBuffer command_buffer) { RecordCopy(command_buffer, buffer); });
+	}
+
+	void Image::RecordUpload(VkCommandBuffer command_buffer, const Buffer& staging_buffer) const
+	{
+		assert(mip_chain_ && handle_ == VK_NULL_HANDLE);
+
+		// InitHandle creates the image and leaves the upload to the command buffer
+		upload_recorded_ = true;
+		GetHandle();
+
+		RecordTransition(command_buffer, TransitionType::kTransferDst);
+		RecordCopy(command_buffer, staging_buffer);
+		RecordTransition(command_buffer, TransitionType::kFragmentRead);
+
+		mip_chain_.reset();
+	}
+
+	void Image::RecordTransition(VkCommandBuffer command_buffer, TransitionType transfer_type) const
 	{
 
 		VkPipelineStageFlags source_stage;
@@ -194,52 +468,51 @@ namespace render
 			destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 		}
 
-		command_pool.ExecuteOneTimeCommand([barrier, source_stage, destination_stage, image = handle_](VkCommandBuffer buffer)
-			{
-				vkCmdPipelineBarrier(
-					buffer,
-					source_stage, destination_stage,
-					0,
-					0, nullptr,
-					0, nullptr,
-					1, &barrier
-				);
-			});
+		vkCmdPipelineBarrier(
+			command_buffer,
+			source_stage, destination_stage,
+			0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier
+		);
 	}
 
-	void Image::CopyBuffer(const CommandPool& command_pool, const Buffer& buffer) const
+	void Image::RecordCopy(VkCommandBuffer command_buffer, const Buffer& buffer) const
 	{
 		assert(handle_ != VK_NULL_HANDLE);
 
+		// one region for the base level, or one per level for a prebuilt mip chain
+		std::vector<VkBufferImageCopy> regions(mip_chain_ ? mipmap_levels_count_ : 1);
 
-		VkBufferImageCopy region{};
-		region.bufferOffset = 0;
-		region.bufferRowLength = 0;
-		region.bufferImageHeight = 0;
-
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = layer_cnt_;
-
-		region.imageOffset = { 0, 0, 0 };
-		region.imageExtent = {
-			extent_.width,
-			extent_.height,
-			1
-		};
+		for (uint32_t level = 0; level < regions.size(); level++)
+		{
+			VkBufferImageCopy& region = regions[level];
+			region.bufferOffset = mip_chain_ ? mip_chain_->level_offsets[first_level_ + level] - mip_chain_->level_offsets[first_level_] : 0;
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = layer_cnt_;
+
+			region.imageOffset = { 0, 0, 0 };
+			region.imageExtent = {
+				std::max(extent_.width >> level, 1u),
+				std::max(extent_.height >> level, 1u),
+				1
+			};
+		}
 
-		command_pool.ExecuteOneTimeCommand([region, &buffer, image = handle_](VkCommandBuffer command_buffer)
-			{
-				vkCmdCopyBufferToImage(
-					command_buffer,
-					buffer.GetHandle(),
-					image,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					1,
-					&region
-				);
-			});
+		vkCmdCopyBufferToImage(
+			command_buffer,
+			buffer.GetHandle(),
+			handle_,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			u32(regions.size()),
+			regions.data()
+		);
 	}
 
 	Image::~Image()
@@ -278,6 +551,17 @@ namespace render
 		return extent_;
 	}
 
+	uint64_t Image::GetId() const
+	{
+		return id_;
+	}
+
+	uint64_t Image::NextId()
+	{
+		static std::atomic<uint64_t> next_id = 1;
+		return next_id++;
+	}
+
 	bool Image::InitHandle() const
 	{
 		VkImageCreateInfo image_info{};
@@ -292,12 +576,12 @@ namespace render
 		image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
 		image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-		if (pixels_data_)
+		if (pixels_data_ || mip_chain_)
 		{
 			AddUsageFlag(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
 		}
 
-		if (mipmap_levels_count_ > 1)
+		if (mipmap_levels_count_ > 1 && !mip_chain_)
 		{
 			AddUsageFlag(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
 		}
@@ -353,9 +637,22 @@ namespace render
 
 			TransitionImageLayout(*global_.graphics_cmd_pool, TransitionType::kTransferDst);
 			CopyBuffer(*global_.transfer_cmd_pool, staging_buffer);
-
 			GenerateMipMaps();
 		}
+		else if (mip_chain_ && !upload_recorded_)
+		{
+			size_t first_offset = mip_chain_->level_offsets[first_level_];
+			size_t size = mip_chain_->GetBytes(first_level_);
+
+			StagingBuffer staging_buffer(global_, size);
+			staging_buffer.LoadData(mip_chain_->data.data() + first_offset, size);
+
+			TransitionImageLayout(*global_.graphics_cmd_pool, TransitionType::kTransferDst);
+			CopyBuffer(*global_.transfer_cmd_pool, staging_buffer);
+			TransitionImageLayout(*global_.graphics_cmd_pool, TransitionType::kFragmentRead);
+
+			mip_chain_.reset();
+		}
 
 
 
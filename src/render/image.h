@@ -4,6 +4,7 @@
 #include <vector>
 #include <array>
 #include <memory>
+#include <span>
 
 #include "vulkan/vulkan.h"
 
@@ -80,6 +81,25 @@ namespace render
 
 
 
+	// CPU side mip levels of a texture, level 0 is the largest.
+	// data points into storage, which is either owned by the chain or a mapped cache file.
+	struct MipChain
+	{
+		VkFormat format;
+		Extent extent;
+		std::span<const unsigned char> data;
+		std::vector<size_t> level_offsets;
+		std::shared_ptr<const void> storage;
+
+		static MipChain FromData(VkFormat format, Extent extent, std::vector<unsigned char>&& data, std::vector<size_t>&& level_offsets);
+
+		uint32_t GetLevelsCount() const;
+		Extent GetLevelExtent(uint32_t level) const;
+
+		// size of levels [first_level, last]
+		size_t GetBytes(uint32_t first_level) const;
+	};
+
 	class Image : public LazyRenderObj<VkImage>
 	{
 	public:
@@ -104,7 +124,23 @@ namespace render
 		Image(const Global& global, VkFormat format, VkImage image_handle);
 		Image(const Global& global, BuiltinImageType type);
 
+		// levels [first_level, last] of a prebuilt mip chain, uploaded straight from the chain storage
+		Image(const Global& global, std::shared_ptr<const MipChain> mip_chain, uint32_t first_level = 0);
+
 		static Image FromFile(const Global& global, const std::string_view& path);
+		static Image FromKtx2(const Global& global, std::span<const unsigned char> data);
+
+		// Decodes KTX2 or any stb supported file, format is used for stb images only.
+		// Creates no Vulkan objects, so it can run on worker threads.
+		static Image FromEncoded(const Global& global, std::span<const unsigned char> data, VkFormat format);
+
+		// Same as FromEncoded, but keeps the levels on CPU, missing RGBA8 levels are built with a box filter.
+		// KTX2 levels keep their format, so the chain does not depend on the device.
+		static MipChain LoadMipChain(std::span<const unsigned char> data, VkFormat format);
+		static MipChain BuildMipChain(VkFormat format, Extent extent, const unsigned char* pixels);
+
+		// decodes block compressed levels the device can't sample, other chains are returned as is
+		static std::shared_ptr<const MipChain> ToSampledFormat(const Global& global, std::shared_ptr<const MipChain> mip_chain);
 
 		Image(const Image&) = delete;
 		Image(Image&&) = default;
@@ -119,6 +155,10 @@ namespace render
 		void TransitionImageLayout(const CommandPool& command_pool, TransitionType transfer_type) const;
 		void CopyBuffer(const CommandPool& command_pool, const Buffer& buffer) const;
 
+		// Creates an image built from a mip chain and records the upload of its levels into command_buffer.
+		// staging_buffer holds levels [first_level, last] laid out as in the chain, the image is sampled once the command buffer completes.
+		void RecordUpload(VkCommandBuffer command_buffer, const Buffer& staging_buffer) const;
+
 		virtual ~Image() override;
 
 		uint32_t GetMipMapLevelsCount() const;
@@ -128,15 +168,28 @@ namespace render
 
 		Extent GetExtent() const;
 
+		// unique for the process lifetime, unlike the handle of a destroyed image
+		uint64_t GetId() const;
+
 	private:
 
+		static uint64_t NextId();
+
 		virtual bool InitHandle() const override;
 
+		void RecordTransition(VkCommandBuffer command_buffer, TransitionType transfer_type) const;
+		void RecordCopy(VkCommandBuffer command_buffer, const Buffer& buffer) const;
+
+		static MipChain LoadKtx2MipChain(std::span<const unsigned char> data);
+
 		Extent extent_;
 
 		void GenerateMipMaps() const;
 
 		mutable std::unique_ptr<std::vector<unsigned char>> pixels_data_;
+		mutable std::shared_ptr<const MipChain> mip_chain_;
+		uint32_t first_level_ = 0;
+		mutable bool upload_recorded_ = false;
 		mutable std::unique_ptr<Memory> memory_;
 
 		VkFormat format_;
@@ -147,6 +200,7 @@ namespace render
 
 		bool holds_external_handle_;
 
+		uint64_t id_ = NextId();
 	};
 }
 #endif  // RENDER_ENGINE_RENDER_IMAGE_H_
\ No newline at end of file
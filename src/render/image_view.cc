@@ -11,17 +11,27 @@ render::ImageView::ImageView(const Global& global, const Image& image): RenderOb
 	Assign(image);
 }
 
+render::ImageView::ImageView(const Global& global, const Image& image, uint32_t base_layer, uint32_t layer_cnt) : RenderObjBase(global), format_(VK_FORMAT_UNDEFINED), layer_cnt_(0)
+{
+	Assign(image, base_layer, layer_cnt);
+}
+
 
 void render::ImageView::Assign(const Image& image)
 {
+	Assign(image, 0, image.GetLayerCount());
+}
+
+void render::ImageView::Assign(const Image& image, uint32_t base_layer, uint32_t layer_cnt)
+{
+	assert(base_layer + layer_cnt <= image.GetLayerCount());
+
 	if (handle_ != VK_NULL_HANDLE)
 	{
-		//TODO: FIX THIS HACK!
-		return;
-		throw std::runtime_error("Image already assigned");
+		throw std::runtime_error("failed to assign image, view already created");
 	}
 
-	layer_cnt_ = image.GetLayerCount();
+	layer_cnt_ = layer_cnt;
 
 //	std::optional<std::reference_wrapper<ReferencedType>>
 
@@ -30,18 +40,7 @@ void render::ImageView::Assign(const Image& image)
 	view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	view_info.image = image.GetHandle();
 
-	if (layer_cnt_ == 6)
-	{
-		view_info.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
-	}
-	else if (layer_cnt_ % 6 == 0)
-	{
-		view_info.viewType = VK_IMAGE_VIEW_TYPE_CUBE_ARRAY;
-	}
-	else
-	{
-		view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	}
+	view_info.viewType = GetViewType(layer_cnt_);
 
 	view_info.format = image.GetFormat();
 
@@ -63,7 +62,7 @@ void render::ImageView::Assign(const Image& image)
 
 	view_info.subresourceRange.baseMipLevel = 0;
 	view_info.subresourceRange.levelCount = image.GetMipMapLevelsCount();
-	view_info.subresourceRange.baseArrayLayer = 0;
+	view_info.subresourceRange.baseArrayLayer = base_layer;
 	view_info.subresourceRange.layerCount = layer_cnt_;
 
 	if (vkCreateImageView(global_.logical_device, &view_info, nullptr, &handle_) != VK_SUCCESS) {
@@ -110,6 +109,20 @@ uint32_t render::ImageView::GetLayerCount() const
 	return layer_cnt_;
 }
 
+VkImageViewType render::ImageView::GetViewType(uint32_t layer_cnt)
+{
+	if (layer_cnt == 6)
+	{
+		return VK_IMAGE_VIEW_TYPE_CUBE;
+	}
+	else if (layer_cnt % 6 == 0)
+	{
+		return VK_IMAGE_VIEW_TYPE_CUBE_ARRAY;
+	}
+
+	return VK_IMAGE_VIEW_TYPE_2D;
+}
+
 render::ImageView::~ImageView()
 {
 	if (handle_ != VK_NULL_HANDLE)
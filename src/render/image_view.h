@@ -19,6 +19,7 @@ namespace render
 
 		ImageView(const Global& global);
 		ImageView(const Global& global, const Image& image);
+		ImageView(const Global& global, const Image& image, uint32_t base_layer, uint32_t layer_cnt);
 
 		ImageView(const ImageView&) = delete;
 		ImageView(ImageView&&) = default;
@@ -27,10 +28,13 @@ namespace render
 		ImageView& operator=(ImageView&&) = default;
 
 		void Assign(const Image& image);
-		
+		void Assign(const Image& image, uint32_t base_layer, uint32_t layer_cnt);
+
 		VkFormat GetFormat() const;
 		uint32_t GetLayerCount() const;
 
+		static VkImageViewType GetViewType(uint32_t layer_cnt);
+
 		virtual ~ImageView() override;
 
 		bool deferred_delete_ = true;
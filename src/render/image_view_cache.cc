@@ -0,0 +1,52 @@
+#include "image_view_cache.h"
+
+#include <algorithm>
+
+#include "global.h"
+
+namespace render
+{
+	std::shared_ptr<const ImageView> ImageViewCache::Get(const Global& global, const Image& image)
+	{
+		return Get(global, image, 0, image.GetLayerCount());
+	}
+
+	std::shared_ptr<const ImageView> ImageViewCache::Get(const Global& global, const Image& image, uint32_t base_layer, uint32_t layer_cnt)
+	{
+		Key key{ image.GetId(), ImageView::GetViewType(layer_cnt), image.GetFormat(), base_layer, layer_cnt, image.GetMipMapLevelsCount() };
+
+		std::lock_guard lock(mutex_);
+
+		auto&& [it, inserted] = views_.try_emplace(key);
+
+		if (!inserted)
+		{
+			if (auto&& view = it->second.lock())
+				return view;
+		}
+
+		auto&& view = std::make_shared<const ImageView>(global, image, base_layer, layer_cnt);
+		it->second = view;
+
+		// views are dropped without notifying the cache, expired entries are swept once the map doubles
+		if (views_.size() >= purge_threshold_)
+		{
+			PurgeExpired();
+			purge_threshold_ = std::max(purge_threshold_, 2 * views_.size());
+		}
+
+		return view;
+	}
+
+	size_t ImageViewCache::GetViewsCount() const
+	{
+		std::lock_guard lock(mutex_);
+
+		return std::count_if(views_.begin(), views_.end(), [](auto&& entry) { return !entry.second.expired(); });
+	}
+
+	void ImageViewCache::PurgeExpired()
+	{
+		std::erase_if(views_, [](auto&& entry) { return entry.second.expired(); });
+	}
+}
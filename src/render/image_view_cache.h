@@ -0,0 +1,54 @@
+#ifndef RENDER_ENGINE_RENDER_IMAGE_VIEW_CACHE_H_
+#define RENDER_ENGINE_RENDER_IMAGE_VIEW_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "vulkan/vulkan.h"
+
+#include "common.h"
+#include "render/image.h"
+#include "render/image_view.h"
+
+namespace render
+{
+	// One view per image and subresource range, shared by descriptor holders, render graph attachments and UI.
+	// The cache only keeps weak references, the view is released through the delete list when its last user drops it.
+	class ImageViewCache
+	{
+	public:
+
+		ImageViewCache() = default;
+
+		ImageViewCache(const ImageViewCache&) = delete;
+		ImageViewCache& operator=(const ImageViewCache&) = delete;
+
+		std::shared_ptr<const ImageView> Get(const Global& global, const Image& image);
+		std::shared_ptr<const ImageView> Get(const Global& global, const Image& image, uint32_t base_layer, uint32_t layer_cnt);
+
+		size_t GetViewsCount() const;
+
+	private:
+
+		// images are identified by id, a destroyed image handle can be reused by a new image
+		struct Key
+		{
+			uint64_t image_id;
+			VkImageViewType view_type;
+			VkFormat format;
+			uint32_t base_layer;
+			uint32_t layer_cnt;
+			uint32_t mip_levels_cnt;
+
+			auto operator<=>(const Key&) const = default;
+		};
+
+		void PurgeExpired();
+
+		mutable std::mutex mutex_;
+		std::map<Key, std::weak_ptr<const ImageView>> views_;
+		size_t purge_threshold_ = 64;
+	};
+}
+#endif  // RENDER_ENGINE_RENDER_IMAGE_VIEW_CACHE_H_
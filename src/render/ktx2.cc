@@ -0,0 +1,93 @@
+#include "ktx2.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace render
+{
+	namespace
+	{
+		const unsigned char kKtx2Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+		// the header follows the 12 byte identifier, 64 bit fields are not 8 byte aligned relative to it
+#pragma pack(push, 4)
+		struct Ktx2Header
+		{
+			uint32_t vk_format;
+			uint32_t type_size;
+			uint32_t pixel_width;
+			uint32_t pixel_height;
+			uint32_t pixel_depth;
+			uint32_t layer_count;
+			uint32_t face_count;
+			uint32_t level_count;
+			uint32_t supercompression_scheme;
+
+			uint32_t dfd_byte_offset;
+			uint32_t dfd_byte_length;
+			uint32_t kvd_byte_offset;
+			uint32_t kvd_byte_length;
+			uint64_t sgd_byte_offset;
+			uint64_t sgd_byte_length;
+		};
+#pragma pack(pop)
+
+		struct Ktx2LevelIndex
+		{
+			uint64_t byte_offset;
+			uint64_t byte_length;
+			uint64_t uncompressed_byte_length;
+		};
+
+		static_assert(sizeof(Ktx2Header) == 68);
+		static_assert(sizeof(Ktx2LevelIndex) == 24);
+	}
+
+	bool IsKtx2(std::span<const unsigned char> data)
+	{
+		return data.size() >= sizeof(kKtx2Identifier) && std::memcmp(data.data(), kKtx2Identifier, sizeof(kKtx2Identifier)) == 0;
+	}
+
+	Ktx2Texture ParseKtx2(std::span<const unsigned char> data)
+	{
+		if (!IsKtx2(data) || data.size() < sizeof(kKtx2Identifier) + sizeof(Ktx2Header))
+			throw std::runtime_error("failed to parse ktx2, bad header");
+
+		Ktx2Header header;
+		std::memcpy(&header, data.data() + sizeof(kKtx2Identifier), sizeof(Ktx2Header));
+
+		// basis universal payloads are stored with undefined format and need a transcoder, textures fall back to their plain source
+		if (header.vk_format == VK_FORMAT_UNDEFINED || header.supercompression_scheme != 0)
+			throw std::runtime_error("failed to parse ktx2, supercompressed textures are not supported");
+
+		if (header.pixel_depth > 1 || header.layer_count > 1 || header.face_count != 1 || header.pixel_width == 0 || header.pixel_height == 0)
+			throw std::runtime_error("failed to parse ktx2, only 2d textures are supported");
+
+		Ktx2Texture texture;
+		texture.format = VkFormat(header.vk_format);
+		texture.extent = { header.pixel_width, header.pixel_height };
+		texture.generate_mips = header.level_count == 0;
+
+		uint32_t levels_count = std::max(header.level_count, 1u);
+		size_t level_index_offset = sizeof(kKtx2Identifier) + sizeof(Ktx2Header);
+
+		if (data.size() < level_index_offset + levels_count * sizeof(Ktx2LevelIndex))
+			throw std::runtime_error("failed to parse ktx2, truncated level index");
+
+		texture.levels.reserve(levels_count);
+
+		for (uint32_t level = 0; level < levels_count; level++)
+		{
+			Ktx2LevelIndex level_index;
+			std::memcpy(&level_index, data.data() + level_index_offset + level * sizeof(Ktx2LevelIndex), sizeof(Ktx2LevelIndex));
+
+			if (level_index.byte_offset > data.size() || level_index.byte_length > data.size() - level_index.byte_offset)
+				throw std::runtime_error("failed to parse ktx2, level is out of range");
+
+			texture.levels.push_back({ size_t(level_index.byte_offset), size_t(level_index.byte_length) });
+		}
+
+		return texture;
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef RENDER_ENGINE_RENDER_KTX2_H_
+#define RENDER_ENGINE_RENDER_KTX2_H_
+
+#include <span>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "common.h"
+#include "render/data_types.h"
+
+namespace render
+{
+	// Parsed KTX2 container, levels point into the source bytes, level 0 is the largest.
+	// Only single layer 2D textures without supercompression are accepted.
+	struct Ktx2Texture
+	{
+		struct Level
+		{
+			size_t offset;
+			size_t size;
+		};
+
+		VkFormat format;
+		Extent extent;
+		std::vector<Level> levels;
+
+		// level count 0 in the header, the container holds only the base level
+		bool generate_mips;
+	};
+
+	bool IsKtx2(std::span<const unsigned char> data);
+	Ktx2Texture ParseKtx2(std::span<const unsigned char> data);
+}
+#endif  // RENDER_ENGINE_RENDER_KTX2_H_
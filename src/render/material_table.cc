@@ -0,0 +1,215 @@
+#include "material_table.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "render/descriptor_sets_manager.h"
+#include "render/mesh.h"
+
+#include "global.h"
+
+namespace render
+{
+	namespace
+	{
+		// feedback value of textures not sampled during the frame
+		const int32_t kNoLodFeedback = std::numeric_limits<int32_t>::max();
+
+		using FeedbackData = DescriptorSet<DescriptorSetType::kMaterials>::Binding<2>::Data;
+	}
+
+	MaterialTable::MaterialTable(const Global& global, DescriptorSetsManager& manager) :
+		RenderObjBase(global), materials_buffer_(global, sizeof(DescriptorSet<DescriptorSetType::kMaterials>::Binding<0>::Data)), materials_cnt_(0), streamer_(global)
+	{
+		std::vector<int32_t> no_feedback(kBindlessTexturesCount, kNoLodFeedback);
+
+		feedback_buffers_.reserve(kFramesCount);
+
+		for (uint32_t frame_index = 0; frame_index < kFramesCount; frame_index++)
+		{
+			feedback_buffers_.emplace_back(global, sizeof(FeedbackData));
+			feedback_buffers_.back().LoadData(no_feedback.data(), sizeof(FeedbackData));
+
+			VkDescriptorSet vk_descriptor_set = manager.GetFreeDescriptor(DescriptorSetType::kMaterials);
+			descriptor_sets_[frame_index].emplace(DescriptorSetType::kMaterials, vk_descriptor_set);
+
+			std::array<VkDescriptorBufferInfo, 2> buffer_infos{};
+			buffer_infos[0].buffer = materials_buffer_.GetHandle();
+			buffer_infos[0].offset = 0;
+			buffer_infos[0].range = VK_WHOLE_SIZE;
+
+			buffer_infos[1].buffer = feedback_buffers_.back().GetHandle();
+			buffer_infos[1].offset = 0;
+			buffer_infos[1].range = VK_WHOLE_SIZE;
+
+			std::array<VkWriteDescriptorSet, 2> writes{};
+
+			for (uint32_t i = 0; i < writes.size(); i++)
+			{
+				writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writes[i].dstSet = vk_descriptor_set;
+				writes[i].dstBinding = i == 0 ? 0 : 2;
+				writes[i].dstArrayElement = 0;
+				writes[i].descriptorCount = 1;
+				writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				writes[i].pBufferInfo = &buffer_infos[i];
+			}
+
+			vkUpdateDescriptorSets(global_.logical_device, u32(writes.size()), writes.data(), 0, nullptr);
+		}
+
+		textures_.reserve(kBindlessTexturesCount);
+
+		error_texture_index_ = AddTexture(*global_.error_image);
+		default_normal_texture_index_ = AddTexture(*global_.default_normal);
+
+		AddMaterial(Material{ glm::vec4(1, 1, 1, 1) });
+	}
+
+	uint32_t MaterialTable::AddMaterial(const Material& material)
+	{
+		if (materials_cnt_ >= kMaterialsCount)
+			throw std::runtime_error("failed to add material, table is full");
+
+		MaterialData material_data;
+		material_data.color = material.color;
+		material_data.albedo_index = material.albedo ? AddTexture(*material.albedo) : error_texture_index_;
+		material_data.metallic_roughness_index = material.metallic_roughness ? AddTexture(*material.metallic_roughness) : error_texture_index_;
+		material_data.normal_map_index = material.normal_map ? AddTexture(*material.normal_map) : default_normal_texture_index_;
+		material_data.flags = material.flags;
+
+		materials_buffer_.LoadData(&material_data, sizeof(MaterialData), materials_cnt_ * sizeof(MaterialData));
+
+		return materials_cnt_++;
+	}
+
+	void MaterialTable::AddStreamedTexture(const Image& image, std::shared_ptr<const MipChain> mip_chain, uint32_t resident_level)
+	{
+		uint32_t texture_index = AddTexture(image);
+
+		if (streamer_.IsStreamed(texture_index))
+			return;
+
+		textures_[texture_index].base_level = resident_level;
+		streamer_.AddTexture(texture_index, std::move(mip_chain), resident_level);
+	}
+
+	void MaterialTable::RemoveTexture(const Image& image)
+	{
+		auto&& it = image_to_texture_index_.find(image.GetId());
+		if (it == image_to_texture_index_.end())
+			return;
+
+		uint32_t texture_index = it->second;
+		image_to_texture_index_.erase(it);
+
+		// materials keep the index, the slot must not reference the destroyed image
+		SetTextureView(texture_index, global_.image_view_cache.Get(global_, *global_.error_image), 0, global_.error_image->GetMipMapLevelsCount());
+	}
+
+	void MaterialTable::BeginFrame(uint32_t frame_index)
+	{
+		// the frame fence is signaled, its feedback is complete and its set is not in use
+		auto&& feedback_buffer = feedback_buffers_[frame_index];
+
+		std::vector<int32_t> min_lods(textures_.size());
+		feedback_buffer.ReadData(min_lods.data(), min_lods.size() * sizeof(int32_t));
+
+		for (uint32_t texture_index = 0; texture_index < min_lods.size(); texture_index++)
+		{
+			if (min_lods[texture_index] == kNoLodFeedback || !streamer_.IsStreamed(texture_index))
+				continue;
+
+			int32_t level = int32_t(textures_[texture_index].frame_base_levels[frame_index]) + min_lods[texture_index];
+			streamer_.RequestLevel(texture_index, u32(std::max(level, 0)));
+		}
+
+		std::vector<int32_t> no_feedback(min_lods.size(), kNoLodFeedback);
+		feedback_buffer.LoadData(no_feedback.data(), no_feedback.size() * sizeof(int32_t));
+
+		for (auto&& residency : streamer_.Update())
+		{
+			SetTextureView(residency.texture_index, std::move(residency.view), residency.base_level, residency.levels_count);
+		}
+
+		auto&& dirty_textures = dirty_textures_[frame_index];
+
+		if (dirty_textures.empty())
+			return;
+
+		std::vector<VkDescriptorImageInfo> image_infos(dirty_textures.size());
+		std::vector<VkWriteDescriptorSet> writes(dirty_textures.size());
+
+		for (uint32_t i = 0; i < dirty_textures.size(); i++)
+		{
+			auto&& texture = textures_[dirty_textures[i]];
+
+			image_infos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			image_infos[i].imageView = texture.view->GetHandle();
+			image_infos[i].sampler = global_.mipmap_cnt_to_global_samplers[texture.levels_count].GetHandle();
+
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = descriptor_sets_[frame_index].at(DescriptorSetType::kMaterials);
+			writes[i].dstBinding = 1;
+			writes[i].dstArrayElement = dirty_textures[i];
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			writes[i].pImageInfo = &image_infos[i];
+
+			texture.frame_views[frame_index] = texture.view;
+			texture.frame_base_levels[frame_index] = texture.base_level;
+		}
+
+		vkUpdateDescriptorSets(global_.logical_device, u32(writes.size()), writes.data(), 0, nullptr);
+
+		dirty_textures.clear();
+	}
+
+	void MaterialTable::SetStreamingBudget(uint64_t bytes)
+	{
+		streamer_.SetBudget(bytes);
+	}
+
+	TextureStreamer::Stats MaterialTable::GetStreamingStats() const
+	{
+		return streamer_.GetStats();
+	}
+
+	const std::map<DescriptorSetType, VkDescriptorSet>& MaterialTable::GetDescriptorSets(uint32_t frame_index) const
+	{
+		return descriptor_sets_[frame_index];
+	}
+
+	uint32_t MaterialTable::AddTexture(const Image& image)
+	{
+		if (auto&& it = image_to_texture_index_.find(image.GetId()); it != image_to_texture_index_.end())
+			return it->second;
+
+		if (textures_.size() >= kBindlessTexturesCount)
+			throw std::runtime_error("failed to add texture, bindless array is full");
+
+		uint32_t texture_index = u32(textures_.size());
+		textures_.push_back(TextureSlot{});
+
+		SetTextureView(texture_index, global_.image_view_cache.Get(global_, image), 0, image.GetMipMapLevelsCount());
+
+		image_to_texture_index_.emplace(image.GetId(), texture_index);
+
+		return texture_index;
+	}
+
+	void MaterialTable::SetTextureView(uint32_t texture_index, std::shared_ptr<const ImageView> view, uint32_t base_level, uint32_t levels_count)
+	{
+		auto&& texture = textures_[texture_index];
+
+		texture.view = std::move(view);
+		texture.base_level = base_level;
+		texture.levels_count = levels_count;
+
+		for (auto&& dirty_textures : dirty_textures_)
+		{
+			if (std::find(dirty_textures.begin(), dirty_textures.end(), texture_index) == dirty_textures.end())
+				dirty_textures.push_back(texture_index);
+		}
+	}
+}
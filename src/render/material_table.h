@@ -0,0 +1,89 @@
+#ifndef RENDER_ENGINE_RENDER_MATERIAL_TABLE_H_
+#define RENDER_ENGINE_RENDER_MATERIAL_TABLE_H_
+
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "common.h"
+#include "render/buffer.h"
+#include "render/descriptor_set.h"
+#include "render/image.h"
+#include "render/image_view.h"
+#include "render/object_base.h"
+#include "render/texture_streamer.h"
+
+namespace render
+{
+	struct Material;
+	class DescriptorSetsManager;
+
+	// Every material and texture in one kMaterials set per frame, bound once and indexed per draw.
+	// Materials and textures are only appended, so indices used by frames in flight stay valid.
+	// Texture slots keep their index when streaming changes the resident image, a frame set is rewritten only when that frame begins.
+	class MaterialTable : public RenderObjBase<void*>
+	{
+	public:
+
+		MaterialTable(const Global& global, DescriptorSetsManager& manager);
+
+		MaterialTable(const MaterialTable&) = delete;
+		MaterialTable(MaterialTable&&) = default;
+
+		MaterialTable& operator=(const MaterialTable&) = delete;
+		MaterialTable& operator=(MaterialTable&&) = default;
+
+		// returns index to pass to shaders, index 0 is the default material
+		uint32_t AddMaterial(const Material& material);
+
+		// image holds levels [resident_level, last] of the chain, finer levels are streamed in when sampled
+		void AddStreamedTexture(const Image& image, std::shared_ptr<const MipChain> mip_chain, uint32_t resident_level);
+
+		// called by the owner before the image is destroyed, its slot keeps its index and samples the error texture instead
+		void RemoveTexture(const Image& image);
+
+		// called once the frame fence is signaled, before the frame is recorded
+		void BeginFrame(uint32_t frame_index);
+
+		void SetStreamingBudget(uint64_t bytes);
+		TextureStreamer::Stats GetStreamingStats() const;
+
+		const std::map<DescriptorSetType, VkDescriptorSet>& GetDescriptorSets(uint32_t frame_index) const;
+
+	private:
+
+		struct TextureSlot
+		{
+			std::shared_ptr<const ImageView> view;
+			uint32_t base_level;
+			uint32_t levels_count;
+
+			// what the set of each frame references
+			std::array<std::shared_ptr<const ImageView>, kFramesCount> frame_views;
+			std::array<uint32_t, kFramesCount> frame_base_levels;
+		};
+
+		uint32_t AddTexture(const Image& image);
+		void SetTextureView(uint32_t texture_index, std::shared_ptr<const ImageView> view, uint32_t base_level, uint32_t levels_count);
+
+		StorageBuffer materials_buffer_;
+		uint32_t materials_cnt_;
+
+		// keyed by Image::GetId, a destroyed image handle can be reused by a new image
+		std::map<uint64_t, uint32_t> image_to_texture_index_;
+		std::vector<TextureSlot> textures_;
+		std::array<std::vector<uint32_t>, kFramesCount> dirty_textures_;
+
+		uint32_t error_texture_index_;
+		uint32_t default_normal_texture_index_;
+
+		std::vector<StorageBuffer> feedback_buffers_;
+		TextureStreamer streamer_;
+
+		std::array<std::map<DescriptorSetType, VkDescriptorSet>, kFramesCount> descriptor_sets_;
+	};
+}
+#endif  // RENDER_ENGINE_RENDER_MATERIAL_TABLE_H_
@@ -88,7 +88,7 @@ namespace render
 	{
 		auto&& [index, size, align] = memory_to_ind_size_align.at(memory.vk_memory);
 
-		if (size > 1024)
+		if (size > kPooledMemoryMaxSize)
 		{
 			alocs_and_sizes[index].first--;
 			alocs_and_sizes[index].second-= size;
@@ -111,7 +111,7 @@ namespace render
 
 		IndSizeAlign ind_size_align = { index , size, align };
 
-		if (size > 1024)
+		if (size > kPooledMemoryMaxSize)
 		{
 			VkMemoryAllocateInfo allocInfo{};
 			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
@@ -12,6 +12,9 @@
 
 namespace render
 {
+	// allocations up to this size share memory chunks, larger ones own their VkDeviceMemory
+	const uint32_t kPooledMemoryMaxSize = 1024;
+
 	class Memory : public RenderObjBase<OffsettedMemory>
 	{
 	public:
@@ -1,5 +1,7 @@
 #include "mesh.h"
 
+#include <atomic>
+
 #include "render/global.h"
 //#include "mesh.h"
 //
@@ -10,71 +12,128 @@
 //}
 namespace render
 {
+	uint64_t NextDataVersion()
+	{
+		static std::atomic<uint64_t> version = descriptor_sets_holder::kUnversioned;
+		return ++version;
+	}
+
+	void Node::SetParent(Node& parent_node)
+	{
+		parent = parent_node;
+		BumpVersion();
 
-	render::RenderModel::RenderModel(const Global& global, DescriptorSetsManager& manager, Node& node_in, Mesh& mesh_in) :
-		RenderModelDescriptorSetHolder(global, manager),
+		if (version_sink_)
+			parent_node.SetVersionSink(version_sink_);
+	}
+
+	const glm::mat4& Node::GetLocalTransform() const
+	{
+		return local_transform_;
+	}
+
+	void Node::SetLocalTransform(const glm::mat4& transform)
+	{
+		// clients may resend unchanged transforms every frame
+		if (transform == local_transform_)
+			return;
+
+		local_transform_ = transform;
+		BumpVersion();
+	}
+
+	uint64_t Node::GetVersion() const
+	{
+		if (parent)
+			return std::max(version_, parent->GetVersion());
+
+		return version_;
+	}
+
+	void Node::SetVersionSink(const std::shared_ptr<uint64_t>& sink)
+	{
+		if (version_sink_ == sink)
+			return;
+
+		version_sink_ = sink;
+		*version_sink_ = std::max(*version_sink_, version_);
+
+		if (parent)
+			parent->SetVersionSink(sink);
+	}
+
+	void Node::BumpVersion()
+	{
+		version_ = NextDataVersion();
+
+		// versions grow across the engine, the latest bump is the largest one the sink has seen
+		if (version_sink_)
+			*version_sink_ = version_;
+	}
+
+	render::RenderModel::RenderModel(Node& node_in, Mesh& mesh_in) :
 		node(node_in),
 		mesh(mesh_in)
 	{
 	}
 	namespace primitive
 	{
-		Geometry::Geometry(const Global& global, DescriptorSetsManager& manager, PrimitiveFlags flags) : GeometryDescriptorSetHolder(global, manager), Base(flags)
+		util::NullableRef<const BufferAccessor> Base::GetIndices(uint32_t lod) const
 		{
-		}
+			if (lod > 0 && lod <= lods.size())
+				return lods[lod - 1].indices;
 
-		bool Geometry::FillData(render::DescriptorSet<render::DescriptorSetType::kMaterial>::Binding<0>::Data& data)
-		{
-			data.flags = 0;
-			return true;
+			if (indices)
+				return *indices;
+
+			return std::nullopt;
 		}
 
-		bool Geometry::FillData(render::DescriptorSet<render::DescriptorSetType::kMaterial>::Binding<1>::Data& data)
+		uint32_t Base::SelectLod(const glm::mat4& model_matrix, const glm::vec3& view_position, float proj_scale, uint32_t current_lod) const
 		{
-			if (material.albedo)
-			{
-				SamplerData sampler_data{ *material.albedo, global_.mipmap_cnt_to_global_samplers[material.albedo->GetMipMapLevelsCount()] };
-				data.albedo = sampler_data;
-			}
-			else
+			if (lods.empty() || bounds_max.x == std::numeric_limits<float>::max())
+				return 0;
+
+			float scale = std::max(glm::length(glm::vec3(model_matrix[0])), std::max(glm::length(glm::vec3(model_matrix[1])), glm::length(glm::vec3(model_matrix[2]))));
+			float radius = glm::length(bounds_max - bounds_min) * 0.5f * scale;
+			glm::vec3 center = glm::vec3(model_matrix * glm::vec4((bounds_min + bounds_max) * 0.5f, 1.0f));
+
+			float distance = glm::length(center - view_position) - radius;
+
+			if (distance <= 0.0f)
+				return 0;
+
+			// object space error to the fraction of the view height it covers at the nearest point of the bounds
+			float error_scale = scale * proj_scale / (2.0f * distance);
+
+			uint32_t lod = 0;
+
+			for (uint32_t level = 1; level <= lods.size(); level++)
 			{
-				SamplerData sampler_data{ *global_.error_image, global_.mipmap_cnt_to_global_samplers[global_.error_image->GetMipMapLevelsCount()] };
-				data.albedo = sampler_data;
+				float max_error = level <= current_lod ? kLodMaxScreenError * kLodHysteresis : kLodMaxScreenError;
+
+				if (lods[level - 1].error * error_scale > max_error)
+					break;
+
+				lod = level;
 			}
 
-			return true;
+			return lod;
 		}
 
-		bool Geometry::FillData(render::DescriptorSet<render::DescriptorSetType::kMaterial>::Binding<2>::Data& data)
+		uint32_t Base::GetTrianglesCount(uint32_t lod) const
 		{
-			if (material.metallic_roughness)
-			{
-				SamplerData sampler_data{ *material.metallic_roughness, global_.mipmap_cnt_to_global_samplers[material.metallic_roughness->GetMipMapLevelsCount()] };
-				data.metallic_roughness = sampler_data;
-			}
-			else
-			{
-				SamplerData sampler_data{ *global_.error_image, global_.mipmap_cnt_to_global_samplers[global_.error_image->GetMipMapLevelsCount()] };
-				data.metallic_roughness = sampler_data;
-			}
+			if (auto&& lod_indices = GetIndices(lod))
+				return u32(lod_indices->count / 3);
 
-			return true;
+			if (vertex_buffers[u32(VertexBufferType::kPOSITION)])
+				return u32(vertex_buffers[u32(VertexBufferType::kPOSITION)]->count / 3);
+
+			return 0;
 		}
 
-		bool Geometry::FillData(render::DescriptorSet<render::DescriptorSetType::kMaterial>::Binding<3>::Data& data)
+		Geometry::Geometry(const Global& global, DescriptorSetsManager& manager, PrimitiveFlags flags) : GeometryDescriptorSetHolder(global, manager), Base(flags)
 		{
-			if (material.normal_map)
-			{
-				SamplerData sampler_data{ *material.normal_map, global_.mipmap_cnt_to_global_samplers[material.normal_map->GetMipMapLevelsCount()] };
-				data.normal_map = sampler_data;
-			}
-			else
-			{
-				SamplerData sampler_data{ *global_.default_normal, global_.mipmap_cnt_to_global_samplers[global_.error_image->GetMipMapLevelsCount()] };
-				data.normal_map = sampler_data;
-			}
-
-			return true;
 		}
 
 		bool Geometry::FillData(render::DescriptorSet<render::DescriptorSetType::kColor>::Binding<0>::Data& data)
@@ -139,17 +198,26 @@ namespace render
 	//}
 
 
-	bool RenderModel::FillData(render::DescriptorSet<render::DescriptorSetType::kModelMatrix>::Binding<0>::Data& data)
+	Mesh::Mesh(const std::string name, Primitive&& primitive): name(name)
+	{
+		primitives.push_back(std::move(primitive));
+	}
+
+	template<typename ValueType>
+	static size_t GetChannelsMemorySize(const std::vector<AnimationChannel<ValueType>>& channels)
 	{
-		if (node)
-			data.model_mat = node->GetGlobalTransformMatrix();
-		else data.model_mat = glm::identity<glm::mat4>();
+		size_t size = 0;
+
+		for (auto&& channel : channels)
+		{
+			size += channel.times.size() * sizeof(float) + channel.values.size() * sizeof(ValueType);
+		}
 
-		return true;
+		return size;
 	}
 
-	Mesh::Mesh(const std::string name, Primitive&& primitive): name(name)
+	size_t AnimationClip::GetMemorySize() const
 	{
-		primitives.push_back(std::move(primitive));
+		return GetChannelsMemorySize(translations) + GetChannelsMemorySize(scales) + GetChannelsMemorySize(rotations) + GetChannelsMemorySize(quantized_rotations);
 	}
 }
@@ -4,6 +4,8 @@
 #include <vector>
 #include <array>
 #include <chrono>
+#include <limits>
+#include <memory>
 
 #include "vulkan/vulkan.h"
 #include "glm/glm/glm.hpp"
@@ -41,9 +43,17 @@ namespace render
 
 
 	
+	// coarser index lists a primitive may have on top of the full detail one
+	const uint32_t kMaxLodsCount = 7;
+
+	// fraction of the view height the error of a picked LOD may project to, about 2 pixels at 1080p
+	const float kLodMaxScreenError = 0.002f;
+	// the level picked for a view last frame is kept until its projected error grows this much over the limit
+	const float kLodHysteresis = 1.25f;
+
 	namespace primitive
 	{
-		using GeometryDescriptorSetHolder = descriptor_sets_holder::Holder<DescriptorSetType::kMaterial, DescriptorSetType::kColor>;
+		using GeometryDescriptorSetHolder = descriptor_sets_holder::Holder<DescriptorSetType::kColor>;
 
 		struct Base
 		{
@@ -52,7 +62,29 @@ namespace render
 			std::optional<BufferAccessor> indices;
 			std::array<std::optional<BufferAccessor>, kVertexBufferTypesCount> vertex_buffers;
 
+			// object space bounds, unbounded if source has no POSITION min/max
+			glm::vec3 bounds_min = glm::vec3(-std::numeric_limits<float>::max());
+			glm::vec3 bounds_max = glm::vec3(std::numeric_limits<float>::max());
+
+			// simplified over the same vertex buffers, each coarser than the previous, error in object space units
+			struct Lod
+			{
+				BufferAccessor indices;
+				float error;
+			};
+
+			std::vector<Lod> lods;
+
 			Base(PrimitiveFlags flags) :flags(flags) {}
+
+			// index list of a level, 0 is full detail, empty for primitives without indices
+			util::NullableRef<const BufferAccessor> GetIndices(uint32_t lod) const;
+
+			// Coarsest level whose error projects below kLodMaxScreenError of the view height from view_position,
+			// levels up to current_lod get kLodHysteresis more. proj_scale is the cotangent of half the vertical field of view.
+			uint32_t SelectLod(const glm::mat4& model_matrix, const glm::vec3& view_position, float proj_scale, uint32_t current_lod) const;
+
+			uint32_t GetTrianglesCount(uint32_t lod) const;
 		};
 
 		struct Geometry : Base, public GeometryDescriptorSetHolder
@@ -61,10 +93,8 @@ namespace render
 
 			Material material;
 
-			bool FillData(render::DescriptorSet<render::DescriptorSetType::kMaterial>::Binding<0>::Data& data) override;
-			bool FillData(render::DescriptorSet<render::DescriptorSetType::kMaterial>::Binding<1>::Data& data) override;
-			bool FillData(render::DescriptorSet<render::DescriptorSetType::kMaterial>::Binding<2>::Data& data) override;
-			bool FillData(render::DescriptorSet<render::DescriptorSetType::kMaterial>::Binding<3>::Data& data) override;
+			// index in MaterialTable, pushed per draw
+			uint32_t material_index = 0;
 
 			bool FillData(render::DescriptorSet<render::DescriptorSetType::kColor>::Binding<0>::Data& data) override;
 		};
@@ -88,17 +118,38 @@ namespace render
 
 	using Primitive = std::variant<primitive::Geometry, primitive::Bitmap>;
 
+	// versions of data sources read by descriptor holders, unique and growing across the engine
+	uint64_t NextDataVersion();
+
 	struct Node: byes::RM<Node>
 	{
 		//glm::vec3 translation;
 		//glm::quat rotation;
 		//glm::vec3 scale;
-		
-		glm::mat4 local_transform = glm::identity<glm::mat4>();
 
+		// read only, changed through SetParent to keep versions valid
 		byes::RTM<Node> parent;
 
+		void SetParent(Node& parent_node);
+
+		const glm::mat4& GetLocalTransform() const;
+		void SetLocalTransform(const glm::mat4& transform);
+
 		glm::mat4 GetGlobalTransformMatrix() const;
+
+		// grows when the node or one of its parents changes
+		uint64_t GetVersion() const;
+
+		// the node and its parents, including ones set later, store their version bumps in sink
+		void SetVersionSink(const std::shared_ptr<uint64_t>& sink);
+
+	private:
+
+		void BumpVersion();
+
+		glm::mat4 local_transform_ = glm::identity<glm::mat4>();
+		uint64_t version_ = NextDataVersion();
+		std::shared_ptr<uint64_t> version_sink_;
 	};
 
 	using NodeId = util::container::ErVec<Node>::Id;
@@ -110,11 +161,11 @@ namespace render
 	};
 
 
+	// joints are indices of pack nodes, models bind them to the nodes they are posed by
 	struct Skin
 	{
-		std::vector<Node> nodes;
+		std::vector<uint32_t> joints;
 		std::vector<glm::mat4> inverse_bind_matrices;
-		std::vector<short> parent_indices;
 	};
 
 	struct Mesh: byes::RM<Mesh>
@@ -128,9 +179,13 @@ namespace render
 		std::string name;
 		//std::vector<Bone> joints;
 		std::vector<Primitive> primitives;
-	};
 
-	using ModelDescriptorSetHolder = descriptor_sets_holder::Holder<DescriptorSetType::kModelMatrix, DescriptorSetType::kSkeleton>;
+		// unique for the process lifetime, unlike the address of a freed mesh
+		uint64_t id = NextDataVersion();
+
+		// maps quantized positions into object space, applied with the model matrix, identity for float streams
+		glm::mat4 dequantization = glm::identity<glm::mat4>();
+	};
 
 	struct ModelInfo
 	{
@@ -153,63 +208,73 @@ namespace render
 		util::NullableRef<Skin> skin;
 	};
 
-	using RenderModelDescriptorSetHolder = descriptor_sets_holder::Holder<DescriptorSetType::kModelMatrix>;
-
-	struct RenderModel : byes::RM<RenderModel>, RenderModelDescriptorSetHolder
+	struct RenderModel : byes::RM<RenderModel>
 	{
-		RenderModel(const Global& global, DescriptorSetsManager& manager, Node& node_in, Mesh& mesh_in);
+		RenderModel(Node& node_in, Mesh& mesh_in);
 		RenderModel(const RenderModel&) = delete;
 		RenderModel(RenderModel&&) = default;
 		RenderModel& operator=(const RenderModel&) = delete;
 		RenderModel& operator=(RenderModel&&) = default;
 		byes::RTM<Node> node;
 		byes::RTM<Mesh> mesh;
-		util::NullableRef<Skin> skin;
 
-		bool FillData(render::DescriptorSet<render::DescriptorSetType::kModelMatrix>::Binding<0>::Data& data) override;
-	};
-
-	using RenderModelId = util::container::ErVec<RenderModel>::Id;
+		// Skinned models: a node per skin joint and the node the mesh is placed on in their hierarchy,
+		// joint matrices are relative to it, so the model matrix places the skinned mesh like a static one.
+		util::NullableRef<const Skin> skin;
+		std::vector<byes::RTM<Node>> joints;
+		byes::RTM<Node> skin_node;
 
-	struct ModelInstance: public ModelDescriptorSetHolder
-	{
-		ModelInstance(const Global& global, DescriptorSetsManager& manager, Node& node_in, Mesh& mesh_in);
+		// per mesh primitive, streams written by the skinning pass, drawn instead of the mesh streams of the same types
+		std::vector<std::array<std::optional<BufferAccessor>, kVertexBufferTypesCount>> skinned_vertex_buffers;
+		// grows when the skinned streams change, 0 for static models
+		uint64_t skinned_version = 0;
 
-	
-		util::NullableRef<Mesh> mesh;
-		util::NullableRef<Skin> skin;
+		// index of the model matrix in the scene kModelMatrix buffer, reassigned when the scene collects the matrices
+		uint32_t object_index = 0;
 
-		bool FillData(render::DescriptorSet<render::DescriptorSetType::kSkeleton>::Binding<0>::Data& data) override;
-		bool FillData(render::DescriptorSet<render::DescriptorSetType::kModelMatrix>::Binding<0>::Data& data) override;
+		// levels picked for the camera per mesh primitive, kept between frames for hysteresis
+		std::vector<uint32_t> primitive_lods;
 	};
 
-	template<typename ValueType>
-	struct FrameValue
-	{
-		std::chrono::milliseconds time;
-		ValueType value;
-	};
+	using RenderModelId = util::container::ErVec<RenderModel>::Id;
 
 	enum class InterpolationType
 	{
+		kStep,
 		kLinear,
 		kCubicSpline
 	};
 
+	// xyzw snorm16, a quarter of the float quaternion size
+	struct QuantizedRotation
+	{
+		std::array<int16_t, 4> xyzw;
+	};
+
+	// Keyframes of one node property, times in seconds from the clip start.
+	// values has one entry per time, three for cubic spline channels: in tangent, value and out tangent.
 	template<typename ValueType>
-	struct AnimSampler // TODO move to namespace
+	struct AnimationChannel
 	{
 		uint32_t node_index;
-
 		InterpolationType interpolation_type;
-		std::vector<FrameValue<ValueType>> frames;
+		std::vector<float> times;
+		std::vector<ValueType> values;
 	};
 
-	struct Animation
+	// Channels grouped by the property they animate, so times and values of a channel are contiguous arrays.
+	// Rotations of channels other than cubic spline ones are in quantized_rotations instead of rotations when the pack is loaded with quantize_rotations.
+	struct AnimationClip
 	{
-		std::vector<AnimSampler<glm::vec3>> translations;
-		std::vector<AnimSampler<glm::vec3>> scales;
-		std::vector<AnimSampler<glm::quat>> rotations;
+		float duration = 0.0f;
+
+		std::vector<AnimationChannel<glm::vec3>> translations;
+		std::vector<AnimationChannel<glm::vec3>> scales;
+		std::vector<AnimationChannel<glm::quat>> rotations;
+		std::vector<AnimationChannel<QuantizedRotation>> quantized_rotations;
+
+		// keyframe times and values
+		size_t GetMemorySize() const;
 	};
 }
 
@@ -0,0 +1,720 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace render
+{
+	namespace
+	{
+		void ValidateIndices(std::span<const uint32_t> indices, size_t vertices_count)
+		{
+			if (std::any_of(indices.begin(), indices.end(), [vertices_count](uint32_t index) { return index >= vertices_count; }))
+				throw std::runtime_error("failed to optimize mesh, index is out of range");
+		}
+
+		// triangles using each vertex, in compressed rows
+		struct Adjacency
+		{
+			std::vector<uint32_t> offsets;
+			std::vector<uint32_t> triangles;
+		};
+
+		Adjacency BuildAdjacency(std::span<const uint32_t> indices, uint32_t vertices_count)
+		{
+			Adjacency adjacency;
+			adjacency.offsets.assign(vertices_count + 1, 0);
+
+			for (uint32_t index : indices)
+			{
+				adjacency.offsets[index + 1]++;
+			}
+
+			std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+			std::vector<uint32_t> fill_offsets(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+			adjacency.triangles.resize(indices.size());
+
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				adjacency.triangles[fill_offsets[indices[i]]++] = u32(i / 3);
+			}
+
+			return adjacency;
+		}
+
+		// symmetric 4x4 error matrix of plane distances, weighted by triangle areas
+		struct Quadric
+		{
+			double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+			double b0 = 0, b1 = 0, b2 = 0;
+			double c = 0;
+			double weight = 0;
+
+			static Quadric FromPlane(const glm::vec3& normal, float distance, float weight)
+			{
+				Quadric quadric;
+				quadric.a00 = double(normal.x) * normal.x * weight;
+				quadric.a01 = double(normal.x) * normal.y * weight;
+				quadric.a02 = double(normal.x) * normal.z * weight;
+				quadric.a11 = double(normal.y) * normal.y * weight;
+				quadric.a12 = double(normal.y) * normal.z * weight;
+				quadric.a22 = double(normal.z) * normal.z * weight;
+				quadric.b0 = double(normal.x) * distance * weight;
+				quadric.b1 = double(normal.y) * distance * weight;
+				quadric.b2 = double(normal.z) * distance * weight;
+				quadric.c = double(distance) * distance * weight;
+				quadric.weight = weight;
+				return quadric;
+			}
+
+			Quadric& operator+=(const Quadric& other)
+			{
+				a00 += other.a00; a01 += other.a01; a02 += other.a02;
+				a11 += other.a11; a12 += other.a12; a22 += other.a22;
+				b0 += other.b0; b1 += other.b1; b2 += other.b2;
+				c += other.c;
+				weight += other.weight;
+				return *this;
+			}
+
+			// area weighted mean of squared plane distances
+			double GetError(const glm::vec3& point) const
+			{
+				double x = point.x;
+				double y = point.y;
+				double z = point.z;
+
+				double error = a00 * x * x + a11 * y * y + a22 * z * z + 2 * (a01 * x * y + a02 * x * z + a12 * y * z)
+					+ 2 * (b0 * x + b1 * y + b2 * z) + c;
+
+				return weight > 0 ? std::max(error, 0.0) / weight : 0.0;
+			}
+		};
+
+		// bit exact positions, vertices sharing one differ only in attributes
+		std::vector<uint32_t> BuildPositionRemap(std::span<const glm::vec3> positions)
+		{
+			struct PositionHash
+			{
+				size_t operator()(const std::array<uint32_t, 3>& bits) const
+				{
+					return (size_t(bits[0]) * 73856093) ^ (size_t(bits[1]) * 19349663) ^ (size_t(bits[2]) * 83492791);
+				}
+			};
+
+			std::unordered_map<std::array<uint32_t, 3>, uint32_t, PositionHash> first_vertices;
+			first_vertices.reserve(positions.size());
+
+			std::vector<uint32_t> remap(positions.size());
+
+			for (uint32_t vertex = 0; vertex < positions.size(); vertex++)
+			{
+				std::array<uint32_t, 3> bits;
+				std::memcpy(bits.data(), &positions[vertex], sizeof(bits));
+
+				remap[vertex] = first_vertices.emplace(bits, vertex).first->second;
+			}
+
+			return remap;
+		}
+
+		// a vertex is cached while fewer than kVertexCacheSize vertices were added after it
+		class VertexCacheSimulator
+		{
+		public:
+
+			VertexCacheSimulator(size_t vertices_count) : timestamps_(vertices_count, 0), time_(kVertexCacheSize + 1)
+			{
+			}
+
+			uint32_t AddTriangle(const uint32_t* triangle)
+			{
+				uint32_t misses = 0;
+
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					uint32_t& timestamp = timestamps_[triangle[corner]];
+
+					if (time_ - timestamp > kVertexCacheSize)
+					{
+						timestamp = time_++;
+						misses++;
+					}
+				}
+
+				return misses;
+			}
+
+			void Clear()
+			{
+				time_ += kVertexCacheSize + 1;
+			}
+
+		private:
+
+			std::vector<uint32_t> timestamps_;
+			uint32_t time_;
+		};
+	}
+
+	float VertexCacheStats::GetACMR() const
+	{
+		return triangles_count > 0 ? float(cache_misses) / triangles_count : 0.0f;
+	}
+
+	float VertexCacheStats::GetATVR() const
+	{
+		return vertices_count > 0 ? float(cache_misses) / vertices_count : 0.0f;
+	}
+
+	VertexCacheStats& VertexCacheStats::operator+=(const VertexCacheStats& other)
+	{
+		triangles_count += other.triangles_count;
+		vertices_count += other.vertices_count;
+		cache_misses += other.cache_misses;
+
+		return *this;
+	}
+
+	VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertices_count)
+	{
+		ValidateIndices(indices, vertices_count);
+
+		VertexCacheStats stats;
+		stats.triangles_count = indices.size() / 3;
+
+		VertexCacheSimulator cache(vertices_count);
+
+		for (size_t triangle = 0; triangle < stats.triangles_count; triangle++)
+		{
+			stats.cache_misses += cache.AddTriangle(indices.data() + triangle * 3);
+		}
+
+		std::vector<bool> referenced(vertices_count, false);
+
+		for (uint32_t index : indices)
+		{
+			if (!referenced[index])
+			{
+				referenced[index] = true;
+				stats.vertices_count++;
+			}
+		}
+
+		return stats;
+	}
+
+	void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertices_count)
+	{
+		ValidateIndices(indices, vertices_count);
+
+		size_t triangles_count = indices.size() / 3;
+		Adjacency adjacency = BuildAdjacency(indices.first(triangles_count * 3), vertices_count);
+
+		std::vector<uint32_t> live_triangles(vertices_count);
+
+		for (uint32_t vertex = 0; vertex < vertices_count; vertex++)
+		{
+			live_triangles[vertex] = adjacency.offsets[vertex + 1] - adjacency.offsets[vertex];
+		}
+
+		std::vector<uint32_t> timestamps(vertices_count, 0);
+		std::vector<bool> emitted(triangles_count, false);
+		std::vector<uint32_t> dead_end;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		result.reserve(triangles_count * 3);
+
+		uint32_t time = kVertexCacheSize + 1;
+		uint32_t input_cursor = 0;
+
+		// most recently used vertex with triangles left, otherwise the next one in input order
+		auto&& skip_dead_end = [&]() -> int64_t
+			{
+				while (!dead_end.empty())
+				{
+					uint32_t vertex = dead_end.back();
+					dead_end.pop_back();
+
+					if (live_triangles[vertex] > 0)
+						return vertex;
+				}
+
+				for (; input_cursor < vertices_count; input_cursor++)
+				{
+					if (live_triangles[input_cursor] > 0)
+						return input_cursor;
+				}
+
+				return -1;
+			};
+
+		int64_t fanning_vertex = skip_dead_end();
+
+		while (fanning_vertex >= 0)
+		{
+			candidates.clear();
+
+			for (uint32_t i = adjacency.offsets[fanning_vertex]; i < adjacency.offsets[fanning_vertex + 1]; i++)
+			{
+				uint32_t triangle = adjacency.triangles[i];
+
+				if (emitted[triangle])
+					continue;
+
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					uint32_t vertex = indices[triangle * 3 + corner];
+
+					result.push_back(vertex);
+					dead_end.push_back(vertex);
+					candidates.push_back(vertex);
+					live_triangles[vertex]--;
+
+					if (time - timestamps[vertex] > kVertexCacheSize)
+					{
+						timestamps[vertex] = time++;
+					}
+				}
+
+				emitted[triangle] = true;
+			}
+
+			// the oldest candidate that stays cached while its remaining triangles are emitted
+			int64_t next_vertex = -1;
+			int64_t best_priority = -1;
+
+			for (uint32_t vertex : candidates)
+			{
+				if (live_triangles[vertex] == 0)
+					continue;
+
+				int64_t priority = 0;
+
+				if (time - timestamps[vertex] + 2 * live_triangles[vertex] <= kVertexCacheSize)
+				{
+					priority = time - timestamps[vertex];
+				}
+
+				if (priority > best_priority)
+				{
+					best_priority = priority;
+					next_vertex = vertex;
+				}
+			}
+
+			fanning_vertex = next_vertex >= 0 ? next_vertex : skip_dead_end();
+		}
+
+		std::copy(result.begin(), result.end(), indices.begin());
+	}
+
+	void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const glm::vec3> positions, float threshold)
+	{
+		ValidateIndices(indices, positions.size());
+
+		size_t triangles_count = indices.size() / 3;
+
+		if (triangles_count == 0)
+			return;
+
+		VertexCacheSimulator cache(positions.size());
+
+		std::vector<uint32_t> triangle_misses(triangles_count);
+		std::vector<size_t> hard_boundaries;
+
+		for (size_t triangle = 0; triangle < triangles_count; triangle++)
+		{
+			triangle_misses[triangle] = cache.AddTriangle(indices.data() + triangle * 3);
+
+			if (triangle == 0 || triangle_misses[triangle] == 3)
+			{
+				hard_boundaries.push_back(triangle);
+			}
+		}
+
+		hard_boundaries.push_back(triangles_count);
+
+		// first triangle of each cluster
+		std::vector<size_t> clusters;
+
+		for (size_t hard_cluster = 0; hard_cluster + 1 < hard_boundaries.size(); hard_cluster++)
+		{
+			size_t begin = hard_boundaries[hard_cluster];
+			size_t end = hard_boundaries[hard_cluster + 1];
+
+			uint64_t cluster_misses = std::accumulate(triangle_misses.begin() + begin, triangle_misses.begin() + end, uint64_t(0));
+			float max_acmr = float(cluster_misses) / (end - begin) * threshold;
+
+			clusters.push_back(begin);
+			cache.Clear();
+
+			uint64_t soft_misses = 0;
+			size_t soft_begin = begin;
+
+			for (size_t triangle = begin; triangle + 1 < end; triangle++)
+			{
+				soft_misses += cache.AddTriangle(indices.data() + triangle * 3);
+
+				if (soft_misses <= max_acmr * (triangle + 1 - soft_begin))
+				{
+					soft_begin = triangle + 1;
+					soft_misses = 0;
+					clusters.push_back(soft_begin);
+					cache.Clear();
+				}
+			}
+		}
+
+		clusters.push_back(triangles_count);
+
+		size_t clusters_count = clusters.size() - 1;
+
+		std::vector<glm::vec3> cluster_centroids(clusters_count, glm::vec3(0));
+		std::vector<glm::vec3> cluster_normals(clusters_count, glm::vec3(0));
+		std::vector<float> cluster_areas(clusters_count, 0.0f);
+
+		glm::vec3 mesh_centroid(0);
+		float mesh_area = 0.0f;
+
+		for (size_t cluster = 0; cluster < clusters_count; cluster++)
+		{
+			for (size_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; triangle++)
+			{
+				const glm::vec3& p0 = positions[indices[triangle * 3]];
+				const glm::vec3& p1 = positions[indices[triangle * 3 + 1]];
+				const glm::vec3& p2 = positions[indices[triangle * 3 + 2]];
+
+				// twice the area, weights centroids and normals alike
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				float area = glm::length(normal);
+
+				cluster_centroids[cluster] += (p0 + p1 + p2) * (area / 3.0f);
+				cluster_normals[cluster] += normal;
+				cluster_areas[cluster] += area;
+			}
+
+			mesh_centroid += cluster_centroids[cluster];
+			mesh_area += cluster_areas[cluster];
+		}
+
+		if (mesh_area > 0.0f)
+		{
+			mesh_centroid /= mesh_area;
+		}
+
+		std::vector<float> cluster_sort_keys(clusters_count, 0.0f);
+
+		for (size_t cluster = 0; cluster < clusters_count; cluster++)
+		{
+			float normal_length = glm::length(cluster_normals[cluster]);
+
+			if (cluster_areas[cluster] > 0.0f && normal_length > 0.0f)
+			{
+				cluster_sort_keys[cluster] = glm::dot(cluster_centroids[cluster] / cluster_areas[cluster] - mesh_centroid, cluster_normals[cluster] / normal_length);
+			}
+		}
+
+		std::vector<size_t> cluster_order(clusters_count);
+		std::iota(cluster_order.begin(), cluster_order.end(), size_t(0));
+		std::stable_sort(cluster_order.begin(), cluster_order.end(), [&cluster_sort_keys](size_t lhs, size_t rhs) { return cluster_sort_keys[lhs] > cluster_sort_keys[rhs]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(triangles_count * 3);
+
+		for (size_t cluster : cluster_order)
+		{
+			result.insert(result.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + clusters[cluster + 1] * 3);
+		}
+
+		std::copy(result.begin(), result.end(), indices.begin());
+	}
+
+	SimplifiedMesh SimplifyMesh(std::span<const uint32_t> indices, std::span<const glm::vec3> positions, std::span<const glm::vec3> normals, std::span<const glm::vec2> uvs, size_t target_indices_count, float target_error)
+	{
+		ValidateIndices(indices, positions.size());
+
+		uint32_t vertices_count = u32(positions.size());
+
+		SimplifiedMesh result;
+		result.indices.assign(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+
+		if (result.indices.empty())
+			return result;
+
+		std::vector<uint32_t> position_remap = BuildPositionRemap(positions);
+
+		glm::vec3 bounds_min = positions[result.indices[0]];
+		glm::vec3 bounds_max = bounds_min;
+
+		for (uint32_t index : result.indices)
+		{
+			bounds_min = glm::min(bounds_min, positions[index]);
+			bounds_max = glm::max(bounds_max, positions[index]);
+		}
+
+		glm::vec3 size = bounds_max - bounds_min;
+		float extent = std::max(size.x, std::max(size.y, size.z));
+		float max_error = target_error * extent;
+
+		// seams: positions shared by several vertices, borders: edges of a single triangle or more than two
+		std::vector<bool> locked(vertices_count, false);
+		std::vector<uint32_t> position_users(vertices_count, 0);
+
+		for (uint32_t vertex = 0; vertex < vertices_count; vertex++)
+		{
+			position_users[position_remap[vertex]]++;
+		}
+
+		std::unordered_map<uint64_t, uint32_t> edge_triangles;
+		std::vector<Quadric> quadrics(vertices_count);
+
+		for (size_t triangle = 0; triangle < result.indices.size(); triangle += 3)
+		{
+			uint32_t corners[3] = { position_remap[result.indices[triangle]], position_remap[result.indices[triangle + 1]], position_remap[result.indices[triangle + 2]] };
+
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t a = std::min(corners[corner], corners[(corner + 1) % 3]);
+				uint32_t b = std::max(corners[corner], corners[(corner + 1) % 3]);
+
+				edge_triangles[(uint64_t(a) << 32) | b]++;
+			}
+
+			const glm::vec3& p0 = positions[corners[0]];
+			glm::vec3 normal = glm::cross(positions[corners[1]] - p0, positions[corners[2]] - p0);
+			float area = glm::length(normal);
+
+			if (area > 0.0f)
+			{
+				normal /= area;
+
+				Quadric quadric = Quadric::FromPlane(normal, -glm::dot(normal, p0), area);
+
+				for (uint32_t corner : corners)
+				{
+					quadrics[corner] += quadric;
+				}
+			}
+		}
+
+		for (auto&& [edge, triangles_count] : edge_triangles)
+		{
+			if (triangles_count != 2)
+			{
+				locked[uint32_t(edge >> 32)] = true;
+				locked[uint32_t(edge)] = true;
+			}
+		}
+
+		for (uint32_t vertex = 0; vertex < vertices_count; vertex++)
+		{
+			if (position_users[position_remap[vertex]] > 1 || locked[position_remap[vertex]])
+			{
+				locked[vertex] = true;
+			}
+		}
+
+		auto&& collapse_error = [&](uint32_t from, uint32_t to)
+			{
+				Quadric quadric = quadrics[position_remap[from]];
+				quadric += quadrics[position_remap[to]];
+
+				float attribute_difference = 0.0f;
+
+				if (!normals.empty())
+				{
+					glm::vec3 difference = normals[from] - normals[to];
+					attribute_difference += glm::dot(difference, difference);
+				}
+
+				if (!uvs.empty())
+				{
+					glm::vec2 difference = uvs[from] - uvs[to];
+					attribute_difference += glm::dot(difference, difference);
+				}
+
+				return float(std::sqrt(quadric.GetError(positions[to]))) + kSimplifyAttributeWeight * extent * std::sqrt(attribute_difference);
+			};
+
+		// collapses of vertices not touched by another one in the same pass, cheapest first
+		struct Collapse
+		{
+			uint32_t from;
+			uint32_t to;
+			float error;
+		};
+
+		std::vector<Collapse> collapses;
+		std::vector<bool> touched(vertices_count);
+		std::vector<uint32_t> collapse_remap(vertices_count);
+
+		while (result.indices.size() > target_indices_count)
+		{
+			Adjacency adjacency = BuildAdjacency(result.indices, vertices_count);
+
+			collapses.clear();
+
+			for (size_t triangle = 0; triangle < result.indices.size(); triangle += 3)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					uint32_t a = result.indices[triangle + corner];
+					uint32_t b = result.indices[triangle + (corner + 1) % 3];
+
+					if (!locked[a])
+					{
+						collapses.push_back({ a, b, collapse_error(a, b) });
+					}
+
+					if (!locked[b])
+					{
+						collapses.push_back({ b, a, collapse_error(b, a) });
+					}
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) { return lhs.error < rhs.error; });
+
+			std::fill(touched.begin(), touched.end(), false);
+			std::iota(collapse_remap.begin(), collapse_remap.end(), 0);
+
+			size_t triangles_to_remove = (result.indices.size() - target_indices_count + 2) / 3;
+			size_t triangles_removed = 0;
+
+			for (auto&& collapse : collapses)
+			{
+				if (collapse.error > max_error || triangles_removed >= triangles_to_remove)
+					break;
+
+				if (touched[collapse.from] || touched[collapse.to])
+					continue;
+
+				// rejected if a remaining triangle around from would flip or degenerate
+				bool valid = true;
+				size_t collapsed_triangles = 0;
+
+				for (uint32_t i = adjacency.offsets[collapse.from]; i < adjacency.offsets[collapse.from + 1] && valid; i++)
+				{
+					const uint32_t* triangle = result.indices.data() + adjacency.triangles[i] * 3;
+
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+					{
+						collapsed_triangles++;
+						continue;
+					}
+
+					glm::vec3 corners[3] = { positions[triangle[0]], positions[triangle[1]], positions[triangle[2]] };
+					glm::vec3 normal_before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+
+					for (auto&& [corner, vertex] : { std::pair(0, triangle[0]), std::pair(1, triangle[1]), std::pair(2, triangle[2]) })
+					{
+						if (vertex == collapse.from)
+						{
+							corners[corner] = positions[collapse.to];
+						}
+					}
+
+					glm::vec3 normal_after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+
+					valid = glm::dot(normal_before, normal_after) > 0.25f * glm::length(normal_before) * glm::length(normal_after) && glm::dot(normal_after, normal_after) > 0.0f;
+				}
+
+				if (!valid)
+					continue;
+
+				collapse_remap[collapse.from] = collapse.to;
+				touched[collapse.from] = true;
+				touched[collapse.to] = true;
+				quadrics[position_remap[collapse.to]] += quadrics[position_remap[collapse.from]];
+
+				triangles_removed += collapsed_triangles;
+				result.error = std::max(result.error, collapse.error);
+			}
+
+			if (triangles_removed == 0)
+				break;
+
+			size_t write_index = 0;
+
+			for (size_t triangle = 0; triangle < result.indices.size(); triangle += 3)
+			{
+				uint32_t a = collapse_remap[result.indices[triangle]];
+				uint32_t b = collapse_remap[result.indices[triangle + 1]];
+				uint32_t c = collapse_remap[result.indices[triangle + 2]];
+
+				if (position_remap[a] == position_remap[b] || position_remap[b] == position_remap[c] || position_remap[a] == position_remap[c])
+					continue;
+
+				result.indices[write_index++] = a;
+				result.indices[write_index++] = b;
+				result.indices[write_index++] = c;
+			}
+
+			result.indices.resize(write_index);
+		}
+
+		return result;
+	}
+
+	std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, uint32_t vertices_count)
+	{
+		ValidateIndices(indices, vertices_count);
+
+		std::vector<uint32_t> remap(vertices_count, std::numeric_limits<uint32_t>::max());
+		std::vector<uint32_t> vertex_order;
+
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == std::numeric_limits<uint32_t>::max())
+			{
+				remap[index] = u32(vertex_order.size());
+				vertex_order.push_back(index);
+			}
+
+			index = remap[index];
+		}
+
+		return vertex_order;
+	}
+
+	int16_t QuantizeSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	uint16_t QuantizeHalf(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		uint32_t sign = (bits >> 16) & 0x8000;
+		uint32_t magnitude = bits & 0x7FFFFFFF;
+
+		// adding half of the dropped mantissa rounds, exponent is rebiased from 127 to 15
+		uint32_t result = ((magnitude + 0x1000) >> 13) - (112 << 10);
+
+		result = magnitude < (113 << 23) ? 0 : result;
+		result = magnitude >= (143 << 23) ? 0x7C00 : result;
+		result = magnitude > (255 << 23) ? 0x7E00 : result;
+
+		return static_cast<uint16_t>(sign | result);
+	}
+
+	glm::vec2 OctahedralEncode(const glm::vec3& unit_vector)
+	{
+		glm::vec2 projected = glm::vec2(unit_vector) / (std::abs(unit_vector.x) + std::abs(unit_vector.y) + std::abs(unit_vector.z));
+
+		if (unit_vector.z >= 0.0f)
+			return projected;
+
+		return glm::vec2((1.0f - std::abs(projected.y)) * (projected.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(projected.x)) * (projected.y >= 0.0f ? 1.0f : -1.0f));
+	}
+}
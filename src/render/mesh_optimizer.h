@@ -0,0 +1,73 @@
+#ifndef RENDER_ENGINE_RENDER_MESH_OPTIMIZER_H_
+#define RENDER_ENGINE_RENDER_MESH_OPTIMIZER_H_
+
+#include <span>
+#include <vector>
+
+#include "glm/glm/glm.hpp"
+
+#include "common.h"
+
+namespace render
+{
+	// FIFO post transform cache size the reordering targets and the statistics simulate, in vertices
+	const uint32_t kVertexCacheSize = 16;
+
+	// clusters may lose up to 5% of the cache efficiency for a better draw order
+	const float kOverdrawThreshold = 1.05f;
+
+	// normal and texture coordinate differences cost this fraction of the mesh extent per unit
+	const float kSimplifyAttributeWeight = 0.01f;
+
+	// counters add up over primitives, so meshes are reported as a whole
+	struct VertexCacheStats
+	{
+		uint64_t triangles_count = 0;
+		// vertices referenced by indices
+		uint64_t vertices_count = 0;
+		uint64_t cache_misses = 0;
+
+		// average cache miss ratio, transformed vertices per triangle, 0.5 at best
+		float GetACMR() const;
+		// average transformed to vertex ratio, 1.0 at best
+		float GetATVR() const;
+
+		VertexCacheStats& operator+=(const VertexCacheStats& other);
+	};
+
+	VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertices_count);
+
+	// Tipsify (Sander, Nehab, Barczak 2007): fans around recently used vertices, so triangles reuse cached ones
+	void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertices_count);
+
+	// Splits the index order into clusters where the cache restarts anyway, or where a restart keeps cluster ACMR
+	// within threshold times the original one, and draws clusters facing away from the mesh center first.
+	void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const glm::vec3> positions, float threshold);
+
+	struct SimplifiedMesh
+	{
+		std::vector<uint32_t> indices;
+		// largest collapse error, in position units
+		float error = 0.0f;
+	};
+
+	// Quadric error edge collapse (Garland, Heckbert 1997) onto existing vertices, so the result indexes the same vertex buffers.
+	// Vertices on open borders and attribute seams stay in place, normal and texture coordinate changes add to the error.
+	// Stops at target_indices_count or before the error exceeds target_error, a fraction of the mesh extent.
+	// normals and uvs may be empty.
+	SimplifiedMesh SimplifyMesh(std::span<const uint32_t> indices, std::span<const glm::vec3> positions, std::span<const glm::vec3> normals, std::span<const glm::vec2> uvs, size_t target_indices_count, float target_error);
+
+	// Renumbers vertices in the order indices first use them, unreferenced vertices are dropped.
+	// Returns the source vertex of each new one, vertex streams are gathered through it.
+	std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, uint32_t vertices_count);
+
+	// value is clamped to [-1, 1]
+	int16_t QuantizeSnorm16(float value);
+
+	// rounds to nearest, magnitudes below the smallest normal half flush to zero
+	uint16_t QuantizeHalf(float value);
+
+	// matches OctahedralEncode of g_buffer.glsl, unit_vector must not be zero
+	glm::vec2 OctahedralEncode(const glm::vec3& unit_vector);
+}
+#endif  // RENDER_ENGINE_RENDER_MESH_OPTIMIZER_H_
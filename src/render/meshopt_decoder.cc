@@ -0,0 +1,608 @@
+#include "meshopt_decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "stl_util.h"
+
+namespace render
+{
+	namespace
+	{
+		const unsigned char kVertexHeader = 0xA0;
+		const unsigned char kTrianglesHeader = 0xE0;
+		const unsigned char kIndicesHeader = 0xD0;
+
+		// vertex blocks are decoded byte by byte through a transposed scratch buffer of this size
+		const size_t kVertexBlockSizeBytes = 8192;
+		const size_t kVertexBlockMaxSize = 256;
+		const size_t kByteGroupSize = 16;
+		// a byte group reads its header bits and up to one byte per value
+		const size_t kByteGroupDecodeLimit = 24;
+		// the first vertex ends the stream, padded to this size
+		const size_t kVertexTailMinSize = 32;
+
+		// size of the codeaux table ending a triangles stream and of the tail ending an indices one
+		const size_t kTrianglesTailSize = 16;
+		const size_t kIndicesTailSize = 4;
+
+		size_t GetVertexBlockSize(size_t vertex_size)
+		{
+			size_t result = (kVertexBlockSizeBytes / vertex_size) & ~(kByteGroupSize - 1);
+			return std::min(result, kVertexBlockMaxSize);
+		}
+
+		unsigned char Unzigzag8(unsigned char value)
+		{
+			return static_cast<unsigned char>(-(value & 1) ^ (value >> 1));
+		}
+
+		// 16 values of 0, 2, 4 or 8 bits, all ones in 2 and 4 bit values are escapes to a full byte after the packed ones
+		const unsigned char* DecodeBytesGroup(const unsigned char* data, unsigned char* values, int bits_log2)
+		{
+			if (bits_log2 == 0)
+			{
+				std::memset(values, 0, kByteGroupSize);
+				return data;
+			}
+
+			if (bits_log2 == 3)
+			{
+				std::memcpy(values, data, kByteGroupSize);
+				return data + kByteGroupSize;
+			}
+
+			uint32_t bits = bits_log2 == 1 ? 2 : 4;
+			uint32_t escape = (1 << bits) - 1;
+			const unsigned char* escaped = data + kByteGroupSize * bits / 8;
+
+			for (uint32_t i = 0; i < kByteGroupSize; i++)
+			{
+				uint32_t shift = 8 - bits - (i * bits) % 8;
+				unsigned char value = (data[i * bits / 8] >> shift) & escape;
+
+				values[i] = value == escape ? *escaped++ : value;
+			}
+
+			return escaped;
+		}
+
+		const unsigned char* DecodeBytes(const unsigned char* data, const unsigned char* data_end, unsigned char* values, size_t count)
+		{
+			const unsigned char* header = data;
+			size_t header_size = (count / kByteGroupSize + 3) / 4;
+
+			if (size_t(data_end - data) < header_size)
+				throw std::runtime_error("failed to decode meshopt vertices, stream is truncated");
+
+			data += header_size;
+
+			for (size_t i = 0; i < count; i += kByteGroupSize)
+			{
+				if (size_t(data_end - data) < kByteGroupDecodeLimit)
+					throw std::runtime_error("failed to decode meshopt vertices, stream is truncated");
+
+				size_t group = i / kByteGroupSize;
+				int bits_log2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+
+				data = DecodeBytesGroup(data, values + i, bits_log2);
+			}
+
+			return data;
+		}
+
+		// bytes of a vertex are delta coded against the previous vertex, each byte position as a separate stream
+		const unsigned char* DecodeVertexBlock(const unsigned char* data, const unsigned char* data_end, unsigned char* vertices, size_t count, size_t vertex_size, std::array<unsigned char, 256>& last_vertex)
+		{
+			std::array<unsigned char, kVertexBlockMaxSize> deltas;
+			size_t count_aligned = (count + kByteGroupSize - 1) & ~(kByteGroupSize - 1);
+
+			for (size_t byte = 0; byte < vertex_size; byte++)
+			{
+				data = DecodeBytes(data, data_end, deltas.data(), count_aligned);
+
+				unsigned char previous = last_vertex[byte];
+
+				for (size_t i = 0; i < count; i++)
+				{
+					previous = static_cast<unsigned char>(Unzigzag8(deltas[i]) + previous);
+					vertices[i * vertex_size + byte] = previous;
+				}
+			}
+
+			std::memcpy(last_vertex.data(), vertices + (count - 1) * vertex_size, vertex_size);
+
+			return data;
+		}
+
+		uint32_t DecodeVByte(const unsigned char*& data)
+		{
+			unsigned char lead = *data++;
+
+			if (lead < 128)
+				return lead;
+
+			// at most 4 more bytes, so malformed streams still stop
+			uint32_t result = lead & 127;
+			uint32_t shift = 7;
+
+			for (int i = 0; i < 4; i++)
+			{
+				unsigned char group = *data++;
+				result |= uint32_t(group & 127) << shift;
+				shift += 7;
+
+				if (group < 128)
+					break;
+			}
+
+			return result;
+		}
+
+		uint32_t DecodeIndex(const unsigned char*& data, uint32_t last)
+		{
+			uint32_t value = DecodeVByte(data);
+			return last + ((value >> 1) ^ (0 - (value & 1)));
+		}
+
+		void WriteIndex(std::span<unsigned char> destination, size_t index_size, size_t position, uint32_t index)
+		{
+			if (index_size == 2)
+			{
+				uint16_t short_index = static_cast<uint16_t>(index);
+				std::memcpy(destination.data() + position * 2, &short_index, 2);
+			}
+			else
+			{
+				std::memcpy(destination.data() + position * 4, &index, 4);
+			}
+		}
+
+		void ValidateDestination(std::span<unsigned char> destination, size_t count, size_t element_size)
+		{
+			if (destination.size() < count * element_size)
+				throw std::runtime_error("failed to decode meshopt stream, destination is too small");
+		}
+
+		struct TriangleFifos
+		{
+			std::array<std::array<uint32_t, 2>, 16> edges;
+			std::array<uint32_t, 16> vertices;
+			size_t edges_offset = 0;
+			size_t vertices_offset = 0;
+
+			void PushEdge(uint32_t a, uint32_t b)
+			{
+				edges[edges_offset] = { a, b };
+				edges_offset = (edges_offset + 1) & 15;
+			}
+
+			void PushVertex(uint32_t vertex, bool advance = true)
+			{
+				vertices[vertices_offset] = vertex;
+				vertices_offset = (vertices_offset + (advance ? 1 : 0)) & 15;
+			}
+		};
+
+		int16_t RoundToInt16(float value)
+		{
+			return static_cast<int16_t>(value + (value >= 0.0f ? 0.5f : -0.5f));
+		}
+
+		template<typename T>
+		void DecodeOctahedralFilter(unsigned char* data, size_t count, size_t stride)
+		{
+			const float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				std::array<T, 3> encoded;
+				std::memcpy(encoded.data(), data + i * stride, sizeof(encoded));
+
+				// z holds the encoded 1.0, so the unit vector is rebuilt at that precision
+				float x = float(encoded[0]);
+				float y = float(encoded[1]);
+				float z = float(encoded[2]) - std::abs(x) - std::abs(y);
+
+				float t = std::min(z, 0.0f);
+				x += x >= 0.0f ? t : -t;
+				y += y >= 0.0f ? t : -t;
+
+				float scale = max / std::sqrt(x * x + y * y + z * z);
+
+				std::array<T, 3> decoded = { T(RoundToInt16(x * scale)), T(RoundToInt16(y * scale)), T(RoundToInt16(z * scale)) };
+				std::memcpy(data + i * stride, decoded.data(), sizeof(decoded));
+			}
+		}
+
+		// three smallest components of a unit quaternion, the index of the largest one in the low bits of the fourth
+		void DecodeQuaternionFilter(unsigned char* data, size_t count, size_t stride)
+		{
+			const float scale = 1.0f / std::sqrt(2.0f);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				std::array<int16_t, 4> encoded;
+				std::memcpy(encoded.data(), data + i * stride, sizeof(encoded));
+
+				float component_scale = scale / float(encoded[3] | 3);
+
+				float x = float(encoded[0]) * component_scale;
+				float y = float(encoded[1]) * component_scale;
+				float z = float(encoded[2]) * component_scale;
+				float w = std::sqrt(std::max(1.0f - x * x - y * y - z * z, 0.0f));
+
+				int largest = encoded[3] & 3;
+
+				std::array<int16_t, 4> decoded;
+				decoded[(largest + 1) & 3] = RoundToInt16(x * 32767.0f);
+				decoded[(largest + 2) & 3] = RoundToInt16(y * 32767.0f);
+				decoded[(largest + 3) & 3] = RoundToInt16(z * 32767.0f);
+				decoded[largest] = RoundToInt16(w * 32767.0f);
+
+				std::memcpy(data + i * stride, decoded.data(), sizeof(decoded));
+			}
+		}
+
+		// 24 bit signed mantissa and 8 bit signed exponent per float
+		void DecodeExponentialFilter(unsigned char* data, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				uint32_t encoded;
+				std::memcpy(&encoded, data + i * 4, 4);
+
+				int32_t mantissa = int32_t(encoded << 8) >> 8;
+				int32_t exponent = int32_t(encoded) >> 24;
+
+				float value = std::ldexp(float(mantissa), exponent);
+				std::memcpy(data + i * 4, &value, 4);
+			}
+		}
+
+		size_t GetSize(const tinygltf::Value& object, const char* key, size_t default_value)
+		{
+			return object.Has(key) ? size_t(object.Get(key).GetNumberAsDouble()) : default_value;
+		}
+
+		const tinygltf::Value* FindMeshoptExtension(const tinygltf::BufferView& buffer_view)
+		{
+			for (const char* name : { "EXT_meshopt_compression", "KHR_meshopt_compression" })
+			{
+				if (auto&& it = buffer_view.extensions.find(name); it != buffer_view.extensions.end())
+					return &it->second;
+			}
+
+			return nullptr;
+		}
+
+		std::string GetString(const tinygltf::Value& object, const char* key, const std::string& default_value)
+		{
+			return object.Has(key) && object.Get(key).IsString() ? object.Get(key).Get<std::string>() : default_value;
+		}
+	}
+
+	void DecodeMeshoptVertices(std::span<unsigned char> destination, size_t count, size_t vertex_size, std::span<const unsigned char> source)
+	{
+		if (vertex_size == 0 || vertex_size > 256 || vertex_size % 4 != 0)
+			throw std::runtime_error("failed to decode meshopt vertices, vertex size is not supported");
+
+		ValidateDestination(destination, count, vertex_size);
+
+		size_t tail_size = std::max(vertex_size, kVertexTailMinSize);
+
+		if (source.size() < 1 + tail_size)
+			throw std::runtime_error("failed to decode meshopt vertices, stream is truncated");
+
+		if ((source[0] & 0xF0) != kVertexHeader || (source[0] & 0x0F) > 0)
+			throw std::runtime_error("failed to decode meshopt vertices, stream version is not supported");
+
+		const unsigned char* data = source.data() + 1;
+		const unsigned char* data_end = source.data() + source.size();
+
+		std::array<unsigned char, 256> last_vertex;
+		std::memcpy(last_vertex.data(), data_end - vertex_size, vertex_size);
+
+		size_t block_size = GetVertexBlockSize(vertex_size);
+
+		for (size_t offset = 0; offset < count; offset += block_size)
+		{
+			data = DecodeVertexBlock(data, data_end, destination.data() + offset * vertex_size, std::min(block_size, count - offset), vertex_size, last_vertex);
+		}
+
+		if (size_t(data_end - data) != tail_size)
+			throw std::runtime_error("failed to decode meshopt vertices, stream size doesn't match");
+	}
+
+	// Triangles reuse edges and vertices of recent ones through 16 entry FIFOs, a code byte per triangle selects them.
+	// New vertices come in order, others are delta coded varints after the codes.
+	void DecodeMeshoptTriangles(std::span<unsigned char> destination, size_t count, size_t index_size, std::span<const unsigned char> source)
+	{
+		if (count % 3 != 0 || (index_size != 2 && index_size != 4))
+			throw std::runtime_error("failed to decode meshopt triangles, index layout is not supported");
+
+		ValidateDestination(destination, count, index_size);
+
+		if (source.size() < 1 + count / 3 + kTrianglesTailSize)
+			throw std::runtime_error("failed to decode meshopt triangles, stream is truncated");
+
+		int version = source[0] & 0x0F;
+
+		if ((source[0] & 0xF0) != kTrianglesHeader || version > 1)
+			throw std::runtime_error("failed to decode meshopt triangles, stream version is not supported");
+
+		TriangleFifos fifos;
+		fifos.edges.fill({ ~0u, ~0u });
+		fifos.vertices.fill(~0u);
+
+		uint32_t next = 0;
+		uint32_t last = 0;
+		// version 1 codes 13 and 14 as the last free index -1 and +1
+		int fec_max = version >= 1 ? 13 : 15;
+
+		const unsigned char* code = source.data() + 1;
+		const unsigned char* data = code + count / 3;
+		const unsigned char* data_safe_end = source.data() + source.size() - kTrianglesTailSize;
+		const unsigned char* codeaux_table = data_safe_end;
+
+		for (size_t i = 0; i < count; i += 3)
+		{
+			// a triangle reads at most 16 bytes, which the codeaux table covers
+			if (data > data_safe_end)
+				throw std::runtime_error("failed to decode meshopt triangles, stream is truncated");
+
+			unsigned char code_triangle = *code++;
+			uint32_t a;
+			uint32_t b;
+			uint32_t c;
+
+			if (code_triangle < 0xF0)
+			{
+				auto&& edge = fifos.edges[(fifos.edges_offset - 1 - (code_triangle >> 4)) & 15];
+				a = edge[0];
+				b = edge[1];
+
+				int fec = code_triangle & 15;
+
+				if (fec < fec_max)
+				{
+					c = fec == 0 ? next++ : fifos.vertices[(fifos.vertices_offset - 1 - fec) & 15];
+					fifos.PushVertex(c, fec == 0);
+				}
+				else
+				{
+					last = c = fec != 15 ? last + (fec - (fec ^ 3)) : DecodeIndex(data, last);
+					fifos.PushVertex(c);
+				}
+
+				fifos.PushEdge(c, b);
+				fifos.PushEdge(a, c);
+			}
+			else
+			{
+				int fea;
+				int feb;
+				int fec;
+				// only codes read from the data carry free indices, table ones are all from the fifo
+				bool explicit_indices = code_triangle >= 0xFE;
+
+				if (!explicit_indices)
+				{
+					unsigned char codeaux = codeaux_table[code_triangle & 15];
+					fea = 0;
+					feb = codeaux >> 4;
+					fec = codeaux & 15;
+				}
+				else
+				{
+					unsigned char codeaux = *data++;
+					fea = code_triangle == 0xFE ? 0 : 15;
+					feb = codeaux >> 4;
+					fec = codeaux & 15;
+
+					if (codeaux == 0)
+					{
+						next = 0;
+					}
+				}
+
+				// next advances for all three vertices before free indices are decoded, as the encoder does
+				a = fea == 0 ? next++ : 0;
+				b = feb == 0 ? next++ : fifos.vertices[(fifos.vertices_offset - feb) & 15];
+				c = fec == 0 ? next++ : fifos.vertices[(fifos.vertices_offset - fec) & 15];
+
+				if (explicit_indices && fea == 15)
+				{
+					last = a = DecodeIndex(data, last);
+				}
+
+				if (explicit_indices && feb == 15)
+				{
+					last = b = DecodeIndex(data, last);
+				}
+
+				if (explicit_indices && fec == 15)
+				{
+					last = c = DecodeIndex(data, last);
+				}
+
+				fifos.PushVertex(a);
+				fifos.PushVertex(b, feb == 0 || (explicit_indices && feb == 15));
+				fifos.PushVertex(c, fec == 0 || (explicit_indices && fec == 15));
+
+				fifos.PushEdge(b, a);
+				fifos.PushEdge(c, b);
+				fifos.PushEdge(a, c);
+			}
+
+			WriteIndex(destination, index_size, i, a);
+			WriteIndex(destination, index_size, i + 1, b);
+			WriteIndex(destination, index_size, i + 2, c);
+		}
+
+		if (data != data_safe_end)
+			throw std::runtime_error("failed to decode meshopt triangles, stream size doesn't match");
+	}
+
+	// varint deltas against one of two baselines, the low bit selects it
+	void DecodeMeshoptIndices(std::span<unsigned char> destination, size_t count, size_t index_size, std::span<const unsigned char> source)
+	{
+		if (index_size != 2 && index_size != 4)
+			throw std::runtime_error("failed to decode meshopt indices, index size is not supported");
+
+		ValidateDestination(destination, count, index_size);
+
+		if (source.size() < 1 + count + kIndicesTailSize)
+			throw std::runtime_error("failed to decode meshopt indices, stream is truncated");
+
+		if ((source[0] & 0xF0) != kIndicesHeader || (source[0] & 0x0F) > 1)
+			throw std::runtime_error("failed to decode meshopt indices, stream version is not supported");
+
+		const unsigned char* data = source.data() + 1;
+		const unsigned char* data_safe_end = source.data() + source.size() - kIndicesTailSize;
+
+		std::array<uint32_t, 2> last = { 0, 0 };
+
+		for (size_t i = 0; i < count; i++)
+		{
+			// an index reads at most 5 bytes, which the tail covers
+			if (data >= data_safe_end)
+				throw std::runtime_error("failed to decode meshopt indices, stream is truncated");
+
+			uint32_t value = DecodeVByte(data);
+			uint32_t baseline = value & 1;
+			value >>= 1;
+
+			last[baseline] += (value >> 1) ^ (0 - (value & 1));
+
+			WriteIndex(destination, index_size, i, last[baseline]);
+		}
+
+		if (data != data_safe_end)
+			throw std::runtime_error("failed to decode meshopt indices, stream size doesn't match");
+	}
+
+	void ApplyMeshoptFilter(std::span<unsigned char> data, size_t count, size_t stride, MeshoptFilter filter)
+	{
+		if (data.size() < count * stride)
+			throw std::runtime_error("failed to apply meshopt filter, data is too small");
+
+		switch (filter)
+		{
+		case MeshoptFilter::kNone:
+			break;
+		case MeshoptFilter::kOctahedral:
+			if (stride == 4)
+				DecodeOctahedralFilter<int8_t>(data.data(), count, stride);
+			else if (stride == 8)
+				DecodeOctahedralFilter<int16_t>(data.data(), count, stride);
+			else
+				throw std::runtime_error("failed to apply meshopt octahedral filter, stride is not supported");
+			break;
+		case MeshoptFilter::kQuaternion:
+			if (stride != 8)
+				throw std::runtime_error("failed to apply meshopt quaternion filter, stride is not supported");
+			DecodeQuaternionFilter(data.data(), count, stride);
+			break;
+		case MeshoptFilter::kExponential:
+			if (stride % 4 != 0)
+				throw std::runtime_error("failed to apply meshopt exponential filter, stride is not supported");
+			DecodeExponentialFilter(data.data(), count * stride / 4);
+			break;
+		}
+	}
+
+	void DecodeMeshoptCompression(tinygltf::Model& gltf_model)
+	{
+		struct View
+		{
+			const tinygltf::Value& extension;
+			const tinygltf::BufferView& buffer_view;
+		};
+
+		std::vector<View> views;
+
+		for (auto&& buffer_view : gltf_model.bufferViews)
+		{
+			const tinygltf::Value* extension = FindMeshoptExtension(buffer_view);
+
+			if (!extension)
+				continue;
+
+			if (buffer_view.buffer < 0 || size_t(buffer_view.buffer) >= gltf_model.buffers.size())
+				throw std::runtime_error("failed to decode meshopt buffer view, buffer is out of range");
+
+			// fallback buffers have no data, decoded views are their only contents
+			auto&& data = gltf_model.buffers[buffer_view.buffer].data;
+			data.resize(std::max(data.size(), buffer_view.byteOffset + buffer_view.byteLength));
+
+			views.push_back({ *extension, buffer_view });
+		}
+
+		util::ParallelFor(views.size(), [&](size_t view_index)
+			{
+				auto&& extension = views[view_index].extension;
+				auto&& buffer_view = views[view_index].buffer_view;
+
+				size_t source_buffer = GetSize(extension, "buffer", gltf_model.buffers.size());
+				size_t source_offset = GetSize(extension, "byteOffset", 0);
+				size_t source_length = GetSize(extension, "byteLength", 0);
+				size_t stride = GetSize(extension, "byteStride", 0);
+				size_t count = GetSize(extension, "count", 0);
+
+				if (source_buffer >= gltf_model.buffers.size() || source_offset + source_length > gltf_model.buffers[source_buffer].data.size())
+					throw std::runtime_error("failed to decode meshopt buffer view, source is out of range");
+
+				if (count * stride > buffer_view.byteLength)
+					throw std::runtime_error("failed to decode meshopt buffer view, decoded data doesn't fit");
+
+				std::span<const unsigned char> source(gltf_model.buffers[source_buffer].data.data() + source_offset, source_length);
+				std::span<unsigned char> destination(gltf_model.buffers[buffer_view.buffer].data.data() + buffer_view.byteOffset, count * stride);
+
+				std::string mode = GetString(extension, "mode", "");
+				std::string filter = GetString(extension, "filter", "NONE");
+
+				if (mode == "ATTRIBUTES")
+				{
+					DecodeMeshoptVertices(destination, count, stride, source);
+
+					if (filter == "OCTAHEDRAL")
+						ApplyMeshoptFilter(destination, count, stride, MeshoptFilter::kOctahedral);
+					else if (filter == "QUATERNION")
+						ApplyMeshoptFilter(destination, count, stride, MeshoptFilter::kQuaternion);
+					else if (filter == "EXPONENTIAL")
+						ApplyMeshoptFilter(destination, count, stride, MeshoptFilter::kExponential);
+					else if (filter != "NONE")
+						throw std::runtime_error("failed to decode meshopt buffer view, filter is not supported");
+				}
+				else if (mode == "TRIANGLES")
+				{
+					DecodeMeshoptTriangles(destination, count, stride, source);
+				}
+				else if (mode == "INDICES")
+				{
+					DecodeMeshoptIndices(destination, count, stride, source);
+				}
+				else
+				{
+					throw std::runtime_error("failed to decode meshopt buffer view, mode is not supported");
+				}
+			});
+
+		for (auto&& buffer_view : gltf_model.bufferViews)
+		{
+			buffer_view.extensions.erase("EXT_meshopt_compression");
+			buffer_view.extensions.erase("KHR_meshopt_compression");
+		}
+	}
+
+	bool HasMeshoptCompression(const tinygltf::Model& gltf_model)
+	{
+		return std::any_of(gltf_model.bufferViews.begin(), gltf_model.bufferViews.end(), [](const tinygltf::BufferView& buffer_view) { return FindMeshoptExtension(buffer_view) != nullptr; });
+	}
+}
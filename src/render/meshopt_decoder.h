@@ -0,0 +1,43 @@
+#ifndef RENDER_ENGINE_RENDER_MESHOPT_DECODER_H_
+#define RENDER_ENGINE_RENDER_MESHOPT_DECODER_H_
+
+#include <span>
+
+#pragma warning(push, 0)
+#include "tinygltf/tiny_gltf.h"
+#pragma warning(pop)
+
+#include "common.h"
+
+namespace render
+{
+	// Decoders of the EXT_meshopt_compression bitstreams, destination holds count elements of the given size.
+	// Malformed streams throw.
+
+	// ATTRIBUTES mode, vertex_size is a multiple of 4 up to 256
+	void DecodeMeshoptVertices(std::span<unsigned char> destination, size_t count, size_t vertex_size, std::span<const unsigned char> source);
+
+	// TRIANGLES mode, index_size is 2 or 4
+	void DecodeMeshoptTriangles(std::span<unsigned char> destination, size_t count, size_t index_size, std::span<const unsigned char> source);
+
+	// INDICES mode, index_size is 2 or 4
+	void DecodeMeshoptIndices(std::span<unsigned char> destination, size_t count, size_t index_size, std::span<const unsigned char> source);
+
+	enum class MeshoptFilter
+	{
+		kNone,
+		kOctahedral,
+		kQuaternion,
+		kExponential
+	};
+
+	// in place over decoded attributes
+	void ApplyMeshoptFilter(std::span<unsigned char> data, size_t count, size_t stride, MeshoptFilter filter);
+
+	// Decodes compressed buffer views in parallel into the buffers they describe, fallback buffers without data are grown.
+	// Accessors read the decoded views as if the file was never compressed, the extension is removed from them.
+	void DecodeMeshoptCompression(tinygltf::Model& gltf_model);
+
+	bool HasMeshoptCompression(const tinygltf::Model& gltf_model);
+}
+#endif  // RENDER_ENGINE_RENDER_MESHOPT_DECODER_H_
@@ -1,6 +1,7 @@
 #include "render_api.h"
 
 #include <memory>
+#include <stdexcept>
 
 
 #include "platform.h"
@@ -95,6 +96,7 @@ namespace render
 			//VkPhysicalDeviceImagelessFramebufferFeatures imageless_features;
 			VkPhysicalDeviceSynchronization2Features synchronization2_features;
 			VkPhysicalDeviceVulkan13Features vk13_features;
+			VkPhysicalDeviceDescriptorIndexingFeatures descriptor_indexing_features{};
 
 			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
 			features2.pNext = &synchronization2_features;
@@ -106,10 +108,15 @@ namespace render
 			synchronization2_features.pNext = &vk13_features;
 
 			vk13_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
-			vk13_features.pNext = nullptr;
+			vk13_features.pNext = &descriptor_indexing_features;
+
+			// left zeroed by devices without VK_EXT_descriptor_indexing
+			descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+			descriptor_indexing_features.pNext = nullptr;
 
 
 			vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+			vk_physical_devices_descriptor_indexing_features_[physical_device] = descriptor_indexing_features;
 			int a = 1;
 		}
 	}
@@ -241,6 +248,7 @@ namespace render
 		//imageless_features.imagelessFramebuffer = VK_TRUE;
 		//VkPhysicalDeviceSynchronization2Features vk_synchronization2_features = {};
 		VkPhysicalDeviceVulkan13Features vk13_features = {};
+		VkPhysicalDeviceVulkan12Features vk12_features = {};
 
 		//vk_synchronization2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
 		//vk_synchronization2_features.synchronization2 = VK_TRUE;
@@ -248,7 +256,21 @@ namespace render
 
 		vk13_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
 		vk13_features.synchronization2 = VK_TRUE;
-		vk13_features.pNext = nullptr;
+		vk13_features.pNext = &vk12_features;
+
+		// bindless material textures, the material table has no path without them
+		auto&& indexing_features = vk_physical_devices_descriptor_indexing_features_[physical_device];
+		if (!indexing_features.shaderSampledImageArrayNonUniformIndexing || !indexing_features.descriptorBindingSampledImageUpdateAfterBind ||
+			!indexing_features.descriptorBindingPartiallyBound || !indexing_features.runtimeDescriptorArray)
+			throw std::runtime_error("failed to create logical device, descriptor indexing for bindless textures is not supported");
+
+		// only the checked features are enabled, descriptorIndexing would also require ones the renderer doesn't use
+		vk12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		vk12_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		vk12_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		vk12_features.descriptorBindingPartiallyBound = VK_TRUE;
+		vk12_features.runtimeDescriptorArray = VK_TRUE;
+		vk12_features.pNext = nullptr;
 
 		logical_device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		logical_device_create_info.pNext = &vk13_features;
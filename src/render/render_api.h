@@ -60,6 +60,7 @@ namespace render
 		std::map<VkPhysicalDevice, VkPhysicalDeviceProperties> vk_physical_devices_propeties_;
 		std::map<VkPhysicalDevice, std::vector<VkQueueFamilyProperties>> vk_physical_devices_to_queues_;
 		std::map<VkPhysicalDevice, VkPhysicalDeviceFeatures> vk_physical_devices_features_;
+		std::map<VkPhysicalDevice, VkPhysicalDeviceDescriptorIndexingFeatures> vk_physical_devices_descriptor_indexing_features_;
 
 		std::map<VkPhysicalDevice, std::vector<VkLayerProperties>> vk_physical_devices_layers_;
 
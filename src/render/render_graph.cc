@@ -1,9 +1,15 @@
 #include "render_graph.h"
 
+#include <algorithm>
+#include <limits>
 #include <stack>
 #include <queue>
 #include <set>
 
+#include <glm/glm/gtc/matrix_transform.hpp>
+
+#include "render/compute_pipeline.h"
+
 #include "global.h"
 
 
@@ -12,6 +18,28 @@ extern PFN_vkCmdDebugMarkerEndEXT pfnCmdDebugMarkerEnd;
 
 namespace render
 {
+	namespace
+	{
+		template<typename T>
+		void HashCombine(size_t& seed, const T& value)
+		{
+			seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		}
+
+		void HashCombine(size_t& seed, const glm::vec3& value)
+		{
+			for (int i = 0; i < 3; i++)
+				HashCombine(seed, value[i]);
+		}
+
+		void HashCombine(size_t& seed, const glm::mat4& value)
+		{
+			for (int i = 0; i < 4; i++)
+				for (int j = 0; j < 4; j++)
+					HashCombine(seed, value[i][j]);
+		}
+	}
+
 	RenderGraph2::RenderGraph2()
 	{}
 
@@ -22,11 +50,58 @@ namespace render
 		return it->second;
 	}
 
+	void RenderGraph2::AddComputePass(const std::string& name, const ComputePipeline& pipeline, std::array<uint32_t, 3> group_count, DescriptorSetType output_set_type)
+	{
+		compute_passes_.push_back({ name, pipeline, group_count, output_set_type });
+	}
+
 	void RenderGraph2::BuildRenderPasses(const Global& global, const Formats& formats)
 	{
+		MergeSubpasses();
+
 		for (auto&& [name, node] : nodes_)
 		{
-			node.BuildRenderPass(global, formats);
+			if (!node.merged_into_)
+				node.BuildRenderPass(global, formats);
+		}
+	}
+
+	void RenderGraph2::MergeSubpasses()
+	{
+		for (auto&& [name, node] : nodes_)
+		{
+			node.subpass_nodes_ = { node };
+			node.subpass_index_ = 0;
+			node.merged_into_ = std::nullopt;
+		}
+
+		for (auto&& [name, node] : nodes_)
+		{
+			if (node.use_swapchain_framebuffer || node.cache_cube_faces || node.subpass_nodes_.size() > 1)
+				continue;
+
+			util::NullableRef<RenderNode> target;
+			bool mergeable = true;
+
+			for (auto&& attachment : node.attachments_)
+			{
+				for (auto&& dependency : attachment.to_dependencies)
+				{
+					RenderNode& to_node = nodes_.at(dependency.to_node.GetName());
+
+					if (!dependency.pixel_local || (target && &*target != &to_node))
+						mergeable = false;
+
+					target = to_node;
+				}
+			}
+
+			if (!mergeable || !target || target->merged_into_ || target->cache_cube_faces || target->subpass_nodes_.size() > 1 || target->order != node.order + 1)
+				continue;
+
+			target->subpass_nodes_.insert(target->subpass_nodes_.begin(), node);
+			target->subpass_index_ = 1;
+			node.merged_into_ = *target;
 		}
 	}
 
@@ -36,6 +111,14 @@ namespace render
 		{
 			node.ClearPipelines();
 		}
+
+		compute_passes_.clear();
+		skinning_pipeline_ = std::nullopt;
+	}
+
+	void RenderGraph2::SetSkinningPipeline(const ComputePipeline& pipeline)
+	{
+		skinning_pipeline_ = pipeline;
 	}
 
 	const std::map<std::string, RenderNode>& RenderGraph2::GetNodes() const
@@ -43,8 +126,18 @@ namespace render
 		return nodes_;
 	}
 
+	const std::vector<RenderGraph2::ComputePass>& RenderGraph2::GetComputePasses() const
+	{
+		return compute_passes_;
+	}
+
+	util::NullableRef<const ComputePipeline> RenderGraph2::GetSkinningPipeline() const
+	{
+		return skinning_pipeline_;
+	}
+
 	RenderNode::RenderNode(const RenderGraph2& render_graph, const std::string& name, const ExtentType& extent_type) :
-		name_(name), render_graph_(render_graph), extent_type_(extent_type), order(0), use_swapchain_framebuffer(false)
+		name_(name), render_graph_(render_graph), extent_type_(extent_type), order(0), use_swapchain_framebuffer(false), cache_cube_faces(false), subpass_index_(0)
 	{
 		attachments_.reserve(16);
 	}
@@ -103,10 +196,13 @@ namespace render
 
 	void RenderNode::BuildRenderPass(const Global& global, const Formats& formats)
 	{
-		render_pass_.emplace(RenderPass(global, *this, formats));
+		render_pass_.emplace(RenderPass(global, subpass_nodes_, formats));
 	}
 	const RenderPass& RenderNode::GetRenderPass() const
 	{
+		if (merged_into_)
+			return merged_into_->GetRenderPass();
+
 		assert(render_pass_);
 		return render_pass_.value();
 	}
@@ -115,6 +211,21 @@ namespace render
 	{
 		return extent_type_;
 	}
+
+	const std::vector<std::reference_wrapper<const RenderNode>>& RenderNode::GetSubpassNodes() const
+	{
+		return subpass_nodes_;
+	}
+
+	uint32_t RenderNode::GetSubpassIndex() const
+	{
+		return subpass_index_;
+	}
+
+	util::NullableRef<const RenderNode> RenderNode::GetMergedInto() const
+	{
+		return merged_into_;
+	}
 	//void RenderNode::AddDependency(Dependency dependency)
 	//{
 	//	to_dependencies_.push_back(dependency);
@@ -148,7 +259,10 @@ namespace render
 	RenderNode::Attachment& RenderNode::Attachment::ForwardAsSampled(RenderNode& to_node, DescriptorSetType set_type, int binding_index)
 	{
 		//RenderNode.AddDependency({ *this, to_node, false });
-		to_dependencies.push_back({ *this, to_node, set_type, binding_index });
+		bool pixel_local = binding_index >= 0 && DescriptorSetUtil::GetTypeToInfoMap().at(set_type).bindings[binding_index].type == DescriptorBindingType::kInputAttachment;
+		assert(!pixel_local || node.extent_type_ == to_node.extent_type_);
+
+		to_dependencies.push_back({ *this, to_node, set_type, binding_index, pixel_local });
 		to_node.order = std::max(to_node.order, node.order + 1);
 		//to_node.depends = true;
 		return *this;
@@ -165,26 +279,122 @@ namespace render
 		return attachment.ForwardAsSampled(node_to_forward, type, descriptor_set_binding_index);
 	}
 
-	RenderGraphHandler::RenderGraphHandler(const Global& global, const RenderGraph2& render_graph, const Extents& extents, const Formats& formats, DescriptorSetsManager& desc_set_manager) :
-		RenderObjBase(global), render_graph_(render_graph), nearest_sampler_(global, 0, Sampler::AddressMode::kRepeat, true)
+	RenderGraphHandler::RenderGraphHandler(const Global& global, const RenderGraph2& render_graph, const Extents& extents, const Formats& formats, DescriptorSetsManager& desc_set_manager, const MaterialTable& material_table, CubeFaceCache& cube_face_cache) :
+		RenderObjBase(global), render_graph_(render_graph), material_table_(material_table), cube_face_cache_(cube_face_cache), extents_(extents), formats_(formats), nearest_sampler_(global, 0, Sampler::AddressMode::kRepeat, true)
+	{
+		for (auto&& [node_name, render_node] : render_graph.GetNodes())
+		{
+			auto&& [it, success] = node_data_.emplace(node_name, RenderNodeData{ {} });
+			assert(success);
+		}
+
+		for (auto&& [node_name, render_node] : render_graph.GetNodes())
+		{
+			for (auto&& attachment : render_node.GetAttachments())
+			{
+				for (auto&& dependency : attachment.to_dependencies)
+				{
+					if (dependency.descriptor_set_type != DescriptorSetType::None)
+					{
+						auto&& descriptor_sets = node_data_.at(dependency.to_node.GetName()).descriptor_sets;
+
+						if (descriptor_sets.find(dependency.descriptor_set_type) == descriptor_sets.end())
+						{
+							descriptor_sets.emplace(dependency.descriptor_set_type, desc_set_manager.GetFreeDescriptor(dependency.descriptor_set_type));
+						}
+					}
+				}
+			}
+		}
+
+		auto&& type_to_desc_info = DescriptorSetUtil::GetTypeToInfoMap();
+
+		compute_buffers_.reserve(render_graph.GetComputePasses().size() * 4);
+
+		for (auto&& compute_pass : render_graph.GetComputePasses())
+		{
+			if (compute_desc_sets_.find(compute_pass.output_set_type) != compute_desc_sets_.end())
+				continue;
+
+			VkDescriptorSet vk_descriptor_set = desc_set_manager.GetFreeDescriptor(compute_pass.output_set_type);
+			compute_desc_sets_.emplace(compute_pass.output_set_type, vk_descriptor_set);
+
+			auto&& bindings = type_to_desc_info.at(compute_pass.output_set_type).bindings;
+
+			std::vector<VkWriteDescriptorSet> writes;
+			std::vector<VkDescriptorBufferInfo> buffer_infos(bindings.size());
+
+			for (uint32_t binding_index = 0; binding_index < bindings.size(); binding_index++)
+			{
+				assert(bindings[binding_index].type == DescriptorBindingType::kStorage);
+
+				compute_buffers_.emplace_back(global_, bindings[binding_index].data_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+				auto&& buffer_info = buffer_infos[binding_index];
+				buffer_info.buffer = compute_buffers_.back().GetHandle();
+				buffer_info.offset = 0;
+				buffer_info.range = bindings[binding_index].data_size;
+
+				VkWriteDescriptorSet write{};
+				write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				write.dstSet = vk_descriptor_set;
+				write.dstBinding = binding_index;
+				write.dstArrayElement = 0;
+				write.descriptorCount = 1;
+				write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				write.pBufferInfo = &buffer_info;
+
+				writes.push_back(write);
+			}
+
+			vkUpdateDescriptorSets(global_.logical_device, u32(writes.size()), writes.data(), 0, nullptr);
+		}
+
+		BuildAttachments({ ExtentType::kPresentation, ExtentType::kViewport, ExtentType::kShadowMap });
+	}
+
+	void RenderGraphHandler::UpdateExtents(const Extents& extents)
+	{
+		util::enums::Flags<ExtentType> changed_extent_types;
+		bool changed = false;
+
+		for (int extent_type = 0; extent_type < kExtentTypeCnt; extent_type++)
+		{
+			if (!(extents_[extent_type] == extents[extent_type]))
+			{
+				changed_extent_types.Set(ExtentType(extent_type));
+				changed = true;
+			}
+		}
+
+		if (!changed)
+			return;
+
+		extents_ = extents;
+		BuildAttachments(changed_extent_types);
+	}
+
+	void RenderGraphHandler::BuildAttachments(util::enums::Flags<ExtentType> extent_types)
 	{
 		std::map<std::string, std::map<DescriptorSetType, std::map<int, const AttachmentImage&>>> desc_set_images;
 
-		for (auto&& [node_name, RenderNode] : render_graph.GetNodes())
+		for (auto&& [node_name, render_node] : render_graph_.GetNodes())
 		{
-			Framebuffer::ConstructParams framebuffer_params{ RenderNode.GetRenderPass(), extents[u32(RenderNode.GetExtentType())] };
+			if (!extent_types.Check(render_node.GetExtentType()))
+				continue;
 
-			for (auto&& attachment : RenderNode.GetAttachments())
+			for (auto&& attachment : render_node.GetAttachments())
 			{
-				auto&& it = attachment_images_.find(attachment.name);
+				if (attachment.depends_on)
+					continue;
 
-				if (it != attachment_images_.end())
-				{
-					framebuffer_params.attachments.push_back(it->second.image_view);
+				// the shadow map extent is fixed, the first handler builds the shared cube image and the others reuse it
+				if (render_node.cache_cube_faces && cube_face_cache_.attachment_image && cube_face_cache_.attachment_image->image.GetExtent() == extents_[u32(render_node.GetExtentType())])
 					continue;
-				}
 
-				Image image(global, formats[int(attachment.format_type)], extents[u32(RenderNode.GetExtentType())], attachment.layers_cnt);
+				attachment_images_.erase(attachment.name);
+
+				Image image(global_, formats_[int(attachment.format_type)], extents_[u32(render_node.GetExtentType())], attachment.layers_cnt);
 
 				if (attachment.format_type == FormatType::kDepth)
 				{
@@ -195,34 +405,107 @@ namespace render
 					image.AddUsageFlag(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
 				}
 
+				bool pixel_local_only = !attachment.to_dependencies.empty();
+
 				for (auto&& dependency : attachment.to_dependencies)
 				{
-					if (dependency.descriptor_set_type != DescriptorSetType::None)
+					if (dependency.pixel_local)
+					{
+						image.AddUsageFlag(VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT);
+					}
+					else
 					{
-						image.AddUsageFlag(VK_IMAGE_USAGE_SAMPLED_BIT);
+						pixel_local_only = false;
+
+						if (dependency.descriptor_set_type != DescriptorSetType::None)
+						{
+							image.AddUsageFlag(VK_IMAGE_USAGE_SAMPLED_BIT);
+						}
 					}
 				}
 
-				ImageView image_view(global, image);
+				// never leaves the tile memory when the reader is a subpass of the same render pass
+				if (pixel_local_only)
+				{
+					image.AddUsageFlag(VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT);
+				}
 
-				auto res = attachment_images_.insert({ attachment.name, AttachmentImage{attachment.format_type, std::move(image), std::move(image_view)} });
-				framebuffer_params.attachments.push_back(res.first->second.image_view);
+				auto&& image_view = global_.image_view_cache.Get(global_, image);
 
+				if (render_node.cache_cube_faces)
+				{
+					cube_face_cache_.attachment_image.reset();
+					cube_face_cache_.attachment_image.emplace(AttachmentImage{ attachment.format_type, std::move(image), std::move(image_view) });
+					cube_face_cache_.face_framebuffers.clear();
+				}
+				else
+				{
+					attachment_images_.insert({ attachment.name, AttachmentImage{attachment.format_type, std::move(image), std::move(image_view)} });
+				}
+			}
+		}
+
+		for (auto&& [node_name, render_node] : render_graph_.GetNodes())
+		{
+			if (!extent_types.Check(render_node.GetExtentType()))
+				continue;
+
+			auto&& node_data = node_data_.at(node_name);
+
+			for (auto&& attachment : render_node.GetAttachments())
+			{
 				for (auto&& dependency : attachment.to_dependencies)
 				{
 					if (dependency.descriptor_set_type != DescriptorSetType::None)
 					{
-						desc_set_images[dependency.to_node.GetName()][dependency.descriptor_set_type].emplace(dependency.descriptor_set_binding_index, res.first->second);
+						desc_set_images[dependency.to_node.GetName()][dependency.descriptor_set_type].emplace(dependency.descriptor_set_binding_index, GetAttachmentImage(attachment.name));
 					}
 				}
 			}
 
-			auto&& [it, success] = node_data_.emplace(node_name, RenderNodeData{ {} });
-			assert(success);
+			if (render_node.cache_cube_faces)
+			{
+				// already built by another handler
+				if (!cube_face_cache_.face_framebuffers.empty())
+					continue;
 
-			if (!RenderNode.use_swapchain_framebuffer)
+				const Image& cube_image = cube_face_cache_.attachment_image->image;
+
+				cube_face_cache_.face_image_views.clear();
+				cube_face_cache_.face_image_views.reserve(cube_image.GetLayerCount());
+				cube_face_cache_.face_framebuffers.reserve(cube_image.GetLayerCount());
+
+				for (uint32_t layer = 0; layer < cube_image.GetLayerCount(); layer++)
+				{
+					cube_face_cache_.face_image_views.push_back(global_.image_view_cache.Get(global_, cube_image, layer, 1));
+
+					Framebuffer::ConstructParams framebuffer_params{ render_node.GetRenderPass(), extents_[u32(render_node.GetExtentType())] };
+					framebuffer_params.attachments.push_back(*cube_face_cache_.face_image_views.back());
+
+					cube_face_cache_.face_framebuffers.emplace_back(global_, framebuffer_params);
+				}
+
+				cube_face_cache_.face_keys.assign(cube_image.GetLayerCount(), std::nullopt);
+				cube_face_cache_.initialized = false;
+			}
+			else if (render_node.use_swapchain_framebuffer)
+			{
+				ResetSwapchainFramebuffers();
+			}
+			else if (!render_node.GetMergedInto())
 			{
-				it->second.frambuffer.emplace(global, framebuffer_params);
+				Framebuffer::ConstructParams framebuffer_params{ render_node.GetRenderPass(), extents_[u32(render_node.GetExtentType())] };
+
+				for (auto&& subpass_node : render_node.GetSubpassNodes())
+				{
+					for (auto&& attachment : subpass_node.get().GetAttachments())
+					{
+						framebuffer_params.attachments.push_back(*attachment_images_.at(attachment.name).image_view);
+					}
+				}
+
+				node_data.frambuffer.reset();
+				node_data.frambuffer.emplace(global_, framebuffer_params);
 			}
 		}
 
@@ -232,37 +515,45 @@ namespace render
 
 			for (auto&& [desc_type, desc_images] : descriptors)
 			{
-				VkDescriptorSet vk_descriptor_set = desc_set_manager.GetFreeDescriptor(desc_type);
+				VkDescriptorSet vk_descriptor_set = node_data.descriptor_sets.at(desc_type);
+
+				auto&& bindings = DescriptorSetUtil::GetTypeToInfoMap().at(desc_type).bindings;
 
-				std::vector<VkWriteDescriptorSet> writes(desc_images.size());
+				std::vector<VkWriteDescriptorSet> writes;
 				std::vector<VkDescriptorImageInfo> image_infos(desc_images.size());
 
+				writes.reserve(desc_images.size());
+
 				for (auto&& [binding_index, binding_att_image] : desc_images)
 				{
-					image_infos[binding_index].sampler = nearest_sampler_.GetHandle();
-					image_infos[binding_index].imageLayout = binding_att_image.format_type == FormatType::kDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-					image_infos[binding_index].imageView = binding_att_image.image_view.GetHandle();
-
-					writes[binding_index].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-					writes[binding_index].pNext = nullptr;
-					writes[binding_index].dstSet = vk_descriptor_set;
-					writes[binding_index].dstBinding = binding_index;
-					writes[binding_index].dstArrayElement = 0;
-					writes[binding_index].descriptorCount = 1;
-					writes[binding_index].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-					writes[binding_index].pImageInfo = &image_infos[binding_index];
-					writes[binding_index].pBufferInfo = nullptr;
-					writes[binding_index].pTexelBufferView = nullptr;
+					auto&& image_info = image_infos[writes.size()];
+					bool input_attachment = bindings[binding_index].type == DescriptorBindingType::kInputAttachment;
+
+					image_info.sampler = input_attachment ? VK_NULL_HANDLE : nearest_sampler_.GetHandle();
+					image_info.imageLayout = binding_att_image.format_type == FormatType::kDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					image_info.imageView = binding_att_image.image_view->GetHandle();
+
+					VkWriteDescriptorSet write{};
+					write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+					write.pNext = nullptr;
+					write.dstSet = vk_descriptor_set;
+					write.dstBinding = binding_index;
+					write.dstArrayElement = 0;
+					write.descriptorCount = 1;
+					write.descriptorType = input_attachment ? VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+					write.pImageInfo = &image_info;
+					write.pBufferInfo = nullptr;
+					write.pTexelBufferView = nullptr;
+
+					writes.push_back(write);
 				}
 
-				vkUpdateDescriptorSets(global.logical_device, u32(writes.size()), writes.data(), 0, nullptr);
-
-				node_data.descriptor_sets.emplace(desc_type, vk_descriptor_set);
+				vkUpdateDescriptorSets(global_.logical_device, u32(writes.size()), writes.data(), 0, nullptr);
 			}
 		}
 	}
 
-	bool RenderGraphHandler::FillCommandBuffer(VkCommandBuffer command_buffer, const FrameInfo& frame_info, const Scene& scene) const
+	bool RenderGraphHandler::FillCommandBuffer(VkCommandBuffer command_buffer, const FrameInfo& frame_info, const Scene& scene)
 	{
 		VkCommandBufferBeginInfo begin_info{};
 		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -275,6 +566,39 @@ namespace render
 			throw std::runtime_error("failed to begin recording command buffer!");
 		}
 
+		DispatchSkinning(command_buffer, frame_info, scene);
+
+		for (auto&& compute_pass : render_graph_.GetComputePasses())
+		{
+			Marker pass_marker(command_buffer, compute_pass.name);
+
+			auto&& compute_pipeline = compute_pass.pipeline.get();
+
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipeline.GetHandle());
+
+			ProcessDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipeline.GetLayout(), compute_pipeline.GetDescriptorSetLayouts(), scene.GetDescriptorSets(frame_info.frame_index));
+			ProcessDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipeline.GetLayout(), compute_pipeline.GetDescriptorSetLayouts(), compute_desc_sets_);
+
+			vkCmdDispatch(command_buffer, compute_pass.group_count[0], compute_pass.group_count[1], compute_pass.group_count[2]);
+		}
+
+		if (render_graph_.GetComputePasses().size() > 0)
+		{
+			VkMemoryBarrier2 barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+			barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+			barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+
+			VkDependencyInfo vk_dependency_info{};
+			vk_dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+			vk_dependency_info.memoryBarrierCount = 1;
+			vk_dependency_info.pMemoryBarriers = &barrier;
+
+			vkCmdPipelineBarrier2(command_buffer, &vk_dependency_info);
+		}
+
 		std::set<std::string> processed_nodes;
 
 		int order = 0;
@@ -292,25 +616,6 @@ namespace render
 
 				stop = false;
 
-				util::NullableRef<const Framebuffer> framebuffer = frame_info.swapchain_framebuffer;
-				std::map<DescriptorSetType, VkDescriptorSet> node_desc_set;
-				if (auto&& it = node_data_.find(node_name); it != node_data_.end())
-				{
-					if (it->second.frambuffer)
-					{
-						framebuffer = it->second.frambuffer;
-					}
-					node_desc_set = it->second.descriptor_sets;
-				}
-
-				VkRenderPassBeginInfo render_pass_begin_info{};
-				render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-				render_pass_begin_info.renderPass = render_node.GetRenderPass().GetHandle();
-				render_pass_begin_info.framebuffer = framebuffer->GetHandle();
-
-				render_pass_begin_info.renderArea.offset = { 0, 0 };
-				render_pass_begin_info.renderArea.extent = framebuffer->GetExtent();
-
 				for (auto&& attachment : render_node.GetAttachments())
 				{
 					for (auto&& dependency : attachment.to_dependencies)
@@ -319,119 +624,46 @@ namespace render
 					}
 				}
 
-				std::vector<VkClearValue> clear_values(framebuffer->GetFormats().size());
-				for (int att_ind = 0; att_ind < framebuffer->GetFormats().size(); att_ind++)
+				if (render_node.cache_cube_faces)
 				{
-					if (framebuffer->GetFormats()[att_ind] == global_.depth_map_format)
-					{
-						clear_values[att_ind].depthStencil = { 1.0f, 0 };
-					}
-					else
-					{
-						clear_values[att_ind].color = VkClearColorValue{ {0.0f, 0.0f, 0.0f, 1.0f} };
-					}
+					FillCubeFaces(command_buffer, frame_info, scene, render_node, node_data_.at(node_name));
+					continue;
 				}
 
-				render_pass_begin_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
-				render_pass_begin_info.pClearValues = clear_values.data();
+				// recorded as the first subpass of the node it was merged into
+				if (render_node.GetMergedInto())
+					continue;
 
-				vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+				auto&& node_data = node_data_.at(node_name);
 
-				const GraphicsPipeline* current_pipeline = nullptr;
-				VkPipelineLayout pipeline_layout;
-				int ind = 0;
-				for (auto&& render_model_ref : scene.models_)
+				util::NullableRef<const Framebuffer> framebuffer = frame_info.swapchain_framebuffer;
+				if (node_data.frambuffer)
 				{
-					auto&& model = render_model_ref;
-					Mesh& mesh = model.mesh;
-					ind++;
-					for (auto&& primitive : mesh.primitives)
-					{
-						auto [flags, primitive_vertex_buffers, primitive_indices] = std::visit([](auto&& primitive) { return std::tie(primitive.flags, primitive.vertex_buffers, primitive.indices); }, primitive);
-
-						if (render_node.required_primitive_flags.Check(flags))
-						{
-							for (auto&& primitive_pipeline_ref : render_node.GetPipelines())
-							{
-								auto&& primitive_pipeline = primitive_pipeline_ref.get();
-
-								if (!primitive_pipeline.GetRequiredPrimitiveFlags().Check(flags))
-									continue;
-
-								Marker node_marker(command_buffer, mesh.name);
-
-								if (current_pipeline != &primitive_pipeline)
-								{
-									current_pipeline = &primitive_pipeline;
-
-									vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, primitive_pipeline.GetHandle());
-									const std::map<uint32_t, const DescriptorSetLayout&>& pipeline_desc_sets = primitive_pipeline.GetDescriptorSetLayouts();
-
-									pipeline_layout = primitive_pipeline.GetLayout();
-
-
-									ProcessDescriptorSets(command_buffer, pipeline_layout, pipeline_desc_sets, scene.GetDescriptorSets(frame_info.frame_index));
-								}
-
-
-								const std::map<uint32_t, const DescriptorSetLayout&>& pipeline_desc_sets = primitive_pipeline.GetDescriptorSetLayouts();
-								ProcessDescriptorSets(command_buffer, pipeline_layout, pipeline_desc_sets, node_desc_set);
-								ProcessDescriptorSets(command_buffer, pipeline_layout, pipeline_desc_sets, model.GetDescriptorSets(frame_info.frame_index));
-
-								std::visit(
-									[&](auto&& primitive)
-									{
-										ProcessDescriptorSets(command_buffer, pipeline_layout, pipeline_desc_sets, primitive.GetDescriptorSets(frame_info.frame_index));
-									},
-									primitive
-								);
-
-								std::array<VkBuffer, kVertexBufferTypesCount> vertex_buffers;
-								std::array<VkDeviceSize, kVertexBufferTypesCount> vertex_buffer_offsets;
-								uint32_t vertex_buffers_cnt = 0;
-
-								bool valid = true;
-								for (auto&& [vertex_binding_index, vertex_binding] : primitive_pipeline.GetVertexBindingsDescs())
-								{
-									for (auto&& [attr_location, attr] : vertex_binding.attributes)
-									{
-										if (!primitive_vertex_buffers[u32(attr.type)])
-										{
-											valid = false;
-											break;
-										}
-
-										//TODO: handle size of vertex attribute on shader parsing
-										assert(vertex_binding.stride == primitive_vertex_buffers[u32(attr.type)]->stride);
-
-										vertex_buffers[vertex_binding_index] = primitive_vertex_buffers[u32(attr.type)]->buffer->GetHandle();
-										vertex_buffer_offsets[vertex_binding_index] = primitive_vertex_buffers[u32(attr.type)]->offset;
-										vertex_buffers_cnt = std::max(vertex_buffers_cnt, vertex_binding_index + 1);
-									}
-
-									if (!valid)
-										break;
-								}
+					framebuffer = node_data.frambuffer;
+				}
+				else if (render_node.use_swapchain_framebuffer)
+				{
+					framebuffer = GetSwapchainFramebuffer(render_node, node_data, frame_info);
+				}
 
+				BeginRenderPass(command_buffer, render_node, *framebuffer);
 
-								if (!valid)
-									continue;
+				std::vector<ModelDraw> model_draws;
+				model_draws.reserve(scene.models_.GetData().size());
 
-								vkCmdBindVertexBuffers(command_buffer, 0, vertex_buffers_cnt, vertex_buffers.data(), vertex_buffer_offsets.data());
+				for (auto&& model : scene.models_)
+				{
+					model_draws.push_back({ model, std::nullopt, model.primitive_lods });
+				}
 
-								if (primitive_indices)
-								{
-									vkCmdBindIndexBuffer(command_buffer, primitive_indices->buffer->GetHandle(), primitive_indices->offset, VK_INDEX_TYPE_UINT16);
-									vkCmdDrawIndexed(command_buffer, u32(primitive_indices->count), 1, 0, 0, 0);
-								}
-								else
-								{
-									vkCmdDraw(command_buffer, u32(primitive_vertex_buffers[u32(VertexBufferType::kPOSITION)]->count), 1, 0, 0);
-									int a = 1;
-								}
-							}
-						}
+				for (auto&& subpass_node : render_node.GetSubpassNodes())
+				{
+					if (subpass_node.get().GetSubpassIndex() > 0)
+					{
+						vkCmdNextSubpass(command_buffer, VK_SUBPASS_CONTENTS_INLINE);
 					}
+
+					DrawModels(command_buffer, frame_info, scene, subpass_node, node_data_.at(subpass_node.get().GetName()).descriptor_sets, model_draws);
 				}
 
 				vkCmdEndRenderPass(command_buffer);
@@ -440,19 +672,24 @@ namespace render
 			std::vector<VkImageMemoryBarrier2> vk_barriers;
 			for (auto&& dependency : dependencies)
 			{
+				// synchronized by the subpass dependency
+				if (dependency.get().pixel_local && dependency.get().from_attachment.node.GetMergedInto())
+					continue;
 
-				util::NullableRef<const Image> barrier_image = attachment_images_.at(dependency.get().from_attachment.name).image;
+				util::NullableRef<const Image> barrier_image = GetAttachmentImage(dependency.get().from_attachment.name).image;
 
 				if (!barrier_image)
 				{
 					barrier_image = frame_info.swapchain_image;
 				}
 
+				bool is_color_image = barrier_image->CheckUsageFlag(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+
 				VkImageMemoryBarrier2 barrier;
 				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
 				barrier.pNext = nullptr;
-				barrier.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT; // < ---
-				barrier.srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+				barrier.srcStageMask = is_color_image ? VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT : VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+				barrier.srcAccessMask = is_color_image ? VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT : VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 				barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
 				barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
 
@@ -508,14 +745,477 @@ namespace render
 		return true;
 	}
 
-	void RenderGraphHandler::ProcessDescriptorSets(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout, const std::map<uint32_t, const DescriptorSetLayout&>& pipeline_desc_sets, const std::map<DescriptorSetType, VkDescriptorSet>& holder_desc_sets) const
+	void RenderGraphHandler::DispatchSkinning(VkCommandBuffer command_buffer, const FrameInfo& frame_info, const Scene& scene) const
+	{
+		auto&& skinning_cache = scene.GetSkinningCache();
+		auto&& skinning_pipeline = render_graph_.GetSkinningPipeline();
+
+		if (!skinning_pipeline || skinning_cache.GetDispatches().empty())
+			return;
+
+		Marker pass_marker(command_buffer, "skinning");
+
+		auto&& make_barrier = [](VkPipelineStageFlags2 src_stage, VkAccessFlags2 src_access, VkPipelineStageFlags2 dst_stage, VkAccessFlags2 dst_access)
+			{
+				VkMemoryBarrier2 barrier{};
+				barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+				barrier.srcStageMask = src_stage;
+				barrier.srcAccessMask = src_access;
+				barrier.dstStageMask = dst_stage;
+				barrier.dstAccessMask = dst_access;
+				return barrier;
+			};
+
+		auto&& pipeline_barrier = [command_buffer](const VkMemoryBarrier2& barrier)
+			{
+				VkDependencyInfo vk_dependency_info{};
+				vk_dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+				vk_dependency_info.memoryBarrierCount = 1;
+				vk_dependency_info.pMemoryBarriers = &barrier;
+
+				vkCmdPipelineBarrier2(command_buffer, &vk_dependency_info);
+			};
+
+		// the cache is shared by the frames, earlier frames may still draw from it
+		pipeline_barrier(make_barrier(VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT, 0, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, 0));
+
+		vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, skinning_pipeline->GetHandle());
+
+		std::map<uint32_t, VkDescriptorSet> bound_sets;
+		ProcessDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, skinning_pipeline->GetLayout(), skinning_pipeline->GetDescriptorSetLayouts(), skinning_cache.GetDescriptorSets(frame_info.frame_index), &bound_sets);
+
+		for (auto&& dispatch : skinning_cache.GetDispatches())
+		{
+			ProcessDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, skinning_pipeline->GetLayout(), skinning_pipeline->GetDescriptorSetLayouts(), skinning_cache.GetSourceDescriptorSets(dispatch.source), &bound_sets);
+
+			vkCmdPushConstants(command_buffer, skinning_pipeline->GetLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SkinningPushConstants), &dispatch.push_constants);
+			vkCmdDispatch(command_buffer, (dispatch.push_constants.vertex_count + kSkinningGroupSize - 1) / kSkinningGroupSize, 1, 1);
+		}
+
+		pipeline_barrier(make_barrier(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT));
+	}
+
+	const AttachmentImage& RenderGraphHandler::GetAttachmentImage(const std::string& name) const
+	{
+		auto&& it = attachment_images_.find(name);
+
+		if (it != attachment_images_.end())
+			return it->second;
+
+		return cube_face_cache_.attachment_image.value();
+	}
+
+	void RenderGraphHandler::FillCubeFaces(VkCommandBuffer command_buffer, const FrameInfo& frame_info, const Scene& scene, const RenderNode& render_node, RenderNodeData& node_data)
+	{
+		assert(render_node.GetAttachments().size() == 1);
+
+		const Image& cube_image = cube_face_cache_.attachment_image->image;
+
+		// faces that are not re-rendered keep the content drawn by an earlier frame, so the whole image goes back to attachment layout
+		VkImageMemoryBarrier2 barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+		barrier.srcStageMask = cube_face_cache_.initialized ? VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT : VK_PIPELINE_STAGE_2_NONE;
+		barrier.srcAccessMask = cube_face_cache_.initialized ? VK_ACCESS_2_SHADER_READ_BIT : VK_ACCESS_2_NONE;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+		barrier.dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		barrier.oldLayout = cube_face_cache_.initialized ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = cube_image.GetHandle();
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = cube_image.GetLayerCount();
+
+		VkDependencyInfo vk_dependency_info{};
+		vk_dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		vk_dependency_info.imageMemoryBarrierCount = 1;
+		vk_dependency_info.pImageMemoryBarriers = &barrier;
+
+		vkCmdPipelineBarrier2(command_buffer, &vk_dependency_info);
+
+		if (!cube_face_cache_.initialized)
+		{
+			std::fill(cube_face_cache_.face_keys.begin(), cube_face_cache_.face_keys.end(), std::nullopt);
+			cube_face_cache_.initialized = true;
+		}
+
+		const glm::mat4 cube_proj = Scene::GetShadowCubeProj();
+		auto&& light_positions = scene.GetShadowCubePositions();
+
+		std::vector<VertexPushConstants> face_push_constants;
+		std::vector<ModelDraw> face_model_draws;
+		std::vector<std::vector<uint32_t>> cube_model_lods;
+		CubeFaceKey face_key;
+
+		face_push_constants.reserve(scene.models_.GetData().size());
+		face_model_draws.reserve(scene.models_.GetData().size());
+
+		uint32_t cubes_cnt = std::min(u32(light_positions.size()), u32(cube_face_cache_.face_framebuffers.size() / 6));
+
+		for (uint32_t cube_index = 0; cube_index < cubes_cnt; cube_index++)
+		{
+			const glm::vec3& light_position = light_positions[cube_index];
+
+			// faces see models from the same distance, so levels are picked once per cube, without hysteresis to keep face keys stable
+			cube_model_lods.clear();
+
+			for (auto&& model : scene.models_)
+			{
+				const Mesh& mesh = model.mesh;
+				glm::mat4 model_matrix = model.node->GetGlobalTransformMatrix();
+
+				auto&& lods = cube_model_lods.emplace_back(mesh.primitives.size());
+
+				for (uint32_t primitive_index = 0; primitive_index < mesh.primitives.size(); primitive_index++)
+				{
+					const primitive::Base& primitive = std::visit([](auto&& primitive) -> const primitive::Base& { return primitive; }, mesh.primitives[primitive_index]);
+					lods[primitive_index] = primitive.SelectLod(model_matrix, light_position, std::abs(cube_proj[1][1]), 0);
+				}
+			}
+
+			for (uint32_t face = 0; face < 6; face++)
+			{
+				const uint32_t layer = cube_index * 6 + face;
+				const glm::mat4 face_view = Scene::GetShadowCubeFaceView(face);
+				const glm::mat4 light_view = face_view * glm::translate(glm::identity<glm::mat4>(), -light_position);
+
+				face_push_constants.clear();
+				face_model_draws.clear();
+
+				face_key.hash = 0;
+				face_key.light_position = light_position;
+				face_key.model_versions.clear();
+				face_key.model_matrices.clear();
+				face_key.lods.clear();
+
+				HashCombine(face_key.hash, light_position);
+
+				uint32_t model_index = 0;
+
+				for (auto&& model : scene.models_)
+				{
+					const Mesh& mesh = model.mesh;
+					const Node& node = model.node;
+					glm::mat4 model_matrix = node.GetGlobalTransformMatrix();
+					const std::vector<uint32_t>& lods = cube_model_lods[model_index++];
+
+					if (!IntersectsCubeFace(mesh, model_matrix, light_position, face_view))
+						continue;
+
+					HashCombine(face_key.hash, mesh.id);
+					HashCombine(face_key.hash, model_matrix);
+					HashCombine(face_key.hash, model.skinned_version);
+
+					for (uint32_t lod : lods)
+					{
+						HashCombine(face_key.hash, lod);
+					}
+
+					face_key.model_versions.push_back(mesh.id);
+					face_key.model_versions.push_back(model.skinned_version);
+					face_key.model_matrices.push_back(model_matrix);
+					face_key.lods.insert(face_key.lods.end(), lods.begin(), lods.end());
+
+					face_push_constants.push_back({ cube_proj, light_view * model_matrix * mesh.dequantization });
+					face_model_draws.push_back({ model, face_push_constants.back(), lods });
+				}
+
+				if (cube_face_cache_.face_keys[layer] == face_key)
+					continue;
+
+				cube_face_cache_.face_keys[layer] = face_key;
+
+				Marker face_marker(command_buffer, "cube_face_" + std::to_string(layer));
+
+				BeginRenderPass(command_buffer, render_node, cube_face_cache_.face_framebuffers[layer]);
+				DrawModels(command_buffer, frame_info, scene, render_node, node_data.descriptor_sets, face_model_draws);
+				vkCmdEndRenderPass(command_buffer);
+			}
+		}
+	}
+
+	bool RenderGraphHandler::IntersectsCubeFace(const Mesh& mesh, const glm::mat4& model_matrix, const glm::vec3& light_position, const glm::mat4& face_view)
+	{
+		glm::vec3 bounds_min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 bounds_max = glm::vec3(-std::numeric_limits<float>::max());
+
+		for (auto&& primitive : mesh.primitives)
+		{
+			auto [primitive_min, primitive_max] = std::visit([](auto&& primitive) { return std::make_pair(primitive.bounds_min, primitive.bounds_max); }, primitive);
+
+			if (primitive_max.x == std::numeric_limits<float>::max())
+				return true;
+
+			bounds_min = glm::min(bounds_min, primitive_min);
+			bounds_max = glm::max(bounds_max, primitive_max);
+		}
+
+		if (bounds_min.x > bounds_max.x)
+			return false;
+
+		glm::vec3 light_space_min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 light_space_max = glm::vec3(-std::numeric_limits<float>::max());
+
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 position((corner & 1) ? bounds_max.x : bounds_min.x, (corner & 2) ? bounds_max.y : bounds_min.y, (corner & 4) ? bounds_max.z : bounds_min.z);
+			position = glm::vec3(model_matrix * glm::vec4(position, 1.0f)) - light_position;
+
+			light_space_min = glm::min(light_space_min, position);
+			light_space_max = glm::max(light_space_max, position);
+		}
+
+		// the face frustum is the 90 degree pyramid around its major axis
+		glm::vec3 forward = -glm::vec3(face_view[0][2], face_view[1][2], face_view[2][2]);
+		int axis = std::abs(forward.x) > 0.5f ? 0 : std::abs(forward.y) > 0.5f ? 1 : 2;
+
+		float max_depth = forward[axis] > 0 ? light_space_max[axis] : -light_space_min[axis];
+
+		if (max_depth <= 0.0f)
+			return false;
+
+		for (int side_axis = 0; side_axis < 3; side_axis++)
+		{
+			if (side_axis == axis)
+				continue;
+
+			float min_offset = (light_space_min[side_axis] <= 0.0f && light_space_max[side_axis] >= 0.0f) ? 0.0f : std::min(std::abs(light_space_min[side_axis]), std::abs(light_space_max[side_axis]));
+
+			if (min_offset > max_depth)
+				return false;
+		}
+
+		return true;
+	}
+
+	const Framebuffer& RenderGraphHandler::GetSwapchainFramebuffer(const RenderNode& render_node, RenderNodeData& node_data, const FrameInfo& frame_info)
+	{
+		if (render_node.GetSubpassNodes().size() == 1)
+			return frame_info.swapchain_framebuffer;
+
+		VkImageView swapchain_image_view = frame_info.swapchain_image_view.GetHandle();
+
+		if (auto&& it = node_data.swapchain_framebuffers.find(swapchain_image_view); it != node_data.swapchain_framebuffers.end())
+			return it->second;
+
+		Framebuffer::ConstructParams framebuffer_params{ render_node.GetRenderPass(), frame_info.swapchain_framebuffer.GetExtent() };
+
+		for (auto&& subpass_node : render_node.GetSubpassNodes())
+		{
+			for (auto&& attachment : subpass_node.get().GetAttachments())
+			{
+				if (attachment.is_swapchain_image)
+				{
+					framebuffer_params.attachments.push_back(frame_info.swapchain_image_view);
+				}
+				else
+				{
+					framebuffer_params.attachments.push_back(*attachment_images_.at(attachment.name).image_view);
+				}
+			}
+		}
+
+		return node_data.swapchain_framebuffers.emplace(swapchain_image_view, Framebuffer(global_, framebuffer_params)).first->second;
+	}
+
+	void RenderGraphHandler::ResetSwapchainFramebuffers()
+	{
+		// RenderSystem waits for every frame in flight before the swapchain changes, so nothing references them
+		for (auto&& [node_name, node_data] : node_data_)
+		{
+			node_data.swapchain_framebuffers.clear();
+		}
+	}
+
+	void RenderGraphHandler::BeginRenderPass(VkCommandBuffer command_buffer, const RenderNode& render_node, const Framebuffer& framebuffer) const
+	{
+		VkRenderPassBeginInfo render_pass_begin_info{};
+		render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		render_pass_begin_info.renderPass = render_node.GetRenderPass().GetHandle();
+		render_pass_begin_info.framebuffer = framebuffer.GetHandle();
+
+		render_pass_begin_info.renderArea.offset = { 0, 0 };
+		render_pass_begin_info.renderArea.extent = framebuffer.GetExtent();
+
+		std::vector<VkClearValue> clear_values(framebuffer.GetFormats().size());
+		for (int att_ind = 0; att_ind < framebuffer.GetFormats().size(); att_ind++)
+		{
+			if (framebuffer.GetFormats()[att_ind] == global_.depth_map_format)
+			{
+				clear_values[att_ind].depthStencil = { 1.0f, 0 };
+			}
+			else
+			{
+				clear_values[att_ind].color = VkClearColorValue{ {0.0f, 0.0f, 0.0f, 1.0f} };
+			}
+		}
+
+		render_pass_begin_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+		render_pass_begin_info.pClearValues = clear_values.data();
+
+		vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(framebuffer.GetExtent().width);
+		viewport.height = static_cast<float>(framebuffer.GetExtent().height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D scissor{};
+		scissor.offset = { 0, 0 };
+		scissor.extent = framebuffer.GetExtent();
+
+		vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+		vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+	}
+
+	void RenderGraphHandler::DrawModels(VkCommandBuffer command_buffer, const FrameInfo& frame_info, const Scene& scene, const RenderNode& render_node, const std::map<DescriptorSetType, VkDescriptorSet>& node_desc_set, const std::vector<ModelDraw>& model_draws) const
+	{
+		const GraphicsPipeline* current_pipeline = nullptr;
+		VkPipelineLayout pipeline_layout;
+		std::map<uint32_t, VkDescriptorSet> bound_sets;
+		for (auto&& model_draw : model_draws)
+		{
+			auto&& model = model_draw.model;
+			Mesh& mesh = model.mesh;
+			for (uint32_t primitive_index = 0; primitive_index < mesh.primitives.size(); primitive_index++)
+			{
+				auto&& primitive = mesh.primitives[primitive_index];
+				auto [flags, primitive_vertex_buffers] = std::visit([](auto&& primitive) { return std::tie(primitive.flags, primitive.vertex_buffers); }, primitive);
+
+				// streams written by the skinning pass replace the mesh streams of the same types
+				auto&& get_vertex_buffer = [&](VertexBufferType type) -> const std::optional<BufferAccessor>&
+					{
+						if (primitive_index < model.skinned_vertex_buffers.size() && model.skinned_vertex_buffers[primitive_index][u32(type)])
+							return model.skinned_vertex_buffers[primitive_index][u32(type)];
+
+						return primitive_vertex_buffers[u32(type)];
+					};
+
+				uint32_t lod = primitive_index < model_draw.primitive_lods.size() ? model_draw.primitive_lods[primitive_index] : 0;
+				auto&& primitive_indices = std::visit([lod](auto&& primitive) { return primitive.GetIndices(lod); }, primitive);
+
+				if (render_node.required_primitive_flags.Check(flags))
+				{
+					for (auto&& primitive_pipeline_ref : render_node.GetPipelines())
+					{
+						auto&& primitive_pipeline = primitive_pipeline_ref.get();
+
+						if (!primitive_pipeline.GetRequiredPrimitiveFlags().Check(flags))
+							continue;
+
+						std::array<VkBuffer, kVertexBufferTypesCount> vertex_buffers;
+						std::array<VkDeviceSize, kVertexBufferTypesCount> vertex_buffer_offsets;
+						uint32_t vertex_buffers_cnt = 0;
+
+						// pipelines only draw primitives whose streams match their vertex input, e.g. quantized or float ones
+						bool valid = true;
+						for (auto&& [vertex_binding_index, vertex_binding] : primitive_pipeline.GetVertexBindingsDescs())
+						{
+							for (auto&& [attr_location, attr] : vertex_binding.attributes)
+							{
+								auto&& vertex_buffer = get_vertex_buffer(attr.type);
+
+								if (!vertex_buffer || vertex_binding.stride != vertex_buffer->stride)
+								{
+									valid = false;
+									break;
+								}
+
+								vertex_buffers[vertex_binding_index] = vertex_buffer->buffer->GetHandle();
+								vertex_buffer_offsets[vertex_binding_index] = vertex_buffer->offset;
+								vertex_buffers_cnt = std::max(vertex_buffers_cnt, vertex_binding_index + 1);
+							}
+
+							if (!valid)
+								break;
+						}
+
+						if (!valid)
+							continue;
+
+						Marker node_marker(command_buffer, mesh.name);
+
+						if (current_pipeline != &primitive_pipeline)
+						{
+							current_pipeline = &primitive_pipeline;
+
+							vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, primitive_pipeline.GetHandle());
+							const std::map<uint32_t, const DescriptorSetLayout&>& pipeline_desc_sets = primitive_pipeline.GetDescriptorSetLayouts();
+
+							pipeline_layout = primitive_pipeline.GetLayout();
+							bound_sets.clear();
+
+							ProcessDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, pipeline_desc_sets, scene.GetDescriptorSets(frame_info.frame_index), &bound_sets);
+							ProcessDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, pipeline_desc_sets, compute_desc_sets_, &bound_sets);
+							ProcessDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, pipeline_desc_sets, material_table_.GetDescriptorSets(frame_info.frame_index), &bound_sets);
+						}
+
+
+						const std::map<uint32_t, const DescriptorSetLayout&>& pipeline_desc_sets = primitive_pipeline.GetDescriptorSetLayouts();
+						ProcessDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, pipeline_desc_sets, node_desc_set, &bound_sets);
+
+						std::visit(
+							[&](auto&& primitive)
+							{
+								ProcessDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, pipeline_desc_sets, primitive.GetDescriptorSets(frame_info.frame_index), &bound_sets);
+							},
+							primitive
+						);
+
+						if (model_draw.push_constants)
+						{
+							vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(VertexPushConstants), &*model_draw.push_constants);
+						}
+
+						if (auto&& geometry = std::get_if<primitive::Geometry>(&primitive))
+						{
+							FragmentPushConstants fragment_push_constants{ 0, 0, geometry->material_index };
+							vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(VertexPushConstants), sizeof(FragmentPushConstants), &fragment_push_constants);
+						}
+
+						vkCmdBindVertexBuffers(command_buffer, 0, vertex_buffers_cnt, vertex_buffers.data(), vertex_buffer_offsets.data());
+
+						// first instance selects the model matrix in the scene kModelMatrix buffer
+						if (primitive_indices)
+						{
+							vkCmdBindIndexBuffer(command_buffer, primitive_indices->buffer->GetHandle(), primitive_indices->offset, primitive_indices->stride == sizeof(uint32_t) ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16);
+							vkCmdDrawIndexed(command_buffer, u32(primitive_indices->count), 1, 0, 0, model.object_index);
+						}
+						else
+						{
+							vkCmdDraw(command_buffer, u32(primitive_vertex_buffers[u32(VertexBufferType::kPOSITION)]->count), 1, 0, model.object_index);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void RenderGraphHandler::ProcessDescriptorSets(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, const std::map<uint32_t, const DescriptorSetLayout&>& pipeline_desc_sets, const std::map<DescriptorSetType, VkDescriptorSet>& holder_desc_sets, std::map<uint32_t, VkDescriptorSet>* bound_sets) const
 	{
 		uint32_t sequence_begin = 0;
 		std::vector<VkDescriptorSet> desc_sets_to_bind;
 
 		for (auto&& [set_id, set_layout] : pipeline_desc_sets)
 		{
-			if (auto&& holder_set = holder_desc_sets.find(set_layout.GetType()); holder_set != holder_desc_sets.end())
+			auto&& holder_set = holder_desc_sets.find(set_layout.GetType());
+
+			bool already_bound = false;
+
+			if (bound_sets && holder_set != holder_desc_sets.end())
+			{
+				auto&& [bound_set, inserted] = bound_sets->try_emplace(set_id, holder_set->second);
+				already_bound = !inserted && bound_set->second == holder_set->second;
+				bound_set->second = holder_set->second;
+			}
+
+			if (holder_set != holder_desc_sets.end() && !already_bound)
 			{
 				if (desc_sets_to_bind.size() == 0)
 				{
@@ -528,7 +1228,7 @@ namespace render
 			{
 				if (desc_sets_to_bind.size() != 0)
 				{
-					vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, sequence_begin, u32(desc_sets_to_bind.size()), desc_sets_to_bind.data(), 0, nullptr);
+					vkCmdBindDescriptorSets(command_buffer, bind_point, pipeline_layout, sequence_begin, u32(desc_sets_to_bind.size()), desc_sets_to_bind.data(), 0, nullptr);
 					desc_sets_to_bind.clear();
 				}
 			}
@@ -536,7 +1236,7 @@ namespace render
 
 		if (desc_sets_to_bind.size() != 0)
 		{
-			vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, sequence_begin, u32(desc_sets_to_bind.size()), desc_sets_to_bind.data(), 0, nullptr);
+			vkCmdBindDescriptorSets(command_buffer, bind_point, pipeline_layout, sequence_begin, u32(desc_sets_to_bind.size()), desc_sets_to_bind.data(), 0, nullptr);
 			desc_sets_to_bind.clear();
 		}
 	}
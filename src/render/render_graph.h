@@ -4,14 +4,19 @@
 
 #include "vulkan/vulkan.h"
 
+#include <array>
 #include <vector>
 #include <map>
+#include <memory>
+#include <optional>
+#include <span>
 
 #include "render/data_types.h"
 #include "render/descriptor_sets_manager.h"
 #include "render/framebuffer.h"
 #include "render/image.h"
 #include "render/image_view.h"
+#include "render/material_table.h"
 #include "render/object_base.h"
 #include "render/scene.h"
 
@@ -22,6 +27,7 @@ namespace render
 	{
 		const Framebuffer& swapchain_framebuffer;
 		const Image& swapchain_image;
+		const ImageView& swapchain_image_view;
 		uint32_t swapchain_image_index;
 		uint32_t frame_index;
 	};
@@ -45,7 +51,9 @@ namespace render
 	//};
 
 	class GraphicsPipeline;
+	class ComputePipeline;
 	class RenderGraph2;
+	struct VertexPushConstants;
 
 	class RenderNode
 	{
@@ -60,6 +68,9 @@ namespace render
 
 			DescriptorSetType descriptor_set_type;
 			int descriptor_set_binding_index = -1;
+
+			// read at the same pixel as an input attachment, lets the two nodes share a render pass
+			bool pixel_local = false;
 		};
 
 		struct Attachment
@@ -118,10 +129,18 @@ namespace render
 		const RenderPass& GetRenderPass() const;
 		const ExtentType& GetExtentType() const;
 
+		// nodes recorded as consecutive subpasses of this node render pass, in subpass order
+		const std::vector<std::reference_wrapper<const RenderNode>>& GetSubpassNodes() const;
+		uint32_t GetSubpassIndex() const;
+		util::NullableRef<const RenderNode> GetMergedInto() const;
+
 		//std::vector<std::reference_wrapper<Dependency>> depends_on;
 
 		bool use_swapchain_framebuffer;
 
+		// render every cube face of the single layered depth attachment separately, only when its light or casters changed
+		bool cache_cube_faces;
+
 		int order;
 
 		PrimitiveFlags required_primitive_flags;
@@ -134,6 +153,12 @@ namespace render
 		std::vector<std::reference_wrapper<const GraphicsPipeline>> pipelines_;
 		std::optional<RenderPass> render_pass_;
 
+		std::vector<std::reference_wrapper<const RenderNode>> subpass_nodes_;
+		uint32_t subpass_index_;
+		util::NullableRef<const RenderNode> merged_into_;
+
+		friend class RenderGraph2;
+
 		/*std::vector<Dependency> to_dependencies_;*/
 		//std::vector<Dependency> from_dependencies_;
 	};
@@ -141,33 +166,94 @@ namespace render
 	class RenderGraph2
 	{
 	public:
+
+		struct ComputePass
+		{
+			std::string name;
+			std::reference_wrapper<const ComputePipeline> pipeline;
+			std::array<uint32_t, 3> group_count;
+
+			// storage set written by the pass and read by the graphics nodes
+			DescriptorSetType output_set_type;
+		};
+
 		RenderGraph2();
 
 		//TODO 
 
 		RenderNode& AddNode(const std::string& name, ExtentType extent_type);
+		void AddComputePass(const std::string& name, const ComputePipeline& pipeline, std::array<uint32_t, 3> group_count, DescriptorSetType output_set_type);
 		void BuildRenderPasses(const Global& global, const Formats& formats);
 		void ClearPipelines();
 
+		// dispatched per skinned primitive of the scene before the compute passes
+		void SetSkinningPipeline(const ComputePipeline& pipeline);
+
 		const std::map<std::string, RenderNode>& GetNodes() const;
+		const std::vector<ComputePass>& GetComputePasses() const;
+		util::NullableRef<const ComputePipeline> GetSkinningPipeline() const;
 
 	private:
+
+		void MergeSubpasses();
+
 		std::map<std::string, RenderNode> nodes_;
+		std::vector<ComputePass> compute_passes_;
+		util::NullableRef<const ComputePipeline> skinning_pipeline_;
 
 	};
 
 	class Scene;
 
+	struct AttachmentImage
+	{
+		FormatType format_type;
+		Image image;
+		std::shared_ptr<const ImageView> image_view;
+	};
+
+	// Everything a cube face is drawn from. The hash is compared first, the rest only when hashes match,
+	// so a hash collision can't keep a stale face.
+	struct CubeFaceKey
+	{
+		size_t hash = 0;
+		glm::vec3 light_position;
+		// mesh id and skinned version of each drawn model
+		std::vector<uint64_t> model_versions;
+		std::vector<glm::mat4> model_matrices;
+		// levels of the primitives of the drawn models in order
+		std::vector<uint32_t> lods;
+
+		bool operator==(const CubeFaceKey&) const = default;
+	};
+
+	// Cube shadow map shared by the frame handlers. Frames are recorded and submitted to one queue in order,
+	// so a face redrawn by one frame stays valid for the next ones instead of being redrawn in each frame image.
+	struct CubeFaceCache
+	{
+		std::optional<AttachmentImage> attachment_image;
+		std::vector<std::shared_ptr<const ImageView>> face_image_views;
+		std::vector<Framebuffer> face_framebuffers;
+		std::vector<std::optional<CubeFaceKey>> face_keys;
+		bool initialized = false;
+	};
+
 	class RenderGraphHandler : RenderObjBase<int*>
 	{
 	public:
 
-		RenderGraphHandler(const Global& global, const RenderGraph2& render_graph, const Extents& extents, const Formats& formats, DescriptorSetsManager& desc_set_manager);
+		RenderGraphHandler(const Global& global, const RenderGraph2& render_graph, const Extents& extents, const Formats& formats, DescriptorSetsManager& desc_set_manager, const MaterialTable& material_table, CubeFaceCache& cube_face_cache);
 
-		bool FillCommandBuffer(VkCommandBuffer command_buffer, const FrameInfo& frame_info, const Scene& scene) const;
+		void UpdateExtents(const Extents& extents);
+		void ResetSwapchainFramebuffers();
+
+		bool FillCommandBuffer(VkCommandBuffer command_buffer, const FrameInfo& frame_info, const Scene& scene);
 
 	private:
 
+		void BuildAttachments(util::enums::Flags<ExtentType> extent_types);
+		void DispatchSkinning(VkCommandBuffer command_buffer, const FrameInfo& frame_info, const Scene& scene) const;
+
 #ifndef NDEBUG1
 		class Marker
 		{
@@ -186,24 +272,45 @@ namespace render
 		};
 #endif
 
-		void ProcessDescriptorSets(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout, const std::map<uint32_t, const DescriptorSetLayout&>& pipeline_desc_sets, const std::map<DescriptorSetType, VkDescriptorSet>& holder_desc_sets) const;
-
-		struct AttachmentImage
-		{
-			FormatType format_type;
-			Image image;
-			ImageView image_view;
-		};
+		// sets already in bound_sets are skipped, draws sharing descriptor sets only bind what differs
+		void ProcessDescriptorSets(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, const std::map<uint32_t, const DescriptorSetLayout&>& pipeline_desc_sets, const std::map<DescriptorSetType, VkDescriptorSet>& holder_desc_sets, std::map<uint32_t, VkDescriptorSet>* bound_sets = nullptr) const;
 
 		struct RenderNodeData
 		{
 			std::optional<Framebuffer> frambuffer;
 			std::map<DescriptorSetType, VkDescriptorSet> descriptor_sets;
+
+			// swapchain image view to framebuffer, for merged render passes that write to the swapchain
+			std::map<VkImageView, Framebuffer> swapchain_framebuffers;
 		};
 
+		struct ModelDraw
+		{
+			const RenderModel& model;
+			util::NullableRef<const VertexPushConstants> push_constants;
+			// per mesh primitive, full detail for missing entries
+			std::span<const uint32_t> primitive_lods;
+		};
+
+		// the cube shadow map attachment lives in the shared cube face cache
+		const AttachmentImage& GetAttachmentImage(const std::string& name) const;
+
+		void FillCubeFaces(VkCommandBuffer command_buffer, const FrameInfo& frame_info, const Scene& scene, const RenderNode& render_node, RenderNodeData& node_data);
+		const Framebuffer& GetSwapchainFramebuffer(const RenderNode& render_node, RenderNodeData& node_data, const FrameInfo& frame_info);
+		void BeginRenderPass(VkCommandBuffer command_buffer, const RenderNode& render_node, const Framebuffer& framebuffer) const;
+		void DrawModels(VkCommandBuffer command_buffer, const FrameInfo& frame_info, const Scene& scene, const RenderNode& render_node, const std::map<DescriptorSetType, VkDescriptorSet>& node_desc_set, const std::vector<ModelDraw>& model_draws) const;
+
+		static bool IntersectsCubeFace(const Mesh& mesh, const glm::mat4& model_matrix, const glm::vec3& light_position, const glm::mat4& face_view);
+
 		std::map<std::string, AttachmentImage> attachment_images_;
+		CubeFaceCache& cube_face_cache_;
 		std::map<std::string, RenderNodeData> node_data_;;
+		std::vector<GPULocalBuffer> compute_buffers_;
+		std::map<DescriptorSetType, VkDescriptorSet> compute_desc_sets_;
 		const RenderGraph2& render_graph_;
+		const MaterialTable& material_table_;
+		Extents extents_;
+		Formats formats_;
 		Sampler nearest_sampler_;
 	};
 
@@ -10,123 +10,180 @@
 
 #include "global.h"
 
-render::RenderPass::RenderPass(const Global& global, const RenderNode& render_node, const Formats& formats): RenderObjBase(global), contains_depth_attachment_(false)
+render::RenderPass::RenderPass(const Global& global, const RenderNode& render_node, const Formats& formats) :
+	RenderPass(global, std::vector<std::reference_wrapper<const RenderNode>>{ render_node }, formats)
+{}
+
+render::RenderPass::RenderPass(const Global& global, const std::vector<std::reference_wrapper<const RenderNode>>& subpass_nodes, const Formats& formats): RenderObjBase(global), contains_depth_attachment_(false)
 {
 	
 	std::vector<VkAttachmentDescription> vk_attachments;
 	std::map<std::string, uint32_t> attachment_name_to_index;
 
+	auto&& is_subpass_dependency = [&subpass_nodes](const RenderNode::Dependency& dependency)
+	{
+		return dependency.pixel_local && std::any_of(subpass_nodes.begin(), subpass_nodes.end(), [&dependency](const RenderNode& subpass_node) { return &subpass_node == &dependency.to_node; });
+	};
+
 	int attachment_index = 0;
-	for (auto&& node_attachment : render_node.GetAttachments())
+	for (auto&& subpass_node : subpass_nodes)
 	{
-		VkAttachmentDescription attachment_description = {};
+		for (auto&& node_attachment : subpass_node.get().GetAttachments())
+		{
+			VkAttachmentDescription attachment_description = {};
 
-		bool is_depth_attachment = node_attachment.format_type == FormatType::kDepth;
+			bool is_depth_attachment = node_attachment.format_type == FormatType::kDepth;
+			bool read_outside = std::any_of(node_attachment.to_dependencies.begin(), node_attachment.to_dependencies.end(), [&is_subpass_dependency](const RenderNode::Dependency& dependency) { return !is_subpass_dependency(dependency); });
 
-		attachment_description.format = formats[int(node_attachment.format_type)];
-		attachment_description.samples = VK_SAMPLE_COUNT_1_BIT;
-		attachment_description.loadOp = node_attachment.depends_on ? VK_ATTACHMENT_LOAD_OP_LOAD : is_depth_attachment ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment_description.format = formats[int(node_attachment.format_type)];
+			attachment_description.samples = VK_SAMPLE_COUNT_1_BIT;
+			attachment_description.loadOp = node_attachment.depends_on ? VK_ATTACHMENT_LOAD_OP_LOAD : is_depth_attachment ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 
-		if(node_attachment.format_type == FormatType::kSwapchain || !node_attachment.to_dependencies.empty())
-			attachment_description.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		else attachment_description.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		
-		attachment_description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			if (node_attachment.format_type == FormatType::kSwapchain || read_outside)
+				attachment_description.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			else attachment_description.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
-		if (!node_attachment.depends_on)
-		{
-			attachment_description.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		}
-		else
-		{
-			attachment_description.initialLayout = is_depth_attachment ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		}
+			attachment_description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
-		if (node_attachment.is_swapchain_image && node_attachment.to_dependencies.empty())
-		{
-			attachment_description.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-		}
-		else
-		{
-			attachment_description.finalLayout = is_depth_attachment ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		}
+			if (!node_attachment.depends_on)
+			{
+				attachment_description.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			}
+			else
+			{
+				attachment_description.initialLayout = is_depth_attachment ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			}
+
+			if (node_attachment.is_swapchain_image && node_attachment.to_dependencies.empty())
+			{
+				attachment_description.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+			}
+			else
+			{
+				attachment_description.finalLayout = is_depth_attachment ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			}
 
-		vk_attachments.push_back(attachment_description);
-		attachment_name_to_index[node_attachment.name] = attachment_index;
-		attachment_index++;
+			vk_attachments.push_back(attachment_description);
+			attachment_name_to_index[node_attachment.name] = attachment_index;
+			attachment_index++;
+		}
 	}
 
 	std::vector<VkSubpassDescription> subpasses;
-	std::map<std::string, uint32_t> subpass_name_to_index;
 
 	std::vector<std::vector<VkAttachmentReference>> subpasses_color_refs;
+	std::vector<std::vector<VkAttachmentReference>> subpasses_input_refs;
 	std::vector<VkAttachmentReference> subpasses_depth_refs;
 
-	int subpass_cnt = 1;
-
+	uint32_t subpass_cnt = u32(subpass_nodes.size());
 
 	subpasses.resize(subpass_cnt);
 
 	subpasses_color_refs.resize(subpass_cnt);
+	subpasses_input_refs.resize(subpass_cnt);
 	subpasses_depth_refs.resize(subpass_cnt);
 
-	for (int subpass_ind = 0; subpass_ind < subpass_cnt; subpass_ind++)
+	for (uint32_t subpass_ind = 0; subpass_ind < subpass_cnt; subpass_ind++)
 	{
-		int attachment_index = 0;
+		const RenderNode& render_node = subpass_nodes[subpass_ind];
+
 		for (auto&& node_attachment : render_node.GetAttachments())
 		{
 			bool is_depth_attachment = node_attachment.format_type == FormatType::kDepth;
 
 			if (is_depth_attachment)
 			{
-				subpasses_depth_refs[subpass_ind].attachment = attachment_index;
+				subpasses_depth_refs[subpass_ind].attachment = attachment_name_to_index.at(node_attachment.name);
 				subpasses_depth_refs[subpass_ind].layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 				subpasses[subpass_ind].pDepthStencilAttachment = &subpasses_depth_refs[subpass_ind];
 			}
 			else
 			{
 				subpasses_color_refs[subpass_ind].push_back({});
-				subpasses_color_refs[subpass_ind].back().attachment = attachment_index;
+				subpasses_color_refs[subpass_ind].back().attachment = attachment_name_to_index.at(node_attachment.name);
 				subpasses_color_refs[subpass_ind].back().layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 			}
+		}
 
-			attachment_index++;
+		// input_attachment_index in the shader equals the descriptor binding index
+		for (uint32_t prev_subpass_ind = 0; prev_subpass_ind < subpass_ind; prev_subpass_ind++)
+		{
+			for (auto&& node_attachment : subpass_nodes[prev_subpass_ind].get().GetAttachments())
+			{
+				for (auto&& dependency : node_attachment.to_dependencies)
+				{
+					if (!dependency.pixel_local || &dependency.to_node != &render_node)
+						continue;
+
+					auto&& input_refs = subpasses_input_refs[subpass_ind];
+					uint32_t input_index = u32(dependency.descriptor_set_binding_index);
+
+					if (input_refs.size() <= input_index)
+						input_refs.resize(input_index + 1, { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED });
+
+					input_refs[input_index].attachment = attachment_name_to_index.at(node_attachment.name);
+					input_refs[input_index].layout = node_attachment.format_type == FormatType::kDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				}
+			}
 		}
 
 		subpasses[subpass_ind].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 		subpasses[subpass_ind].colorAttachmentCount = u32(subpasses_color_refs[subpass_ind].size());
 		subpasses[subpass_ind].pColorAttachments = subpasses_color_refs[subpass_ind].data();
+		subpasses[subpass_ind].inputAttachmentCount = u32(subpasses_input_refs[subpass_ind].size());
+		subpasses[subpass_ind].pInputAttachments = subpasses_input_refs[subpass_ind].data();
 	}
 
 	std::vector<VkSubpassDependency> dependencies;
 
-	bool acquire_depend = false;
-	for (auto&& attachment : render_node.GetAttachments())
+	for (uint32_t subpass_ind = 0; subpass_ind < subpass_cnt; subpass_ind++)
 	{
-		if (attachment.is_swapchain_image)
+		bool acquire_depend = false;
+		for (auto&& attachment : subpass_nodes[subpass_ind].get().GetAttachments())
 		{
-			acquire_depend = true;
-			break;
+			if (attachment.is_swapchain_image)
+			{
+				acquire_depend = true;
+				break;
+			}
 		}
-	}
 
-	if (acquire_depend)
-	{
-		//if (!it->second.depends_on)
+		if (acquire_depend)
+		{
+			//if (!it->second.depends_on)
+			{
+				VkSubpassDependency vk_dependency;
+
+				vk_dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+				vk_dependency.dstSubpass = subpass_ind;
+
+				vk_dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT/* | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT*/;
+				vk_dependency.srcAccessMask = 0;
+
+				vk_dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				vk_dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+				vk_dependency.dependencyFlags = 0;
+
+				dependencies.push_back(vk_dependency);
+			}
+		}
+
+		if (subpass_ind > 0)
 		{
 			VkSubpassDependency vk_dependency;
 
-			vk_dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-			vk_dependency.dstSubpass = 0;
+			vk_dependency.srcSubpass = subpass_ind - 1;
+			vk_dependency.dstSubpass = subpass_ind;
 
-			vk_dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT/* | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT*/;
-			vk_dependency.srcAccessMask = 0;
+			vk_dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			vk_dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
-			vk_dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			vk_dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			vk_dependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			vk_dependency.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
 
-			vk_dependency.dependencyFlags = 0;
+			vk_dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
 			dependencies.push_back(vk_dependency);
 		}
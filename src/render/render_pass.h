@@ -4,6 +4,9 @@
 
 #include "vulkan/vulkan.h"
 
+#include <functional>
+#include <vector>
+
 #include "render/object_base.h"
 #include "render/image_view.h"
 
@@ -35,6 +38,7 @@ namespace render
 
 
 		RenderPass(const Global& global, const RenderNode& render_node, const Formats& formats);
+		RenderPass(const Global& global, const std::vector<std::reference_wrapper<const RenderNode>>& subpass_nodes, const Formats& formats);
 
 		//int AddColorAttachment(const std::string_view& name, bool high_range = true);
 		//int AddDepthAttachment(const std::string_view& name);
@@ -5,15 +5,17 @@
 #include "render/shader_module.h"
 
 #include "render/descriptor_set.h"
+#include "render/skinning.h"
 
 #include "global.h"
 
 namespace render
 {
-	RenderSetup::RenderSetup(const Global& global) :
-		RenderObjBase(global)
+	RenderSetup::RenderSetup(const Global& global, GBufferLayout g_buffer_layout) :
+		RenderObjBase(global), g_buffer_layout_(g_buffer_layout)
 	{
 		pipelines_.reserve(32);
+		compute_pipelines_.reserve(8);
 
 		g_build_node = render_graph_.AddNode("g_build", ExtentType::kPresentation);
 		cube_shadow_map_node = render_graph_.AddNode("cube_shadow_map", ExtentType::kShadowMap);
@@ -26,13 +28,25 @@ namespace render
 		g_collect_node->use_swapchain_framebuffer = true;
 		ui_node->use_swapchain_framebuffer = true;
 
-		g_build_node->Attach("g_albedo", FormatType::kHighRangeColor) >> DescriptorSetType::kGBuffers >> 0 >> *g_collect_node;
-		g_build_node->Attach("g_position", FormatType::kHighRangeColor) >> DescriptorSetType::kGBuffers >> 1 >> *g_collect_node;
-		g_build_node->Attach("g_normal", FormatType::kHighRangeColor) >> DescriptorSetType::kGBuffers >> 2 >> *g_collect_node;
-		g_build_node->Attach("g_metal_rough", FormatType::kHighRangeColor) >> DescriptorSetType::kGBuffers >> 3 >> *g_collect_node;
-		g_build_node->Attach("g_depth", FormatType::kDepth);
+		cube_shadow_map_node->cache_cube_faces = true;
 
-		cube_shadow_map_node->Attach("cube_depth", FormatType::kDepth, 6 * 10) >> DescriptorSetType::kShadowCubeMaps >> 0 >> *g_collect_node;
+		if (g_buffer_layout_ == GBufferLayout::kCompact)
+		{
+			g_build_node->Attach("g_albedo", FormatType::kColor) >> DescriptorSetType::kGBuffers >> 0 >> *g_collect_node;
+			g_build_node->Attach("g_normal", FormatType::kOctahedralNormal) >> DescriptorSetType::kGBuffers >> 2 >> *g_collect_node;
+			g_build_node->Attach("g_metal_rough", FormatType::kMetallicRoughness) >> DescriptorSetType::kGBuffers >> 3 >> *g_collect_node;
+			g_build_node->Attach("g_depth", FormatType::kDepth) >> DescriptorSetType::kGBuffers >> 1 >> *g_collect_node;
+		}
+		else
+		{
+			g_build_node->Attach("g_albedo", FormatType::kHighRangeColor) >> DescriptorSetType::kGBuffers >> 0 >> *g_collect_node;
+			g_build_node->Attach("g_position", FormatType::kHighRangeColor) >> DescriptorSetType::kGBuffers >> 1 >> *g_collect_node;
+			g_build_node->Attach("g_normal", FormatType::kHighRangeColor) >> DescriptorSetType::kGBuffers >> 2 >> *g_collect_node;
+			g_build_node->Attach("g_metal_rough", FormatType::kHighRangeColor) >> DescriptorSetType::kGBuffers >> 3 >> *g_collect_node;
+			g_build_node->Attach("g_depth", FormatType::kDepth);
+		}
+
+		cube_shadow_map_node->Attach("cube_depth", FormatType::kDepth, 6 * Scene::kShadowCubesCount) >> DescriptorSetType::kShadowCubeMaps >> 0 >> *g_collect_node;
 
 		auto&& swapchain_attachment = g_collect_node->AttachSwapchain() >> *ui_node;
 
@@ -42,7 +56,8 @@ namespace render
 	{
 		render_graph_.BuildRenderPasses(global_, formats);
 
-		swapchain_render_pass_ = g_collect_node->GetRenderPass();
+		// g_collect render pass also holds the g-buffer subpass, ui one has the swapchain image only
+		swapchain_render_pass_ = ui_node->GetRenderPass();
 	}
 
 	const RenderGraph2& RenderSetup::GetRenderGraph() const
@@ -60,32 +75,59 @@ namespace render
 		return pipelines_;
 	}
 
-	void RenderSetup::InitPipelines(const DescriptorSetsManager& descriptor_set_manager, const std::array<Extent, kExtentTypeCnt>& extents)
+	void RenderSetup::InitPipelines(const DescriptorSetsManager& descriptor_set_manager)
 	{
 		pipelines_.clear();
+		compute_pipelines_.clear();
 		render_graph_.ClearPipelines();
 
+		{
+			ShaderModule comp_shader_module(global_, "light_culling.comp", descriptor_set_manager.GetLayouts());
+
+			compute_pipelines_.push_back(ComputePipeline(global_, comp_shader_module));
+
+			// one invocation per cluster, should match local_size_x of light_culling.comp
+			const uint32_t kLightCullingGroupSize = 64;
+			render_graph_.AddComputePass("light_culling", compute_pipelines_.back(), { (kLightClustersCount + kLightCullingGroupSize - 1) / kLightCullingGroupSize, 1, 1 }, DescriptorSetType::kLightClusters);
+		}
+
+		{
+			ShaderModule comp_shader_module(global_, "skinning.comp", descriptor_set_manager.GetLayouts());
+
+			compute_pipelines_.push_back(ComputePipeline(global_, comp_shader_module, u32(sizeof(SkinningPushConstants))));
+			render_graph_.SetSkinningPipeline(compute_pipelines_.back());
+		}
+
 		{
 			ShaderModule vert_shader_module(global_, "bitmap.vert", descriptor_set_manager.GetLayouts());
 			ShaderModule frag_shader_module(global_, "bitmap.frag", descriptor_set_manager.GetLayouts());
 
-			pipelines_.push_back(GraphicsPipeline(global_, *ui_node, vert_shader_module, frag_shader_module, extents, PrimitiveProps::kUIShape, GraphicsPipeline::EParams::kDisableDepthTest));
+			pipelines_.push_back(GraphicsPipeline(global_, *ui_node, vert_shader_module, frag_shader_module, PrimitiveProps::kUIShape, GraphicsPipeline::EParams::kDisableDepthTest));
 			ui_node->AddPipeline(pipelines_.back());
 		}
 
 		{
 			ShaderModule vert_shader_module(global_, "build_g_buffers.vert", descriptor_set_manager.GetLayouts());
-			ShaderModule frag_shader_module(global_, "build_g_buffers.frag", descriptor_set_manager.GetLayouts());
+			ShaderModule frag_shader_module(global_, "build_g_buffers.frag", descriptor_set_manager.GetLayouts(), g_buffer_layout_ == GBufferLayout::kCompact ? "compact" : "");
+
+			pipelines_.push_back(GraphicsPipeline(global_, *g_build_node, vert_shader_module, frag_shader_module, PrimitiveProps::kOpaque));
+			g_build_node->AddPipeline(pipelines_.back());
+		}
+
+		// primitives with quantized streams, the vertex input layout selects them
+		{
+			ShaderModule vert_shader_module(global_, "build_g_buffers_quantized.vert", descriptor_set_manager.GetLayouts());
+			ShaderModule frag_shader_module(global_, "build_g_buffers.frag", descriptor_set_manager.GetLayouts(), g_buffer_layout_ == GBufferLayout::kCompact ? "compact" : "");
 
-			pipelines_.push_back(GraphicsPipeline(global_, *g_build_node, vert_shader_module, frag_shader_module, extents, PrimitiveProps::kOpaque));
+			pipelines_.push_back(GraphicsPipeline(global_, *g_build_node, vert_shader_module, frag_shader_module, PrimitiveProps::kOpaque));
 			g_build_node->AddPipeline(pipelines_.back());
 		}
 
 		{
 			ShaderModule vert_shader_module(global_, "collect_g_buffers.vert", descriptor_set_manager.GetLayouts());
-			ShaderModule frag_shader_module(global_, "collect_g_buffers.frag", descriptor_set_manager.GetLayouts());
+			ShaderModule frag_shader_module(global_, "collect_g_buffers.frag", descriptor_set_manager.GetLayouts(), g_buffer_layout_ == GBufferLayout::kCompact ? "compact" : "");
 
-			pipelines_.push_back(GraphicsPipeline(global_, *g_collect_node, vert_shader_module, frag_shader_module, extents, PrimitiveProps::kViewport));
+			pipelines_.push_back(GraphicsPipeline(global_, *g_collect_node, vert_shader_module, frag_shader_module, PrimitiveProps::kViewport));
 			g_collect_node->AddPipeline(pipelines_.back());
 		}
 
@@ -93,7 +135,7 @@ namespace render
 			ShaderModule vert_shader_module(global_, "dbg_color_uni.vert", descriptor_set_manager.GetLayouts());
 			ShaderModule frag_shader_module(global_, "dbg_color_uni.frag", descriptor_set_manager.GetLayouts());
 
-			pipelines_.push_back(GraphicsPipeline(global_, *ui_node, vert_shader_module, frag_shader_module, extents, PrimitiveProps::kDebugPoints, { GraphicsPipeline::EParams::kPointTopology, GraphicsPipeline::EParams::kDisableDepthTest }));
+			pipelines_.push_back(GraphicsPipeline(global_, *ui_node, vert_shader_module, frag_shader_module, PrimitiveProps::kDebugPoints, { GraphicsPipeline::EParams::kPointTopology, GraphicsPipeline::EParams::kDisableDepthTest }));
 			ui_node->AddPipeline(pipelines_.back());
 		}
 
@@ -101,7 +143,7 @@ namespace render
 			ShaderModule vert_shader_module(global_, "pos_color.vert", descriptor_set_manager.GetLayouts());
 			ShaderModule frag_shader_module(global_, "pos_color.frag", descriptor_set_manager.GetLayouts());
 
-			pipelines_.push_back(GraphicsPipeline(global_, *ui_node, vert_shader_module, frag_shader_module, extents, PrimitiveProps::kDebugLines, GraphicsPipeline::EParams::kLineTopology));
+			pipelines_.push_back(GraphicsPipeline(global_, *ui_node, vert_shader_module, frag_shader_module, PrimitiveProps::kDebugLines, GraphicsPipeline::EParams::kLineTopology));
 			ui_node->AddPipeline(pipelines_.back());
 		}
 
@@ -109,16 +151,23 @@ namespace render
 		//	ShaderModule vert_shader_module(global_, "pos.vert", descriptor_set_manager.GetLayouts());
 		//	ShaderModule frag_shader_module(global_, "pos.frag", descriptor_set_manager.GetLayouts());
 
-		//	pipelines_.push_back(GraphicsPipeline(global_, *ui_node, vert_shader_module, frag_shader_module, extents, PrimitiveProps::kUIShape));
+		//	pipelines_.push_back(GraphicsPipeline(global_, *ui_node, vert_shader_module, frag_shader_module, PrimitiveProps::kUIShape));
 		//	ui_node->AddPipeline(pipelines_.back));
 		//}
 
 		{
-			ShaderModule vert_shader_module(global_, "cube_depth.vert", descriptor_set_manager.GetLayouts());
-			ShaderModule geom_shader_module(global_, "cube_depth.geom", descriptor_set_manager.GetLayouts());
-			ShaderModule frag_shader_module(global_, "cube_depth.frag", descriptor_set_manager.GetLayouts());
+			ShaderModule vert_shader_module(global_, "cube_depth_face.vert", descriptor_set_manager.GetLayouts());
+			ShaderModule frag_shader_module(global_, "cube_depth_face.frag", descriptor_set_manager.GetLayouts());
+
+			pipelines_.push_back(GraphicsPipeline(global_, *cube_shadow_map_node, vert_shader_module, frag_shader_module, PrimitiveProps::kOpaque, GraphicsPipeline::EParams::kDepthBias));
+			cube_shadow_map_node->AddPipeline(pipelines_.back());
+		}
+
+		{
+			ShaderModule vert_shader_module(global_, "cube_depth_face_quantized.vert", descriptor_set_manager.GetLayouts());
+			ShaderModule frag_shader_module(global_, "cube_depth_face.frag", descriptor_set_manager.GetLayouts());
 
-			pipelines_.push_back(GraphicsPipeline(global_, *cube_shadow_map_node, vert_shader_module, geom_shader_module, frag_shader_module, extents, PrimitiveProps::kOpaque, GraphicsPipeline::EParams::kDepthBias));
+			pipelines_.push_back(GraphicsPipeline(global_, *cube_shadow_map_node, vert_shader_module, frag_shader_module, PrimitiveProps::kOpaque, GraphicsPipeline::EParams::kDepthBias));
 			cube_shadow_map_node->AddPipeline(pipelines_.back());
 		}
 	}
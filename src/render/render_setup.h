@@ -7,6 +7,7 @@
 
 #include "vulkan/vulkan.h"
 
+#include "render/compute_pipeline.h"
 #include "render/data_types.h"
 #include "render/graphics_pipeline.h"
 #include "render/descriptor_sets_manager.h"
@@ -21,11 +22,11 @@ namespace render
 	{
 	public:
 
-		RenderSetup(const Global& global);
+		RenderSetup(const Global& global, GBufferLayout g_buffer_layout);
 
 		void BuildRenderPasses(const Formats& formats);
 
-		void InitPipelines(const DescriptorSetsManager& descriptor_set_manager, const std::array<Extent, kExtentTypeCnt>& extents);
+		void InitPipelines(const DescriptorSetsManager& descriptor_set_manager);
 
 		const RenderGraph2& GetRenderGraph() const;
 		const RenderPass& GetSwapchainRenderPass() const;
@@ -34,10 +35,12 @@ namespace render
 	private:
 
 		RenderGraph2 render_graph_;
+		GBufferLayout g_buffer_layout_;
 
 		util::NullableRef<const RenderPass> swapchain_render_pass_;
 
 		std::vector<GraphicsPipeline> pipelines_;
+		std::vector<ComputePipeline> compute_pipelines_;
 
 		util::NullableRef<render::RenderNode> g_build_node;
 		util::NullableRef<render::RenderNode> cube_shadow_map_node;
@@ -8,8 +8,8 @@ PFN_vkCmdDebugMarkerEndEXT pfnCmdDebugMarkerEnd;
 
 namespace render
 {
-	RenderSystem::RenderSystem(platform::Window window, const std::string& app_name): 
-		render_api_(global_, app_name), render_setup_(global_),
+	RenderSystem::RenderSystem(platform::Window window, const std::string& app_name, GBufferLayout g_buffer_layout): 
+		render_api_(global_, app_name), render_setup_(global_, g_buffer_layout),
 		surface_(window, render_api_.GetInstance(), global_)
 	{
 		render_api_.FillGlobal(global_);
@@ -18,27 +18,50 @@ namespace render
 		pfnCmdDebugMarkerEnd = (PFN_vkCmdDebugMarkerEndEXT)vkGetDeviceProcAddr(global_.logical_device, "vkCmdDebugMarkerEndEXT");
 
 		descriptor_set_manager_.emplace(global_);
+		material_table_.emplace(global_, descriptor_set_manager_.value());
 
 		formats_ =
 		{
 			surface_.GetSurfaceFormat(global_.physical_device).format,
 			VK_FORMAT_R32G32B32A32_SFLOAT,
 			VK_FORMAT_R8G8B8A8_SRGB,
-			VK_FORMAT_D32_SFLOAT
+			VK_FORMAT_D32_SFLOAT,
+			VK_FORMAT_R16G16_SNORM,
+			VK_FORMAT_R8G8_UNORM
 		};
 
 		render_setup_.BuildRenderPasses(formats_);
 	}
 
 
-	void RenderSystem::Render(uint32_t frame_index, const Scene& scene)
+	void RenderSystem::Render(uint32_t frame_index, Scene& scene)
 	{
-		if (!swapchain_)
+		if (!swapchain_ || swapchain_out_of_date_)
 		{
-			global_.graphics_cmd_pool->ClearCommandBuffers();
-			global_.graphics_cmd_pool->CreateCommandBuffers(kFramesCount);
+			global_.frame_ind = frame_index;
 
-			swapchain_.emplace(global_, surface_);
+			bool first_init = !swapchain_;
+
+			if (first_init)
+			{
+				global_.graphics_cmd_pool->ClearCommandBuffers();
+				global_.graphics_cmd_pool->CreateCommandBuffers(kFramesCount);
+
+				swapchain_.emplace(global_, surface_);
+			}
+			else
+			{
+				// any frame in flight may render to or present the old swapchain, it is destroyed once all of them are complete
+				for (auto&& frame : frames_)
+				{
+					frame->WaitForCompletion();
+				}
+
+				Swapchain new_swapchain(global_, surface_, swapchain_->GetHandle());
+				swapchain_.emplace(std::move(new_swapchain));
+			}
+
+			swapchain_out_of_date_ = false;
 
 			auto&& swapchain = swapchain_.value();
 
@@ -47,7 +70,15 @@ namespace render
 			extents_[int(ExtentType::kViewport)] = swapchain_extent;
 			extents_[int(ExtentType::kShadowMap)] = {512, 512};
 
-			render_setup_.InitPipelines(descriptor_set_manager_.value(), extents_);
+			if (first_init)
+			{
+				render_setup_.InitPipelines(descriptor_set_manager_.value());
+			}
+
+			for (int i = 0; i < kFramesCount; i++)
+			{
+				swapchain_framebuffers_[i].reset();
+			}
 
 			for (int i = 0; i < swapchain.GetImagesCount(); i++)
 			{
@@ -62,11 +93,21 @@ namespace render
 				swapchain_framebuffers_[i].emplace(global_, params);
 			}
 
-			formats_[int(FormatType::kSwapchain)] = surface_.GetSurfaceFormat(global_.physical_device).format;
+			if (first_init)
+			{
+				formats_[int(FormatType::kSwapchain)] = surface_.GetSurfaceFormat(global_.physical_device).format;
 
-			for (int i = 0; i < kFramesCount; i++)
+				for (int i = 0; i < kFramesCount; i++)
+				{
+					frames_[i].emplace(global_, swapchain, render_setup_, extents_, formats_, descriptor_set_manager_.value(), material_table_.value(), cube_face_cache_);
+				}
+			}
+			else
 			{
-				frames_[i].emplace(global_, swapchain, render_setup_, extents_, formats_, descriptor_set_manager_.value());
+				for (auto&& frame : frames_)
+				{
+					frame->UpdateSwapchain(swapchain);
+				}
 			}
 
 			for (auto&& callback : on_swapchain_update_callbacks)
@@ -91,8 +132,7 @@ namespace render
 		{
 			if (result == VK_ERROR_OUT_OF_DATE_KHR)
 			{
-				swapchain_.reset();
-				vkDeviceWaitIdle(global_.logical_device);
+				swapchain_out_of_date_ = true;
 				return;
 			}
 			
@@ -103,6 +143,7 @@ namespace render
 		{
 			swapchain_framebuffers_[swapchain_image_index].value(),
 			swapchain.GetImage(swapchain_image_index),
+			swapchain.GetImageView(swapchain_image_index),
 			swapchain_image_index,
 			frame_index
 		};
@@ -113,8 +154,7 @@ namespace render
 
 		if (!frame.Draw(frame_info, scene))
 		{
-			swapchain_.reset();
-			vkDeviceWaitIdle(global_.logical_device);
+			swapchain_out_of_date_ = true;
 			return;
 		}
 	}
@@ -129,6 +169,11 @@ namespace render
 		return descriptor_set_manager_.value();
 	}
 
+	MaterialTable& RenderSystem::GetMaterialTable()
+	{
+		return material_table_.value();
+	}
+
 	void RenderSystem::AddOnSwapchainUpdateCallback(std::function<void(const Swapchain&)> callback)
 	{
 		on_swapchain_update_callbacks.push_back(callback);
@@ -14,6 +14,7 @@
 #include "command_pool.h"
 #include "descriptor_sets_manager.h"
 #include "frame_handler.h"
+#include "material_table.h"
 #include "render_api.h"
 
 
@@ -24,13 +25,14 @@ namespace render
 	class RenderSystem
 	{
 	public:
-		RenderSystem(platform::Window window, const std::string& app_name);
+		RenderSystem(platform::Window window, const std::string& app_name, GBufferLayout g_buffer_layout = GBufferLayout::kCompact);
 		
 		bool ShouldRender() const;
-		void Render(uint32_t frame_index, const Scene& scene);
+		void Render(uint32_t frame_index, Scene& scene);
 
 		const Global& GetGlobal() const;
 		DescriptorSetsManager& GetDescriptorSetsManager();
+		MaterialTable& GetMaterialTable();
 
 		void AddOnSwapchainUpdateCallback(std::function<void(const Swapchain&)> callback);
 
@@ -43,8 +45,13 @@ namespace render
 		Surface surface_;
 
 		std::optional<DescriptorSetsManager> descriptor_set_manager_;
+		std::optional<MaterialTable> material_table_;
 
 		std::optional<Swapchain> swapchain_;
+		bool swapchain_out_of_date_ = false;
+
+		// outlives the frames drawing into it
+		CubeFaceCache cube_face_cache_;
 
 		std::array<std::optional<FrameHandler>, kFramesCount> frames_;
 		std::array<std::optional<Framebuffer>, kFramesCount> swapchain_framebuffers_;
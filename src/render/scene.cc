@@ -350,8 +350,13 @@ namespace render
 		debug_geometry_(debug_geometry_),
 		viewport_node_(),
 		viewport_mesh_{"viewport"},
-		viewport_model_(global, manager, viewport_node_, viewport_mesh_),
-		desc_set_manager_(manager)
+		viewport_model_(viewport_node_, viewport_mesh_),
+		desc_set_manager_(manager),
+		skinning_cache_(global, manager),
+		aspect_(1.5f),
+		camera_version_(NextDataVersion()),
+		models_version_(NextDataVersion()),
+		lights_version_(NextDataVersion())
 	{
 
 		std::vector<glm::vec3> viewport_vertex_data = {
@@ -370,78 +375,320 @@ namespace render
 
 		viewport_mesh_.primitives.push_back(std::move(viewport_primitive));
 
+		viewport_node_.SetVersionSink(model_nodes_version_);
+		debug_geometry_.model.node->SetVersionSink(model_nodes_version_);
+
 		models_.Add(std::move(viewport_model_));
 		models_.Add(std::move(debug_geometry_.model));
+
+		for (int frame_index = 0; frame_index < kFramesCount; frame_index++)
+		{
+			descriptor_sets_per_frame_[frame_index].emplace(DescriptorSetType::kModelMatrix, manager.GetFreeDescriptor(DescriptorSetType::kModelMatrix));
+		}
+
+		light_culling_stats_buffers_.reserve(kFramesCount);
+
+		for (int frame_index = 0; frame_index < kFramesCount; frame_index++)
+		{
+			light_culling_stats_buffers_.emplace_back(global, sizeof(LightCullingStats));
+			light_culling_stats_buffers_.back().LoadData(&light_culling_stats_, sizeof(LightCullingStats));
+
+			VkDescriptorSet vk_descriptor_set = manager.GetFreeDescriptor(DescriptorSetType::kLightCullingStats);
+			descriptor_sets_per_frame_[frame_index].emplace(DescriptorSetType::kLightCullingStats, vk_descriptor_set);
+
+			VkDescriptorBufferInfo buffer_info{ light_culling_stats_buffers_.back().GetHandle(), 0, VK_WHOLE_SIZE };
+
+			VkWriteDescriptorSet write{};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = vk_descriptor_set;
+			write.dstBinding = 0;
+			write.dstArrayElement = 0;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write.pBufferInfo = &buffer_info;
+
+			vkUpdateDescriptorSets(global.logical_device, 1, &write, 0, nullptr);
+		}
 	}
 
-	void /*Scene::*/Scene::Update(int frame_index)
+	int /*Scene::*/Scene::Update(int frame_index)
 	{
 		debug_geometry_.Update();
-		UpdateAndTryFillWrites(frame_index);
+		UpdateLods();
+		int writes_cnt = UpdateModelMatrices(frame_index);
+		writes_cnt += skinning_cache_.Update(frame_index, models_, models_version_);
+		return writes_cnt + UpdateAndTryFillWrites(frame_index);
+	}
+
+	const Scene::LodStats& Scene::GetLodStats() const
+	{
+		return lod_stats_;
+	}
+
+	void Scene::BeginFrame(uint32_t frame_index)
+	{
+		// the frame fence is signaled, the counters of the frame are complete and not in use
+		auto&& stats_buffer = light_culling_stats_buffers_[frame_index];
+
+		stats_buffer.ReadData(&light_culling_stats_, sizeof(LightCullingStats));
+
+		LightCullingStats cleared{};
+		stats_buffer.LoadData(&cleared, sizeof(LightCullingStats));
+	}
+
+	const Scene::LightCullingStats& Scene::GetLightCullingStats() const
+	{
+		return light_culling_stats_;
+	}
+
+	void Scene::UpdateLods()
+	{
+		glm::vec3 camera_position;
+		glm::mat4 view;
+		glm::mat4 proj;
+
+		GetCameraViewProj(camera_position, view, proj);
+
+		lod_stats_ = {};
+
+		for (auto&& model : models_)
+		{
+			glm::mat4 model_matrix = model.node ? model.node->GetGlobalTransformMatrix() : glm::identity<glm::mat4>();
+
+			model.primitive_lods.resize(model.mesh->primitives.size(), 0);
+
+			for (uint32_t primitive_index = 0; primitive_index < model.mesh->primitives.size(); primitive_index++)
+			{
+				const primitive::Base& primitive = std::visit([](auto&& primitive) -> const primitive::Base& { return primitive; }, model.mesh->primitives[primitive_index]);
+				uint32_t& lod = model.primitive_lods[primitive_index];
+
+				lod = primitive.SelectLod(model_matrix, camera_position, std::abs(proj[1][1]), lod);
+
+				lod_stats_.full_detail_triangles += primitive.GetTrianglesCount(0);
+				lod_stats_.lod_triangles += primitive.GetTrianglesCount(lod);
+			}
+		}
 	}
 
 	bool /*Scene::*/Scene::FillData(render::DescriptorSet<render::DescriptorSetType::kCameraPositionAndViewProjMat>::Binding<0>::Data& data)
+	{
+		glm::vec3 position;
+		glm::mat4 view;
+		glm::mat4 proj;
+
+		GetCameraViewProj(position, view, proj);
+
+		data.position = glm::vec4(position, 1);
+		data.proj_view_mat = proj * view;
+		data.inv_proj_view_mat = glm::inverse(data.proj_view_mat);
+
+		return true;
+	}
+
+	int Scene::UpdateModelMatrices(int frame_index)
+	{
+		uint64_t models_version = GetModelsVersion();
+
+		if (models_version != model_matrices_version_)
+		{
+			model_matrices_version_ = models_version;
+			model_matrices_.clear();
+
+			for (auto&& model : models_)
+			{
+				model.object_index = u32(model_matrices_.size());
+				model_matrices_.push_back((model.node ? model.node->GetGlobalTransformMatrix() : glm::identity<glm::mat4>()) * model.mesh->dequantization);
+			}
+		}
+
+		if (model_matrix_uploaded_versions_[frame_index] == model_matrices_version_)
+			return 0;
+
+		int writes_cnt = 0;
+
+		auto&& buffer = model_matrix_buffers_[frame_index];
+		size_t matrices_bytes = model_matrices_.size() * sizeof(glm::mat4);
+
+		// the replaced buffer is destroyed once the frames using it are complete
+		if (!buffer || buffer->GetSize() < matrices_bytes)
+		{
+			buffer.emplace(global_, std::max(matrices_bytes, buffer ? 2 * buffer->GetSize() : sizeof(glm::mat4)));
+
+			VkDescriptorBufferInfo buffer_info{ buffer->GetHandle(), 0, VK_WHOLE_SIZE };
+
+			VkWriteDescriptorSet write{};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = descriptor_sets_per_frame_[frame_index].at(DescriptorSetType::kModelMatrix);
+			write.dstBinding = 0;
+			write.dstArrayElement = 0;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write.pBufferInfo = &buffer_info;
+
+			vkUpdateDescriptorSets(global_.logical_device, 1, &write, 0, nullptr);
+			writes_cnt++;
+		}
+
+		buffer->LoadData(model_matrices_.data(), matrices_bytes);
+		global_.uploaded_bytes += matrices_bytes;
+
+		model_matrix_uploaded_versions_[frame_index] = model_matrices_version_;
+
+		return writes_cnt;
+	}
+
+	uint64_t Scene::GetDataVersion(std::type_identity<render::DescriptorSet<render::DescriptorSetType::kCameraPositionAndViewProjMat>::Binding<0>::Data>) const
+	{
+		return GetCameraVersion();
+	}
+
+	uint64_t Scene::GetDataVersion(std::type_identity<render::DescriptorSet<render::DescriptorSetType::kShadowCubeViewProj>::Binding<0>::Data>) const
+	{
+		return std::max(GetLightsVersion(), GetCameraVersion());
+	}
+
+	uint64_t Scene::GetDataVersion(std::type_identity<render::DescriptorSet<render::DescriptorSetType::kLights>::Binding<0>::Data>) const
+	{
+		return GetLightsVersion();
+	}
+
+	uint64_t Scene::GetDataVersion(std::type_identity<render::DescriptorSet<render::DescriptorSetType::kLights>::Binding<1>::Data>) const
+	{
+		return GetCameraVersion();
+	}
+
+	void Scene::SetCameraNode(NodeId id)
+	{
+		camera_node_id_ = id;
+		camera_version_ = NextDataVersion();
+	}
+
+	void Scene::SetAspect(float aspect)
+	{
+		aspect_ = aspect;
+		camera_version_ = NextDataVersion();
+	}
+
+	uint64_t Scene::GetCameraVersion() const
 	{
+		if (camera_node_id_.Valid())
+			return std::max(camera_version_, nodes_.Get(camera_node_id_).GetVersion());
+
+		return camera_version_;
+	}
+
+	uint64_t Scene::GetModelsVersion() const
+	{
+		return std::max(models_version_, *model_nodes_version_);
+	}
+
+	uint64_t Scene::GetLightsVersion() const
+	{
+		uint64_t version = lights_version_;
+
+		for (auto&& light : lights_.GetData())
+		{
+			version = std::max(version, light.node->GetVersion());
+		}
+
+		return version;
+	}
+
+	void Scene::GetCameraViewProj(glm::vec3& position, glm::mat4& view, glm::mat4& proj)
+	{
+		glm::vec3 orientation;
+
 		if (camera_node_id_.Valid())
 		{
 			auto&& camera_node = nodes_.Get(camera_node_id_);
 
-			data.position = camera_node.local_transform[3];
+			position = camera_node.GetLocalTransform()[3];
 
-			auto rotation = glm::quat_cast(camera_node.local_transform);
+			auto rotation = glm::quat_cast(camera_node.GetLocalTransform());
 
-			glm::vec3 orientation = glm::rotate(rotation, glm::vec3(0, 1, 0));
+			orientation = glm::rotate(rotation, glm::vec3(0, 1, 0));
 
-			glm::mat4 proj = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 200.0f);
-			proj[1][1] *= -1;
-			data.proj_view_mat = proj * glm::lookAt(glm::vec3(data.position), glm::vec3(data.position) + orientation, glm::vec3(0.0f, 0.0f, 1.0f));
+			proj = glm::perspective(glm::radians(45.0f), aspect_, kCameraNearPlane, kCameraFarPlane);
 		}
 		else
 		{
-			glm::vec3 position = glm::vec3(1, 1, 2);
-
-			data.position = glm::vec4(position, 1);
+			position = glm::vec3(1, 1, 2);
 
-			glm::vec3 orientation = glm::normalize(glm::vec3(-1, -1, -2));
+			orientation = glm::normalize(glm::vec3(-1, -1, -2));
 
-			glm::mat4 proj = glm::perspective(glm::radians(45.0f), 1.5f, 0.1f, 200.0f);
-			proj[1][1] *= -1;
-			data.proj_view_mat = proj * glm::lookAt(position, position + orientation, glm::vec3(0.0f, 0.0f, 1.0f));
+			proj = glm::perspective(glm::radians(45.0f), 1.5f, kCameraNearPlane, kCameraFarPlane);
 		}
 
-		return true;
+		proj[1][1] *= -1;
+		view = glm::lookAt(position, position + orientation, glm::vec3(0.0f, 0.0f, 1.0f));
 	}
 
-	bool Scene::FillData(render::DescriptorSet<render::DescriptorSetType::kShadowCubeViewProj>::Binding<0>::Data& data)
+	glm::mat4 Scene::GetShadowCubeFaceView(uint32_t face)
 	{
+		static const std::array<glm::mat4, 6> kFaceViews =
+		{
+			glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f),	glm::vec3(0.0f, 0.0f, 1.0f)), // +X
+			glm::lookAt(glm::vec3(0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),	glm::vec3(0.0f, 0.0f, 1.0f)), // -X
+			glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f),	glm::vec3(0.0f, -1.0f, 0.0f)), // +Y
+			glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),	glm::vec3(0.0f, 1.0f, 0.0f)), // -Y
+			glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f),	glm::vec3(0.0f, 0.0f, 1.0f)), // +Z
+			glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, -1.0f, 0.0f),	glm::vec3(0.0f, 0.0f, 1.0f)), // -Z
+		};
 
-		data.cube_views[0] = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f),	glm::vec3(0.0f, 0.0f, 1.0f)); // +X
-		data.cube_views[1] = glm::lookAt(glm::vec3(0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),	glm::vec3(0.0f, 0.0f, 1.0f)); // -X
-		data.cube_views[2] = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f),	glm::vec3(0.0f, -1.0f, 0.0f)); // +Y
-		data.cube_views[3] = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),	glm::vec3(0.0f, 1.0f, 0.0f)); // -Y
-		data.cube_views[4] = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f),	glm::vec3(0.0f, 0.0f, 1.0f)); // +Z
-		data.cube_views[5] = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, -1.0f, 0.0f),	glm::vec3(0.0f, 0.0f, 1.0f)); // -Z
+		return kFaceViews[face];
+	}
 
-		data.cube_proj = glm::perspective(glm::radians(90.0f), 1.0f, 0.01f, 200.f);
-		data.cube_proj[1][1] *= -1;
-		//data.cube_proj[0][0] *= -1;
+	glm::mat4 Scene::GetShadowCubeProj()
+	{
+		glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1.0f, kShadowCubeNearPlane, kShadowCubeFarPlane);
+		proj[1][1] *= -1;
+		return proj;
+	}
 
+	const std::vector<glm::vec3>& Scene::GetShadowCubePositions() const
+	{
+		return shadow_cube_positions_;
+	}
 
-		data.positions[0] = glm::vec4(0.f, 0.f, 1.f, 1.f);
-		data.positions[1] = glm::vec4(0.f, -1.f, 2.f, 1.f);
+	bool Scene::FillData(render::DescriptorSet<render::DescriptorSetType::kShadowCubeViewProj>::Binding<0>::Data& data)
+	{
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			data.cube_views[face] = GetShadowCubeFaceView(face);
+		}
+
+		data.cube_proj = GetShadowCubeProj();
 
 		data.mask = 0;
-		data.mask |= 0x1;
-		data.mask |= 0x2;
+		shadow_cube_positions_.clear();
 
-		if (camera_node_id_.Valid())
+		for (auto&& light : lights_)
+		{
+			if (shadow_cube_positions_.size() == kShadowCubesCount)
+				break;
+
+			if (!light.cast_shadows)
+				continue;
+
+			uint32_t shadow_cube_index = u32(shadow_cube_positions_.size());
+
+			data.positions[shadow_cube_index] = light.node->GetGlobalTransformMatrix()[3];
+			data.positions[shadow_cube_index].w = 1.0f;
+			data.mask |= 1 << shadow_cube_index;
+			shadow_cube_positions_.push_back(glm::vec3(data.positions[shadow_cube_index]));
+		}
+
+		if (camera_node_id_.Valid() && shadow_cube_positions_.size() < kShadowCubesCount)
 		{
 			auto&& camera_node = nodes_.Get(camera_node_id_);
 
-			data.mask |= 0x4;
-			data.positions[2] = camera_node.local_transform[3];
-			data.positions[2].w = 0.5f;
-			data.positions[2].z -= 0.5f;
+			uint32_t shadow_cube_index = u32(shadow_cube_positions_.size());
+
+			data.mask |= 1 << shadow_cube_index;
+			data.positions[shadow_cube_index] = camera_node.GetLocalTransform()[3];
+			data.positions[shadow_cube_index].w = 0.5f;
+			data.positions[shadow_cube_index].z -= 0.5f;
+			shadow_cube_positions_.push_back(glm::vec3(data.positions[shadow_cube_index]));
 		}
 
 		return true;
@@ -455,6 +702,43 @@ namespace render
 		return true;
 	}
 
+	bool Scene::FillData(render::DescriptorSet<render::DescriptorSetType::kLights>::Binding<0>::Data& data)
+	{
+		uint32_t light_index = 0;
+
+		for (auto&& light : lights_)
+		{
+			if (light_index == kMaxLightsCount)
+				break;
+
+			data.lights[light_index].position_radius = glm::vec4(glm::vec3(light.node->GetGlobalTransformMatrix()[3]), light.radius);
+			data.lights[light_index].color_intensity = glm::vec4(light.color, light.intensity);
+			light_index++;
+		}
+
+		data.count = light_index;
+
+		return true;
+	}
+
+	size_t Scene::GetFilledSize(const render::DescriptorSet<render::DescriptorSetType::kLights>::Binding<0>::Data& data) const
+	{
+		return sizeof(data.count) + sizeof(data.padding) + data.count * sizeof(LightData);
+	}
+
+	bool Scene::FillData(render::DescriptorSet<render::DescriptorSetType::kLights>::Binding<1>::Data& data)
+	{
+		glm::vec3 position;
+		glm::mat4 proj;
+
+		GetCameraViewProj(position, data.view, proj);
+
+		data.projection_params = glm::vec4(1.0f / proj[0][0], 1.0f / proj[1][1], kCameraNearPlane, kCameraFarPlane);
+		data.grid_size = glm::uvec4(kLightClusterGridX, kLightClusterGridY, kLightClusterGridZ, kMaxLightsPerCluster);
+
+		return true;
+	}
+
 	NodeId Scene::AddNode()
 	{
 		return nodes_.Add();
@@ -478,15 +762,45 @@ namespace render
 
 	RenderModelId Scene::AddModel(Node& node, Mesh& mesh)
 	{
-		RenderModel model(global_, desc_set_manager_, node, mesh);
+		models_version_ = NextDataVersion();
+		node.SetVersionSink(model_nodes_version_);
+
+		RenderModel model(node, mesh);
 		return models_.Add(std::move(model));
 	}
 
+	RenderModelId Scene::AddSkinnedModel(Node& node, Mesh& mesh, const Skin& skin, std::vector<byes::RTM<Node>> joints, Node& skin_node)
+	{
+		if (joints.size() != skin.inverse_bind_matrices.size())
+			throw std::runtime_error("failed to add skinned model, joints do not match the skin");
+
+		models_version_ = NextDataVersion();
+		node.SetVersionSink(model_nodes_version_);
+
+		RenderModel model(node, mesh);
+		model.skin = skin;
+		model.joints = std::move(joints);
+		model.skin_node = skin_node;
+		return models_.Add(std::move(model));
+	}
+
+	const SkinningCache& Scene::GetSkinningCache() const
+	{
+		return skinning_cache_;
+	}
+
 	void Scene::RemoveModel(RenderModelId id)
 	{
+		models_version_ = NextDataVersion();
 		models_.Remove(id);
 	}
 
+	LightId Scene::AddLight(Node& node, glm::vec3 color, float intensity, float radius, bool cast_shadows)
+	{
+		lights_version_ = NextDataVersion();
+		return lights_.Add(Light{ byes::RTM<Node>(node), color, intensity, radius, cast_shadows });
+	}
+
 	//void Scene::AddCamera()
 	//{
 	//	cameras_.push_back(Camera());
@@ -507,7 +821,7 @@ namespace render
 		debug_lines_vertex_cnt(0),
 		node(),
 		mesh{ "debug" },
-		model(global, manager, node, mesh)
+		model(node, mesh)
 	{
 		ready_to_write.store(true);
 		ready_to_read.store(false);
@@ -11,6 +11,7 @@
 #include "render/image_view.h"
 #include "render/mesh.h"
 #include "render/render_engine.h"
+#include "render/skinning.h"
 //#include "render/ui/ui.h"
 //#include "render/ui/panel.h"
 
@@ -60,18 +61,61 @@ namespace render
 		RenderModel model;
 	};
 
-	using SceneDescriptorSetHolder = descriptor_sets_holder::Holder<DescriptorSetType::kCameraPositionAndViewProjMat, DescriptorSetType::kShadowCubeViewProj, DescriptorSetType::kEnvironement>;
+	// parameters are fixed once added, scenes only version light nodes
+	struct Light
+	{
+		byes::RTM<Node> node;
+
+		glm::vec3 color;
+		float intensity;
+		float radius;
+
+		bool cast_shadows;
+	};
+
+	using LightId = util::container::ErVec<Light>::Id;
+
+	using SceneDescriptorSetHolder = descriptor_sets_holder::Holder<DescriptorSetType::kCameraPositionAndViewProjMat, DescriptorSetType::kShadowCubeViewProj, DescriptorSetType::kEnvironement, DescriptorSetType::kLights>;
 
 	class /*Scene::*/Scene : public SceneDescriptorSetHolder
 	{
 	public:
 		Scene(const Global& global, DescriptorSetsManager& manager, DebugGeometry& debug_geometry_);
 
-		void Update(int frame_index);
+		// returns the number of descriptor sets rewritten
+		int Update(int frame_index);
+
+		// triangles of the camera view at full detail and at the LODs picked by the last Update
+		struct LodStats
+		{
+			uint64_t full_detail_triangles = 0;
+			uint64_t lod_triangles = 0;
+		};
+
+		const LodStats& GetLodStats() const;
+
+		using LightCullingStats = DescriptorSet<DescriptorSetType::kLightCullingStats>::Binding<0>::Data;
+
+		// called once the frame fence is signaled, reads back and clears what light culling counted for the frame
+		void BeginFrame(uint32_t frame_index);
+
+		// counted by the last frame read back, lights beyond kMaxLightsPerCluster are not shaded in their cluster
+		const LightCullingStats& GetLightCullingStats() const;
 
 		bool FillData(render::DescriptorSet<render::DescriptorSetType::kCameraPositionAndViewProjMat>::Binding<0>::Data& data) override;
 		bool FillData(render::DescriptorSet<render::DescriptorSetType::kShadowCubeViewProj>::Binding<0>::Data& data) override;
 		bool FillData(render::DescriptorSet<render::DescriptorSetType::kEnvironement>::Binding<0>::Data& data) override;
+		bool FillData(render::DescriptorSet<render::DescriptorSetType::kLights>::Binding<0>::Data& data) override;
+		bool FillData(render::DescriptorSet<render::DescriptorSetType::kLights>::Binding<1>::Data& data) override;
+		size_t GetFilledSize(const render::DescriptorSet<render::DescriptorSetType::kLights>::Binding<0>::Data& data) const override;
+
+		uint64_t GetDataVersion(std::type_identity<render::DescriptorSet<render::DescriptorSetType::kCameraPositionAndViewProjMat>::Binding<0>::Data>) const override;
+		uint64_t GetDataVersion(std::type_identity<render::DescriptorSet<render::DescriptorSetType::kShadowCubeViewProj>::Binding<0>::Data>) const override;
+		uint64_t GetDataVersion(std::type_identity<render::DescriptorSet<render::DescriptorSetType::kLights>::Binding<0>::Data>) const override;
+		uint64_t GetDataVersion(std::type_identity<render::DescriptorSet<render::DescriptorSetType::kLights>::Binding<1>::Data>) const override;
+
+		void SetCameraNode(NodeId id);
+		void SetAspect(float aspect);
 
 		NodeId AddNode();
 		Node& AddNodeAndGet();
@@ -79,8 +123,24 @@ namespace render
 		void RemoveNode(NodeId id);
 
 		RenderModelId AddModel(Node& node, Mesh& mesh);
+		// joints are posed by the nodes given per skin joint, the mesh is skinned in the space of skin_node
+		RenderModelId AddSkinnedModel(Node& node, Mesh& mesh, const Skin& skin, std::vector<byes::RTM<Node>> joints, Node& skin_node);
 		void RemoveModel(RenderModelId);
 
+		const SkinningCache& GetSkinningCache() const;
+
+		LightId AddLight(Node& node, glm::vec3 color, float intensity, float radius, bool cast_shadows);
+
+		static constexpr uint32_t kShadowCubesCount = 10;
+		static constexpr float kShadowCubeNearPlane = 0.01f;
+		static constexpr float kShadowCubeFarPlane = 200.0f;
+
+		static glm::mat4 GetShadowCubeFaceView(uint32_t face);
+		static glm::mat4 GetShadowCubeProj();
+
+		// positions of the lights rendered into the shadow cube array, cube i occupies layers [6 * i, 6 * i + 6)
+		const std::vector<glm::vec3>& GetShadowCubePositions() const;
+
 		//void AddCamera();
 
 		Node viewport_node_;
@@ -89,13 +149,51 @@ namespace render
 
 		util::container::ErVec<Node> nodes_;
 		util::container::ErVec<RenderModel> models_;
+		util::container::ErVec<Light> lights_;
 		DebugGeometry& debug_geometry_;
 
+	private:
+
+		uint64_t GetCameraVersion() const;
+		uint64_t GetModelsVersion() const;
+		uint64_t GetLightsVersion() const;
+
 		NodeId camera_node_id_;
+		float aspect_;
 
-		float aspect;
+		// bumped when the camera, the model list or the light list changes, node versions are tracked by nodes
+		uint64_t camera_version_;
+		uint64_t models_version_;
+		uint64_t lights_version_;
+
+		// nodes of added models and their parents store their latest version here, nodes of removed models still do
+		std::shared_ptr<uint64_t> model_nodes_version_ = std::make_shared<uint64_t>(0);
+
+		// should match the planes used by light_culling.comp to slice clusters
+		const float kCameraNearPlane = 0.1f;
+		const float kCameraFarPlane = 200.0f;
+
+		void GetCameraViewProj(glm::vec3& position, glm::mat4& view, glm::mat4& proj);
+		void UpdateLods();
+
+		// returns the number of descriptor sets rewritten
+		int UpdateModelMatrices(int frame_index);
+
+		LodStats lod_stats_;
+
+		std::vector<StorageBuffer> light_culling_stats_buffers_;
+		LightCullingStats light_culling_stats_{};
+
+		SkinningCache skinning_cache_;
+
+		std::vector<glm::vec3> shadow_cube_positions_;
+
+		// kModelMatrix buffers grow by doubling with the model count, models index them with object_index
+		std::vector<glm::mat4> model_matrices_;
+		uint64_t model_matrices_version_ = 0;
+		std::array<std::optional<StorageBuffer>, kFramesCount> model_matrix_buffers_;
+		std::array<uint64_t, kFramesCount> model_matrix_uploaded_versions_{};
 
-	private:
 		GPULocalVertexBuffer viewport_vertex_buffer_;
 		/*Primitive viewport_primitive;*/
 		Image env_image_;
@@ -7,9 +7,9 @@
 
 #include "global.h"
 
-render::ShaderModule::ShaderModule(const Global& global, const std::string& shader_path, const std::array<DescriptorSetLayout, kDescriptorSetTypesCount>& descriptor_sets_layouts) : RenderObjBase(global)
+render::ShaderModule::ShaderModule(const Global& global, const std::string& shader_path, const std::array<DescriptorSetLayout, kDescriptorSetTypesCount>& descriptor_sets_layouts, const std::string& variant) : RenderObjBase(global)
 {
-	std::ifstream file("../shaders/" + shader_path + ".spv", std::ios::ate | std::ios::binary);
+	std::ifstream file("../shaders/" + shader_path + (variant.empty() ? "" : "." + variant) + ".spv", std::ios::ate | std::ios::binary);
 
 	if (!file.is_open()) {
 		throw std::runtime_error("failed to open file!");
@@ -44,6 +44,10 @@ render::ShaderModule::ShaderModule(const Global& global, const std::string& shad
 	{
 		shader_type_ = ShaderType::Fragment;
 	}
+	else if (shader_path.find("comp") != std::string::npos)
+	{
+		shader_type_ = ShaderType::Compute;
+	}
 	else
 	{
 		shader_type_ = ShaderType::Invalid;
@@ -115,6 +119,20 @@ void render::ShaderModule::FillInputDescsAndDescSets(const std::string& shader_p
 		{
 			processed_text >> token;
 
+			if ((token == "std430" || token == "std140") && !processed_text.eof())
+			{
+				processed_text >> token;
+			}
+
+			// input_attachment_index matches the binding index, "input attachment index N"
+			if (token == "input" && !processed_text.eof())
+			{
+				for (int i = 0; i < 4 && !processed_text.eof(); i++)
+				{
+					processed_text >> token;
+				}
+			}
+
 			if (token == "location" && !processed_text.eof())
 			{
 				processed_text >> token;
@@ -130,19 +148,23 @@ void render::ShaderModule::FillInputDescsAndDescSets(const std::string& shader_p
 						processed_text >> token;
 						std::string type = token;
 						std::string component;
-						std::string buffer_type_token;
 
-						if (!processed_text.eof())
+						processed_text >> token;
+
+						// component format comment before the name, "in uvec4 /*byte*/ inJoints"
+						if ((token == "byte" || token == "quantized") && !processed_text.eof())
 						{
+							component = token;
 							processed_text >> token;
-							buffer_type_token = token;
-							std::transform(buffer_type_token.begin(), buffer_type_token.end(), buffer_type_token.begin(), ::toupper);
 						}
 
-						if (!processed_text.eof())
+						// names are the vertex buffer type with the "in" prefix, "inTexCoord"
+						std::string buffer_type_token = token;
+						std::transform(buffer_type_token.begin(), buffer_type_token.end(), buffer_type_token.begin(), ::toupper);
+
+						if (buffer_type_token.starts_with("IN"))
 						{
-							processed_text >> token;
-							component = token;
+							buffer_type_token = buffer_type_token.substr(2);
 						}
 
 						auto&& vertex_buffer_names_to_types = GetVertexBufferNamesToTypes();
@@ -151,6 +173,19 @@ void render::ShaderModule::FillInputDescsAndDescSets(const std::string& shader_p
 
 						VertexBufferType buffer_type = vertex_buffer_names_to_types.at(buffer_type_token);
 
+						// quantized inputs share the bindings of their interleaved streams, the format comes from the stream layout
+						if (component == "quantized")
+						{
+							auto&& quantized_attribute = GetQuantizedVertexAttribute(buffer_type);
+
+							if (!quantized_attribute)
+								throw std::runtime_error("Unsupported quantized input type");
+
+							auto&& binding_desc = input_bindings_descs_[quantized_attribute->binding];
+							binding_desc.stride = quantized_attribute->stride;
+							binding_desc.attributes.emplace(location, VertexBindingAttributeDesc{ u32(quantized_attribute->format), quantized_attribute->offset, buffer_type });
+						}
+						else
 						if (type == "float")
 							input_bindings_descs_.emplace(location, VertexBindingDesc{ sizeof(float) * 1, { {location, VertexBindingAttributeDesc{VK_FORMAT_R32_SFLOAT, 0, buffer_type} } } });
 						else
@@ -207,11 +242,16 @@ void render::ShaderModule::FillInputDescsAndDescSets(const std::string& shader_p
 				{
 					processed_text >> token;
 
-					if (token == "uniform" && !processed_text.eof())
+					while ((token == "readonly" || token == "writeonly" || token == "restrict" || token == "coherent") && !processed_text.eof())
+					{
+						processed_text >> token;
+					}
+
+					if ((token == "uniform" || token == "buffer") && !processed_text.eof())
 					{
 						processed_text >> token;
 
-						if (token.find("sampler") == 0 && !processed_text.eof())
+						if ((token.find("sampler") == 0 || token.find("subpassInput") == 0) && !processed_text.eof())
 						{
 							processed_text >> token;
 						}
@@ -42,7 +42,8 @@ namespace render
 		//	std::vector<uint32_t> bindings_descs_types;
 		//};
 
-		ShaderModule(const Global& global, const std::string& shader_path, const std::array<DescriptorSetLayout, kDescriptorSetTypesCount>& descriptor_sets_layouts);
+		// variant selects "<shader_path>.<variant>.spv", built from the same source with a different set of defines
+		ShaderModule(const Global& global, const std::string& shader_path, const std::array<DescriptorSetLayout, kDescriptorSetTypesCount>& descriptor_sets_layouts, const std::string& variant = "");
 
 		ShaderModule(const ShaderModule&) = delete;
 		ShaderModule(ShaderModule&&) = default;
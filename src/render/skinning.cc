@@ -0,0 +1,285 @@
+#include "skinning.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "render/descriptor_sets_manager.h"
+
+#include "global.h"
+
+namespace render
+{
+	namespace
+	{
+		// cache streams start at 16 bytes, like the pack arena streams
+		const size_t kCacheStreamAlignment = 16;
+
+		size_t AlignCacheOffset(size_t offset)
+		{
+			return (offset + kCacheStreamAlignment - 1) / kCacheStreamAlignment * kCacheStreamAlignment;
+		}
+
+		void FillStorageWrite(VkWriteDescriptorSet& write, VkDescriptorSet set, uint32_t binding, const VkDescriptorBufferInfo& buffer_info)
+		{
+			write = {};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = set;
+			write.dstBinding = binding;
+			write.dstArrayElement = 0;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write.pBufferInfo = &buffer_info;
+		}
+	}
+
+	SkinningCache::SkinningCache(const Global& global, DescriptorSetsManager& manager) :
+		RenderObjBase(global), manager_(&manager)
+	{
+		for (uint32_t frame_index = 0; frame_index < kFramesCount; frame_index++)
+		{
+			descriptor_sets_[frame_index].emplace(DescriptorSetType::kSkeleton, manager.GetFreeDescriptor(DescriptorSetType::kSkeleton));
+		}
+	}
+
+	int SkinningCache::Update(uint32_t frame_index, util::container::ErVec<RenderModel>& models, uint64_t models_version)
+	{
+		int writes_cnt = 0;
+
+		if (models_version != layout_version_)
+		{
+			layout_version_ = models_version;
+			writes_cnt += Layout(models);
+		}
+
+		joint_matrices_.clear();
+
+		for (auto&& model : models)
+		{
+			if (!model.skin)
+				continue;
+
+			glm::mat4 skin_space = glm::inverse(model.skin_node->GetGlobalTransformMatrix());
+			uint64_t pose_version = std::max(layout_version_, model.skin_node->GetVersion());
+
+			for (uint32_t joint_index = 0; joint_index < model.joints.size(); joint_index++)
+			{
+				joint_matrices_.push_back(skin_space * model.joints[joint_index]->GetGlobalTransformMatrix() * model.skin->inverse_bind_matrices[joint_index]);
+				pose_version = std::max(pose_version, model.joints[joint_index]->GetVersion());
+			}
+
+			model.skinned_version = pose_version;
+		}
+
+		joint_matrices_cnt_ = u32(joint_matrices_.size());
+
+		if (joint_matrices_.empty())
+			return writes_cnt;
+
+		auto&& joint_buffer = joint_buffers_[frame_index];
+		VkDescriptorSet set = descriptor_sets_[frame_index].at(DescriptorSetType::kSkeleton);
+
+		std::array<VkDescriptorBufferInfo, 2> buffer_infos{};
+		std::array<VkWriteDescriptorSet, 2> writes{};
+		uint32_t frame_writes_cnt = 0;
+
+		// grows by doubling, the replaced buffer is destroyed once the frames using it are complete
+		size_t joint_bytes = joint_matrices_.size() * sizeof(glm::mat4);
+
+		if (!joint_buffer || joint_buffer->GetSize() < joint_bytes)
+		{
+			joint_buffer.emplace(global_, std::max(joint_bytes, joint_buffer ? 2 * joint_buffer->GetSize() : joint_bytes));
+
+			buffer_infos[frame_writes_cnt] = { joint_buffer->GetHandle(), 0, VK_WHOLE_SIZE };
+			FillStorageWrite(writes[frame_writes_cnt], set, 0, buffer_infos[frame_writes_cnt]);
+			frame_writes_cnt++;
+		}
+
+		joint_buffer->LoadData(joint_matrices_.data(), joint_bytes);
+
+		if (!cache_buffer_bound_[frame_index])
+		{
+			buffer_infos[frame_writes_cnt] = { cache_buffer_->GetHandle(), 0, VK_WHOLE_SIZE };
+			FillStorageWrite(writes[frame_writes_cnt], set, 1, buffer_infos[frame_writes_cnt]);
+			frame_writes_cnt++;
+
+			cache_buffer_bound_[frame_index] = true;
+		}
+
+		if (frame_writes_cnt > 0)
+		{
+			vkUpdateDescriptorSets(global_.logical_device, frame_writes_cnt, writes.data(), 0, nullptr);
+			writes_cnt++;
+		}
+
+		return writes_cnt;
+	}
+
+	int SkinningCache::Layout(util::container::ErVec<RenderModel>& models)
+	{
+		int writes_cnt = 0;
+
+		dispatches_.clear();
+		skinned_vertices_cnt_ = 0;
+
+		size_t cache_size = 0;
+		uint32_t first_joint = 0;
+
+		struct PrimitiveRange
+		{
+			std::reference_wrapper<RenderModel> model;
+			uint32_t primitive_index;
+			size_t position_offset;
+			std::optional<size_t> normal_offset;
+			std::optional<size_t> tangent_offset;
+		};
+
+		std::vector<PrimitiveRange> ranges;
+
+		for (auto&& model : models)
+		{
+			model.skinned_vertex_buffers.clear();
+
+			if (!model.skin || model.joints.empty())
+				continue;
+
+			model.skinned_vertex_buffers.resize(model.mesh->primitives.size());
+
+			for (uint32_t primitive_index = 0; primitive_index < model.mesh->primitives.size(); primitive_index++)
+			{
+				auto&& geometry = std::get_if<primitive::Geometry>(&model.mesh->primitives[primitive_index]);
+
+				if (!geometry)
+					continue;
+
+				auto&& source = geometry->vertex_buffers;
+				auto&& position = source[u32(VertexBufferType::kPOSITION)];
+				auto&& normal = source[u32(VertexBufferType::kNORMAL)];
+				auto&& tangent = source[u32(VertexBufferType::kTANGENT)];
+				auto&& joints = source[u32(VertexBufferType::kJOINTS)];
+				auto&& weights = source[u32(VertexBufferType::kWEIGHTS)];
+
+				// skinned meshes are cooked with float streams, u8 or u16 joints and float weights
+				if (!position || !joints || !weights || position->stride != sizeof(glm::vec3) || weights->stride != sizeof(glm::vec4))
+					continue;
+
+				bool joints_16_bit = joints->stride == 4 * sizeof(uint16_t);
+				if (!joints_16_bit && joints->stride != 4 * sizeof(uint8_t))
+					continue;
+
+				// all streams are read through the kSkinningSource set of one buffer
+				VkBuffer source_buffer = position->buffer->GetHandle();
+
+				if (joints->buffer->GetHandle() != source_buffer || weights->buffer->GetHandle() != source_buffer || position->count == 0)
+					continue;
+
+				bool has_normals = normal && normal->stride == sizeof(glm::vec3) && normal->buffer->GetHandle() == source_buffer;
+				bool has_tangents = tangent && tangent->stride == sizeof(glm::vec4) && tangent->buffer->GetHandle() == source_buffer;
+
+				uint32_t vertex_count = u32(position->count);
+
+				PrimitiveRange range{ model, primitive_index, AlignCacheOffset(cache_size) };
+				cache_size = range.position_offset + vertex_count * sizeof(glm::vec3);
+
+				if (has_normals)
+				{
+					range.normal_offset = AlignCacheOffset(cache_size);
+					cache_size = *range.normal_offset + vertex_count * sizeof(glm::vec3);
+				}
+
+				if (has_tangents)
+				{
+					range.tangent_offset = AlignCacheOffset(cache_size);
+					cache_size = *range.tangent_offset + vertex_count * sizeof(glm::vec4);
+				}
+
+				SkinningPushConstants push_constants{};
+				push_constants.vertex_count = vertex_count;
+				push_constants.flags = (joints_16_bit ? SkinningPushConstants::kJoints16Bit : 0) | (has_normals ? SkinningPushConstants::kHasNormals : 0) | (has_tangents ? SkinningPushConstants::kHasTangents : 0);
+				push_constants.first_joint = first_joint;
+				push_constants.position_offset = u32(position->offset / sizeof(uint32_t));
+				push_constants.normal_offset = has_normals ? u32(normal->offset / sizeof(uint32_t)) : 0;
+				push_constants.tangent_offset = has_tangents ? u32(tangent->offset / sizeof(uint32_t)) : 0;
+				push_constants.joints_offset = u32(joints->offset / sizeof(uint32_t));
+				push_constants.weights_offset = u32(weights->offset / sizeof(uint32_t));
+				push_constants.skinned_position_offset = u32(range.position_offset / sizeof(float));
+				push_constants.skinned_normal_offset = u32(range.normal_offset.value_or(0) / sizeof(float));
+				push_constants.skinned_tangent_offset = u32(range.tangent_offset.value_or(0) / sizeof(float));
+
+				dispatches_.push_back({ source_buffer, push_constants });
+				ranges.push_back(range);
+
+				skinned_vertices_cnt_ += vertex_count;
+
+				if (source_descriptor_sets_.find(source_buffer) == source_descriptor_sets_.end())
+				{
+					VkDescriptorSet source_set = manager_->GetFreeDescriptor(DescriptorSetType::kSkinningSource);
+					source_descriptor_sets_[source_buffer].emplace(DescriptorSetType::kSkinningSource, source_set);
+
+					VkDescriptorBufferInfo buffer_info{ source_buffer, 0, VK_WHOLE_SIZE };
+					VkWriteDescriptorSet write;
+					FillStorageWrite(write, source_set, 0, buffer_info);
+
+					vkUpdateDescriptorSets(global_.logical_device, 1, &write, 0, nullptr);
+					writes_cnt++;
+				}
+			}
+
+			first_joint += u32(model.joints.size());
+		}
+
+		if (!cache_buffer_ || cache_buffer_->GetSize() < cache_size)
+		{
+			// the replaced buffer is destroyed once the frames drawing from it are complete, every frame set is rebound
+			cache_buffer_.emplace(global_, std::max(cache_size, cache_buffer_ ? 2 * cache_buffer_->GetSize() : kCacheStreamAlignment), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+			cache_buffer_bound_.fill(false);
+		}
+
+		for (auto&& range : ranges)
+		{
+			RenderModel& model = range.model;
+			auto&& skinned_vertex_buffers = model.skinned_vertex_buffers[range.primitive_index];
+			auto&& source = std::get<primitive::Geometry>(model.mesh->primitives[range.primitive_index]).vertex_buffers;
+
+			size_t vertex_count = source[u32(VertexBufferType::kPOSITION)]->count;
+
+			skinned_vertex_buffers[u32(VertexBufferType::kPOSITION)].emplace(*cache_buffer_, sizeof(glm::vec3), range.position_offset, vertex_count);
+
+			if (range.normal_offset)
+			{
+				skinned_vertex_buffers[u32(VertexBufferType::kNORMAL)].emplace(*cache_buffer_, sizeof(glm::vec3), *range.normal_offset, vertex_count);
+			}
+
+			if (range.tangent_offset)
+			{
+				skinned_vertex_buffers[u32(VertexBufferType::kTANGENT)].emplace(*cache_buffer_, sizeof(glm::vec4), *range.tangent_offset, vertex_count);
+			}
+		}
+
+		return writes_cnt;
+	}
+
+	const std::vector<SkinningCache::Dispatch>& SkinningCache::GetDispatches() const
+	{
+		return dispatches_;
+	}
+
+	const std::map<DescriptorSetType, VkDescriptorSet>& SkinningCache::GetDescriptorSets(uint32_t frame_index) const
+	{
+		return descriptor_sets_[frame_index];
+	}
+
+	const std::map<DescriptorSetType, VkDescriptorSet>& SkinningCache::GetSourceDescriptorSets(VkBuffer source) const
+	{
+		return source_descriptor_sets_.at(source);
+	}
+
+	uint32_t SkinningCache::GetSkinnedVerticesCount() const
+	{
+		return skinned_vertices_cnt_;
+	}
+
+	uint32_t SkinningCache::GetJointMatricesCount() const
+	{
+		return joint_matrices_cnt_;
+	}
+}
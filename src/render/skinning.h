@@ -0,0 +1,105 @@
+#ifndef RENDER_ENGINE_RENDER_SKINNING_H_
+#define RENDER_ENGINE_RENDER_SKINNING_H_
+
+#include <array>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "common.h"
+#include "render/buffer.h"
+#include "render/descriptor_set.h"
+#include "render/mesh.h"
+#include "render/object_base.h"
+
+namespace render
+{
+	class DescriptorSetsManager;
+
+	// should match local_size_x of skinning.comp
+	const uint32_t kSkinningGroupSize = 64;
+
+	// should match the push constants of skinning.comp, offsets are in 4 byte elements of the source and cache buffers
+	struct SkinningPushConstants
+	{
+		enum Flags : uint32_t
+		{
+			kJoints16Bit = 1,
+			kHasNormals = 2,
+			kHasTangents = 4
+		};
+
+		uint32_t vertex_count;
+		uint32_t flags;
+		uint32_t first_joint;
+
+		uint32_t position_offset;
+		uint32_t normal_offset;
+		uint32_t tangent_offset;
+		uint32_t joints_offset;
+		uint32_t weights_offset;
+
+		uint32_t skinned_position_offset;
+		uint32_t skinned_normal_offset;
+		uint32_t skinned_tangent_offset;
+	};
+
+	// Skinned positions, normals and tangents of every skinned model, written once per frame by the skinning pass
+	// and drawn by the G-buffer and shadow cube passes instead of the mesh streams.
+	// Joint matrices go to a kSkeleton buffer per frame, both buffers grow with the skinned models, there is no joint limit.
+	class SkinningCache : public RenderObjBase<void*>
+	{
+	public:
+
+		// one per skinned primitive, source is the pack geometry buffer read through its kSkinningSource set
+		struct Dispatch
+		{
+			VkBuffer source;
+			SkinningPushConstants push_constants;
+		};
+
+		SkinningCache(const Global& global, DescriptorSetsManager& manager);
+
+		SkinningCache(const SkinningCache&) = delete;
+		SkinningCache(SkinningCache&&) = default;
+
+		SkinningCache& operator=(const SkinningCache&) = delete;
+		SkinningCache& operator=(SkinningCache&&) = default;
+
+		// Lays the cache out again when models_version changes, the streams of skinned models point into it.
+		// Fills the joint matrices of the frame, returns the number of descriptor sets rewritten.
+		int Update(uint32_t frame_index, util::container::ErVec<RenderModel>& models, uint64_t models_version);
+
+		const std::vector<Dispatch>& GetDispatches() const;
+
+		const std::map<DescriptorSetType, VkDescriptorSet>& GetDescriptorSets(uint32_t frame_index) const;
+		const std::map<DescriptorSetType, VkDescriptorSet>& GetSourceDescriptorSets(VkBuffer source) const;
+
+		uint32_t GetSkinnedVerticesCount() const;
+		uint32_t GetJointMatricesCount() const;
+
+	private:
+
+		// returns the number of descriptor sets written
+		int Layout(util::container::ErVec<RenderModel>& models);
+
+		DescriptorSetsManager* manager_;
+
+		uint64_t layout_version_ = 0;
+		std::vector<Dispatch> dispatches_;
+		uint32_t skinned_vertices_cnt_ = 0;
+		uint32_t joint_matrices_cnt_ = 0;
+
+		std::optional<GPULocalBuffer> cache_buffer_;
+		std::array<bool, kFramesCount> cache_buffer_bound_{};
+
+		std::array<std::optional<StorageBuffer>, kFramesCount> joint_buffers_;
+		std::vector<glm::mat4> joint_matrices_;
+
+		std::array<std::map<DescriptorSetType, VkDescriptorSet>, kFramesCount> descriptor_sets_;
+		std::map<VkBuffer, std::map<DescriptorSetType, VkDescriptorSet>> source_descriptor_sets_;
+	};
+}
+#endif  // RENDER_ENGINE_RENDER_SKINNING_H_
@@ -6,7 +6,7 @@
 #include "global.h"
 #include "surface.h"
 
-render::Swapchain::Swapchain(const Global& global, const Surface& surface) : RenderObjBase(global), extent_(), format_()
+render::Swapchain::Swapchain(const Global& global, const Surface& surface, VkSwapchainKHR old_swapchain) : RenderObjBase(global), extent_(), format_()
 {
 	VkSurfaceCapabilitiesKHR capabilities;
 	VkBool32 device_surface_support;
@@ -25,7 +25,6 @@ render::Swapchain::Swapchain(const Global& global, const Surface& surface) : Ren
 			format_ = surface_format.format;
 
 			VkSwapchainCreateInfoKHR create_info{};
-			VkSwapchainKHR old_swapchain = nullptr;
 
 			create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
 			create_info.pNext = nullptr;
@@ -94,6 +93,13 @@ render::Swapchain::~Swapchain()
 
 	if (handle_ != VK_NULL_HANDLE)
 	{
-		vkDestroySwapchainKHR(global_.logical_device, handle_, nullptr);
+		if (!deferred_delete_)
+		{
+			vkDestroySwapchainKHR(global_.logical_device, handle_, nullptr);
+		}
+		else
+		{
+			global_.delete_list.push_back({ global_.frame_ind, handle_ });
+		}
 	}
 }
\ No newline at end of file
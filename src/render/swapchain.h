@@ -16,7 +16,7 @@ namespace render
 	class Swapchain : public RenderObjBase<VkSwapchainKHR>
 	{
 	public:
-		Swapchain(const Global& device, const Surface& surface);
+		Swapchain(const Global& device, const Surface& surface, VkSwapchainKHR old_swapchain = VK_NULL_HANDLE);
 
 		Swapchain(const Swapchain&) = delete;
 		Swapchain(Swapchain&&) = default;
@@ -32,6 +32,8 @@ namespace render
 		const ImageView& GetImageView(size_t index) const;
 
 		virtual ~Swapchain() override;
+
+		bool deferred_delete_ = false;
 	private:
 
 		Extent extent_;
@@ -0,0 +1,402 @@
+#include "tangents.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define RENDER_ENGINE_TANGENTS_SSE
+#include <immintrin.h>
+#endif
+
+namespace render
+{
+	namespace
+	{
+		// texture coordinate area below which a face has no usable tangent direction
+		const float kMinUVDeterminant = 1e-12f;
+		const float kMinTangentLength2 = 1e-12f;
+
+		const uint32_t kNoGroup = ~0u;
+
+		// unnormalized directions of increasing u and v on the face, zero for degenerate texture coordinates
+		void ComputeFace(const glm::vec3& e1, const glm::vec3& e2, const glm::vec2& duv1, const glm::vec2& duv2, glm::vec3& tangent, glm::vec3& bitangent)
+		{
+			float det = duv1.x * duv2.y - duv2.x * duv1.y;
+
+			if (std::abs(det) <= kMinUVDeterminant)
+			{
+				tangent = glm::vec3(0);
+				bitangent = glm::vec3(0);
+				return;
+			}
+
+			float r = 1.0f / det;
+			tangent = (e1 * duv2.y - e2 * duv1.y) * r;
+			bitangent = (e2 * duv1.x - e1 * duv2.x) * r;
+		}
+
+		glm::vec3 NormalizeOrZero(const glm::vec3& value)
+		{
+			float length2 = glm::dot(value, value);
+			return length2 > kMinTangentLength2 ? value / std::sqrt(length2) : glm::vec3(0);
+		}
+
+		glm::vec3 ProjectOnPlane(const glm::vec3& value, const glm::vec3& normal)
+		{
+			return NormalizeOrZero(value - normal * glm::dot(normal, value));
+		}
+
+		glm::vec4 FinishTangent(const glm::vec3& normal, const glm::vec3& tangent, bool orientation)
+		{
+			glm::vec3 t = ProjectOnPlane(tangent, normal);
+
+			if (glm::dot(t, t) == 0.0f)
+			{
+				t = glm::normalize(glm::cross(normal, std::abs(normal.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0)));
+			}
+
+			return glm::vec4(t, orientation ? 1.0f : -1.0f);
+		}
+
+		// vertices are welded by the bits of their attributes, like MikkTSpace does
+		struct VertexKey
+		{
+			std::array<uint32_t, 8> bits;
+
+			bool operator==(const VertexKey& rhs) const = default;
+		};
+
+		struct VertexKeyHash
+		{
+			size_t operator()(const VertexKey& key) const
+			{
+				size_t result = 0;
+				for (uint32_t value : key.bits)
+				{
+					result ^= std::hash<uint32_t>()(value) + 0x9e3779b9 + (result << 6) + (result >> 2);
+				}
+				return result;
+			}
+		};
+
+		std::vector<uint32_t> WeldVertices(std::span<const glm::vec3> positions, std::span<const glm::vec3> normals, std::span<const glm::vec2> uvs)
+		{
+			std::vector<uint32_t> welded(positions.size());
+			std::unordered_map<VertexKey, uint32_t, VertexKeyHash> first_vertices;
+			first_vertices.reserve(positions.size());
+
+			for (uint32_t vertex = 0; vertex < positions.size(); vertex++)
+			{
+				VertexKey key{ {
+					std::bit_cast<uint32_t>(positions[vertex].x), std::bit_cast<uint32_t>(positions[vertex].y), std::bit_cast<uint32_t>(positions[vertex].z),
+					std::bit_cast<uint32_t>(normals[vertex].x), std::bit_cast<uint32_t>(normals[vertex].y), std::bit_cast<uint32_t>(normals[vertex].z),
+					std::bit_cast<uint32_t>(uvs[vertex].x), std::bit_cast<uint32_t>(uvs[vertex].y) } };
+
+				welded[vertex] = first_vertices.emplace(key, vertex).first->second;
+			}
+
+			return welded;
+		}
+
+		uint32_t FindGroup(std::vector<uint32_t>& parents, uint32_t corner)
+		{
+			while (parents[corner] != corner)
+			{
+				parents[corner] = parents[parents[corner]];
+				corner = parents[corner];
+			}
+			return corner;
+		}
+
+#ifdef RENDER_ENGINE_TANGENTS_SSE
+		struct Vec3x4
+		{
+			__m128 x;
+			__m128 y;
+			__m128 z;
+		};
+
+		Vec3x4 Load(const glm::vec3* values, const uint32_t* indices)
+		{
+			return {
+				_mm_setr_ps(values[indices[0]].x, values[indices[1]].x, values[indices[2]].x, values[indices[3]].x),
+				_mm_setr_ps(values[indices[0]].y, values[indices[1]].y, values[indices[2]].y, values[indices[3]].y),
+				_mm_setr_ps(values[indices[0]].z, values[indices[1]].z, values[indices[2]].z, values[indices[3]].z) };
+		}
+
+		Vec3x4 Sub(const Vec3x4& lhs, const Vec3x4& rhs)
+		{
+			return { _mm_sub_ps(lhs.x, rhs.x), _mm_sub_ps(lhs.y, rhs.y), _mm_sub_ps(lhs.z, rhs.z) };
+		}
+
+		Vec3x4 Mul(const Vec3x4& lhs, __m128 rhs)
+		{
+			return { _mm_mul_ps(lhs.x, rhs), _mm_mul_ps(lhs.y, rhs), _mm_mul_ps(lhs.z, rhs) };
+		}
+
+		// 4 faces, corners gathered into separate lanes
+		void ComputeFaces(const uint32_t* face_indices, std::span<const glm::vec3> positions, std::span<const glm::vec2> uvs, glm::vec3* tangents, glm::vec3* bitangents)
+		{
+			std::array<std::array<uint32_t, 4>, 3> corners;
+
+			for (uint32_t lane = 0; lane < 4; lane++)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					corners[corner][lane] = face_indices[lane * 3 + corner];
+				}
+			}
+
+			Vec3x4 p0 = Load(positions.data(), corners[0].data());
+			Vec3x4 e1 = Sub(Load(positions.data(), corners[1].data()), p0);
+			Vec3x4 e2 = Sub(Load(positions.data(), corners[2].data()), p0);
+
+			auto&& uv = [&uvs, &corners](uint32_t corner, uint32_t component)
+				{
+					return _mm_setr_ps(uvs[corners[corner][0]][component], uvs[corners[corner][1]][component], uvs[corners[corner][2]][component], uvs[corners[corner][3]][component]);
+				};
+
+			__m128 du1 = _mm_sub_ps(uv(1, 0), uv(0, 0));
+			__m128 dv1 = _mm_sub_ps(uv(1, 1), uv(0, 1));
+			__m128 du2 = _mm_sub_ps(uv(2, 0), uv(0, 0));
+			__m128 dv2 = _mm_sub_ps(uv(2, 1), uv(0, 1));
+
+			__m128 det = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+			__m128 abs_det = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+			__m128 valid = _mm_cmpgt_ps(abs_det, _mm_set1_ps(kMinUVDeterminant));
+
+			// faces with degenerate texture coordinates get zero directions
+			__m128 r = _mm_and_ps(valid, _mm_div_ps(_mm_set1_ps(1.0f), _mm_or_ps(det, _mm_andnot_ps(valid, _mm_set1_ps(1.0f)))));
+
+			Vec3x4 face_tangent = Mul(Sub(Mul(e1, dv2), Mul(e2, dv1)), r);
+			Vec3x4 face_bitangent = Mul(Sub(Mul(e2, du1), Mul(e1, du2)), r);
+
+			alignas(16) float tangent_lanes[3][4];
+			alignas(16) float bitangent_lanes[3][4];
+
+			_mm_store_ps(tangent_lanes[0], face_tangent.x);
+			_mm_store_ps(tangent_lanes[1], face_tangent.y);
+			_mm_store_ps(tangent_lanes[2], face_tangent.z);
+			_mm_store_ps(bitangent_lanes[0], face_bitangent.x);
+			_mm_store_ps(bitangent_lanes[1], face_bitangent.y);
+			_mm_store_ps(bitangent_lanes[2], face_bitangent.z);
+
+			for (uint32_t lane = 0; lane < 4; lane++)
+			{
+				tangents[lane] = glm::vec3(tangent_lanes[0][lane], tangent_lanes[1][lane], tangent_lanes[2][lane]);
+				bitangents[lane] = glm::vec3(bitangent_lanes[0][lane], bitangent_lanes[1][lane], bitangent_lanes[2][lane]);
+			}
+		}
+#endif
+	}
+
+	GeneratedTangents GenerateTangents(std::span<const uint32_t> indices, std::span<const glm::vec3> positions, std::span<const glm::vec3> normals, std::span<const glm::vec2> uvs)
+	{
+		uint32_t vertices_count = u32(positions.size());
+
+		if (normals.size() < vertices_count || uvs.size() < vertices_count)
+			throw std::runtime_error("failed to generate tangents, vertex attributes are too short");
+
+		if (std::any_of(indices.begin(), indices.end(), [vertices_count](uint32_t index) { return index >= vertices_count; }))
+			throw std::runtime_error("failed to generate tangents, index is out of range");
+
+		uint32_t faces_count = u32(indices.size() / 3);
+		uint32_t corners_count = faces_count * 3;
+
+		std::vector<glm::vec3> face_tangents(faces_count);
+		std::vector<glm::vec3> face_bitangents(faces_count);
+
+		uint32_t face = 0;
+
+#ifdef RENDER_ENGINE_TANGENTS_SSE
+		for (; face + 4 <= faces_count; face += 4)
+		{
+			ComputeFaces(indices.data() + face * 3, positions, uvs, face_tangents.data() + face, face_bitangents.data() + face);
+		}
+#endif
+
+		for (; face < faces_count; face++)
+		{
+			uint32_t i0 = indices[face * 3];
+			uint32_t i1 = indices[face * 3 + 1];
+			uint32_t i2 = indices[face * 3 + 2];
+
+			ComputeFace(positions[i1] - positions[i0], positions[i2] - positions[i0], uvs[i1] - uvs[i0], uvs[i2] - uvs[i0], face_tangents[face], face_bitangents[face]);
+		}
+
+		// orientation of the texture space relative to the winding, mirrored islands flip it
+		std::vector<char> degenerate(faces_count);
+		std::vector<char> orientation(faces_count);
+
+		for (face = 0; face < faces_count; face++)
+		{
+			glm::vec3 normal = glm::cross(positions[indices[face * 3 + 1]] - positions[indices[face * 3]], positions[indices[face * 3 + 2]] - positions[indices[face * 3]]);
+
+			degenerate[face] = glm::dot(face_tangents[face], face_tangents[face]) <= kMinTangentLength2;
+			orientation[face] = glm::dot(glm::cross(face_tangents[face], face_bitangents[face]), normal) >= 0.0f;
+		}
+
+		std::vector<uint32_t> welded = WeldVertices(positions.first(vertices_count), normals.first(vertices_count), uvs.first(vertices_count));
+
+		// edges around each welded vertex, (other end, corner) sorted so corners sharing an edge are adjacent
+		std::vector<uint32_t> vertex_edges_offsets(vertices_count + 1, 0);
+
+		for (uint32_t corner = 0; corner < corners_count; corner++)
+		{
+			vertex_edges_offsets[welded[indices[corner]] + 1] += 2;
+		}
+
+		std::partial_sum(vertex_edges_offsets.begin(), vertex_edges_offsets.end(), vertex_edges_offsets.begin());
+
+		std::vector<std::pair<uint32_t, uint32_t>> vertex_edges(vertex_edges_offsets.back());
+		std::vector<uint32_t> vertex_edges_filled(vertex_edges_offsets.begin(), vertex_edges_offsets.end() - 1);
+
+		for (uint32_t corner = 0; corner < corners_count; corner++)
+		{
+			uint32_t first_corner = corner - corner % 3;
+			uint32_t vertex = welded[indices[corner]];
+
+			vertex_edges[vertex_edges_filled[vertex]++] = { welded[indices[first_corner + (corner + 1) % 3]], corner };
+			vertex_edges[vertex_edges_filled[vertex]++] = { welded[indices[first_corner + (corner + 2) % 3]], corner };
+		}
+
+		for (uint32_t vertex = 0; vertex < vertices_count; vertex++)
+		{
+			std::sort(vertex_edges.begin() + vertex_edges_offsets[vertex], vertex_edges.begin() + vertex_edges_offsets[vertex + 1]);
+		}
+
+		auto&& for_each_shared_edge = [&](auto&& callback)
+			{
+				for (uint32_t vertex = 0; vertex < vertices_count; vertex++)
+				{
+					for (uint32_t edge = vertex_edges_offsets[vertex]; edge + 1 < vertex_edges_offsets[vertex + 1]; edge++)
+					{
+						for (uint32_t other = edge + 1; other < vertex_edges_offsets[vertex + 1] && vertex_edges[other].first == vertex_edges[edge].first; other++)
+						{
+							callback(vertex_edges[edge].second, vertex_edges[other].second);
+						}
+					}
+				}
+			};
+
+		// faces without a texture space take the orientation of a neighbour, so they don't join mirrored groups
+		std::vector<std::vector<uint32_t>> face_neighbours(faces_count);
+		std::vector<uint32_t> known_faces;
+
+		for_each_shared_edge([&](uint32_t lhs, uint32_t rhs)
+			{
+				face_neighbours[lhs / 3].push_back(rhs / 3);
+				face_neighbours[rhs / 3].push_back(lhs / 3);
+			});
+
+		for (face = 0; face < faces_count; face++)
+		{
+			if (!degenerate[face])
+				known_faces.push_back(face);
+		}
+
+		std::vector<char> orientation_known(faces_count);
+		std::transform(degenerate.begin(), degenerate.end(), orientation_known.begin(), [](char value) { return char(!value); });
+
+		for (size_t i = 0; i < known_faces.size(); i++)
+		{
+			for (uint32_t neighbour : face_neighbours[known_faces[i]])
+			{
+				if (!orientation_known[neighbour])
+				{
+					orientation[neighbour] = orientation[known_faces[i]];
+					orientation_known[neighbour] = true;
+					known_faces.push_back(neighbour);
+				}
+			}
+		}
+
+		// corners of a vertex form one group per fan of faces with the same orientation
+		std::vector<uint32_t> groups(corners_count);
+		std::iota(groups.begin(), groups.end(), 0);
+
+		for_each_shared_edge([&](uint32_t lhs, uint32_t rhs)
+			{
+				if (lhs != rhs && orientation[lhs / 3] == orientation[rhs / 3])
+				{
+					groups[FindGroup(groups, lhs)] = FindGroup(groups, rhs);
+				}
+			});
+
+		// face directions projected on the vertex normal, weighted by the corner angle
+		std::vector<glm::vec3> group_tangents(corners_count, glm::vec3(0));
+
+		for (uint32_t corner = 0; corner < corners_count; corner++)
+		{
+			uint32_t corner_face = corner / 3;
+
+			if (degenerate[corner_face])
+				continue;
+
+			uint32_t first_corner = corner_face * 3;
+			uint32_t vertex = indices[corner];
+			glm::vec3 normal = NormalizeOrZero(normals[vertex]);
+
+			glm::vec3 edge0 = ProjectOnPlane(positions[indices[first_corner + (corner + 1) % 3]] - positions[vertex], normal);
+			glm::vec3 edge1 = ProjectOnPlane(positions[indices[first_corner + (corner + 2) % 3]] - positions[vertex], normal);
+			float angle = std::acos(std::clamp(glm::dot(edge0, edge1), -1.0f, 1.0f));
+
+			group_tangents[FindGroup(groups, corner)] += ProjectOnPlane(face_tangents[corner_face], normal) * angle;
+		}
+
+		GeneratedTangents result;
+		result.tangents.resize(vertices_count);
+		result.indices.assign(indices.begin(), indices.end());
+
+		// the first group reaching a vertex keeps it, others get a copy
+		std::vector<uint32_t> vertex_groups(vertices_count, kNoGroup);
+		std::unordered_map<uint64_t, uint32_t> split_copies;
+
+		for (uint32_t corner = 0; corner < corners_count; corner++)
+		{
+			uint32_t vertex = indices[corner];
+			uint32_t group = FindGroup(groups, corner);
+			glm::vec3 normal = NormalizeOrZero(normals[vertex]);
+
+			if (glm::dot(normal, normal) == 0.0f)
+			{
+				normal = glm::vec3(0, 0, 1);
+			}
+
+			if (vertex_groups[vertex] == kNoGroup)
+			{
+				vertex_groups[vertex] = group;
+				result.tangents[vertex] = FinishTangent(normal, group_tangents[group], orientation[group / 3]);
+			}
+			else if (vertex_groups[vertex] != group)
+			{
+				auto&& [it, inserted] = split_copies.emplace((uint64_t(vertex) << 32) | group, vertices_count + u32(result.split_vertices.size()));
+
+				if (inserted)
+				{
+					result.split_vertices.push_back(vertex);
+					result.tangents.push_back(FinishTangent(normal, group_tangents[group], orientation[group / 3]));
+				}
+
+				result.indices[corner] = it->second;
+			}
+		}
+
+		for (uint32_t vertex = 0; vertex < vertices_count; vertex++)
+		{
+			if (vertex_groups[vertex] == kNoGroup)
+			{
+				glm::vec3 normal = NormalizeOrZero(normals[vertex]);
+				result.tangents[vertex] = FinishTangent(glm::dot(normal, normal) > 0.0f ? normal : glm::vec3(0, 0, 1), glm::vec3(0), true);
+			}
+		}
+
+		return result;
+	}
+}
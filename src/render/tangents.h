@@ -0,0 +1,31 @@
+#ifndef RENDER_ENGINE_RENDER_TANGENTS_H_
+#define RENDER_ENGINE_RENDER_TANGENTS_H_
+
+#include <span>
+#include <vector>
+
+#include "glm/glm/glm.hpp"
+
+#include "common.h"
+
+namespace render
+{
+	// Vertices whose corners need different tangents are split, the split copies are appended after the source vertices.
+	// tangents has one entry per output vertex, split_vertices the source vertex of each appended one,
+	// indices address the output vertices.
+	struct GeneratedTangents
+	{
+		std::vector<glm::vec4> tangents;
+		std::vector<uint32_t> split_vertices;
+		std::vector<uint32_t> indices;
+	};
+
+	// MikkTSpace tangents with handedness in w, the bitangent is cross(normal, tangent.xyz) * tangent.w.
+	// Vertices with equal position, normal and texture coordinates are welded, their corners are grouped
+	// by shared edges and texture space orientation, so mirrored islands meeting at a vertex get separate tangents.
+	// Face directions are projected on the vertex normal and weighted by the corner angle.
+	// Groups without usable texture coordinates get an arbitrary tangent perpendicular to the normal.
+	// Face directions are computed four faces at a time with SSE where available.
+	GeneratedTangents GenerateTangents(std::span<const uint32_t> indices, std::span<const glm::vec3> positions, std::span<const glm::vec3> normals, std::span<const glm::vec2> uvs);
+}
+#endif  // RENDER_ENGINE_RENDER_TANGENTS_H_
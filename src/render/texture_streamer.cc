@@ -0,0 +1,258 @@
+#include "texture_streamer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "global.h"
+
+namespace render
+{
+	TextureStreamer::TextureStreamer(const Global& global) : global_(global), upload_pool_(global, CommandPool::PoolType::kGraphics), budget_(kDefaultTextureStreamingBudget), frame_number_(0)
+	{
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+		for (auto&& [texture_index, texture] : textures_)
+		{
+			if (!texture.pending_load)
+				continue;
+
+			if (texture.pending_load->staging_filled.valid())
+			{
+				texture.pending_load->staging_filled.wait();
+			}
+
+			ReleaseUpload(*texture.pending_load);
+		}
+	}
+
+	void TextureStreamer::AddTexture(uint32_t texture_index, std::shared_ptr<const MipChain> mip_chain, uint32_t resident_level)
+	{
+		textures_.emplace(texture_index, StreamedTexture{ std::move(mip_chain), resident_level, resident_level, resident_level, frame_number_ });
+	}
+
+	bool TextureStreamer::IsStreamed(uint32_t texture_index) const
+	{
+		return textures_.contains(texture_index);
+	}
+
+	void TextureStreamer::RequestLevel(uint32_t texture_index, uint32_t level)
+	{
+		if (auto&& it = textures_.find(texture_index); it != textures_.end())
+		{
+			it->second.requested_level = std::min(level, it->second.coarsest_level);
+			it->second.last_request_frame = frame_number_;
+		}
+	}
+
+	std::vector<TextureStreamer::Residency> TextureStreamer::Update()
+	{
+		frame_number_++;
+
+		std::erase_if(retired_images_, [this](auto&& retired) { return frame_number_ - retired.first > 2 * kFramesCount; });
+
+		std::vector<Residency> residency_changes;
+		uint64_t uploaded_bytes = 0;
+		uint32_t pending_loads = 0;
+
+		for (auto&& [texture_index, texture] : textures_)
+		{
+			if (!texture.pending_load)
+				continue;
+
+			auto&& load = *texture.pending_load;
+
+			if (load.fence == VK_NULL_HANDLE)
+			{
+				if (uploaded_bytes < kStreamingUploadBytesPerFrame && load.staging_filled.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+				{
+					load.staging_filled.get();
+					SubmitUpload(load);
+					uploaded_bytes += load.staging_buffer->GetSize();
+				}
+
+				pending_loads++;
+				continue;
+			}
+
+			if (vkGetFenceStatus(global_.logical_device, load.fence) != VK_SUCCESS)
+			{
+				pending_loads++;
+				continue;
+			}
+
+			ReleaseUpload(load);
+
+			// the image is created and uploaded, the view only wraps it
+			auto&& view = global_.image_view_cache.Get(global_, *load.image);
+
+			if (texture.image)
+			{
+				retired_images_.push_back({ frame_number_, std::move(texture.image) });
+			}
+
+			texture.image = std::move(load.image);
+			texture.resident_level = load.level;
+			texture.pending_load.reset();
+
+			residency_changes.push_back({ texture_index, view, texture.resident_level, texture.image->GetMipMapLevelsCount() });
+		}
+
+		struct TargetLevel
+		{
+			uint32_t level;
+			uint32_t texture_index;
+			StreamedTexture* texture;
+		};
+
+		std::vector<TargetLevel> target_levels;
+		uint64_t target_bytes = 0;
+
+		for (auto&& [texture_index, texture] : textures_)
+		{
+			if (frame_number_ - texture.last_request_frame > kStreamingIdleFrames)
+			{
+				texture.requested_level = texture.coarsest_level;
+			}
+
+			target_levels.push_back({ texture.requested_level, texture_index, &texture });
+			target_bytes += texture.mip_chain->GetBytes(texture.requested_level);
+		}
+
+		// least recently sampled textures give up their finest levels first
+		if (target_bytes > budget_)
+		{
+			std::sort(target_levels.begin(), target_levels.end(), [](auto&& lhs, auto&& rhs) { return lhs.texture->last_request_frame < rhs.texture->last_request_frame; });
+
+			for (auto&& [level, texture_index, texture] : target_levels)
+			{
+				while (target_bytes > budget_ && level < texture->coarsest_level)
+				{
+					target_bytes -= texture->mip_chain->GetBytes(level) - texture->mip_chain->GetBytes(level + 1);
+					level++;
+				}
+			}
+		}
+
+		for (auto&& [level, texture_index, texture] : target_levels)
+		{
+			if (pending_loads >= kMaxPendingTextureLoads)
+				break;
+
+			if (level == texture->resident_level || texture->pending_load)
+				continue;
+
+			StartLoad(*texture, level);
+			pending_loads++;
+		}
+
+		return residency_changes;
+	}
+
+	void TextureStreamer::StartLoad(StreamedTexture& texture, uint32_t level)
+	{
+		auto&& load = texture.pending_load.emplace();
+
+		load.level = level;
+		load.image = std::make_shared<const Image>(global_, texture.mip_chain, level);
+
+		// buffers are created on the render thread, only the copy of the levels runs on a worker
+		size_t bytes = texture.mip_chain->GetBytes(level);
+		load.staging_buffer = std::make_unique<StagingBuffer>(global_, bytes);
+
+		auto&& fill = [staging_buffer = load.staging_buffer.get(), mip_chain = texture.mip_chain, level, bytes]()
+			{
+				staging_buffer->LoadData(mip_chain->data.data() + mip_chain->level_offsets[level], bytes);
+			};
+
+		// pooled memory is shared with buffers the render thread maps, so only dedicated allocations are mapped by workers
+		if (bytes > kPooledMemoryMaxSize)
+		{
+			load.staging_filled = std::async(std::launch::async, std::move(fill));
+		}
+		else
+		{
+			fill();
+
+			std::promise<void> filled;
+			filled.set_value();
+			load.staging_filled = filled.get_future();
+		}
+	}
+
+	void TextureStreamer::SubmitUpload(PendingLoad& load)
+	{
+		VkCommandBufferAllocateInfo alloc_info{};
+		alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		alloc_info.commandPool = upload_pool_.GetHandle();
+		alloc_info.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(global_.logical_device, &alloc_info, &load.command_buffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate texture upload command buffer");
+
+		VkCommandBufferBeginInfo begin_info{};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(load.command_buffer, &begin_info);
+		load.image->RecordUpload(load.command_buffer, *load.staging_buffer);
+
+		if (vkEndCommandBuffer(load.command_buffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to record texture upload command buffer");
+
+		VkFenceCreateInfo fence_info{};
+		fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		if (vkCreateFence(global_.logical_device, &fence_info, nullptr, &load.fence) != VK_SUCCESS)
+			throw std::runtime_error("failed to create texture upload fence");
+
+		VkSubmitInfo submit_info{};
+		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submit_info.commandBufferCount = 1;
+		submit_info.pCommandBuffers = &load.command_buffer;
+
+		if (vkQueueSubmit(global_.graphics_queue, 1, &submit_info, load.fence) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit texture upload");
+	}
+
+	void TextureStreamer::ReleaseUpload(PendingLoad& load)
+	{
+		if (load.fence != VK_NULL_HANDLE)
+		{
+			vkWaitForFences(global_.logical_device, 1, &load.fence, VK_TRUE, UINT64_MAX);
+			vkDestroyFence(global_.logical_device, load.fence, nullptr);
+			load.fence = VK_NULL_HANDLE;
+		}
+
+		if (load.command_buffer != VK_NULL_HANDLE)
+		{
+			vkFreeCommandBuffers(global_.logical_device, upload_pool_.GetHandle(), 1, &load.command_buffer);
+			load.command_buffer = VK_NULL_HANDLE;
+		}
+
+		load.staging_buffer.reset();
+	}
+
+	void TextureStreamer::SetBudget(uint64_t bytes)
+	{
+		budget_ = bytes;
+	}
+
+	TextureStreamer::Stats TextureStreamer::GetStats() const
+	{
+		Stats stats;
+
+		for (auto&& [texture_index, texture] : textures_)
+		{
+			stats.resident_bytes += texture.mip_chain->GetBytes(texture.resident_level);
+			stats.requested_bytes += texture.mip_chain->GetBytes(texture.requested_level);
+			stats.pending_loads += texture.pending_load ? 1 : 0;
+		}
+
+		stats.streamed_textures = u32(textures_.size());
+
+		return stats;
+	}
+}
@@ -0,0 +1,128 @@
+#ifndef RENDER_ENGINE_RENDER_TEXTURE_STREAMER_H_
+#define RENDER_ENGINE_RENDER_TEXTURE_STREAMER_H_
+
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "common.h"
+#include "render/buffer.h"
+#include "render/command_pool.h"
+#include "render/image.h"
+#include "render/image_view.h"
+
+namespace render
+{
+	// textures larger than this start with only the levels that fit into it resident
+	const uint32_t kStreamingResidentExtent = 128;
+
+	const uint64_t kDefaultTextureStreamingBudget = 256ull * 1024 * 1024;
+	const uint64_t kStreamingUploadBytesPerFrame = 16ull * 1024 * 1024;
+
+	// frames without feedback before a texture drops back to its coarsest levels
+	const uint64_t kStreamingIdleFrames = 120;
+	const uint32_t kMaxPendingTextureLoads = 4;
+
+	// Chooses the resident mip levels of streamed textures from sampling feedback and a byte budget.
+	// Worker threads copy the levels of a new resident image from the CPU mip chain into its staging buffer,
+	// the render thread submits the upload with a fence, up to kStreamingUploadBytesPerFrame per frame,
+	// and swaps the image in once the fence is signaled. The render thread never waits for a load.
+	class TextureStreamer
+	{
+	public:
+
+		struct Residency
+		{
+			uint32_t texture_index;
+			std::shared_ptr<const ImageView> view;
+			uint32_t base_level;
+			uint32_t levels_count;
+		};
+
+		struct Stats
+		{
+			uint64_t resident_bytes = 0;
+			uint64_t requested_bytes = 0;
+			uint32_t streamed_textures = 0;
+			uint32_t pending_loads = 0;
+		};
+
+		TextureStreamer(const Global& global);
+
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer(TextureStreamer&&) = default;
+
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(TextureStreamer&&) = default;
+
+		~TextureStreamer();
+
+		// resident_level is the first level of the image already bound at texture_index
+		void AddTexture(uint32_t texture_index, std::shared_ptr<const MipChain> mip_chain, uint32_t resident_level);
+		bool IsStreamed(uint32_t texture_index) const;
+
+		// level is absolute, 0 is the full resolution
+		void RequestLevel(uint32_t texture_index, uint32_t level);
+
+		// called once per frame, returns textures whose resident image changed
+		std::vector<Residency> Update();
+
+		void SetBudget(uint64_t bytes);
+		Stats GetStats() const;
+
+	private:
+
+		struct PendingLoad
+		{
+			uint32_t level;
+			std::shared_ptr<const Image> image;
+
+			std::unique_ptr<StagingBuffer> staging_buffer;
+			std::future<void> staging_filled;
+
+			// set once the upload is submitted
+			VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+		};
+
+		struct StreamedTexture
+		{
+			std::shared_ptr<const MipChain> mip_chain;
+
+			// never evicted, the image created at load time holds these levels
+			uint32_t coarsest_level;
+
+			uint32_t resident_level;
+			uint32_t requested_level;
+			uint64_t last_request_frame;
+
+			// null until the first streamed image replaces the one created at load time
+			std::shared_ptr<const Image> image;
+
+			std::optional<PendingLoad> pending_load;
+		};
+
+		void StartLoad(StreamedTexture& texture, uint32_t level);
+		void SubmitUpload(PendingLoad& load);
+
+		// waits for the upload and frees its command buffer and fence
+		void ReleaseUpload(PendingLoad& load);
+
+		const Global& global_;
+
+		CommandPool upload_pool_;
+
+		std::map<uint32_t, StreamedTexture> textures_;
+
+		// replaced images are kept until no frame in flight can reference their views
+		std::vector<std::pair<uint64_t, std::shared_ptr<const Image>>> retired_images_;
+
+		uint64_t budget_;
+		uint64_t frame_number_;
+	};
+}
+#endif  // RENDER_ENGINE_RENDER_TEXTURE_STREAMER_H_
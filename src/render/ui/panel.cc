@@ -48,10 +48,10 @@ namespace render::ui
         NodeId node_id = scene_.AddNode();
         Node& node = scene_.GetNode(node_id);
 
-        node.parent = scene_.GetNode(node_id_);
+        node.SetParent(scene_.GetNode(node_id_));
 
-        node.local_transform = glm::translate(glm::identity<glm::mat4>(), glm::vec3(1.0f * x / width_, 1.0f * y / height_, 1.0f));
-        node.local_transform = glm::scale(node.local_transform, glm::vec3(1.0f * width / width_, 1.0f * height / height_, 1.0f));
+        glm::mat4 local_transform = glm::translate(glm::identity<glm::mat4>(), glm::vec3(1.0f * x / width_, 1.0f * y / height_, 1.0f));
+        node.SetLocalTransform(glm::scale(local_transform, glm::vec3(1.0f * width / width_, 1.0f * height / height_, 1.0f)));
 
         RenderModelId model_id = scene_.AddModel(node, mesh);
         node_models_ids_.push_back({ node_id, model_id });
@@ -101,10 +101,10 @@ namespace render::ui
 
         Node& node = scene_.GetNode(node_id_);
 
-        node.parent = scene_.GetNode(parent.node_id_);
+        node.SetParent(scene_.GetNode(parent.node_id_));
 
-        node.local_transform = glm::translate(glm::identity<glm::mat4>(), glm::vec3(anchor_x_ + 1.0f * x_ / parent_->width_, anchor_y_ + 1.0f * y_ / parent_->height_, 1.0f));
-        node.local_transform = glm::scale(node.local_transform, glm::vec3(1.0f * width_ / parent_->width_, 1.0f * height_ / parent_->height_, 1.0f));
+        glm::mat4 local_transform = glm::translate(glm::identity<glm::mat4>(), glm::vec3(anchor_x_ + 1.0f * x_ / parent_->width_, anchor_y_ + 1.0f * y_ / parent_->height_, 1.0f));
+        node.SetLocalTransform(glm::scale(local_transform, glm::vec3(1.0f * width_ / parent_->width_, 1.0f * height_ / parent_->height_, 1.0f)));
     }
 
     TextBlock::TextBlock(const UI& ui, Scene& scene, DescriptorSetsManager& desc_manager, int x, int y) : Panel(scene, x, y, 0, 0), ui_(ui), desc_manager_(desc_manager)
@@ -1,4 +1,6 @@
 #include "vertex_buffer.h"
+
+#include <cstddef>
 //#include "vertex_buffer.h"
 //
 //render::VertexBuffer::VertexBuffer(const VkDevice& device, const VkPhysicalDevice& physical_device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& queue_famaly_indeces) :RenderObjBase(device), physical_device_(physical_device)
@@ -132,4 +134,21 @@ namespace render
 	{
 		return vertex_buffer_names_to_types_ref;
 	}
+
+	std::optional<QuantizedVertexAttribute> GetQuantizedVertexAttribute(VertexBufferType type)
+	{
+		switch (type)
+		{
+		case VertexBufferType::kPOSITION:
+			return QuantizedVertexAttribute{ 0, sizeof(QuantizedPosition), VK_FORMAT_R16G16B16A16_SNORM, offsetof(QuantizedPosition, position) };
+		case VertexBufferType::kNORMAL:
+			return QuantizedVertexAttribute{ 1, sizeof(QuantizedAttributes), VK_FORMAT_R16G16_SNORM, offsetof(QuantizedAttributes, normal) };
+		case VertexBufferType::kTANGENT:
+			return QuantizedVertexAttribute{ 1, sizeof(QuantizedAttributes), VK_FORMAT_R16G16_SNORM, offsetof(QuantizedAttributes, tangent) };
+		case VertexBufferType::kTEXCOORD:
+			return QuantizedVertexAttribute{ 1, sizeof(QuantizedAttributes), VK_FORMAT_R16G16_SFLOAT, offsetof(QuantizedAttributes, texcoord) };
+		default:
+			return std::nullopt;
+		}
+	}
 }
\ No newline at end of file
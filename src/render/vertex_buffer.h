@@ -4,6 +4,7 @@
 #include <vector>
 #include <array>
 #include <map>
+#include <optional>
 
 #include "vulkan/vulkan.h"
 #include "glm/glm/glm.hpp"
@@ -32,6 +33,32 @@ namespace render
 	const std::map<VertexBufferType, std::string>& GetVertexBufferTypesToNames();
 	const std::map<std::string, VertexBufferType>& GetVertexBufferNamesToTypes();
 
+	// Streams of primitives cooked with CookOptions::quantize_vertices, two per primitive.
+	// POSITION is snorm16 inside the dequantization box of the mesh, w holds the tangent handedness.
+	struct QuantizedPosition
+	{
+		std::array<int16_t, 4> position;
+	};
+
+	// octahedral snorm16 directions and half texture coordinates, interleaved for the G-buffer pass
+	struct QuantizedAttributes
+	{
+		std::array<int16_t, 2> normal;
+		std::array<int16_t, 2> tangent;
+		std::array<uint16_t, 2> texcoord;
+	};
+
+	struct QuantizedVertexAttribute
+	{
+		uint32_t binding;
+		uint32_t stride;
+		VkFormat format;
+		uint32_t offset;
+	};
+
+	// layout of a shader input declared /*quantized*/, empty for types without a quantized form
+	std::optional<QuantizedVertexAttribute> GetQuantizedVertexAttribute(VertexBufferType type);
+
 	class VertexBuffer : public RenderObjBase<VkBuffer>
 	{
 	public:
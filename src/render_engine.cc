@@ -11,6 +11,7 @@
 #include <map>
 #include <tuple>
 #include <chrono>
+#include <mutex>
 #include <sstream>
 
 #include "vulkan/vulkan.h"
@@ -29,6 +30,7 @@
 #include "render/vk_util.h"
 #include "render/data_types.h"
 
+#include "render/animator.h"
 #include "render/batch.h"
 #include "render/batches_manager.h"
 #include "render/buffer.h"
@@ -92,7 +94,8 @@ namespace render
 
 		RenderEngineImpl(InitParam param, const std::string& app_name) : external_command_queue_(32), last_object_id_(0), render_system_(platform::CreatePlatformWindow(param), app_name)
 		{
-
+			// the workers start here once instead of on the first frame that poses animated instances
+			util::ThreadPool::Get();
 		}
 
 		void cleanup() {
@@ -115,13 +118,14 @@ namespace render
 			std::vector<ModelPack> model_packs;
 			std::map<std::string, Image> images;
 			std::unordered_map<std::string, uint32_t> model_packs_name_to_index;
+			std::vector<Animator> animators;
 
 			static auto start_time = std::chrono::high_resolution_clock::now();
 			static auto start_time_fps = std::chrono::high_resolution_clock::now();
 
 
 
-			model_packs.push_back(ModelPack(render_system_.GetGlobal(), render_system_.GetDescriptorSetsManager()));
+			model_packs.push_back(ModelPack(render_system_.GetGlobal(), render_system_.GetDescriptorSetsManager(), render_system_.GetMaterialTable()));
 
 			DebugGeometry dg(render_system_.GetGlobal(), render_system_.GetDescriptorSetsManager());
 
@@ -139,24 +143,98 @@ namespace render
 			render_system_.AddOnSwapchainUpdateCallback([&](const Swapchain& swapchain)
 				{
 					screen_panel.SetExtent(swapchain.GetExtent());
-					scenes_[0].aspect = 1.0f * swapchain.GetExtent().width / swapchain.GetExtent().height; });
+					scenes_[0].SetAspect(1.0f * swapchain.GetExtent().width / swapchain.GetExtent().height); });
+
+			auto last_frame_time = std::chrono::high_resolution_clock::now();
 
 			while (render_system_.ShouldRender())
 			{
 				current_frame_index = (current_frame_index + 1) % kFramesCount;
 				frame_cnt++;
 
-				scenes_[0].Update(current_frame_index);
+				{
+					auto frame_time = std::chrono::high_resolution_clock::now();
+					std::chrono::duration<float, std::milli> frame_duration = frame_time - last_frame_time;
+					last_frame_time = frame_time;
+
+					std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+					stats_.frame_time_ms = frame_duration.count();
+					stats_.fps = frame_duration.count() > 0 ? 1000.0f / frame_duration.count() : 0.0f;
+					stats_.lights_count = u32(scenes_[0].lights_.GetData().size());
+					stats_.frames_count++;
+					stats_.frames_time_ms += frame_duration.count();
+				}
+
+				{
+					auto animation_start_time = std::chrono::high_resolution_clock::now();
+
+					// instances own their nodes, so they are posed in parallel, a batch per index keeps the shared counter cold
+					const size_t kAnimatorsPerTask = 16;
+					Animator::TimePoint animation_time = Animator::Clock::now();
+
+					util::ParallelFor((animators.size() + kAnimatorsPerTask - 1) / kAnimatorsPerTask, [&](size_t task_index)
+						{
+							size_t end = std::min(animators.size(), (task_index + 1) * kAnimatorsPerTask);
+
+							for (size_t index = task_index * kAnimatorsPerTask; index < end; index++)
+							{
+								animators[index].Update(animation_time);
+							}
+						});
+
+					std::chrono::duration<float, std::milli> animation_duration = std::chrono::high_resolution_clock::now() - animation_start_time;
+
+					std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+					stats_.animated_instances_count = u32(animators.size());
+					stats_.animation_update_time_ms = animation_duration.count();
+				}
+
+				auto descriptor_update_start_time = std::chrono::high_resolution_clock::now();
+
+				int descriptor_set_updates = scenes_[0].Update(current_frame_index);
 				int i = 0;
 				for (auto&& model : scenes_[0].models_)
 				{
-					model.UpdateAndTryFillWrites(current_frame_index);
 					i++;
 					for (auto&& primitive : model.mesh->primitives)
 					{
-						std::visit([&current_frame_index](auto&& primitive) {primitive.UpdateAndTryFillWrites(current_frame_index); }, primitive);
+						descriptor_set_updates += std::visit([&current_frame_index](auto&& primitive) { return primitive.UpdateAndTryFillWrites(current_frame_index); }, primitive);
 					}
 				}
+
+				{
+					std::chrono::duration<float, std::milli> descriptor_update_duration = std::chrono::high_resolution_clock::now() - descriptor_update_start_time;
+
+					std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+					stats_.descriptor_set_updates = u32(descriptor_set_updates);
+					stats_.descriptor_update_time_ms = descriptor_update_duration.count();
+					stats_.uploaded_bytes = render_system_.GetGlobal().uploaded_bytes.exchange(0);
+
+					auto&& descriptor_sets_stats = render_system_.GetDescriptorSetsManager().GetStats();
+					stats_.descriptor_sets_used = descriptor_sets_stats.used_sets;
+					stats_.descriptor_sets_free = descriptor_sets_stats.free_sets;
+					stats_.descriptor_sets_cached = descriptor_sets_stats.cached_sets;
+					stats_.descriptor_pools_count = descriptor_sets_stats.pools_count;
+					stats_.descriptor_sets_shared = descriptor_sets_stats.shared_sets;
+					stats_.descriptor_set_shared_refs = descriptor_sets_stats.shared_set_refs;
+
+					stats_.image_views_count = u32(render_system_.GetGlobal().image_view_cache.GetViewsCount());
+
+					auto&& streaming_stats = render_system_.GetMaterialTable().GetStreamingStats();
+					stats_.streamed_textures_count = streaming_stats.streamed_textures;
+					stats_.texture_resident_bytes = streaming_stats.resident_bytes;
+					stats_.texture_requested_bytes = streaming_stats.requested_bytes;
+					stats_.texture_pending_loads = streaming_stats.pending_loads;
+
+					stats_.full_detail_triangles_count = scenes_[0].GetLodStats().full_detail_triangles;
+					stats_.lod_triangles_count = scenes_[0].GetLodStats().lod_triangles;
+
+					stats_.overflowed_light_clusters = scenes_[0].GetLightCullingStats().overflowed_clusters;
+					stats_.dropped_cluster_lights = scenes_[0].GetLightCullingStats().dropped_lights;
+
+					stats_.skinned_vertices_count = scenes_[0].GetSkinningCache().GetSkinnedVerticesCount();
+					stats_.joint_matrices_count = scenes_[0].GetSkinningCache().GetJointMatricesCount();
+				}
 				
 				render_system_.Render(current_frame_index, scenes_[0]);
 
@@ -184,13 +262,33 @@ namespace render
 				{
 					auto&& command = external_command_queue_.Pop();
 
-					if (std::holds_alternative<command::Load>(command))
+					if (std::holds_alternative<command::Load>(command) || std::holds_alternative<command::LoadFile>(command))
 					{
-						model_packs.push_back(ModelPack(render_system_.GetGlobal(), render_system_.GetDescriptorSetsManager()));
+						auto load_start_time = std::chrono::high_resolution_clock::now();
+
+						model_packs.push_back(ModelPack(render_system_.GetGlobal(), render_system_.GetDescriptorSetsManager(), render_system_.GetMaterialTable()));
+
+						if (auto&& load_command = std::get_if<command::Load>(&command))
+						{
+							model_packs.back().AddGLTF(*load_command->model);
+							model_packs_name_to_index.emplace(load_command->pack_name, (uint32_t)(model_packs.size() - 1));
+						}
+						else
+						{
+							auto&& load_file_command = std::get<command::LoadFile>(command);
+							model_packs.back().AddCooked(LoadCookedModelPack(load_file_command.path, load_file_command.cache_dir, load_file_command.options));
+							model_packs_name_to_index.emplace(load_file_command.pack_name, (uint32_t)(model_packs.size() - 1));
+						}
 
-						auto&& specified_command = std::get<command::Load>(command);
-						model_packs.back().AddGLTF(*specified_command.model);
-						model_packs_name_to_index.emplace(specified_command.pack_name, (uint32_t)(model_packs.size() - 1));
+						std::chrono::duration<float, std::milli> load_duration = std::chrono::high_resolution_clock::now() - load_start_time;
+
+						std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+						stats_.packs_loaded++;
+						stats_.pack_load_time_ms = load_duration.count();
+						stats_.pack_source_buffers_bytes = model_packs.back().source_buffers_bytes;
+						stats_.pack_uploaded_buffers_bytes = model_packs.back().uploaded_buffers_bytes;
+						stats_.pack_animation_import_time_ms = model_packs.back().animation_import_time_ms;
+						stats_.pack_animation_clips_bytes = model_packs.back().animation_clips_bytes;
 					}
 
 					if (std::holds_alternative<command::Image>(command))
@@ -229,7 +327,73 @@ namespace render
 
 						RegisterObject(ObjectType::Node, specified_command.object_id, node_id);
 
-						scenes_[0].AddModel(node, *pack_model.mesh);
+						// static instances of skinned models keep the rest pose of the pack nodes
+						if (pack_model.skin)
+						{
+							std::vector<byes::RTM<Node>> joints;
+
+							for (uint32_t joint : pack_model.skin->joints)
+							{
+								joints.emplace_back(pack.nodes[joint]);
+							}
+
+							scenes_[0].AddSkinnedModel(node, *pack_model.mesh, *pack_model.skin, std::move(joints), *pack_model.node);
+						}
+						else
+						{
+							scenes_[0].AddModel(node, *pack_model.mesh);
+						}
+					}
+
+					if (std::holds_alternative<command::AddObject<ObjectType::AnimatedModel>>(command))
+					{
+						auto&& specified_command = std::get<command::AddObject<ObjectType::AnimatedModel>>(command);
+
+						auto&& pack = model_packs[model_packs_name_to_index.at(specified_command.desc.pack_name)];
+
+						auto root_id = scenes_[0].AddNode();
+						RegisterObject(ObjectType::Node, specified_command.object_id, root_id);
+
+						std::vector<byes::RTM<Node>> instance_nodes;
+
+						for (auto&& pack_node : pack.nodes)
+						{
+							auto&& node = scenes_[0].AddNodeAndGet();
+							node.SetLocalTransform(pack_node.GetLocalTransform());
+							instance_nodes.emplace_back(node);
+						}
+
+						for (size_t node_index = 0; node_index < instance_nodes.size(); node_index++)
+						{
+							int32_t parent_index = pack.node_parents[node_index];
+							instance_nodes[node_index]->SetParent(parent_index >= 0 ? *instance_nodes[parent_index] : scenes_[0].GetNode(root_id));
+						}
+
+						for (auto&& node_mesh : pack.node_meshes)
+						{
+							if (node_mesh.skin >= 0)
+							{
+								auto&& skin = pack.skins[node_mesh.skin];
+								std::vector<byes::RTM<Node>> joints;
+
+								for (uint32_t joint : skin.joints)
+								{
+									joints.push_back(instance_nodes[joint]);
+								}
+
+								scenes_[0].AddSkinnedModel(*instance_nodes[node_mesh.node], pack.meshes[node_mesh.mesh], skin, std::move(joints), *instance_nodes[node_mesh.node]);
+							}
+							else
+							{
+								scenes_[0].AddModel(*instance_nodes[node_mesh.node], pack.meshes[node_mesh.mesh]);
+							}
+						}
+
+						if (auto&& it = pack.animations.find(specified_command.desc.animation_name); it != pack.animations.end())
+						{
+							animators.emplace_back(it->second, std::move(instance_nodes));
+							animators.back().Start();
+						}
 					}
 
 					if (std::holds_alternative<command::AddObject<ObjectType::Node>>(command))
@@ -259,6 +423,20 @@ namespace render
 						scenes_[0].AddModel(node, model_packs[0].meshes.back());
 					}
 
+					if (std::holds_alternative<command::AddObject<ObjectType::Light>>(command))
+					{
+						auto&& specified_command = std::get<command::AddObject<ObjectType::Light>>(command);
+						auto&& desc = specified_command.desc;
+
+						auto node_id = scenes_[0].AddNode();
+						auto&& node = scenes_[0].GetNode(node_id);
+						node.SetLocalTransform(glm::translate(glm::identity<glm::mat4>(), desc.position));
+
+						RegisterObject(ObjectType::Node, specified_command.object_id, node_id);
+
+						scenes_[0].AddLight(node, desc.color, desc.intensity, desc.radius, desc.cast_shadows);
+					}
+
 					if (std::holds_alternative<command::AddObject<ObjectType::Camera>>(command))
 					{
 						auto&& specified_command = std::get<command::AddObject<ObjectType::Camera>>(command);
@@ -269,7 +447,7 @@ namespace render
 						auto&& specified_command = std::get<command::SetActiveCameraNode>(command);
 
 						auto&& info = object_id_to_scene_object_id_[specified_command.node_id.value];
-						scenes_[0].camera_node_id_ = { info.id };
+						scenes_[0].SetCameraNode({ info.id });
 						block = std::make_shared<ui::TextBlock>(ui, scenes_[0], render_system_.GetDescriptorSetsManager(), 30, 30);
 						block->SetText(U"", 30);
 						screen_panel.AddChild(block);
@@ -287,11 +465,17 @@ namespace render
 								{
 									NodeId node_id = object_id_to_scene_object_id_[id].id;
 									auto&& node = scenes_[0].GetNode({ node_id });
-									node.local_transform = transform;
+									node.SetLocalTransform(transform);
 								}
 							}
 						}
 					}
+
+					if (std::holds_alternative<command::TextureStreamingBudget>(command))
+					{
+						auto&& specified_command = std::get<command::TextureStreamingBudget>(command);
+						render_system_.GetMaterialTable().SetStreamingBudget(specified_command.bytes);
+					}
 				}
 			}
 		}
@@ -349,6 +533,12 @@ namespace render
 			return result;
 		}
 
+		RenderStats GetStats()
+		{
+			std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+			return stats_;
+		}
+
 		~RenderEngineImpl()
 		{
 
@@ -392,6 +582,9 @@ namespace render
 		std::stack<uint32_t> free_ids_;
 		std::vector<ObjectInfo> object_id_to_scene_object_id_;
 
+		std::mutex stats_mutex_;
+		RenderStats stats_;
+
 		RenderSystem render_system_;
 	};
 
@@ -410,6 +603,11 @@ namespace render
 		impl_->external_command_queue_.Push(render_command);
 	}
 
+	RenderStats RenderEngine::GetStats()
+	{
+		return impl_->GetStats();
+	}
+
 	RenderEngine::~RenderEngine() = default;
 
 	bool RenderEngine::VKInitSuccess()
@@ -3,10 +3,18 @@
 
 #include <algorithm>
 #include <any>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
 #include <utility>
 #include <type_traits>
+#include <vector>
 
 namespace render::util
 {
@@ -149,6 +157,162 @@ namespace render::util
 	template<typename ReferencedType>
 	NullableRef<ReferencedType> MakeNullableRef(ReferencedType& ref) { return NullableRef<ReferencedType>(ref); }
 
+	// Process-wide workers, started on first use and joined at exit.
+	class ThreadPool
+	{
+	public:
+
+		static ThreadPool& Get()
+		{
+			static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+			return pool;
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		size_t GetWorkersCount() const
+		{
+			return workers_.size();
+		}
+
+		void Push(std::function<void()> task)
+		{
+			{
+				std::lock_guard lock(mutex_);
+				tasks_.push_back(std::move(task));
+			}
+
+			condition_.notify_one();
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard lock(mutex_);
+				stop_ = true;
+			}
+
+			condition_.notify_all();
+
+			for (auto&& worker : workers_)
+			{
+				worker.join();
+			}
+		}
+
+	private:
+
+		explicit ThreadPool(size_t workers_count)
+		{
+			workers_.reserve(workers_count);
+
+			for (size_t i = 0; i < workers_count; i++)
+			{
+				workers_.emplace_back([this]()
+					{
+						for (;;)
+						{
+							std::function<void()> task;
+
+							{
+								std::unique_lock lock(mutex_);
+								condition_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+
+								if (tasks_.empty())
+									return;
+
+								task = std::move(tasks_.front());
+								tasks_.pop_front();
+							}
+
+							task();
+						}
+					});
+			}
+		}
+
+		std::mutex mutex_;
+		std::condition_variable condition_;
+		std::deque<std::function<void()>> tasks_;
+		bool stop_ = false;
+
+		std::vector<std::thread> workers_;
+	};
+
+	// Calls func(index) for every index in [0, count) on the ThreadPool workers and the caller thread.
+	// Indices are handed out one at a time through an atomic counter, no threads are created per call.
+	// The caller only waits for workers that picked the loop up, so nested calls from pool tasks can't deadlock.
+	// The first exception thrown by func is rethrown after all running workers are done.
+	template<typename Func>
+	void ParallelFor(size_t count, Func&& func)
+	{
+		struct State
+		{
+			std::atomic<size_t> next_index = 0;
+			std::exception_ptr exception;
+
+			std::mutex mutex;
+			std::condition_variable done;
+			size_t running_cnt = 0;
+			bool closed = false;
+		};
+
+		auto&& state = std::make_shared<State>();
+
+		auto&& run = [count, &func](State& state)
+			{
+				for (size_t index = state.next_index++; index < count; index = state.next_index++)
+				{
+					try
+					{
+						func(index);
+					}
+					catch (...)
+					{
+						std::lock_guard lock(state.mutex);
+						if (!state.exception)
+							state.exception = std::current_exception();
+					}
+				}
+			};
+
+		auto&& pool = ThreadPool::Get();
+		size_t tasks_count = count > 1 ? std::min(count - 1, pool.GetWorkersCount()) : 0;
+
+		for (size_t i = 0; i < tasks_count; i++)
+		{
+			// a task started after the caller is done returns without touching func
+			pool.Push([state, &run]()
+				{
+					{
+						std::lock_guard lock(state->mutex);
+						if (state->closed)
+							return;
+						state->running_cnt++;
+					}
+
+					run(*state);
+
+					{
+						std::lock_guard lock(state->mutex);
+						state->running_cnt--;
+					}
+
+					state->done.notify_all();
+				});
+		}
+
+		run(*state);
+
+		std::unique_lock lock(state->mutex);
+		state->closed = true;
+		state->done.wait(lock, [&state]() { return state->running_cnt == 0; });
+
+		if (state->exception)
+			std::rethrow_exception(state->exception);
+	}
+
 	namespace enums
 	{
 
@@ -277,6 +441,11 @@ namespace render::util
 				return data_[id_to_ind_[id.value]];
 			}
 
+			const T& Get(Id id) const
+			{
+				return data_[id_to_ind_.at(id.value)];
+			}
+
 			bool Remove(Id id)
 			{
 				if (id.value < id_)